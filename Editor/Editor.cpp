@@ -28,6 +28,50 @@ extern bool window_recreating;
 #include "sdl2.h"
 #endif // PLATFORM_WINDOWS
 
+void RunImportBenchmark()
+{
+	// Imports the sample models multiple times into temporary scenes and reports the average stage timings
+	//	The results are written to the backlog, which is also printed to the standard output
+	const char* files[] = {
+		"../Content/models/DamagedHelmet.glb",
+		"../Content/models/CesiumMan.glb",
+		"../Content/models/gltf_KHR_lights_punctual_test.glb",
+	};
+	const int iterations = 4;
+	for (auto& file : files)
+	{
+		if (!wi::helper::FileExists(file))
+		{
+			wi::backlog::post(std::string("Import benchmark: file not found: ") + file, wi::backlog::LogLevel::Warning);
+			continue;
+		}
+		ImportStatistics_GLTF average;
+		for (int i = 0; i < iterations; ++i)
+		{
+			Scene scene;
+			ImportStatistics_GLTF statistics;
+			ImportModel_GLTF(file, scene, true, &statistics);
+			average.parse += statistics.parse / iterations;
+			average.images += statistics.images / iterations;
+			average.materials += statistics.materials / iterations;
+			average.meshes += statistics.meshes / iterations;
+			average.scene += statistics.scene / iterations;
+			average.animations += statistics.animations / iterations;
+			average.total += statistics.total / iterations;
+		}
+		wi::backlog::post(
+			std::string("Import benchmark: ") + file + " (average of " + std::to_string(iterations) + " imports, " + std::to_string(wi::jobsystem::GetThreadCount()) + " threads)" +
+			"\n\tparse: " + std::to_string(average.parse) + " ms" +
+			"\n\timages: " + std::to_string(average.images) + " ms" +
+			"\n\tmaterials: " + std::to_string(average.materials) + " ms" +
+			"\n\tmeshes: " + std::to_string(average.meshes) + " ms" +
+			"\n\tscene: " + std::to_string(average.scene) + " ms" +
+			"\n\tanimations: " + std::to_string(average.animations) + " ms" +
+			"\n\ttotal: " + std::to_string(average.total) + " ms"
+		);
+	}
+}
+
 void Editor::Initialize()
 {
 	Application::Initialize();
@@ -52,6 +96,17 @@ void Editor::Initialize()
 
 	loader.addLoadingComponent(&renderComponent, this, 0.2f);
 
+	if (wi::arguments::HasArgument("importbenchmark"))
+	{
+		loader.addLoadingFunction([](wi::jobsystem::JobArgs args) {
+			RunImportBenchmark();
+			// Exit is requested from the main thread:
+			wi::eventhandler::Subscribe_Once(wi::eventhandler::EVENT_THREAD_SAFE_POINT, [](uint64_t userdata) {
+				wi::platform::Exit();
+				});
+			});
+	}
+
 	ActivatePath(&loader, 0.2f);
 
 }
@@ -490,6 +545,7 @@ void EditorComponent::Load()
 		ss += "\t- Enable graphics device debug mode: debugdevice\n";
 		ss += "\t- Enable graphics device GPU-based validation: gpuvalidation\n";
 		ss += "\t- Make window always active, even when in background: alwaysactive\n";
+		ss += "\t- Run the GLTF import benchmark on the sample models and exit: importbenchmark\n";
 		ss += "\nFor questions, bug reports, feedback, requests, please open an issue at:\n";
 		ss += "https://github.com/turanszkij/WickedEngine/issues\n";
 		ss += "\n\n";
@@ -4,8 +4,6 @@
 
 #include "Utility/stb_image.h"
 
-#include "meshoptimizer/meshoptimizer.h"
-
 #include <string>
 
 using namespace wi::ecs;
@@ -79,6 +77,21 @@ void MeshWindow::Create(EditorComponent* _editor)
 	});
 	AddWidget(&doubleSidedCheckBox);
 
+	quantizedPositionsCheckBox.Create("Quantized Positions: ");
+	quantizedPositionsCheckBox.SetTooltip("If enabled, positions and normals will be stored with 8 bytes per vertex instead of 16 when the precision loss is small enough.\nMeshes with morph targets, skinning or wind weights are always stored in full precision.");
+	quantizedPositionsCheckBox.SetSize(XMFLOAT2(hei, hei));
+	quantizedPositionsCheckBox.SetPos(XMFLOAT2(x, y += step));
+	quantizedPositionsCheckBox.OnClick([&](wi::gui::EventArgs args) {
+		MeshComponent* mesh = editor->GetCurrentScene().meshes.GetComponent(entity);
+		if (mesh != nullptr)
+		{
+			mesh->SetQuantizedPositions(args.bValue);
+			mesh->CreateRenderData();
+			SetEntity(entity, subset);
+		}
+	});
+	AddWidget(&quantizedPositionsCheckBox);
+
 	impostorCreateButton.Create("Create Impostor");
 	impostorCreateButton.SetTooltip("Create an impostor image of the mesh. The mesh will be replaced by this image when far away, to render faster.");
 	impostorCreateButton.SetSize(XMFLOAT2(wid, hei));
@@ -89,7 +102,9 @@ void MeshWindow::Create(EditorComponent* _editor)
 		if (impostor == nullptr)
 		{
 			impostorCreateButton.SetText("Delete Impostor");
-			scene.impostors.Create(entity).swapInDistance = impostorDistanceSlider.GetValue();
+			ImpostorComponent& impostor = scene.impostors.Create(entity);
+			impostor.swapInDistance = impostorDistanceSlider.GetValue();
+			impostor.resolution = (uint32_t)impostorResolutionSlider.GetValue();
 		}
 		else
 		{
@@ -112,6 +127,20 @@ void MeshWindow::Create(EditorComponent* _editor)
 	});
 	AddWidget(&impostorDistanceSlider);
 
+	impostorResolutionSlider.Create(16, 512, 128, 31, "Impostor Res: ");
+	impostorResolutionSlider.SetTooltip("Assign the texture resolution of one capture angle of the impostor in the impostor atlas.");
+	impostorResolutionSlider.SetSize(XMFLOAT2(wid, hei));
+	impostorResolutionSlider.SetPos(XMFLOAT2(x, y += step));
+	impostorResolutionSlider.OnSlide([&](wi::gui::EventArgs args) {
+		ImpostorComponent* impostor = editor->GetCurrentScene().impostors.GetComponent(entity);
+		if (impostor != nullptr)
+		{
+			impostor->resolution = (uint32_t)args.iValue;
+			impostor->SetDirty();
+		}
+	});
+	AddWidget(&impostorResolutionSlider);
+
 	tessellationFactorSlider.Create(0, 100, 0, 10000, "Tess Factor: ");
 	tessellationFactorSlider.SetTooltip("Set the dynamic tessellation amount. Tessellation should be enabled in the Renderer window and your GPU must support it!");
 	tessellationFactorSlider.SetSize(XMFLOAT2(wid, hei));
@@ -227,6 +256,7 @@ void MeshWindow::Create(EditorComponent* _editor)
 		bool valid_boneweights = false;
 		bool valid_colors = false;
 		bool valid_windweights = false;
+		bool valid_meshlets = false;
 		wi::unordered_set<Entity> entities_to_remove;
 		Entity prev_subset_material = INVALID_ENTITY;
 		for (auto& picked : editor->translator.selected)
@@ -237,6 +267,7 @@ void MeshWindow::Create(EditorComponent* _editor)
 			MeshComponent* mesh = scene.meshes.GetComponent(object->meshID);
 			if (mesh == nullptr)
 				continue;
+			valid_meshlets |= mesh->HasMeshlets();
 			const TransformComponent* transform = scene.transforms.GetComponent(picked.entity);
 			XMMATRIX W = XMLoadFloat4x4(&transform->world);
 			uint32_t vertexOffset = (uint32_t)merged_mesh.vertex_positions.size();
@@ -383,6 +414,11 @@ void MeshWindow::Create(EditorComponent* _editor)
 			object->meshID = merged_mesh_entity;
 			MeshComponent* mesh = scene.meshes.GetComponent(merged_mesh_entity);
 			*mesh = std::move(merged_mesh);
+			if (valid_meshlets)
+			{
+				// the meshlets of the merged meshes can't be reused, they are rebuilt for the merged mesh:
+				mesh->BuildMeshlets();
+			}
 			mesh->CreateRenderData();
 		}
 
@@ -395,22 +431,28 @@ void MeshWindow::Create(EditorComponent* _editor)
 	AddWidget(&mergeButton);
 
 	optimizeButton.Create("Optimize");
-	optimizeButton.SetTooltip("Run the meshoptimizer library.");
+	optimizeButton.SetTooltip("Optimize the mesh for vertex cache, overdraw and vertex fetch with the meshoptimizer library.");
 	optimizeButton.SetSize(XMFLOAT2(mod_wid, hei));
 	optimizeButton.SetPos(XMFLOAT2(mod_x, y += step));
 	optimizeButton.OnClick([&](wi::gui::EventArgs args) {
-		MeshComponent* mesh = editor->GetCurrentScene().meshes.GetComponent(entity);
+		Scene& scene = editor->GetCurrentScene();
+		MeshComponent* mesh = scene.meshes.GetComponent(entity);
 		if (mesh != nullptr)
 		{
-			// https://github.com/zeux/meshoptimizer#vertex-cache-optimization
-
-			size_t index_count = mesh->indices.size();
-			size_t vertex_count = mesh->vertex_positions.size();
+			MeshComponent::OptimizationStatistics statistics;
+			wi::vector<uint32_t> vertex_remap;
+			mesh->Optimize(&statistics, &vertex_remap);
 
-			wi::vector<uint32_t> indices(index_count);
-			meshopt_optimizeVertexCache(indices.data(), mesh->indices.data(), index_count, vertex_count);
+			// The soft body mappings and painted weights reference the vertices which were reordered:
+			SoftBodyPhysicsComponent* softbody = scene.softbodies.GetComponent(entity);
+			if (softbody != nullptr)
+			{
+				softbody->RemapGraphicsVertices(vertex_remap);
+			}
 
-			mesh->indices = indices;
+			MeshComponent::OptimizationStatistics optimized;
+			optimized.Accumulate(statistics, mesh->indices.size());
+			optimized.Log("Mesh optimization:");
 
 			mesh->CreateRenderData();
 			SetEntity(entity, subset);
@@ -418,6 +460,30 @@ void MeshWindow::Create(EditorComponent* _editor)
 		});
 	AddWidget(&optimizeButton);
 
+	meshletButton.Create("Build meshlets");
+	meshletButton.SetTooltip("Build the meshlet cluster hierarchy which can be used for culling parts of the mesh on the CPU.\nThe meshlets are serialized with the mesh.");
+	meshletButton.SetSize(XMFLOAT2(mod_wid, hei));
+	meshletButton.SetPos(XMFLOAT2(mod_x, y += step));
+	meshletButton.OnClick([&](wi::gui::EventArgs args) {
+		MeshComponent* mesh = editor->GetCurrentScene().meshes.GetComponent(entity);
+		if (mesh != nullptr)
+		{
+			wi::Timer timer;
+			MeshComponent::MeshletBuildStatistics statistics;
+			mesh->BuildMeshlets(&statistics);
+
+			std::string str = "Meshlet build: " + std::to_string(timer.elapsed()) + " ms";
+			str += "\n\tmeshlets: " + std::to_string(statistics.meshlet_count);
+			str += "\n\thierarchy nodes: " + std::to_string(statistics.node_count);
+			str += "\n\tvertices per meshlet: " + std::to_string(statistics.vertices_per_meshlet);
+			str += "\n\ttriangles per meshlet: " + std::to_string(statistics.triangles_per_meshlet);
+			wi::backlog::post(str);
+
+			SetEntity(entity, subset);
+		}
+		});
+	AddWidget(&meshletButton);
+
 
 
 	subsetMaterialComboBox.Create("Material: ");
@@ -480,103 +546,12 @@ void MeshWindow::Create(EditorComponent* _editor)
 		MeshComponent* mesh = editor->GetCurrentScene().meshes.GetComponent(entity);
 		if (mesh != nullptr)
 		{
-			if (mesh->subsets_per_lod == 0)
-			{
-				// if there were no lods before, record the subset count without lods:
-				mesh->subsets_per_lod = (uint32_t)mesh->subsets.size();
-			}
-
-			// https://github.com/zeux/meshoptimizer/blob/bedaaaf6e710d3b42d49260ca738c15d171b1a8f/demo/main.cpp
-			size_t index_count = mesh->indices.size();
-			size_t vertex_count = mesh->vertex_positions.size();
-
-			const size_t lod_count = (size_t)lodCountSlider.GetValue();
-			struct LOD
-			{
-				struct Subset
-				{
-					wi::vector<uint32_t> indices;
-				};
-				wi::vector<Subset> subsets;
-			};
-			wi::vector<LOD> lods(lod_count);
-
-			const float target_error = lodErrorSlider.GetValue();
-
-			for (size_t i = 0; i < lod_count; ++i)
-			{
-				lods[i].subsets.resize(mesh->subsets_per_lod);
-				for (uint32_t subsetIndex = 0; subsetIndex < mesh->subsets_per_lod; ++subsetIndex)
-				{
-					const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
-					lods[i].subsets[subsetIndex].indices.resize(subset.indexCount);
-					for (uint32_t ind = 0; ind < subset.indexCount; ++ind)
-					{
-						lods[i].subsets[subsetIndex].indices[ind] = mesh->indices[subset.indexOffset + ind];
-					}
-				}
-			}
-
-			for (uint32_t subsetIndex = 0; subsetIndex < mesh->subsets_per_lod; ++subsetIndex)
-			{
-				const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
-
-				float threshold = wi::math::Lerp(0, 0.9f, wi::math::saturate(lodQualitySlider.GetValue()));
-				for (size_t i = 1; i < lod_count; ++i)
-				{
-					wi::vector<unsigned int>& lod = lods[i].subsets[subsetIndex].indices;
-
-					size_t target_index_count = size_t(mesh->indices.size() * threshold) / 3 * 3;
-
-					// we can simplify all the way from base level or from the last result
-					// simplifying from the base level sometimes produces better results, but simplifying from last level is faster
-					//const wi::vector<unsigned int>& source = lods[0].subsets[subsetIndex].indices;
-					const wi::vector<unsigned int>& source = lods[i - 1].subsets[subsetIndex].indices;
-
-					if (source.size() < target_index_count)
-						target_index_count = source.size();
-
-					lod.resize(source.size());
-					if (lodSloppyCheckBox.GetCheck())
-					{
-						lod.resize(meshopt_simplifySloppy(&lod[0], &source[0], source.size(), &mesh->vertex_positions[0].x, mesh->vertex_positions.size(), sizeof(XMFLOAT3), target_index_count, target_error));
-					}
-					else
-					{
-						lod.resize(meshopt_simplify(&lod[0], &source[0], source.size(), &mesh->vertex_positions[0].x, mesh->vertex_positions.size(), sizeof(XMFLOAT3), target_index_count, target_error));
-					}
-
-					threshold *= threshold;
-				}
-
-				// optimize each individual LOD for vertex cache & overdraw
-				for (size_t i = 0; i < lod_count; ++i)
-				{
-					wi::vector<unsigned int>& lod = lods[i].subsets[subsetIndex].indices;
-
-					meshopt_optimizeVertexCache(&lod[0], &lod[0], lod.size(), mesh->vertex_positions.size());
-					meshopt_optimizeOverdraw(&lod[0], &lod[0], lod.size(), &mesh->vertex_positions[0].x, mesh->vertex_positions.size(), sizeof(XMFLOAT3), 1.0f);
-				}
-			}
-
-			mesh->indices.clear();
-			wi::vector<MeshComponent::MeshSubset> subsets;
-			for (size_t i = 0; i < lod_count; ++i)
-			{
-				for (uint32_t subsetIndex = 0; subsetIndex < mesh->subsets_per_lod; ++subsetIndex)
-				{
-					const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
-					subsets.emplace_back();
-					subsets.back() = subset;
-					subsets.back().indexOffset = (uint32_t)mesh->indices.size();
-					subsets.back().indexCount = (uint32_t)lods[i].subsets[subsetIndex].indices.size();
-					for (auto& x : lods[i].subsets[subsetIndex].indices)
-					{
-						mesh->indices.push_back(x);
-					}
-				}
-			}
-			mesh->subsets = subsets;
+			MeshComponent::LODGenerationParams params;
+			params.lod_count = (uint32_t)lodCountSlider.GetValue();
+			params.quality = lodQualitySlider.GetValue();
+			params.target_error = lodErrorSlider.GetValue();
+			params.sloppy = lodSloppyCheckBox.GetCheck();
+			mesh->GenerateLODs(params);
 
 			mesh->CreateRenderData();
 			SetEntity(entity, subset);
@@ -635,9 +610,10 @@ void MeshWindow::SetEntity(Entity entity, int subset)
 		ss += "Vertex count: " + std::to_string(mesh->vertex_positions.size()) + "\n";
 		ss += "Index count: " + std::to_string(mesh->indices.size()) + "\n";
 		ss += "Subset count: " + std::to_string(mesh->subsets.size()) + " (" + std::to_string(mesh->GetLODCount()) + " LODs)\n";
+		if (mesh->HasMeshlets()) ss += "Meshlet count: " + std::to_string(mesh->meshlets.size()) + "\n";
 		ss += "GPU memory: " + std::to_string((mesh->generalBuffer.GetDesc().size + mesh->streamoutBuffer.GetDesc().size) / 1024.0f / 1024.0f) + " MB\n";
 		ss += "\nVertex buffers:\n";
-		if (!mesh->vertex_positions.empty()) ss += "\tposition;\n";
+		if (!mesh->vertex_positions.empty()) ss += mesh->positions_quantized ? "\tposition (quantized);\n" : "\tposition;\n";
 		if (!mesh->vertex_normals.empty()) ss += "\tnormal;\n";
 		if (!mesh->vertex_windweights.empty()) ss += "\twind;\n";
 		if (mesh->vb_uvs.IsValid()) ss += "\tuvsets;\n";
@@ -675,12 +651,14 @@ void MeshWindow::SetEntity(Entity entity, int subset)
 		}
 
 		doubleSidedCheckBox.SetCheck(mesh->IsDoubleSided());
+		quantizedPositionsCheckBox.SetCheck(mesh->IsQuantizedPositions());
 
 		const ImpostorComponent* impostor = scene.impostors.GetComponent(entity);
 		if (impostor != nullptr)
 		{
 			impostorCreateButton.SetText("Delete Impostor");
 			impostorDistanceSlider.SetValue(impostor->swapInDistance);
+			impostorResolutionSlider.SetValue((float)impostor->resolution);
 		}
 		else
 		{
@@ -761,8 +739,10 @@ void MeshWindow::ResizeLayout()
 	add(subsetComboBox);
 	add(subsetMaterialComboBox);
 	add_right(doubleSidedCheckBox);
+	add_right(quantizedPositionsCheckBox);
 	add_fullwidth(impostorCreateButton);
 	add(impostorDistanceSlider);
+	add(impostorResolutionSlider);
 	add(tessellationFactorSlider);
 	add_fullwidth(flipCullingButton);
 	add_fullwidth(flipNormalsButton);
@@ -772,6 +752,7 @@ void MeshWindow::ResizeLayout()
 	add_fullwidth(recenterToBottomButton);
 	add_fullwidth(mergeButton);
 	add_fullwidth(optimizeButton);
+	add_fullwidth(meshletButton);
 
 	add(morphTargetCombo);
 	add(morphTargetSlider);
@@ -17,8 +17,10 @@ public:
 	wi::gui::ComboBox subsetComboBox;
 	wi::gui::ComboBox subsetMaterialComboBox;
 	wi::gui::CheckBox doubleSidedCheckBox;
+	wi::gui::CheckBox quantizedPositionsCheckBox;
 	wi::gui::Button impostorCreateButton;
 	wi::gui::Slider impostorDistanceSlider;
+	wi::gui::Slider impostorResolutionSlider;
 	wi::gui::Slider tessellationFactorSlider;
 	wi::gui::Button flipCullingButton;
 	wi::gui::Button flipNormalsButton;
@@ -28,6 +30,7 @@ public:
 	wi::gui::Button recenterToBottomButton;
 	wi::gui::Button mergeButton;
 	wi::gui::Button optimizeButton;
+	wi::gui::Button meshletButton;
 
 	wi::gui::ComboBox morphTargetCombo;
 	wi::gui::Slider morphTargetSlider;
@@ -6,6 +6,25 @@ namespace wi::scene
 	struct Scene;
 }
 
-void ImportModel_OBJ(const std::string& fileName, wi::scene::Scene& scene);
-void ImportModel_GLTF(const std::string& fileName, wi::scene::Scene& scene);
+// optimize_meshes: meshes will be optimized for vertex cache, overdraw and vertex fetch with MeshComponent::Optimize()
+//	large meshes will also get a meshlet cluster hierarchy with MeshComponent::BuildMeshlets()
+static constexpr size_t meshlet_import_triangle_threshold = 16384;
+void ImportModel_OBJ(const std::string& fileName, wi::scene::Scene& scene, bool optimize_meshes = true);
+
+// Time spent in the import stages in milliseconds
+struct ImportStatistics_GLTF
+{
+	double parse = 0; // reading the file and parsing the json/binary container
+	double images = 0; // decoding the embedded and referenced images
+	double materials = 0;
+	double meshes = 0; // converting, optimizing and creating GPU buffers of meshes
+	double scene = 0; // nodes, armatures and skinning
+	double animations = 0;
+	double total = 0;
+	size_t image_count = 0;
+	size_t mesh_count = 0;
+	size_t animation_sampler_count = 0;
+};
+// statistics: if not nullptr, the time spent in the import stages will be written to it
+void ImportModel_GLTF(const std::string& fileName, wi::scene::Scene& scene, bool optimize_meshes = true, ImportStatistics_GLTF* statistics = nullptr);
 
@@ -23,6 +23,14 @@ using namespace wi::ecs;
 // Transform the data from glTF space to engine-space:
 static const bool transform_to_LH = true;
 
+// Images are only gathered while tinygltf parses the file, they are decoded in parallel after parsing:
+struct ImageLoadRequest
+{
+	std::string name; // uri of the image, every image with this uri will use the result
+	wi::vector<uint8_t> filedata;
+	wi::Resource resource;
+};
+
 
 namespace tinygltf
 {
@@ -95,6 +103,16 @@ namespace tinygltf
 	{
 		(void)warn;
 
+		wi::vector<ImageLoadRequest>& requests = *(wi::vector<ImageLoadRequest>*)userdata;
+		auto is_requested = [&](const std::string& name) {
+			for (auto& request : requests)
+			{
+				if (request.name == name)
+					return true;
+			}
+			return false;
+		};
+
 		if (image->uri.empty())
 		{
 			// Force some image resource name:
@@ -102,28 +120,18 @@ namespace tinygltf
 			do {
 				ss.clear();
 				ss += "gltfimport_" + std::to_string(wi::random::GetRandom(std::numeric_limits<int>::max())) + ".png";
-			} while (wi::resourcemanager::Contains(ss)); // this is to avoid overwriting an existing imported image
+			} while (wi::resourcemanager::Contains(ss) || is_requested(ss)); // this is to avoid overwriting an existing imported image
 			image->uri = ss;
 		}
-
-		auto resource = wi::resourcemanager::Load(
-			image->uri,
-			wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA,
-			(const uint8_t*)bytes,
-			(size_t)size
-		);
-
-		if (!resource.IsValid())
+		else if (is_requested(image->uri))
 		{
-			return false;
+			return true; // multiple images are referencing the same file, it will be decoded once
 		}
 
-		image->width = resource.GetTexture().desc.width;
-		image->height = resource.GetTexture().desc.height;
-		image->component = 4;
-
-		wi::resourcemanager::ResourceSerializer* seri = (wi::resourcemanager::ResourceSerializer*)userdata;
-		seri->resources.push_back(resource);
+		ImageLoadRequest& request = requests.emplace_back();
+		request.name = image->uri;
+		request.filedata.resize((size_t)size);
+		std::memcpy(request.filedata.data(), bytes, (size_t)size);
 
 		return true;
 	}
@@ -264,7 +272,7 @@ void LoadNode(int nodeIndex, Entity parent, LoaderState& state)
 	}
 }
 
-void ImportModel_GLTF(const std::string& fileName, Scene& scene)
+void ImportModel_GLTF(const std::string& fileName, Scene& scene, bool optimize_meshes, ImportStatistics_GLTF* statistics)
 {
 	std::string directory = wi::helper::GetDirectoryFromPath(fileName);
 	std::string name = wi::helper::GetFileNameFromPath(fileName);
@@ -284,12 +292,18 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	loader.SetFsCallbacks(callbacks);
 
 	wi::resourcemanager::ResourceSerializer seri; // keep this alive to not delete loaded images while importing gltf
-	loader.SetImageLoader(tinygltf::LoadImageData, &seri);
+	wi::vector<ImageLoadRequest> image_requests;
+	loader.SetImageLoader(tinygltf::LoadImageData, &image_requests);
 	loader.SetImageWriter(tinygltf::WriteImageData, nullptr);
 	
 	LoaderState state;
 	state.scene = &scene;
 
+	ImportStatistics_GLTF timings;
+	wi::Timer total_timer;
+	wi::Timer timer;
+	wi::jobsystem::context ctx;
+
 	wi::vector<uint8_t> filedata;
 	ret = wi::helper::FileRead(fileName, filedata);
 
@@ -318,6 +332,44 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	if (!ret) {
 		wi::helper::messageBox(err, "GLTF error!");
 	}
+	timings.parse = timer.record_elapsed_seconds() * 1000;
+
+	// Decode images in parallel, the results are collected in parsing order:
+	wi::jobsystem::Dispatch(ctx, (uint32_t)image_requests.size(), 1, [&](wi::jobsystem::JobArgs args) {
+		ImageLoadRequest& request = image_requests[args.jobIndex];
+		request.resource = wi::resourcemanager::Load(
+			request.name,
+			wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA,
+			request.filedata.data(),
+			request.filedata.size()
+		);
+		request.filedata = {};
+	});
+	wi::jobsystem::Wait(ctx);
+	wi::unordered_map<std::string, const wi::Resource*> decoded_images;
+	for (auto& request : image_requests)
+	{
+		if (!request.resource.IsValid())
+		{
+			wi::backlog::post("GLTF image decoding failed: " + request.name, wi::backlog::LogLevel::Warning);
+			continue;
+		}
+		decoded_images[request.name] = &request.resource;
+		seri.resources.push_back(request.resource);
+	}
+	// Images that are referencing the same file were decoded once, but all of them receive the dimensions:
+	for (auto& image : state.gltfModel.images)
+	{
+		auto it = decoded_images.find(image.uri);
+		if (it == decoded_images.end())
+			continue;
+		image.width = it->second->GetTexture().desc.width;
+		image.height = it->second->GetTexture().desc.height;
+		image.component = 4;
+	}
+	timings.images = timer.record_elapsed_seconds() * 1000;
+	timings.image_count = image_requests.size();
+	image_requests.clear();
 
 	state.rootEntity = CreateEntity();
 	scene.transforms.Create(state.rootEntity);
@@ -769,13 +821,23 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	{
 		scene.Entity_CreateMaterial("gltfimport_defaultMaterial");
 	}
+	timings.materials = timer.record_elapsed_seconds() * 1000;
 
 	// Create meshes:
-	for (auto& x : state.gltfModel.meshes)
+	//	The entities are created in glTF order, then each mesh is converted, optimized and uploaded in parallel
+	//	The primitives of a glTF mesh are appended into the same MeshComponent, so the mesh is the unit of work
+	const uint32_t mesh_count = (uint32_t)state.gltfModel.meshes.size();
+	wi::vector<Entity> mesh_entities(mesh_count);
+	for (uint32_t meshIndex = 0; meshIndex < mesh_count; ++meshIndex)
 	{
-		Entity meshEntity = scene.Entity_CreateMesh(x.name);
+		Entity meshEntity = scene.Entity_CreateMesh(state.gltfModel.meshes[meshIndex].name);
 		scene.Component_Attach(meshEntity, state.rootEntity);
-		MeshComponent& mesh = *scene.meshes.GetComponent(meshEntity);
+		mesh_entities[meshIndex] = meshEntity;
+	}
+	wi::vector<MeshComponent::OptimizationStatistics> mesh_statistics(mesh_count);
+	wi::jobsystem::Dispatch(ctx, mesh_count, 1, [&](wi::jobsystem::JobArgs args) {
+		const tinygltf::Mesh& x = state.gltfModel.meshes[args.jobIndex];
+		MeshComponent& mesh = *scene.meshes.GetComponent(mesh_entities[args.jobIndex]);
 
 		for (auto& prim : x.primitives)
 		{
@@ -796,7 +858,6 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 			mesh.subsets.back().indexCount = (uint32_t)indexCount;
 
 			mesh.subsets.back().materialID = scene.materials.GetEntity(std::max(0, prim.material));
-			MaterialComponent* material = scene.materials.GetComponent(mesh.subsets.back().materialID);
 
 			uint32_t vertexOffset = (uint32_t)mesh.vertex_positions.size();
 
@@ -1126,10 +1187,6 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 				}
 				else if (!attr_name.compare("COLOR_0"))
 				{
-					if(material != nullptr)
-					{
-						material->SetUseVertexColors(true);
-					}
 					mesh.vertex_colors.resize(vertexOffset + vertexCount);
 					if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT)
 					{
@@ -1351,8 +1408,48 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 			mesh.morph_targets[i].weight = static_cast<float_t>(x.weights[i]);
 		}
 
+		if (optimize_meshes)
+		{
+			mesh.Optimize(&mesh_statistics[args.jobIndex]);
+			if (mesh.indices.size() / 3 >= meshlet_import_triangle_threshold)
+			{
+				mesh.BuildMeshlets();
+			}
+		}
+
 		mesh.CreateRenderData();
+	});
+	wi::jobsystem::Wait(ctx);
+
+	// Materials are shared between meshes, so they are only modified after the parallel part:
+	for (auto& x : state.gltfModel.meshes)
+	{
+		for (auto& prim : x.primitives)
+		{
+			if (prim.attributes.count("COLOR_0") > 0)
+			{
+				MaterialComponent* material = scene.materials.GetComponent(scene.materials.GetEntity(std::max(0, prim.material)));
+				if (material != nullptr)
+				{
+					material->SetUseVertexColors(true);
+				}
+			}
+		}
+	}
+
+	MeshComponent::OptimizationStatistics optimized;
+	if (optimize_meshes)
+	{
+		for (uint32_t meshIndex = 0; meshIndex < mesh_count; ++meshIndex)
+		{
+			const MeshComponent& mesh = *scene.meshes.GetComponent(mesh_entities[meshIndex]);
+			optimized.Accumulate(mesh_statistics[meshIndex], mesh.indices.size());
+		}
 	}
+	timings.meshes = timer.record_elapsed_seconds() * 1000;
+	timings.mesh_count = mesh_count;
+
+	optimized.Log("GLTF mesh optimization: " + name);
 
 	// Create armatures:
 	for (auto& skin : state.gltfModel.skins)
@@ -1405,7 +1502,19 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 		}
 	}
 
+	timings.scene = timer.record_elapsed_seconds() * 1000;
+
 	// Create animations:
+	//	The entities are created in glTF order, then the keyframes of the samplers are converted in parallel
+	struct SamplerConversion
+	{
+		const tinygltf::AnimationSampler* sam = nullptr;
+		Entity animation = INVALID_ENTITY;
+		Entity data = INVALID_ENTITY;
+		float start = std::numeric_limits<float>::max();
+		float end = std::numeric_limits<float>::lowest();
+	};
+	wi::vector<SamplerConversion> sampler_conversions;
 	for (auto& anim : state.gltfModel.animations)
 	{
 		Entity entity = CreateEntity();
@@ -1434,8 +1543,53 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 
 			animationcomponent.samplers[i].data = CreateEntity();
 			scene.Component_Attach(animationcomponent.samplers[i].data, state.rootEntity);
-			AnimationDataComponent& animationdata = scene.animation_datas.Create(animationcomponent.samplers[i].data);
+			scene.animation_datas.Create(animationcomponent.samplers[i].data);
+
+			SamplerConversion& conversion = sampler_conversions.emplace_back();
+			conversion.sam = &sam;
+			conversion.animation = entity;
+			conversion.data = animationcomponent.samplers[i].data;
+		}
+
+		for (size_t i = 0; i < anim.channels.size(); ++i)
+		{
+			auto& channel = anim.channels[i];
+
+			animationcomponent.channels[i].target = state.entityMap[channel.target_node];
+			assert(channel.sampler >= 0);
+			animationcomponent.channels[i].samplerIndex = (uint32_t)channel.sampler;
 
+			if (!channel.target_path.compare("scale"))
+			{
+				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::SCALE;
+			}
+			else if (!channel.target_path.compare("rotation"))
+			{
+				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::ROTATION;
+			}
+			else if (!channel.target_path.compare("translation"))
+			{
+				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::TRANSLATION;
+			}
+			else if (!channel.target_path.compare("weights"))
+			{
+				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::WEIGHTS;
+			}
+			else
+			{
+				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::UNKNOWN;
+			}
+		}
+
+	}
+
+	// The component storage doesn't change while converting, so the components can be filled in parallel:
+	wi::jobsystem::Dispatch(ctx, (uint32_t)sampler_conversions.size(), 1, [&](wi::jobsystem::JobArgs args) {
+		SamplerConversion& conversion = sampler_conversions[args.jobIndex];
+		const tinygltf::AnimationSampler& sam = *conversion.sam;
+		AnimationDataComponent& animationdata = *scene.animation_datas.GetComponent(conversion.data);
+
+		{
 			// AnimationSampler input = keyframe times
 			{
 				const tinygltf::Accessor& accessor = state.gltfModel.accessors[sam.input];
@@ -1457,8 +1611,8 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 				{
 					float time = ((float*)data)[j];
 					animationdata.keyframe_times[j] = time;
-					animationcomponent.start = std::min(animationcomponent.start, time);
-					animationcomponent.end = std::max(animationcomponent.end, time);
+					conversion.start = std::min(conversion.start, time);
+					conversion.end = std::max(conversion.end, time);
 				}
 
 			}
@@ -1513,38 +1667,17 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 			}
 
 		}
+	});
+	wi::jobsystem::Wait(ctx);
 
-		for (size_t i = 0; i < anim.channels.size(); ++i)
-		{
-			auto& channel = anim.channels[i];
-
-			animationcomponent.channels[i].target = state.entityMap[channel.target_node];
-			assert(channel.sampler >= 0);
-			animationcomponent.channels[i].samplerIndex = (uint32_t)channel.sampler;
-
-			if (!channel.target_path.compare("scale"))
-			{
-				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::SCALE;
-			}
-			else if (!channel.target_path.compare("rotation"))
-			{
-				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::ROTATION;
-			}
-			else if (!channel.target_path.compare("translation"))
-			{
-				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::TRANSLATION;
-			}
-			else if (!channel.target_path.compare("weights"))
-			{
-				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::WEIGHTS;
-			}
-			else
-			{
-				animationcomponent.channels[i].path = AnimationComponent::AnimationChannel::Path::UNKNOWN;
-			}
-		}
-
+	for (auto& conversion : sampler_conversions)
+	{
+		AnimationComponent& animationcomponent = *scene.animations.GetComponent(conversion.animation);
+		animationcomponent.start = std::min(animationcomponent.start, conversion.start);
+		animationcomponent.end = std::max(animationcomponent.end, conversion.end);
 	}
+	timings.animations = timer.record_elapsed_seconds() * 1000;
+	timings.animation_sampler_count = sampler_conversions.size();
 
 	// Create lights:
 	int lightIndex = 0;
@@ -1606,6 +1739,22 @@ void ImportModel_GLTF(const std::string& fileName, Scene& scene)
 	// Update the scene, to have up to date values immediately after loading:
 	//	For example, snap to camera functionality relies on this
 	scene.Update(0);
+
+	timings.total = total_timer.elapsed_milliseconds();
+	wi::backlog::post(
+		"GLTF import timings: " + fileName +
+		"\n\tparse: " + std::to_string(timings.parse) + " ms" +
+		"\n\timages: " + std::to_string(timings.images) + " ms (" + std::to_string(timings.image_count) + " images)" +
+		"\n\tmaterials: " + std::to_string(timings.materials) + " ms" +
+		"\n\tmeshes: " + std::to_string(timings.meshes) + " ms (" + std::to_string(timings.mesh_count) + " meshes)" +
+		"\n\tscene: " + std::to_string(timings.scene) + " ms" +
+		"\n\tanimations: " + std::to_string(timings.animations) + " ms (" + std::to_string(timings.animation_sampler_count) + " samplers)" +
+		"\n\ttotal: " + std::to_string(timings.total) + " ms"
+	);
+	if (statistics != nullptr)
+	{
+		*statistics = timings;
+	}
 }
 
 void Import_Extension_VRM(LoaderState& state)
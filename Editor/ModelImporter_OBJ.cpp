@@ -72,7 +72,7 @@ private:
 // Transform the data from OBJ space to engine-space:
 static const bool transform_to_LH = true;
 
-void ImportModel_OBJ(const std::string& fileName, Scene& scene)
+void ImportModel_OBJ(const std::string& fileName, Scene& scene, bool optimize_meshes)
 {
 	std::string directory = wi::helper::GetDirectoryFromPath(fileName);
 	std::string name = wi::helper::GetFileNameFromPath(fileName);
@@ -161,6 +161,7 @@ void ImportModel_OBJ(const std::string& fileName, Scene& scene)
 		}
 
 		// Load objects, meshes:
+		MeshComponent::OptimizationStatistics optimized;
 		for (auto& shape : obj_shapes)
 		{
 			Entity objectEntity = scene.Entity_CreateObject(shape.name);
@@ -251,9 +252,24 @@ void ImportModel_OBJ(const std::string& fileName, Scene& scene)
 					mesh.subsets.back().indexCount++;
 				}
 			}
+
+			if (optimize_meshes)
+			{
+				MeshComponent::OptimizationStatistics statistics;
+				mesh.Optimize(&statistics);
+				optimized.Accumulate(statistics, mesh.indices.size());
+
+				if (mesh.indices.size() / 3 >= meshlet_import_triangle_threshold)
+				{
+					mesh.BuildMeshlets();
+				}
+			}
+
 			mesh.CreateRenderData();
 		}
 
+		optimized.Log("OBJ mesh optimization: " + name);
+
 	}
 	else
 	{
@@ -29,6 +29,8 @@ public:
 	wi::gui::Button stopLightmapGenButton;
 	wi::gui::Button clearLightmapButton;
 
+	wi::scene::MeshComponent::AtlasCache atlasCache;
+
 	void ResizeLayout() override;
 };
 
@@ -6,6 +6,7 @@
 #include <thread>
 #include <unordered_map>
 #include <vector>
+#include <filesystem>
 
 using namespace wi::ecs;
 using namespace wi::scene;
@@ -32,6 +33,29 @@ enum TEST_TYPE
 	INVERSEKINEMATICSTEST,
 	INSTANCESTEST,
 	CONTAINERPERF,
+	ASYNCRESOURCELOADINGTEST,
+	RESOURCECACHETEST,
+	TEXTURESTREAMINGTEST,
+	PACKAGETEST,
+	TEXTURETRANSCODINGTEST,
+	NOISEPERFTEST,
+	TERRAINGENERATIONTEST,
+	TERRAINDISKCACHETEST,
+	TERRAINHEIGHTQUERYTEST,
+	PHYSICSQUERYTEST,
+	PHYSICSSIMULATIONTEST,
+	PHYSICSFIXEDTIMESTEPTEST,
+	PHYSICSSHAPECACHETEST,
+	SPRINGCOLLIDERTEST,
+	INVERSEKINEMATICSPERFTEST,
+	MORPHTARGETPERFTEST,
+	LODGENERATIONTEST,
+	MESHOPTIMIZATIONTEST,
+	VERTEXQUANTIZATIONTEST,
+	MESHLETCULLINGTEST,
+	COMPUTENORMALSTEST,
+	ATLASGENERATIONTEST,
+	IMPOSTORLODTEST,
 };
 
 // Controller Test UI Data, info down below will be using Xbox Controller as reference
@@ -163,6 +187,29 @@ void TestsRenderer::Load()
 	testSelector.AddItem("Inverse Kinematics", INVERSEKINEMATICSTEST);
 	testSelector.AddItem("65k Instances", INSTANCESTEST);
 	testSelector.AddItem("Container perf", CONTAINERPERF);
+	testSelector.AddItem("Async resource loading", ASYNCRESOURCELOADINGTEST);
+	testSelector.AddItem("Resource cache", RESOURCECACHETEST);
+	testSelector.AddItem("Texture streaming", TEXTURESTREAMINGTEST);
+	testSelector.AddItem("Package loading", PACKAGETEST);
+	testSelector.AddItem("KTX2 transcoding", TEXTURETRANSCODINGTEST);
+	testSelector.AddItem("Noise performance", NOISEPERFTEST);
+	testSelector.AddItem("Terrain generation", TERRAINGENERATIONTEST);
+	testSelector.AddItem("Terrain disk cache", TERRAINDISKCACHETEST);
+	testSelector.AddItem("Terrain height query", TERRAINHEIGHTQUERYTEST);
+	testSelector.AddItem("Physics queries", PHYSICSQUERYTEST);
+	testSelector.AddItem("Physics simulation", PHYSICSSIMULATIONTEST);
+	testSelector.AddItem("Physics fixed time step", PHYSICSFIXEDTIMESTEPTEST);
+	testSelector.AddItem("Physics shape cache", PHYSICSSHAPECACHETEST);
+	testSelector.AddItem("Spring colliders", SPRINGCOLLIDERTEST);
+	testSelector.AddItem("Inverse kinematics performance", INVERSEKINEMATICSPERFTEST);
+	testSelector.AddItem("Morph target performance", MORPHTARGETPERFTEST);
+	testSelector.AddItem("LOD generation", LODGENERATIONTEST);
+	testSelector.AddItem("Mesh optimization", MESHOPTIMIZATIONTEST);
+	testSelector.AddItem("Vertex quantization", VERTEXQUANTIZATIONTEST);
+	testSelector.AddItem("Meshlet culling", MESHLETCULLINGTEST);
+	testSelector.AddItem("Compute normals", COMPUTENORMALSTEST);
+	testSelector.AddItem("Lightmap atlas generation", ATLASGENERATIONTEST);
+	testSelector.AddItem("Impostor LOD selection", IMPOSTORLODTEST);
 	testSelector.SetMaxVisibleItemCount(10);
 	testSelector.OnSelect([=](wi::gui::EventArgs args) {
 
@@ -418,6 +465,77 @@ void TestsRenderer::Load()
 			ContainerTest();
 			break;
 
+		case ASYNCRESOURCELOADINGTEST:
+			RunAsyncResourceLoadingTest();
+			break;
+
+		case RESOURCECACHETEST:
+			RunResourceCacheTest();
+			break;
+		case TEXTURESTREAMINGTEST:
+			RunTextureStreamingTest();
+			break;
+		case PACKAGETEST:
+			RunPackageTest();
+			break;
+		case TEXTURETRANSCODINGTEST:
+			RunTextureTranscodingTest();
+			break;
+		case NOISEPERFTEST:
+			RunNoisePerformanceTest();
+			break;
+		case TERRAINGENERATIONTEST:
+			RunTerrainGenerationTest();
+			break;
+		case TERRAINDISKCACHETEST:
+			RunTerrainDiskCacheTest();
+			break;
+		case TERRAINHEIGHTQUERYTEST:
+			RunTerrainHeightQueryTest();
+			break;
+		case PHYSICSQUERYTEST:
+			RunPhysicsQueryTest();
+			break;
+		case PHYSICSSIMULATIONTEST:
+			RunPhysicsSimulationTest();
+			break;
+		case PHYSICSFIXEDTIMESTEPTEST:
+			RunPhysicsFixedTimeStepTest();
+			break;
+		case PHYSICSSHAPECACHETEST:
+			RunPhysicsShapeCacheTest();
+			break;
+		case SPRINGCOLLIDERTEST:
+			RunSpringColliderTest();
+			break;
+		case INVERSEKINEMATICSPERFTEST:
+			RunInverseKinematicsPerformanceTest();
+			break;
+		case MORPHTARGETPERFTEST:
+			RunMorphTargetPerformanceTest();
+			break;
+		case LODGENERATIONTEST:
+			RunLODGenerationTest();
+			break;
+		case MESHOPTIMIZATIONTEST:
+			RunMeshOptimizationTest();
+			break;
+		case VERTEXQUANTIZATIONTEST:
+			RunVertexQuantizationTest();
+			break;
+		case MESHLETCULLINGTEST:
+			RunMeshletCullingTest();
+			break;
+		case COMPUTENORMALSTEST:
+			RunComputeNormalsTest();
+			break;
+		case ATLASGENERATIONTEST:
+			RunAtlasGenerationTest();
+			break;
+		case IMPOSTORLODTEST:
+			RunImpostorLODTest();
+			break;
+
 		default:
 			assert(0);
 			break;
@@ -1256,3 +1374,2629 @@ void TestsRenderer::ContainerTest()
 	font.params.size = 24;
 	this->AddFont(&font);
 }
+
+void TestsRenderer::RunAsyncResourceLoadingTest()
+{
+	wi::Timer timer;
+
+	const uint32_t unique_count = 200;
+	const uint32_t load_count = 1000;
+
+	// Generate unique image files first:
+	const std::string directory = wi::helper::GetTempDirectoryPath() + "wi_async_resource_loading_test/";
+	wi::helper::DirectoryCreate(directory);
+	wi::vector<std::string> names(load_count);
+	{
+		wi::graphics::TextureDesc desc;
+		desc.width = 256;
+		desc.height = 256;
+		desc.format = wi::graphics::Format::R8G8B8A8_UNORM;
+		wi::vector<uint8_t> texturedata(desc.width * desc.height * sizeof(uint32_t));
+		for (uint32_t i = 0; i < unique_count; ++i)
+		{
+			std::string name = directory + "image_" + std::to_string(i) + ".png";
+			if (!wi::helper::FileExists(name))
+			{
+				for (size_t j = 0; j < texturedata.size(); ++j)
+				{
+					texturedata[j] = uint8_t(i * 7 + j * 13);
+				}
+				wi::helper::saveTextureToFile(texturedata, desc, name);
+			}
+		}
+		for (uint32_t i = 0; i < load_count; ++i)
+		{
+			names[i] = directory + "image_" + std::to_string(i % unique_count) + ".png";
+		}
+	}
+
+	std::string ss = "Async resource loading test: " + std::to_string(load_count) + " loads of " + std::to_string(unique_count) + " unique files\n";
+	ss += "You can find out more in Tests.cpp, RunAsyncResourceLoadingTest() function.\n\n";
+
+	// Synchronous loading on this thread:
+	{
+		wi::vector<wi::Resource> resources(load_count);
+		timer.record();
+		for (uint32_t i = 0; i < load_count; ++i)
+		{
+			resources[i] = wi::resourcemanager::Load(names[i]);
+		}
+		ss += "wi::resourcemanager::Load() took " + std::to_string(timer.elapsed_milliseconds()) + " ms\n";
+	}
+	wi::resourcemanager::Clear();
+
+	// Asynchronous loading, every request is issued at once:
+	static wi::SpriteFont font;
+	{
+		timer.record();
+		wi::vector<wi::resourcemanager::LoadFuture> futures = wi::resourcemanager::LoadAsyncBatch(names, wi::resourcemanager::Flags::NONE, [=](const wi::vector<wi::Resource>& resources) {
+			// This is called on the main thread when all the loads are finished:
+			uint32_t valid = 0;
+			for (auto& x : resources)
+			{
+				valid += x.IsValid() ? 1 : 0;
+			}
+			font.SetText(font.GetTextA() + "Batch completion callback received " + std::to_string(valid) + " valid resources\n");
+		});
+		const double issue_time = timer.elapsed_milliseconds();
+
+		wi::unordered_map<std::string, void*> unique_resources;
+		bool deduplicated = true;
+		for (uint32_t i = 0; i < load_count; ++i)
+		{
+			wi::Resource resource = futures[i].Get();
+			auto it = unique_resources.find(names[i]);
+			if (it == unique_resources.end())
+			{
+				unique_resources[names[i]] = resource.internal_state.get();
+			}
+			else if (it->second != resource.internal_state.get())
+			{
+				deduplicated = false;
+			}
+		}
+		ss += "wi::resourcemanager::LoadAsyncBatch() took " + std::to_string(timer.elapsed_milliseconds()) + " ms (issuing took " + std::to_string(issue_time) + " ms)\n";
+		ss += "Unique resources: " + std::to_string(unique_resources.size()) + (deduplicated ? " (deduplicated correctly)\n" : " (deduplication FAILED)\n");
+	}
+
+	// A default constructed future is ready and returns an invalid resource:
+	{
+		wi::resourcemanager::LoadFuture future;
+		const bool ok = future.IsReady() && !future.Get().IsValid();
+		ss += std::string("Invalid future: ") + (ok ? "OK\n" : "FAILED\n");
+	}
+
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunResourceCacheTest()
+{
+	// Script files are used, because their memory size is exactly their file size:
+	const size_t file_size = 1024;
+	const uint32_t file_count = 12;
+	const std::string directory = wi::helper::GetTempDirectoryPath() + "wi_resource_cache_test/";
+	wi::helper::DirectoryCreate(directory);
+	wi::vector<std::string> names(file_count);
+	for (uint32_t i = 0; i < file_count; ++i)
+	{
+		names[i] = directory + "script_" + std::to_string(i) + ".lua";
+		std::string script = "-- " + std::to_string(i) + "\n";
+		script.resize(file_size, '-');
+		wi::helper::FileWrite(names[i], (const uint8_t*)script.data(), script.size());
+	}
+
+	std::string ss = "Resource cache test:\n";
+	ss += "You can find out more in Tests.cpp, RunResourceCacheTest() function.\n\n";
+	bool success = true;
+	auto check = [&](bool condition, const std::string& description) {
+		ss += description + (condition ? ": OK\n" : ": FAILED\n");
+		success &= condition;
+	};
+
+	wi::resourcemanager::Clear();
+	wi::resourcemanager::ResetCacheStatistics();
+	const size_t budget = 10 * file_size;
+	wi::resourcemanager::SetCacheBudget(budget, 0);
+
+	// Load 8 resources, they are released immediately but kept alive by the cache:
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		wi::resourcemanager::Load(names[i]);
+	}
+	bool all_cached = true;
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		all_cached &= wi::resourcemanager::Contains(names[i]);
+	}
+	check(all_cached, "Released resources are kept alive by the cache");
+
+	// Reload the first one, this will be a hit and makes it the most recently used:
+	wi::resourcemanager::Load(names[0]);
+	wi::resourcemanager::CacheStatistics stats = wi::resourcemanager::GetCacheStatistics();
+	check(stats.hits == 1 && stats.misses == 8, "Hit/miss counters (hits: " + std::to_string(stats.hits) + ", misses: " + std::to_string(stats.misses) + ")");
+
+	// Keep one of the least recently used resources referenced, it leaves the cache and doesn't count toward the budget:
+	wi::Resource referenced = wi::resourcemanager::Load(names[1]);
+
+	// Load 4 more resources, exceeding the budget by 1 resource:
+	for (uint32_t i = 8; i < file_count; ++i)
+	{
+		wi::resourcemanager::Load(names[i]);
+	}
+	stats = wi::resourcemanager::GetCacheStatistics();
+	check(stats.cached_cpu_usage <= budget, "Budget compliance (" + std::to_string(stats.cached_cpu_usage) + " / " + std::to_string(budget) + " bytes)");
+	check(stats.evictions == 1, "Eviction count (" + std::to_string(stats.evictions) + ")");
+
+	// Size reporting:
+	bool sizes = true;
+	for (auto& info : wi::resourcemanager::GetResourceInfos())
+	{
+		sizes &= info.cpu_size == file_size && info.gpu_size == 0;
+		sizes &= info.referenced == (info.name == names[1]);
+		sizes &= info.cached != info.referenced;
+	}
+	check(sizes, "Per-resource sizes and references");
+
+	// Releasing the last reference puts the resource into the cache, which evicts the least recently released one:
+	referenced = {};
+	stats = wi::resourcemanager::GetCacheStatistics();
+	check(stats.evictions == 2 && stats.cached_cpu_usage <= budget, "Eviction on release (" + std::to_string(stats.evictions) + ")");
+
+	// Order of release was: 2, 3, 4, 5, 6, 7, 0, 8, 9, 10, 11, 1, so 2 and 3 must be evicted
+	bool eviction_order = true;
+	for (uint32_t i = 0; i < file_count; ++i)
+	{
+		const bool expected = i != 2 && i != 3;
+		eviction_order &= wi::resourcemanager::Contains(names[i]) == expected;
+	}
+	check(eviction_order, "Eviction order (least recently released first)");
+
+	// Shrinking the budget evicts everything that doesn't fit:
+	wi::resourcemanager::SetCacheBudget(file_size, 0);
+	stats = wi::resourcemanager::GetCacheStatistics();
+	check(stats.resource_count == 1 && stats.cached_count == 1 && wi::resourcemanager::Contains(names[1]), "Shrinking budget");
+
+	wi::resourcemanager::SetCacheBudget(0, 0);
+	wi::resourcemanager::Clear();
+
+	ss += success ? "\nAll tests passed!" : "\nThere were failures!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunTextureStreamingTest()
+{
+	// This simulates the streaming decisions of many high resolution textures with changing resolution requests
+	//	The simulation doesn't create GPU resources, it only tests wi::resourcemanager::ComputeStreamingResidency()
+	//	After that, a streaming texture is saved into an archive with embedded resources and loaded back
+	const uint32_t texture_count = 300;
+	const uint32_t frame_count = 60;
+	const size_t budget = 256ull * 1024ull * 1024ull;
+
+	wi::vector<wi::resourcemanager::StreamingResidencyRequest> requests(texture_count);
+	for (auto& request : requests)
+	{
+		request.desc.width = 4096;
+		request.desc.height = 4096;
+		request.desc.mip_levels = 13;
+		request.desc.format = wi::graphics::Format::BC1_UNORM;
+		request.base_mips = 6;
+	}
+	const size_t full_size = wi::graphics::ComputeTextureMemorySizeInBytes(requests[0].desc);
+
+	std::string ss = "Texture streaming test:\n";
+	ss += "You can find out more in Tests.cpp, RunTextureStreamingTest() function.\n\n";
+	ss += std::to_string(texture_count) + " textures of 4096x4096 BC1, full size: " + std::to_string(texture_count * full_size / 1024 / 1024) + " MB\n";
+	ss += "Streaming budget: " + std::to_string(budget / 1024 / 1024) + " MB\n\n";
+
+	bool budget_compliance = true;
+	bool fairness = true;
+	bool no_overstreaming = true;
+	size_t max_usage = 0;
+	double time = 0;
+	wi::vector<uint32_t> resident_mips(texture_count);
+	for (uint32_t frame = 0; frame < frame_count; ++frame)
+	{
+		for (auto& request : requests)
+		{
+			// Some textures are not visible, others are requested in random screen sizes:
+			request.resolution = wi::random::GetRandom(0, 3) == 0 ? 0 : wi::random::GetRandom(1, 4096);
+		}
+
+		wi::Timer timer;
+		size_t usage = wi::resourcemanager::ComputeStreamingResidency(requests.data(), requests.size(), budget, resident_mips.data());
+		time += timer.elapsed();
+
+		budget_compliance &= usage <= budget;
+		max_usage = std::max(max_usage, usage);
+
+		// The highest resolution of a resident streamed mip must not exceed the lowest resolution that was requested but didn't fit:
+		uint32_t max_resident = 0;
+		uint32_t min_missing = ~0u;
+		for (uint32_t i = 0; i < texture_count; ++i)
+		{
+			const auto& request = requests[i];
+			const uint32_t resident = 4096u >> (request.desc.mip_levels - resident_mips[i]);
+			if (resident_mips[i] > request.base_mips)
+			{
+				max_resident = std::max(max_resident, resident);
+			}
+			if (request.resolution > resident)
+			{
+				min_missing = std::min(min_missing, resident * 2);
+			}
+			if (request.resolution == 0)
+			{
+				no_overstreaming &= resident_mips[i] == request.base_mips;
+			}
+			else if (resident_mips[i] > request.base_mips)
+			{
+				no_overstreaming &= (resident / 2) < request.resolution;
+			}
+		}
+		fairness &= max_resident <= min_missing;
+	}
+
+	ss += "Budget compliance: " + std::string(budget_compliance ? "OK" : "FAILED") + " (peak usage: " + std::to_string(max_usage / 1024 / 1024) + " MB)\n";
+	ss += "Lower resolutions are streamed first: " + std::string(fairness ? "OK" : "FAILED") + "\n";
+	ss += "Only requested resolutions are streamed: " + std::string(no_overstreaming ? "OK" : "FAILED") + "\n";
+	ss += "Average residency update time: " + std::to_string(time / frame_count) + " ms\n";
+	ss += "Streaming enabled in engine: " + std::string(wi::resourcemanager::IsStreamingEnabled() ? "yes" : "no") + "\n";
+
+	// Saving a scene with embedded resources must also embed the streaming textures, which don't keep their file data in memory:
+	{
+		const std::string filename = "../Content/models/grid.dds";
+		const size_t streaming_budget = wi::resourcemanager::GetStreamingMemoryBudget();
+		const wi::resourcemanager::Mode mode = wi::resourcemanager::GetMode();
+		wi::resourcemanager::SetStreamingMemoryBudget(64ull * 1024ull * 1024ull);
+		wi::resourcemanager::SetMode(wi::resourcemanager::Mode::ALLOW_RETAIN_FILEDATA);
+
+		wi::Resource resource = wi::resourcemanager::Load(filename, wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA | wi::resourcemanager::Flags::STREAMING);
+		bool streamed = false;
+		for (auto& info : wi::resourcemanager::GetResourceInfos())
+		{
+			streamed |= info.name == filename && info.cpu_size == 0;
+		}
+
+		wi::Archive archive;
+		wi::resourcemanager::ResourceSerializer seri;
+		wi::resourcemanager::Serialize(archive, seri);
+
+		wi::vector<uint8_t> filedata;
+		wi::helper::FileRead(filename, filedata);
+		bool embedded = false;
+		archive.SetReadModeAndResetPos(true);
+		size_t serializable_count = 0;
+		archive >> serializable_count;
+		for (size_t i = 0; i < serializable_count; ++i)
+		{
+			std::string name;
+			uint32_t flags = 0;
+			wi::vector<uint8_t> data;
+			archive >> name;
+			archive >> flags;
+			archive >> data;
+			embedded |= name == filename && !data.empty() && data == filedata;
+		}
+
+		// Load the archive again after the original resource was released, the texture is created from the embedded file data:
+		resource = {};
+		bool reloaded = false;
+		if (!wi::resourcemanager::Contains(filename))
+		{
+			archive.SetReadModeAndResetPos(true);
+			wi::resourcemanager::Serialize(archive, seri);
+			for (auto& x : seri.resources)
+			{
+				reloaded |= x.IsValid() && x.GetTexture().desc.width == 256 && x.GetTexture().desc.mip_levels == 9;
+			}
+		}
+		seri.resources.clear();
+
+		wi::resourcemanager::SetMode(mode);
+		wi::resourcemanager::SetStreamingMemoryBudget(streaming_budget);
+
+		ss += "\nStreaming texture without file data in memory: " + std::string(streamed ? "OK" : "FAILED") + "\n";
+		ss += "Streaming texture embedded when saving: " + std::string(embedded ? "OK" : "FAILED") + "\n";
+		ss += "Embedded streaming texture loaded: " + std::string(reloaded ? "OK" : "FAILED (the resource is kept alive by the cache)") + "\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunPackageTest()
+{
+	// Startup loading of many small assets, as loose files and from a package
+	const uint32_t file_count = 10000;
+	const std::string directory = wi::helper::GetTempDirectoryPath() + "wi_package_test/";
+	const std::string package_filename = wi::helper::GetTempDirectoryPath() + "wi_package_test.wipkg";
+	wi::helper::DirectoryCreate(directory);
+	wi::vector<std::string> names(file_count);
+	wi::vector<wi::package::Entry> entries(file_count);
+	for (uint32_t i = 0; i < file_count; ++i)
+	{
+		names[i] = "script_" + std::to_string(i) + ".lua";
+		std::string script = "-- " + std::to_string(i % 1000) + "\n"; // every 10th file has the same content
+		script.resize(2048, '-');
+		wi::helper::FileWrite(directory + names[i], (const uint8_t*)script.data(), script.size());
+		entries[i].name = names[i];
+		entries[i].filename = directory + names[i];
+	}
+
+	std::string ss = "Package test:\n";
+	ss += "You can find out more in Tests.cpp, RunPackageTest() function.\n\n";
+
+	wi::Timer timer;
+	wi::package::WriteStatistics statistics;
+	bool success = wi::package::Write(package_filename, entries, &statistics);
+	ss += "Package creation: " + std::to_string(timer.elapsed()) + " ms (" + std::to_string(statistics.file_count) + " files, " + std::to_string(statistics.unique_count) + " unique payloads, " + std::to_string(statistics.package_size / 1024) + " KB)\n";
+
+	// Loose files:
+	wi::resourcemanager::Clear();
+	timer.record();
+	wi::vector<wi::Resource> resources(file_count);
+	for (uint32_t i = 0; i < file_count; ++i)
+	{
+		resources[i] = wi::resourcemanager::Load(directory + names[i]);
+		success &= resources[i].IsValid();
+	}
+	ss += "Loading loose files: " + std::to_string(timer.elapsed()) + " ms\n";
+	resources.clear();
+	resources.resize(file_count);
+	wi::resourcemanager::Clear();
+
+	// Mounted package, the same resource names are used:
+	timer.record();
+	success &= wi::resourcemanager::MountPackage(package_filename, directory);
+	for (uint32_t i = 0; i < file_count; ++i)
+	{
+		resources[i] = wi::resourcemanager::Load(directory + names[i]);
+		success &= resources[i].IsValid() && resources[i].GetScript().size() == 2048;
+	}
+	ss += "Mounting package and loading: " + std::to_string(timer.elapsed()) + " ms\n";
+	success &= wi::resourcemanager::IsInMountedPackage(directory + names[0]) && !wi::resourcemanager::IsInMountedPackage(directory + "missing.lua");
+	resources.clear();
+	wi::resourcemanager::Clear();
+	wi::resourcemanager::UnmountPackage(package_filename);
+
+	ss += "(Files were just written, so the operating system's file cache is warm. Measuring a real cold start requires flushing it.)\n";
+	ss += success ? "\nAll tests passed!" : "\nThere were failures!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunTextureTranscodingTest()
+{
+	const uint32_t texture_count = 4;
+	const uint32_t resolution = 4096;
+
+	// Generate 4K KTX2 textures with full mip chains, this is slow, so they are kept in the temp directory:
+	const std::string directory = wi::helper::GetTempDirectoryPath() + "wi_texture_transcoding_test/";
+	wi::helper::DirectoryCreate(directory);
+	wi::vector<std::string> names(texture_count);
+	wi::Timer timer;
+	{
+		wi::graphics::TextureDesc desc;
+		desc.width = resolution;
+		desc.height = resolution;
+		desc.mip_levels = 0;
+		while ((resolution >> desc.mip_levels) > 0)
+		{
+			desc.mip_levels++;
+		}
+		desc.format = wi::graphics::Format::R8G8B8A8_UNORM;
+		wi::vector<uint8_t> texturedata;
+		for (uint32_t i = 0; i < texture_count; ++i)
+		{
+			names[i] = directory + "texture_" + std::to_string(i) + ".ktx2";
+			if (wi::helper::FileExists(names[i]))
+				continue;
+			texturedata.clear();
+			for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
+			{
+				const uint32_t width = std::max(1u, desc.width >> mip);
+				const uint32_t height = std::max(1u, desc.height >> mip);
+				for (uint32_t y = 0; y < height; ++y)
+				{
+					for (uint32_t x = 0; x < width; ++x)
+					{
+						const uint32_t u = (x << mip) + i * 97;
+						const uint32_t v = y << mip;
+						texturedata.push_back(uint8_t((u ^ v) >> 4));
+						texturedata.push_back(uint8_t(u >> 4));
+						texturedata.push_back(uint8_t(v >> 4));
+						texturedata.push_back(255);
+					}
+				}
+			}
+			wi::helper::saveTextureToFile(texturedata, desc, names[i]);
+		}
+	}
+	const double generation_time = timer.elapsed();
+
+	std::string ss = "KTX2 transcoding test: " + std::to_string(texture_count) + " textures, " + std::to_string(resolution) + "x" + std::to_string(resolution) + " with full mip chain\n";
+	ss += "You can find out more in Tests.cpp, RunTextureTranscodingTest() function.\n\n";
+	ss += "Texture generation: " + std::to_string(generation_time) + " ms (only at first run)\n";
+
+	bool success = true;
+
+	// One texture at a time, the mip levels of each texture are transcoded in parallel:
+	wi::resourcemanager::Clear();
+	timer.record();
+	for (auto& name : names)
+	{
+		wi::Resource resource = wi::resourcemanager::Load(name);
+		success &= resource.IsValid() && resource.GetTexture().desc.width == resolution;
+	}
+	ss += "Load(), one texture at a time: " + std::to_string(timer.elapsed()) + " ms\n";
+	wi::resourcemanager::Clear();
+
+	// All textures in parallel:
+	timer.record();
+	wi::vector<wi::resourcemanager::LoadFuture> futures = wi::resourcemanager::LoadAsyncBatch(names);
+	for (auto& future : futures)
+	{
+		wi::Resource resource = future.Get();
+		success &= resource.IsValid() && resource.GetTexture().desc.width == resolution;
+	}
+	ss += "LoadAsyncBatch(), all textures: " + std::to_string(timer.elapsed()) + " ms\n";
+	wi::resourcemanager::Clear();
+
+	ss += success ? "\nAll textures loaded successfully!" : "\nThere were failures!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunNoisePerformanceTest()
+{
+	// Sample positions in a grid, like the terrain generator would use:
+	const size_t sample_count = 1024 * 1024;
+	wi::vector<float> x(sample_count);
+	wi::vector<float> y(sample_count);
+	for (size_t i = 0; i < sample_count; ++i)
+	{
+		x[i] = float(i % 1024) * 0.137f - 50;
+		y[i] = float(i / 1024) * 0.071f - 30;
+	}
+	wi::vector<float> scalar_result(sample_count);
+	wi::vector<float> batched_result(sample_count);
+	wi::vector<float> cell_id(sample_count);
+
+	std::string ss = "Noise performance test: " + std::to_string(sample_count) + " samples\n";
+	ss += "You can find out more in Tests.cpp, RunNoisePerformanceTest() function.\n\n";
+
+	wi::Timer timer;
+	float max_error = 0;
+
+	// Perlin fBm, 6 octaves:
+	const int octaves = 6;
+	wi::noise::Perlin perlin;
+	perlin.init(1234);
+	timer.record();
+	for (size_t i = 0; i < sample_count; ++i)
+	{
+		scalar_result[i] = perlin.compute(x[i], y[i], 0, octaves);
+	}
+	double scalar_time = timer.elapsed_seconds();
+	timer.record();
+	perlin.compute(x.data(), y.data(), nullptr, batched_result.data(), sample_count, octaves);
+	double batched_time = timer.elapsed_seconds();
+	for (size_t i = 0; i < sample_count; ++i)
+	{
+		max_error = std::max(max_error, std::abs(scalar_result[i] - batched_result[i]));
+	}
+	ss += "Perlin fBm (" + std::to_string(octaves) + " octaves):\n";
+	ss += "\tscalar: " + std::to_string(int(sample_count / scalar_time / 1000000.0)) + " M samples/sec\n";
+	ss += "\tbatched: " + std::to_string(int(sample_count / batched_time / 1000000.0)) + " M samples/sec\n";
+
+	// Voronoi:
+	const float seed = 7;
+	timer.record();
+	for (size_t i = 0; i < sample_count; ++i)
+	{
+		scalar_result[i] = wi::noise::voronoi::compute(x[i], y[i], seed).distance;
+	}
+	scalar_time = timer.elapsed_seconds();
+	timer.record();
+	wi::noise::voronoi::compute(x.data(), y.data(), seed, batched_result.data(), cell_id.data(), sample_count);
+	batched_time = timer.elapsed_seconds();
+	for (size_t i = 0; i < sample_count; ++i)
+	{
+		max_error = std::max(max_error, std::abs(scalar_result[i] - batched_result[i]));
+	}
+	ss += "Voronoi:\n";
+	ss += "\tscalar: " + std::to_string(int(sample_count / scalar_time / 1000000.0)) + " M samples/sec\n";
+	ss += "\tbatched: " + std::to_string(int(sample_count / batched_time / 1000000.0)) + " M samples/sec\n";
+
+	// Terrain chunk heights with the default modifiers, evaluated per vertex and per row:
+	const int chunk_count = 16;
+	wi::terrain::PerlinModifier perlin_modifier;
+	perlin_modifier.Seed(1234);
+	wi::terrain::VoronoiModifier voronoi_modifier;
+	voronoi_modifier.Seed(1234);
+	wi::terrain::Modifier* modifiers[] = { &perlin_modifier, &voronoi_modifier };
+	const int chunk_width = wi::terrain::chunk_width;
+	const size_t chunk_vertex_count = size_t(chunk_width * chunk_width);
+	timer.record();
+	for (int chunk = 0; chunk < chunk_count; ++chunk)
+	{
+		for (size_t i = 0; i < chunk_vertex_count; ++i)
+		{
+			float height = 0;
+			const XMFLOAT2 world_pos = XMFLOAT2(float(chunk * chunk_width + int(i % chunk_width)), float(i / chunk_width));
+			for (auto& modifier : modifiers)
+			{
+				modifier->Apply(world_pos, height);
+			}
+			scalar_result[i] = height;
+		}
+	}
+	scalar_time = timer.elapsed_seconds();
+	timer.record();
+	for (int chunk = 0; chunk < chunk_count; ++chunk)
+	{
+		for (int row = 0; row < chunk_width; ++row)
+		{
+			float* heights = batched_result.data() + row * chunk_width;
+			for (int column = 0; column < chunk_width; ++column)
+			{
+				x[column] = float(chunk * chunk_width + column);
+				y[column] = float(row);
+				heights[column] = 0;
+			}
+			for (auto& modifier : modifiers)
+			{
+				modifier->ApplyBatch(x.data(), y.data(), heights, chunk_width);
+			}
+		}
+	}
+	batched_time = timer.elapsed_seconds();
+	for (size_t i = 0; i < chunk_vertex_count; ++i)
+	{
+		max_error = std::max(max_error, std::abs(scalar_result[i] - batched_result[i]));
+	}
+	ss += "Terrain chunk heights (" + std::to_string(chunk_width) + "x" + std::to_string(chunk_width) + " vertices, Perlin + Voronoi modifiers):\n";
+	ss += "\tper vertex: " + std::to_string(scalar_time * 1000.0 / chunk_count) + " ms per chunk\n";
+	ss += "\tper row: " + std::to_string(batched_time * 1000.0 / chunk_count) + " ms per chunk\n";
+
+	ss += "\nMax error between scalar and batched results: " + std::to_string(max_error) + "\n";
+	ss += max_error < 1e-4f ? "Results match!" : "Results don't match!";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+// The scene system tests below create their content in a static scene of their own instead of the displayed scene, so it will not be displayed
+void TestsRenderer::RunTerrainGenerationTest()
+{
+	static wi::scene::Scene terrain_scene;
+	terrain_scene.Clear();
+	wi::terrain::Terrain terrain;
+	terrain.scene = &terrain_scene;
+	terrain.terrainEntity = wi::ecs::CreateEntity();
+	terrain.generation = 4;
+	terrain.SetGrassEnabled(false);
+	terrain.generation_time_budget_milliseconds = std::numeric_limits<float>::max(); // don't exit generation early
+	std::shared_ptr<wi::terrain::PerlinModifier> perlin = std::make_shared<wi::terrain::PerlinModifier>();
+	perlin->blend = wi::terrain::Modifier::BlendMode::Additive;
+	terrain.modifiers.push_back(perlin);
+	std::shared_ptr<wi::terrain::VoronoiModifier> voronoi = std::make_shared<wi::terrain::VoronoiModifier>();
+	voronoi->blend = wi::terrain::Modifier::BlendMode::Multiply;
+	terrain.modifiers.push_back(voronoi);
+
+	const int chunk_count_per_side = terrain.generation * 2 + 1;
+	const int chunk_count = chunk_count_per_side * chunk_count_per_side;
+	const float chunk_size = float(wi::terrain::chunk_width - 1) * terrain.chunk_scale;
+	// Camera will be moved this far, so that all previous chunks will be removed:
+	const float camera_jump = chunk_size * (terrain.generation * 2 + 4);
+
+	std::string ss = "Terrain generation test: " + std::to_string(chunk_count) + " chunks around the camera\n";
+	ss += "You can find out more in Tests.cpp, RunTerrainGenerationTest() function.\n\n";
+
+	wi::scene::CameraComponent camera;
+	wi::Timer timer;
+	auto generate = [&](float camera_x) {
+		camera.Eye = XMFLOAT3(camera_x, 0, 0);
+		timer.record();
+		terrain.Generation_Update(camera);
+		terrain.Generation_Wait();
+		const double seconds = timer.elapsed_seconds();
+		terrain.Generation_Update(camera); // merges the generated chunks and removes far away chunks
+		terrain.Generation_Cancel();
+		return seconds;
+	};
+
+	timer.record();
+	camera.Eye = XMFLOAT3(0, 0, 0);
+	terrain.Generation_Update(camera);
+	const double update_time = timer.elapsed();
+	terrain.Generation_Wait();
+	const double time_cold = timer.elapsed_seconds();
+	terrain.Generation_Update(camera);
+	terrain.Generation_Cancel();
+	ss += "First generation: " + std::to_string(int(chunk_count / time_cold)) + " chunks/sec\n";
+	ss += "Main thread time in Generation_Update() while scheduling: " + std::to_string(update_time) + " ms\n";
+	ss += "Main thread time of handing over " + std::to_string(terrain.generation_statistics.handover_chunk_count) + " chunks: " + std::to_string(terrain.generation_statistics.handover_milliseconds) + " ms\n";
+
+	const double time_moved = generate(camera_jump);
+	ss += "Generation after camera moved away: " + std::to_string(int(chunk_count / time_moved)) + " chunks/sec\n";
+
+	const double time_cached = generate(0);
+	ss += "Generation after camera moved back (cached heights): " + std::to_string(int(chunk_count / time_cached)) + " chunks/sec\n";
+
+	terrain.height_cache_capacity = 0;
+	terrain.Generation_Restart();
+	generate(0);
+	generate(camera_jump);
+	const double time_uncached = generate(0);
+	ss += "Generation after camera moved back (height cache disabled): " + std::to_string(int(chunk_count / time_uncached)) + " chunks/sec\n";
+
+	terrain.Generation_Cancel();
+	terrain_scene.Clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunTerrainDiskCacheTest()
+{
+	const std::string directory = wi::helper::GetTempDirectoryPath() + "wi_terrain_disk_cache_test";
+	std::error_code ec;
+	std::filesystem::remove_all(directory, ec); // the first flythrough must start with an empty cache
+
+	static wi::scene::Scene terrain_scene;
+	terrain_scene.Clear();
+	wi::terrain::Terrain terrain;
+	terrain.scene = &terrain_scene;
+	terrain.terrainEntity = wi::ecs::CreateEntity();
+	terrain.generation = 4;
+	terrain.SetGrassEnabled(false);
+	terrain.generation_time_budget_milliseconds = std::numeric_limits<float>::max(); // don't exit generation early
+	terrain.disk_cache_directory = directory;
+	std::shared_ptr<wi::terrain::PerlinModifier> perlin = std::make_shared<wi::terrain::PerlinModifier>();
+	perlin->blend = wi::terrain::Modifier::BlendMode::Additive;
+	terrain.modifiers.push_back(perlin);
+	std::shared_ptr<wi::terrain::VoronoiModifier> voronoi = std::make_shared<wi::terrain::VoronoiModifier>();
+	voronoi->blend = wi::terrain::Modifier::BlendMode::Multiply;
+	terrain.modifiers.push_back(voronoi);
+
+	// The camera flies in a straight line, one chunk per step:
+	const int steps = 32;
+	const float chunk_size = float(wi::terrain::chunk_width - 1) * terrain.chunk_scale;
+	wi::scene::CameraComponent camera;
+	auto flythrough = [&]() {
+		terrain.Generation_Restart(); // in-memory state is cleared, only the disk cache is kept
+		wi::Timer timer;
+		for (int step = 0; step < steps; ++step)
+		{
+			camera.Eye = XMFLOAT3(step * chunk_size, 0, 0);
+			terrain.Generation_Update(camera);
+			terrain.Generation_Wait();
+		}
+		const double seconds = timer.elapsed_seconds();
+		terrain.Generation_Cancel();
+		return seconds;
+	};
+
+	std::string ss = "Terrain disk cache test: flythrough of " + std::to_string(steps) + " chunks\n";
+	ss += "You can find out more in Tests.cpp, RunTerrainDiskCacheTest() function.\n\n";
+
+	const double time_cold = flythrough();
+	ss += "Cold flythrough (empty disk cache): " + std::to_string(int(time_cold * 1000)) + " ms\n";
+
+	const double time_warm = flythrough();
+	ss += "Warm flythrough (chunks loaded from disk cache): " + std::to_string(int(time_warm * 1000)) + " ms\n";
+
+	terrain.disk_cache_directory.clear();
+	const double time_disabled = flythrough();
+	ss += "Flythrough with disk cache disabled: " + std::to_string(int(time_disabled * 1000)) + " ms\n";
+
+	terrain.Generation_Cancel();
+	terrain_scene.Clear();
+	std::filesystem::remove_all(directory, ec);
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunTerrainHeightQueryTest()
+{
+	static wi::scene::Scene terrain_scene;
+	terrain_scene.Clear();
+	wi::terrain::Terrain terrain;
+	terrain.scene = &terrain_scene;
+	terrain.terrainEntity = wi::ecs::CreateEntity();
+	terrain.generation = 2;
+	terrain.SetGrassEnabled(false);
+	terrain.generation_time_budget_milliseconds = std::numeric_limits<float>::max(); // don't exit generation early
+	std::shared_ptr<wi::terrain::PerlinModifier> perlin = std::make_shared<wi::terrain::PerlinModifier>();
+	perlin->blend = wi::terrain::Modifier::BlendMode::Additive;
+	terrain.modifiers.push_back(perlin);
+	std::shared_ptr<wi::terrain::VoronoiModifier> voronoi = std::make_shared<wi::terrain::VoronoiModifier>();
+	voronoi->blend = wi::terrain::Modifier::BlendMode::Multiply;
+	terrain.modifiers.push_back(voronoi);
+
+	wi::scene::CameraComponent camera;
+	camera.Eye = XMFLOAT3(0, 0, 0);
+	terrain.Generation_Update(camera);
+	terrain.Generation_Wait();
+	terrain.Generation_Update(camera);
+	terrain.Generation_Cancel();
+	terrain_scene.Update(0); // updates bounding boxes and acceleration structures for picking
+
+	// Random agent positions inside the generated area:
+	const size_t agent_count = 4096;
+	const float extent = float(wi::terrain::chunk_width - 1) * terrain.chunk_scale * (terrain.generation + 0.5f);
+	wi::vector<float> agents_x(agent_count);
+	wi::vector<float> agents_z(agent_count);
+	for (size_t i = 0; i < agent_count; ++i)
+	{
+		agents_x[i] = wi::random::GetRandom(-extent, extent);
+		agents_z[i] = wi::random::GetRandom(-extent, extent);
+	}
+
+	std::string ss = "Terrain height query test: " + std::to_string(agent_count) + " positions on the terrain\n";
+	ss += "You can find out more in Tests.cpp, RunTerrainHeightQueryTest() function.\n\n";
+
+	wi::Timer timer;
+	wi::vector<float> heights_pick(agent_count);
+	for (size_t i = 0; i < agent_count; ++i)
+	{
+		wi::primitive::Ray ray(XMFLOAT3(agents_x[i], terrain.topLevel + 1, agents_z[i]), XMFLOAT3(0, -1, 0));
+		wi::scene::PickResult pick = wi::scene::Pick(ray, wi::enums::RENDERTYPE_ALL, ~0u, terrain_scene);
+		heights_pick[i] = pick.entity == wi::ecs::INVALID_ENTITY ? 0 : pick.position.y;
+	}
+	ss += "Pick() from above: " + std::to_string(timer.elapsed()) + " ms\n";
+
+	timer.record();
+	wi::vector<float> heights_scalar(agent_count);
+	for (size_t i = 0; i < agent_count; ++i)
+	{
+		heights_scalar[i] = terrain.GetHeight(XMFLOAT3(agents_x[i], 0, agents_z[i]));
+	}
+	ss += "GetHeight(): " + std::to_string(timer.elapsed()) + " ms\n";
+
+	timer.record();
+	wi::vector<float> heights_batch(agent_count);
+	terrain.GetHeights(agents_x.data(), agents_z.data(), heights_batch.data(), agent_count);
+	ss += "GetHeights(): " + std::to_string(timer.elapsed()) + " ms\n";
+
+	float max_difference_pick = 0;
+	float max_difference_batch = 0;
+	for (size_t i = 0; i < agent_count; ++i)
+	{
+		max_difference_pick = std::max(max_difference_pick, std::abs(heights_pick[i] - heights_scalar[i]));
+		max_difference_batch = std::max(max_difference_batch, std::abs(heights_batch[i] - heights_scalar[i]));
+	}
+	ss += "\nMax height difference from Pick(): " + std::to_string(max_difference_pick) + "\n";
+	ss += "Max height difference of GetHeights() from GetHeight(): " + std::to_string(max_difference_batch) + "\n";
+
+	terrain.Generation_Cancel();
+	terrain_scene.Clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunPhysicsQueryTest()
+{
+	static wi::scene::Scene physics_scene;
+	physics_scene.Clear();
+
+	const float extent = 100;
+	wi::ecs::Entity ground = physics_scene.Entity_CreatePlane("ground");
+	physics_scene.transforms.GetComponent(ground)->Scale(XMFLOAT3(extent, 1, extent));
+	physics_scene.rigidbodies.Create(ground).shape = wi::scene::RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH;
+
+	const int box_count_per_side = 32;
+	for (int x = 0; x < box_count_per_side; ++x)
+	{
+		for (int z = 0; z < box_count_per_side; ++z)
+		{
+			wi::ecs::Entity box = physics_scene.Entity_CreateCube("");
+			wi::scene::TransformComponent& transform = *physics_scene.transforms.GetComponent(box);
+			transform.Translate(XMFLOAT3(
+				(float(x) / float(box_count_per_side - 1) * 2 - 1) * extent * 0.9f,
+				wi::random::GetRandom(1.0f, 10.0f),
+				(float(z) / float(box_count_per_side - 1) * 2 - 1) * extent * 0.9f
+			));
+			wi::scene::RigidBodyPhysicsComponent& rigidbody = physics_scene.rigidbodies.Create(box);
+			rigidbody.shape = wi::scene::RigidBodyPhysicsComponent::CollisionShape::BOX;
+			rigidbody.mass = 0; // static, so it won't move in the update
+		}
+	}
+	physics_scene.Update(1.0f / 60.0f); // registers the physics bodies and updates bounding boxes for picking
+
+	const uint32_t query_count = 16384;
+	wi::vector<wi::primitive::Ray> rays(query_count);
+	for (uint32_t i = 0; i < query_count; ++i)
+	{
+		rays[i] = wi::primitive::Ray(
+			XMFLOAT3(wi::random::GetRandom(-extent, extent), 20, wi::random::GetRandom(-extent, extent)),
+			XMFLOAT3(wi::random::GetRandom(-0.5f, 0.5f), -1, wi::random::GetRandom(-0.5f, 0.5f)),
+			0,
+			100
+		);
+	}
+
+	std::string ss = "Physics query test: " + std::to_string(query_count) + " rays against " + std::to_string(box_count_per_side * box_count_per_side) + " boxes\n";
+	ss += "You can find out more in Tests.cpp, RunPhysicsQueryTest() function.\n\n";
+
+	wi::Timer timer;
+	wi::vector<wi::scene::PickResult> picks(query_count);
+	for (uint32_t i = 0; i < query_count; ++i)
+	{
+		picks[i] = wi::scene::Pick(rays[i], wi::enums::RENDERTYPE_ALL, ~0u, physics_scene);
+	}
+	double seconds = timer.elapsed_seconds();
+	ss += "wi::scene::Pick(): " + std::to_string(int(query_count / seconds)) + " queries/sec\n";
+
+	timer.record();
+	wi::vector<wi::physics::QueryResult> results(query_count);
+	for (uint32_t i = 0; i < query_count; ++i)
+	{
+		results[i] = wi::physics::RayCast(physics_scene, rays[i]);
+	}
+	seconds = timer.elapsed_seconds();
+	ss += "wi::physics::RayCast(): " + std::to_string(int(query_count / seconds)) + " queries/sec\n";
+
+	timer.record();
+	wi::vector<wi::physics::QueryResult> results_batch(query_count);
+	wi::jobsystem::context ctx;
+	wi::physics::RayCastBatch(ctx, physics_scene, rays.data(), results_batch.data(), query_count);
+	wi::jobsystem::Wait(ctx);
+	seconds = timer.elapsed_seconds();
+	ss += "wi::physics::RayCastBatch(): " + std::to_string(int(query_count / seconds)) + " queries/sec\n";
+
+	wi::vector<wi::physics::QueryShape> shapes(query_count);
+	wi::vector<XMFLOAT3> motions(query_count);
+	for (uint32_t i = 0; i < query_count; ++i)
+	{
+		shapes[i].type = wi::physics::QueryShape::Type::Sphere;
+		shapes[i].radius = 0.5f;
+		shapes[i].position = rays[i].origin;
+		XMStoreFloat3(&motions[i], XMVector3Normalize(XMLoadFloat3(&rays[i].direction)) * 100);
+	}
+	timer.record();
+	wi::vector<wi::physics::QueryResult> results_sweep(query_count);
+	wi::physics::ConvexSweepBatch(ctx, physics_scene, shapes.data(), motions.data(), results_sweep.data(), query_count);
+	wi::jobsystem::Wait(ctx);
+	seconds = timer.elapsed_seconds();
+	ss += "wi::physics::ConvexSweepBatch() with spheres: " + std::to_string(int(query_count / seconds)) + " queries/sec\n";
+
+	uint32_t mismatch_count = 0;
+	for (uint32_t i = 0; i < query_count; ++i)
+	{
+		if (picks[i].entity != results[i].entity || results[i].entity != results_batch[i].entity)
+		{
+			mismatch_count++;
+		}
+	}
+	ss += "\nRays that hit a different entity than Pick(): " + std::to_string(mismatch_count) + "\n";
+
+	physics_scene.Clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+// Creates a static ground and a grid of piles from boxes and spheres, the piles are 10 units apart
+static void CreatePhysicsPiles(wi::scene::Scene& scene, int pile_count_per_side, int pile_width, int pile_height)
+{
+	wi::ecs::Entity ground = wi::ecs::CreateEntity();
+	scene.transforms.Create(ground).Translate(XMFLOAT3(0, -1, 0));
+	wi::scene::RigidBodyPhysicsComponent& ground_rigidbody = scene.rigidbodies.Create(ground);
+	ground_rigidbody.shape = wi::scene::RigidBodyPhysicsComponent::CollisionShape::BOX;
+	ground_rigidbody.box.halfextents = XMFLOAT3(1000, 1, 1000);
+	ground_rigidbody.mass = 0;
+
+	for (int pile = 0; pile < pile_count_per_side * pile_count_per_side; ++pile)
+	{
+		for (int y = 0; y < pile_height; ++y)
+		{
+			for (int x = 0; x < pile_width; ++x)
+			{
+				for (int z = 0; z < pile_width; ++z)
+				{
+					wi::ecs::Entity entity = wi::ecs::CreateEntity();
+					scene.transforms.Create(entity).Translate(XMFLOAT3(
+						float(pile % pile_count_per_side) * 10 + float(x) * 1.01f,
+						0.5f + float(y) * 1.01f,
+						float(pile / pile_count_per_side) * 10 + float(z) * 1.01f
+					));
+					wi::scene::RigidBodyPhysicsComponent& rigidbody = scene.rigidbodies.Create(entity);
+					rigidbody.shape = (x + y + z) % 3 == 0 ? wi::scene::RigidBodyPhysicsComponent::CollisionShape::SPHERE : wi::scene::RigidBodyPhysicsComponent::CollisionShape::BOX;
+					rigidbody.box.halfextents = XMFLOAT3(0.5f, 0.5f, 0.5f);
+					rigidbody.sphere.radius = 0.5f;
+				}
+			}
+		}
+	}
+}
+
+void TestsRenderer::RunPhysicsSimulationTest()
+{
+	static wi::scene::Scene physics_scene;
+
+	const int pile_count_per_side = 10;
+	const int pile_width = 5;
+	const int pile_height = 4;
+	const int body_count = pile_count_per_side * pile_count_per_side * pile_width * pile_width * pile_height;
+	const int step_count = 120;
+	const float dt = 1.0f / 60.0f;
+
+	// Simulates the piles from the same starting state and returns the average time of one step in milliseconds:
+	auto simulate = [&](wi::vector<XMFLOAT3>& positions) {
+		physics_scene.Clear();
+		physics_scene.physics_scene = nullptr; // start with a new physics world
+
+		CreatePhysicsPiles(physics_scene, pile_count_per_side, pile_width, pile_height);
+
+		wi::jobsystem::context ctx;
+		wi::physics::RunPhysicsUpdateSystem(ctx, physics_scene, dt); // registers the bodies
+
+		wi::Timer timer;
+		for (int step = 0; step < step_count; ++step)
+		{
+			wi::physics::RunPhysicsUpdateSystem(ctx, physics_scene, dt);
+		}
+		const double milliseconds = timer.elapsed() / step_count;
+
+		positions.resize(physics_scene.rigidbodies.GetCount());
+		for (size_t i = 0; i < physics_scene.rigidbodies.GetCount(); ++i)
+		{
+			positions[i] = physics_scene.transforms.GetComponent(physics_scene.rigidbodies.GetEntity(i))->translation_local;
+		}
+		return milliseconds;
+	};
+
+	std::string ss = "Physics simulation test: " + std::to_string(body_count) + " rigid bodies in " + std::to_string(pile_count_per_side * pile_count_per_side) + " piles, " + std::to_string(step_count) + " steps\n";
+	ss += "You can find out more in Tests.cpp, RunPhysicsSimulationTest() function.\n\n";
+
+	const bool multithreaded = wi::physics::IsMultithreaded();
+	const bool deterministic = wi::physics::IsDeterministic();
+	wi::vector<XMFLOAT3> positions_serial;
+	wi::vector<XMFLOAT3> positions_deterministic[2];
+	wi::vector<XMFLOAT3> positions_multithreaded;
+
+	wi::physics::SetMultithreaded(false);
+	wi::physics::SetDeterministic(false);
+	ss += "Single threaded: " + std::to_string(simulate(positions_serial)) + " ms per step\n";
+
+	wi::physics::SetMultithreaded(true);
+	ss += "Multithreaded: " + std::to_string(simulate(positions_multithreaded)) + " ms per step\n";
+
+	wi::physics::SetDeterministic(true);
+	ss += "Multithreaded, deterministic: " + std::to_string(simulate(positions_deterministic[0])) + " ms per step\n";
+	simulate(positions_deterministic[1]);
+
+	bool identical = positions_deterministic[0].size() == positions_deterministic[1].size();
+	for (size_t i = 0; identical && i < positions_deterministic[0].size(); ++i)
+	{
+		identical = std::memcmp(&positions_deterministic[0][i], &positions_deterministic[1][i], sizeof(XMFLOAT3)) == 0;
+	}
+	ss += "\nDeterministic simulation repeated with identical results: " + std::string(identical ? "yes" : "no") + "\n";
+
+	wi::physics::SetMultithreaded(multithreaded);
+	wi::physics::SetDeterministic(deterministic);
+	physics_scene.Clear();
+	physics_scene.physics_scene = nullptr;
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunPhysicsFixedTimeStepTest()
+{
+	static wi::scene::Scene physics_scene;
+
+	const int pile_count_per_side = 6;
+	const int pile_width = 4;
+	const int pile_height = 4;
+	const float fixed_timestep = 1.0f / 64.0f;
+	const float simulated_time = 2.0f;
+	const double render_milliseconds = 4; // simulated rendering work in every frame
+	const int body_count = pile_count_per_side * pile_count_per_side * pile_width * pile_width * pile_height;
+
+	auto create_scene = [&]() {
+		physics_scene.Clear();
+		physics_scene.physics_scene = nullptr; // start with a new physics world
+
+		CreatePhysicsPiles(physics_scene, pile_count_per_side, pile_width, pile_height);
+
+		// Register the bodies without simulating:
+		wi::jobsystem::context ctx;
+		wi::physics::SetSimulationEnabled(false);
+		wi::physics::RunPhysicsUpdateSystem(ctx, physics_scene, fixed_timestep);
+		wi::physics::SetSimulationEnabled(true);
+	};
+
+	// Simulates the same amount of time with the given frame times and returns the final positions:
+	//	The frame times are multiples of 1/128 seconds, so they add up to the simulated time exactly
+	auto simulate = [&](const wi::vector<float>& frame_times, wi::vector<XMFLOAT3>& positions) {
+		create_scene();
+		wi::jobsystem::context ctx;
+		for (float dt : frame_times)
+		{
+			wi::physics::RunPhysicsUpdateSystem(ctx, physics_scene, dt);
+		}
+		// One more update to wait for the last simulation and read back its results, there is no remaining time to interpolate:
+		wi::physics::RunPhysicsUpdateSystem(ctx, physics_scene, 0.000001f);
+
+		positions.resize(physics_scene.rigidbodies.GetCount());
+		for (size_t i = 0; i < physics_scene.rigidbodies.GetCount(); ++i)
+		{
+			positions[i] = physics_scene.transforms.GetComponent(physics_scene.rigidbodies.GetEntity(i))->translation_local;
+		}
+	};
+
+	// Runs frames with simulated rendering work and returns the frame time mean and standard deviation in milliseconds:
+	auto measure = [&](int frame_count, double& mean, double& deviation) {
+		create_scene();
+		wi::jobsystem::context ctx;
+		wi::vector<double> frame_milliseconds;
+		for (int frame = 0; frame < frame_count; ++frame)
+		{
+			wi::Timer timer;
+			wi::physics::RunPhysicsUpdateSystem(ctx, physics_scene, 1.0f / 60.0f);
+			while (timer.elapsed() < render_milliseconds); // rendering
+			frame_milliseconds.push_back(timer.elapsed());
+		}
+		mean = 0;
+		for (double x : frame_milliseconds)
+		{
+			mean += x;
+		}
+		mean /= frame_count;
+		deviation = 0;
+		for (double x : frame_milliseconds)
+		{
+			deviation += (x - mean) * (x - mean);
+		}
+		deviation = std::sqrt(deviation / frame_count);
+	};
+
+	std::string ss = "Physics fixed time step test: " + std::to_string(body_count) + " rigid bodies, fixed time step: 1/64 s\n";
+	ss += "You can find out more in Tests.cpp, RunPhysicsFixedTimeStepTest() function.\n\n";
+
+	const bool enabled = wi::physics::IsFixedTimeStepEnabled();
+	const float timestep = wi::physics::GetFixedTimeStep();
+	const bool deterministic = wi::physics::IsDeterministic();
+	wi::physics::SetFixedTimeStep(fixed_timestep);
+	wi::physics::SetDeterministic(true);
+
+	// Frame rate independence: the same simulated time with different frame rates must give identical results
+	wi::physics::SetFixedTimeStepEnabled(true);
+	const int frame_steps[] = { 4, 2, 1, 0 }; // in 1/128 seconds, 0 means random
+	wi::vector<XMFLOAT3> positions[arraysize(frame_steps)];
+	for (size_t i = 0; i < arraysize(frame_steps); ++i)
+	{
+		wi::vector<float> frame_times;
+		int remaining = int(simulated_time * 128);
+		while (remaining > 0)
+		{
+			int steps = frame_steps[i] > 0 ? frame_steps[i] : wi::random::GetRandom(1, 7);
+			steps = std::min(steps, remaining);
+			frame_times.push_back(float(steps) / 128.0f);
+			remaining -= steps;
+		}
+		simulate(frame_times, positions[i]);
+	}
+	ss += "Simulated " + std::to_string(simulated_time) + " seconds at 32 FPS, 64 FPS, 128 FPS and random frame times\n";
+	for (size_t i = 1; i < arraysize(frame_steps); ++i)
+	{
+		bool identical = positions[0].size() == positions[i].size();
+		for (size_t j = 0; identical && j < positions[0].size(); ++j)
+		{
+			identical = std::memcmp(&positions[0][j], &positions[i][j], sizeof(XMFLOAT3)) == 0;
+		}
+		ss += "\tresult " + std::to_string(i) + " is identical to the first: " + std::string(identical ? "yes" : "no") + "\n";
+	}
+
+	// Frame time: the variable time step simulation is part of the frame, the fixed time step simulation runs in the background
+	const int frame_count = 120;
+	double mean = 0;
+	double deviation = 0;
+	ss += "\nFrame times with " + std::to_string(int(render_milliseconds)) + " ms rendering work per frame:\n";
+	wi::physics::SetFixedTimeStepEnabled(false);
+	measure(frame_count, mean, deviation);
+	ss += "\tvariable time step: " + std::to_string(mean) + " ms, deviation: " + std::to_string(deviation) + " ms\n";
+	wi::physics::SetFixedTimeStepEnabled(true);
+	measure(frame_count, mean, deviation);
+	ss += "\tfixed time step: " + std::to_string(mean) + " ms, deviation: " + std::to_string(deviation) + " ms\n";
+
+	wi::physics::SetFixedTimeStepEnabled(enabled);
+	wi::physics::SetFixedTimeStep(timestep);
+	wi::physics::SetDeterministic(deterministic);
+	physics_scene.Clear();
+	physics_scene.physics_scene = nullptr;
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunPhysicsShapeCacheTest()
+{
+	static wi::scene::Scene physics_scene;
+
+	const int instance_count = 10000;
+	const int rock_segments = 32;
+	const float extent = 1000;
+
+	physics_scene.Clear();
+	physics_scene.physics_scene = nullptr; // start with a new physics world
+
+	// Rock mesh: a noisy sphere
+	wi::ecs::Entity meshID = wi::ecs::CreateEntity();
+	wi::scene::MeshComponent& mesh = physics_scene.meshes.Create(meshID);
+	for (int y = 0; y <= rock_segments; ++y)
+	{
+		for (int x = 0; x <= rock_segments; ++x)
+		{
+			const float theta = float(y) / rock_segments * XM_PI;
+			const float phi = float(x) / rock_segments * XM_2PI;
+			const float radius = 1 + 0.2f * std::sin(theta * 5) * std::cos(phi * 3);
+			mesh.vertex_positions.push_back(XMFLOAT3(radius * std::sin(theta) * std::cos(phi), radius * std::cos(theta), radius * std::sin(theta) * std::sin(phi)));
+		}
+	}
+	for (int y = 0; y < rock_segments; ++y)
+	{
+		for (int x = 0; x < rock_segments; ++x)
+		{
+			const uint32_t i0 = y * (rock_segments + 1) + x;
+			const uint32_t i1 = i0 + 1;
+			const uint32_t i2 = i0 + rock_segments + 1;
+			const uint32_t i3 = i2 + 1;
+			mesh.indices.push_back(i0);
+			mesh.indices.push_back(i2);
+			mesh.indices.push_back(i1);
+			mesh.indices.push_back(i1);
+			mesh.indices.push_back(i2);
+			mesh.indices.push_back(i3);
+		}
+	}
+	wi::scene::MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+	subset.indexOffset = 0;
+	subset.indexCount = (uint32_t)mesh.indices.size();
+
+	wi::vector<wi::ecs::Entity> entities(instance_count);
+	for (int i = 0; i < instance_count; ++i)
+	{
+		entities[i] = wi::ecs::CreateEntity();
+		physics_scene.objects.Create(entities[i]).meshID = meshID;
+		wi::scene::TransformComponent& transform = physics_scene.transforms.Create(entities[i]);
+		transform.Scale(XMFLOAT3(wi::random::GetRandom(0.5f, 2.0f), wi::random::GetRandom(0.5f, 2.0f), wi::random::GetRandom(0.5f, 2.0f)));
+		transform.Translate(XMFLOAT3(wi::random::GetRandom(-extent, extent), 0, wi::random::GetRandom(-extent, extent)));
+	}
+
+	// Creates the rigid bodies of all instances and returns the time in milliseconds:
+	auto create_bodies = [&](wi::scene::RigidBodyPhysicsComponent::CollisionShape shape, float mass) {
+		for (auto entity : entities)
+		{
+			physics_scene.rigidbodies.Remove(entity);
+		}
+		for (auto entity : entities)
+		{
+			wi::scene::RigidBodyPhysicsComponent& rigidbody = physics_scene.rigidbodies.Create(entity);
+			rigidbody.shape = shape;
+			rigidbody.mass = mass;
+		}
+		wi::jobsystem::context ctx;
+		wi::Timer timer;
+		wi::physics::RunPhysicsUpdateSystem(ctx, physics_scene, 1.0f / 60.0f); // registers the bodies
+		return timer.elapsed();
+	};
+	auto print_statistics = [&](double milliseconds) {
+		const wi::physics::CollisionShapeStatistics statistics = wi::physics::GetCollisionShapeStatistics(physics_scene);
+		std::string str;
+		str += "\tbody creation: " + std::to_string(milliseconds) + " ms\n";
+		str += "\tcooked shapes: " + std::to_string(statistics.cooked_shape_count) + ", used by " + std::to_string(statistics.rigidbody_count) + " rigid bodies\n";
+		str += "\tshape memory: " + std::to_string(statistics.cooked_memory / 1024) + " KB";
+		if (statistics.cooked_shape_count > 0)
+		{
+			// Without sharing, every rigid body would store its own cooked data:
+			str += " (" + std::to_string(statistics.cooked_memory / statistics.cooked_shape_count * statistics.rigidbody_count / 1024 / 1024) + " MB without sharing)";
+		}
+		str += "\n";
+		return str;
+	};
+
+	std::string ss = "Physics shape cache test: " + std::to_string(instance_count) + " rigid bodies created from the same mesh with " + std::to_string(mesh.indices.size() / 3) + " triangles\n";
+	ss += "You can find out more in Tests.cpp, RunPhysicsShapeCacheTest() function.\n\n";
+
+	ss += "Triangle mesh:\n";
+	ss += print_statistics(create_bodies(wi::scene::RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH, 0));
+
+	// The cooked triangle meshes are serialized, then the rigid bodies are created again in a new physics world:
+	wi::Archive archive;
+	wi::ecs::EntitySerializer seri;
+	seri.allow_remap = false; // the entities are not changing in this test
+	wi::physics::SerializeCollisionShapes(physics_scene, archive, seri);
+	for (auto entity : entities)
+	{
+		physics_scene.rigidbodies.Remove(entity);
+	}
+	physics_scene.physics_scene = nullptr;
+	archive.SetReadModeAndResetPos(true);
+	wi::physics::SerializeCollisionShapes(physics_scene, archive, seri);
+	ss += "Triangle mesh, loaded from serialized cooked data:\n";
+	ss += print_statistics(create_bodies(wi::scene::RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH, 0));
+
+	ss += "Convex hull:\n";
+	ss += print_statistics(create_bodies(wi::scene::RigidBodyPhysicsComponent::CollisionShape::CONVEX_HULL, 1));
+
+	// The mesh is modified in place while the cooked shape is still used by the other rigid bodies
+	//	A new rigid body must not reuse the cooked shape of the old mesh data, the ray must hit the moved triangles:
+	create_bodies(wi::scene::RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH, 0);
+	for (auto& position : mesh.vertex_positions)
+	{
+		position.y += 100;
+	}
+	wi::ecs::Entity probe = wi::ecs::CreateEntity();
+	physics_scene.objects.Create(probe).meshID = meshID;
+	physics_scene.transforms.Create(probe);
+	physics_scene.rigidbodies.Create(probe).shape = wi::scene::RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH;
+	{
+		wi::jobsystem::context ctx;
+		wi::physics::RunPhysicsUpdateSystem(ctx, physics_scene, 1.0f / 60.0f);
+	}
+	const wi::physics::QueryResult result = wi::physics::RayCast(physics_scene, wi::primitive::Ray(XMFLOAT3(0, 200, 0), XMFLOAT3(0, -1, 0)));
+	const bool recooked = result.entity == probe && result.position.y > 50;
+	ss += "Mesh modified in place, cooked again: " + std::string(recooked ? "OK" : "FAILED") + "\n";
+
+	physics_scene.Clear();
+	physics_scene.physics_scene = nullptr;
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunSpringColliderTest()
+{
+	static wi::scene::Scene spring_scene;
+	spring_scene.Clear();
+
+	const int character_count = 100;
+	const int chain_count = 8; // per character
+	const int chain_length = 6;
+	const int level_collider_count = 2000;
+	const float extent = 100;
+	const int frame_count = 120;
+
+	// Characters with hair chains hanging around body colliders:
+	for (int character = 0; character < character_count; ++character)
+	{
+		wi::ecs::Entity root = wi::ecs::CreateEntity();
+		spring_scene.transforms.Create(root).Translate(XMFLOAT3(wi::random::GetRandom(-extent, extent), 0, wi::random::GetRandom(-extent, extent)));
+
+		wi::ecs::Entity body = wi::ecs::CreateEntity();
+		spring_scene.transforms.Create(body);
+		spring_scene.Component_Attach(body, root, true);
+		wi::scene::ColliderComponent& body_collider = spring_scene.colliders.Create(body);
+		body_collider.shape = wi::scene::ColliderComponent::Shape::Capsule;
+		body_collider.radius = 0.3f;
+		body_collider.offset = XMFLOAT3(0, 0.5f, 0);
+		body_collider.tail = XMFLOAT3(0, 1.5f, 0);
+
+		wi::ecs::Entity head = wi::ecs::CreateEntity();
+		spring_scene.transforms.Create(head);
+		spring_scene.Component_Attach(head, root, true);
+		wi::scene::ColliderComponent& head_collider = spring_scene.colliders.Create(head);
+		head_collider.shape = wi::scene::ColliderComponent::Shape::Sphere;
+		head_collider.radius = 0.25f;
+		head_collider.offset = XMFLOAT3(0, 1.8f, 0);
+
+		for (int chain = 0; chain < chain_count; ++chain)
+		{
+			const float angle = float(chain) / chain_count * XM_2PI;
+			wi::ecs::Entity parent = root;
+			for (int bone = 0; bone < chain_length; ++bone)
+			{
+				wi::ecs::Entity entity = wi::ecs::CreateEntity();
+				wi::scene::TransformComponent& transform = spring_scene.transforms.Create(entity);
+				if (bone == 0)
+				{
+					transform.Translate(XMFLOAT3(std::cos(angle) * 0.2f, 1.9f, std::sin(angle) * 0.2f));
+				}
+				else
+				{
+					transform.Translate(XMFLOAT3(std::cos(angle) * 0.12f, 0.02f, std::sin(angle) * 0.12f));
+				}
+				spring_scene.Component_Attach(entity, parent, true);
+				wi::scene::SpringComponent& spring = spring_scene.springs.Create(entity);
+				spring.windForce = 0; // wind depends on global time, it would make the results different between the runs
+				spring.hitRadius = 0.05f;
+				spring.gravityDir = XMFLOAT3(0, -1, 0);
+				spring.gravityPower = 2;
+				parent = entity;
+			}
+		}
+	}
+
+	// Level colliders:
+	for (int i = 0; i < level_collider_count; ++i)
+	{
+		wi::ecs::Entity entity = wi::ecs::CreateEntity();
+		spring_scene.transforms.Create(entity).Translate(XMFLOAT3(wi::random::GetRandom(-extent, extent), wi::random::GetRandom(0.0f, 2.0f), wi::random::GetRandom(-extent, extent)));
+		wi::scene::ColliderComponent& collider = spring_scene.colliders.Create(entity);
+		collider.shape = wi::scene::ColliderComponent::Shape::Sphere;
+		collider.radius = 0.5f;
+	}
+	wi::ecs::Entity ground = wi::ecs::CreateEntity();
+	spring_scene.transforms.Create(ground).Translate(XMFLOAT3(0, 0.5f, 0));
+	wi::scene::ColliderComponent& ground_collider = spring_scene.colliders.Create(ground);
+	ground_collider.shape = wi::scene::ColliderComponent::Shape::Plane;
+	ground_collider.radius = extent;
+
+	wi::jobsystem::context ctx;
+	spring_scene.RunTransformUpdateSystem(ctx);
+	wi::jobsystem::Wait(ctx);
+	spring_scene.RunHierarchyUpdateSystem(ctx);
+	wi::jobsystem::Wait(ctx);
+	spring_scene.dt = 1.0f / 60.0f;
+
+	const wi::vector<wi::scene::SpringComponent> springs_initial = spring_scene.springs.GetComponentArray();
+	const wi::vector<wi::scene::TransformComponent> transforms_initial = spring_scene.transforms.GetComponentArray();
+
+	// Simulates the springs from the initial state and returns the average spring update time in milliseconds:
+	auto simulate = [&](bool broadphase, wi::vector<XMFLOAT3>& tails) {
+		for (size_t i = 0; i < spring_scene.springs.GetCount(); ++i)
+		{
+			spring_scene.springs[i] = springs_initial[i];
+		}
+		for (size_t i = 0; i < spring_scene.transforms.GetCount(); ++i)
+		{
+			spring_scene.transforms[i] = transforms_initial[i];
+		}
+		double milliseconds = 0;
+		for (int frame = 0; frame < frame_count; ++frame)
+		{
+			spring_scene.RunColliderUpdateSystem(ctx);
+			if (!broadphase)
+			{
+				spring_scene.collider_bvh.Clear(); // every spring will check every collider
+			}
+			wi::Timer timer;
+			spring_scene.RunSpringUpdateSystem(ctx);
+			milliseconds += timer.elapsed();
+		}
+		tails.resize(spring_scene.springs.GetCount());
+		for (size_t i = 0; i < spring_scene.springs.GetCount(); ++i)
+		{
+			tails[i] = spring_scene.springs[i].currentTail;
+		}
+		return milliseconds / frame_count;
+	};
+
+	std::string ss = "Spring collider test: " + std::to_string(spring_scene.springs.GetCount()) + " springs, " + std::to_string(spring_scene.colliders.GetCount()) + " colliders, " + std::to_string(frame_count) + " frames\n";
+	ss += "You can find out more in Tests.cpp, RunSpringColliderTest() function.\n\n";
+
+	wi::vector<XMFLOAT3> tails_reference;
+	wi::vector<XMFLOAT3> tails_broadphase;
+	ss += "Every spring against every collider: " + std::to_string(simulate(false, tails_reference)) + " ms per frame\n";
+	ss += "Collider broadphase: " + std::to_string(simulate(true, tails_broadphase)) + " ms per frame\n";
+
+	bool identical = tails_reference.size() == tails_broadphase.size();
+	for (size_t i = 0; identical && i < tails_reference.size(); ++i)
+	{
+		identical = std::memcmp(&tails_reference[i], &tails_broadphase[i], sizeof(XMFLOAT3)) == 0;
+	}
+	ss += "\nIdentical results: " + std::string(identical ? "yes" : "no") + "\n";
+
+	spring_scene.Clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunInverseKinematicsPerformanceTest()
+{
+	static wi::scene::Scene ik_scene;
+	ik_scene.Clear();
+
+	const int character_count = 50;
+	const int level_transform_count = 100000;
+	const float extent = 100;
+	const int frame_count = 60;
+
+	// Large level that is not affected by inverse kinematics:
+	for (int i = 0; i < level_transform_count; ++i)
+	{
+		wi::ecs::Entity entity = wi::ecs::CreateEntity();
+		ik_scene.transforms.Create(entity).Translate(XMFLOAT3(wi::random::GetRandom(-extent, extent), wi::random::GetRandom(0.0f, 10.0f), wi::random::GetRandom(-extent, extent)));
+	}
+
+	// Characters with two legs, each leg has a foot IK and toes that are not part of the IK chain:
+	struct Leg
+	{
+		XMFLOAT3 rest; // world space foot position in rest pose
+		wi::ecs::Entity foot;
+		wi::ecs::Entity toes;
+		wi::ecs::Entity target;
+	};
+	wi::vector<Leg> legs;
+	for (int character = 0; character < character_count; ++character)
+	{
+		const XMFLOAT3 position = XMFLOAT3(wi::random::GetRandom(-extent, extent), 0, wi::random::GetRandom(-extent, extent));
+		wi::ecs::Entity root = wi::ecs::CreateEntity();
+		ik_scene.transforms.Create(root).Translate(position);
+
+		wi::ecs::Entity hips = wi::ecs::CreateEntity();
+		ik_scene.transforms.Create(hips).Translate(XMFLOAT3(0, 1, 0));
+		ik_scene.Component_Attach(hips, root, true);
+
+		for (int side = -1; side <= 1; side += 2)
+		{
+			const float x = side * 0.2f;
+			wi::ecs::Entity thigh = wi::ecs::CreateEntity();
+			ik_scene.transforms.Create(thigh).Translate(XMFLOAT3(x, 1, 0));
+			ik_scene.Component_Attach(thigh, hips, true);
+
+			wi::ecs::Entity knee = wi::ecs::CreateEntity();
+			ik_scene.transforms.Create(knee).Translate(XMFLOAT3(x, 0.5f, 0.05f));
+			ik_scene.Component_Attach(knee, thigh, true);
+
+			Leg& leg = legs.emplace_back();
+			leg.rest = XMFLOAT3(position.x + x, 0.05f, position.z);
+			leg.foot = wi::ecs::CreateEntity();
+			ik_scene.transforms.Create(leg.foot).Translate(XMFLOAT3(x, 0.05f, 0));
+			ik_scene.Component_Attach(leg.foot, knee, true);
+
+			leg.toes = wi::ecs::CreateEntity();
+			ik_scene.transforms.Create(leg.toes).Translate(XMFLOAT3(x, 0, 0.15f));
+			ik_scene.Component_Attach(leg.toes, leg.foot, true);
+
+			leg.target = wi::ecs::CreateEntity();
+			ik_scene.transforms.Create(leg.target);
+
+			wi::scene::InverseKinematicsComponent& ik = ik_scene.inverse_kinematics.Create(leg.foot);
+			ik.target = leg.target;
+			ik.chain_length = 2;
+			ik.iteration_count = 5;
+		}
+	}
+
+	wi::jobsystem::context ctx;
+	double milliseconds = 0;
+	for (int frame = 0; frame < frame_count; ++frame)
+	{
+		// Targets are moving in reach of the legs:
+		for (const Leg& leg : legs)
+		{
+			wi::scene::TransformComponent& target = *ik_scene.transforms.GetComponent(leg.target);
+			target.ClearTransform();
+			target.Translate(leg.rest);
+			target.Translate(XMFLOAT3(wi::random::GetRandom(-0.3f, 0.3f), wi::random::GetRandom(0.0f, 0.4f), wi::random::GetRandom(-0.3f, 0.3f)));
+		}
+		ik_scene.RunTransformUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+		ik_scene.RunHierarchyUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+
+		wi::Timer timer;
+		ik_scene.RunInverseKinematicsUpdateSystem(ctx);
+		milliseconds += timer.elapsed();
+	}
+
+	// The last frame is checked, toes must follow the feet that were moved by the IK:
+	float target_distance = 0;
+	float toes_error = 0;
+	for (const Leg& leg : legs)
+	{
+		const wi::scene::TransformComponent& foot = *ik_scene.transforms.GetComponent(leg.foot);
+		const wi::scene::TransformComponent& toes = *ik_scene.transforms.GetComponent(leg.toes);
+		const wi::scene::TransformComponent& target = *ik_scene.transforms.GetComponent(leg.target);
+		target_distance += wi::math::Distance(foot.GetPosition(), target.GetPosition());
+		XMFLOAT3 toes_expected;
+		XMStoreFloat3(&toes_expected, XMVector3Transform(XMLoadFloat3(&toes.translation_local), XMLoadFloat4x4(&foot.world)));
+		toes_error = std::max(toes_error, wi::math::Distance(toes_expected, toes.GetPosition()));
+	}
+	target_distance /= legs.size();
+
+	std::string ss = "Inverse kinematics performance test: " + std::to_string(ik_scene.inverse_kinematics.GetCount()) + " IK, " + std::to_string(ik_scene.transforms.GetCount()) + " transforms, " + std::to_string(frame_count) + " frames\n";
+	ss += "You can find out more in Tests.cpp, RunInverseKinematicsPerformanceTest() function.\n\n";
+	ss += "Inverse kinematics update: " + std::to_string(milliseconds / frame_count) + " ms per frame\n";
+	ss += "Average distance of feet to targets: " + std::to_string(target_distance) + "\n";
+	ss += "Maximum error of toes following the feet: " + std::to_string(toes_error) + "\n";
+
+	ik_scene.Clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunMorphTargetPerformanceTest()
+{
+	static wi::scene::Scene morph_scene;
+	morph_scene.Clear();
+
+	const int head_count = 100;
+	const int grid_size = 70; // vertices per side
+	const int target_count = 52;
+	const int target_vertex_count = 200;
+	const int changed_weights_per_frame = 4; // per head
+	const int frame_count = 120;
+
+	// Heads are grids with sparse blendshapes that affect a small region each:
+	for (int head = 0; head < head_count; ++head)
+	{
+		wi::ecs::Entity entity = wi::ecs::CreateEntity();
+		wi::scene::MeshComponent& mesh = morph_scene.meshes.Create(entity);
+		for (int y = 0; y < grid_size; ++y)
+		{
+			for (int x = 0; x < grid_size; ++x)
+			{
+				mesh.vertex_positions.push_back(XMFLOAT3(float(x) / grid_size, float(y) / grid_size, 0));
+				mesh.vertex_normals.push_back(XMFLOAT3(0, 0, 1));
+				if (x < grid_size - 1 && y < grid_size - 1)
+				{
+					const uint32_t i = uint32_t(x + y * grid_size);
+					mesh.indices.push_back(i);
+					mesh.indices.push_back(i + grid_size);
+					mesh.indices.push_back(i + 1);
+					mesh.indices.push_back(i + 1);
+					mesh.indices.push_back(i + grid_size);
+					mesh.indices.push_back(i + grid_size + 1);
+				}
+			}
+		}
+		for (int target = 0; target < target_count; ++target)
+		{
+			wi::scene::MeshComponent::MorphTarget& morph = mesh.morph_targets.emplace_back();
+			const uint32_t start = wi::random::GetRandom(0u, uint32_t(mesh.vertex_positions.size() - target_vertex_count));
+			for (int i = 0; i < target_vertex_count; ++i)
+			{
+				morph.sparse_indices.push_back(start + i);
+				morph.vertex_positions.push_back(XMFLOAT3(0, 0, wi::random::GetRandom(0.0f, 0.1f)));
+				morph.vertex_normals.push_back(XMFLOAT3(wi::random::GetRandom(-0.1f, 0.1f), wi::random::GetRandom(-0.1f, 0.1f), 0));
+			}
+		}
+		mesh.CreateRenderData();
+	}
+
+	// Facial animation changes a few weights of every head each frame, the same changes are used for both runs:
+	struct WeightChange
+	{
+		int target;
+		float weight;
+	};
+	wi::vector<WeightChange> changes(frame_count * head_count * changed_weights_per_frame);
+	for (WeightChange& change : changes)
+	{
+		change.target = wi::random::GetRandom(0, target_count - 1);
+		change.weight = wi::random::GetRandom(0.0f, 1.0f);
+	}
+
+	wi::jobsystem::context ctx;
+	auto simulate = [&](bool incremental) {
+		const WeightChange* change = changes.data();
+		for (size_t i = 0; i < morph_scene.meshes.GetCount(); ++i)
+		{
+			for (auto& morph : morph_scene.meshes[i].morph_targets)
+			{
+				morph.weight = 0;
+			}
+			morph_scene.meshes[i].morph_weights_applied.clear();
+		}
+		double milliseconds = 0;
+		for (int frame = 0; frame < frame_count; ++frame)
+		{
+			for (size_t i = 0; i < morph_scene.meshes.GetCount(); ++i)
+			{
+				wi::scene::MeshComponent& mesh = morph_scene.meshes[i];
+				for (int j = 0; j < changed_weights_per_frame; ++j)
+				{
+					mesh.morph_targets[change->target].weight = change->weight;
+					change++;
+				}
+				if (!incremental)
+				{
+					mesh.morph_weights_applied.clear(); // every vertex is recomputed from every target
+				}
+				mesh.dirty_morph = true;
+			}
+			wi::Timer timer;
+			morph_scene.RunMeshUpdateSystem(ctx);
+			wi::jobsystem::Wait(ctx);
+			milliseconds += timer.elapsed();
+		}
+		return milliseconds / frame_count;
+	};
+
+	std::string ss = "Morph target performance test: " + std::to_string(head_count) + " heads, " + std::to_string(grid_size * grid_size) + " vertices, " + std::to_string(target_count) + " morph targets, " + std::to_string(frame_count) + " frames\n";
+	ss += "You can find out more in Tests.cpp, RunMorphTargetPerformanceTest() function.\n\n";
+
+	ss += "Full morph update: " + std::to_string(simulate(false)) + " ms per frame\n";
+	const double incremental_time = simulate(true);
+	ss += "Incremental morph update: " + std::to_string(incremental_time) + " ms per frame\n";
+
+	// The incremental result is compared against a full update of the same weights:
+	float max_error = 0;
+	for (size_t i = 0; i < morph_scene.meshes.GetCount(); ++i)
+	{
+		wi::scene::MeshComponent& mesh = morph_scene.meshes[i];
+		const wi::vector<XMFLOAT3> incremental_positions = mesh.morph_temp_pos;
+		mesh.morph_weights_applied.clear();
+		mesh.dirty_morph = true;
+		morph_scene.RunMeshUpdateSystem(ctx);
+		wi::jobsystem::Wait(ctx);
+		for (size_t j = 0; j < incremental_positions.size(); ++j)
+		{
+			max_error = std::max(max_error, wi::math::Distance(incremental_positions[j], mesh.morph_temp_pos[j]));
+		}
+	}
+	ss += "\nMaximum position difference: " + std::to_string(max_error) + "\n";
+
+	morph_scene.Clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+static const char* test_models[] = {
+	"../Content/models/teapot.wiscene",
+	"../Content/models/suzanne.wiscene",
+	"../Content/models/girl.wiscene",
+	"../Content/models/dojo.wiscene",
+};
+// Loads the first model_count test models into the scene one by one, and calls process for each of them
+//	The scene still contains the last model after this returns
+static void ForEachTestModel(wi::scene::Scene& scene, size_t model_count, const std::function<void(const char* model)>& process)
+{
+	for (size_t i = 0; i < std::min(model_count, arraysize(test_models)); ++i)
+	{
+		scene.Clear();
+		wi::scene::LoadModel(scene, test_models[i]);
+		process(test_models[i]);
+	}
+}
+
+void TestsRenderer::RunLODGenerationTest()
+{
+	static wi::scene::Scene lod_scene;
+
+	wi::scene::MeshComponent::LODGenerationParams params;
+	params.lod_count = 6;
+
+	std::string ss = "LOD generation test: " + std::to_string(params.lod_count) + " levels\n";
+	ss += "You can find out more in Tests.cpp, RunLODGenerationTest() function.\n\n";
+
+	ForEachTestModel(lod_scene, 3, [&](const char* model) { // without the dojo
+		wi::vector<wi::vector<XMFLOAT3>> vertex_positions(lod_scene.meshes.GetCount());
+		for (size_t i = 0; i < lod_scene.meshes.GetCount(); ++i)
+		{
+			vertex_positions[i] = lod_scene.meshes[i].vertex_positions;
+		}
+
+		size_t triangles_per_lod[16] = {};
+		wi::Timer timer;
+		for (size_t i = 0; i < lod_scene.meshes.GetCount(); ++i)
+		{
+			wi::scene::MeshComponent& mesh = lod_scene.meshes[i];
+			if (mesh.subsets_per_lod > 0)
+			{
+				// existing levels are discarded, generation starts from the first level:
+				mesh.subsets.resize(mesh.subsets_per_lod);
+			}
+			mesh.GenerateLODs(params);
+		}
+		const double milliseconds = timer.elapsed();
+
+		// The vertices must not be reordered, because vertex indexed data outside of the mesh (eg. soft body mappings) would be invalidated:
+		bool vertices_unchanged = true;
+		for (size_t i = 0; i < lod_scene.meshes.GetCount(); ++i)
+		{
+			const wi::vector<XMFLOAT3>& positions = lod_scene.meshes[i].vertex_positions;
+			vertices_unchanged &= positions.size() == vertex_positions[i].size() && (positions.empty() || std::memcmp(positions.data(), vertex_positions[i].data(), positions.size() * sizeof(XMFLOAT3)) == 0);
+		}
+
+		for (size_t i = 0; i < lod_scene.meshes.GetCount(); ++i)
+		{
+			const wi::scene::MeshComponent& mesh = lod_scene.meshes[i];
+			for (uint32_t lod = 0; lod < std::min(mesh.GetLODCount(), (uint32_t)arraysize(triangles_per_lod)); ++lod)
+			{
+				uint32_t first_subset = 0;
+				uint32_t last_subset = 0;
+				mesh.GetLODSubsetRange(lod, first_subset, last_subset);
+				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+				{
+					triangles_per_lod[lod] += mesh.subsets[subsetIndex].indexCount / 3;
+				}
+			}
+		}
+
+		ss += std::string(model) + ": " + std::to_string(lod_scene.meshes.GetCount()) + " meshes, " + std::to_string(milliseconds) + " ms\n\ttriangles:";
+		for (uint32_t lod = 0; lod < params.lod_count; ++lod)
+		{
+			ss += " " + std::to_string(triangles_per_lod[lod]);
+			if (lod > 0 && triangles_per_lod[0] > 0)
+			{
+				ss += " (" + std::to_string(triangles_per_lod[lod] * 100 / triangles_per_lod[0]) + "%)";
+			}
+		}
+		ss += std::string("\n\tvertices unchanged: ") + (vertices_unchanged ? "OK" : "FAILED") + "\n";
+	});
+
+	lod_scene.Clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunMeshOptimizationTest()
+{
+	static wi::scene::Scene optimization_scene;
+
+	std::string ss = "Mesh optimization test, statistics are averaged by index count\n";
+	ss += "You can find out more in Tests.cpp, RunMeshOptimizationTest() function.\n\n";
+
+	ForEachTestModel(optimization_scene, arraysize(test_models), [&](const char* model) {
+		wi::scene::MeshComponent::OptimizationStatistics total;
+		wi::Timer timer;
+		for (size_t i = 0; i < optimization_scene.meshes.GetCount(); ++i)
+		{
+			wi::scene::MeshComponent& mesh = optimization_scene.meshes[i];
+			wi::scene::MeshComponent::OptimizationStatistics statistics;
+			mesh.Optimize(&statistics);
+			total.Accumulate(statistics, mesh.indices.size());
+		}
+		const double milliseconds = timer.elapsed();
+		const wi::scene::MeshComponent::OptimizationStatistics average = total.GetAverage();
+
+		ss += std::string(model) + ": " + std::to_string(optimization_scene.meshes.GetCount()) + " meshes, " + std::to_string(milliseconds) + " ms\n";
+		ss += "\tACMR: " + std::to_string(average.acmr_before) + " -> " + std::to_string(average.acmr_after);
+		ss += ", ATVR: " + std::to_string(average.atvr_before) + " -> " + std::to_string(average.atvr_after);
+		ss += ", overfetch: " + std::to_string(average.overfetch_before) + " -> " + std::to_string(average.overfetch_after) + "\n";
+	});
+
+	optimization_scene.Clear();
+
+	// Soft body cloth: every quad has its own vertices, so the physics vertices are shared by multiple graphics vertices
+	//	The indices reference the vertices in reverse order, so the vertex fetch optimization will reorder all of them
+	{
+		const uint32_t grid = 32;
+		wi::scene::MeshComponent mesh;
+		for (uint32_t z = 0; z < grid; ++z)
+		{
+			for (uint32_t x = 0; x < grid; ++x)
+			{
+				const uint32_t base = (uint32_t)mesh.vertex_positions.size();
+				mesh.vertex_positions.push_back(XMFLOAT3(float(x), 0, float(z)));
+				mesh.vertex_positions.push_back(XMFLOAT3(float(x + 1), 0, float(z)));
+				mesh.vertex_positions.push_back(XMFLOAT3(float(x), 0, float(z + 1)));
+				mesh.vertex_positions.push_back(XMFLOAT3(float(x + 1), 0, float(z + 1)));
+				const uint32_t quad[] = { base + 0, base + 2, base + 1, base + 1, base + 2, base + 3 };
+				mesh.indices.insert(mesh.indices.begin(), quad, quad + arraysize(quad));
+			}
+		}
+		mesh.subsets.emplace_back().indexCount = (uint32_t)mesh.indices.size();
+
+		wi::scene::SoftBodyPhysicsComponent softbody;
+		softbody.CreateFromMesh(mesh);
+		for (size_t i = 0; i < softbody.weights.size(); ++i)
+		{
+			// pin the first row, like it was painted in the editor:
+			softbody.weights[i] = mesh.vertex_positions[softbody.physicsToGraphicsVertexMapping[i]].z == 0 ? 0.0f : 1.0f;
+		}
+		const size_t physics_vertex_count = softbody.physicsToGraphicsVertexMapping.size();
+
+		wi::vector<uint32_t> vertex_remap;
+		mesh.Optimize(nullptr, &vertex_remap);
+		softbody.RemapGraphicsVertices(vertex_remap);
+
+		size_t reordered = 0;
+		for (size_t i = 0; i < vertex_remap.size(); ++i)
+		{
+			reordered += vertex_remap[i] != i ? 1 : 0;
+		}
+		bool valid = softbody.physicsToGraphicsVertexMapping.size() == physics_vertex_count && softbody.physicsobject == nullptr;
+		for (size_t i = 0; valid && i < mesh.vertex_positions.size(); ++i)
+		{
+			const XMFLOAT3& position = mesh.vertex_positions[i];
+			const uint32_t physicsIndex = softbody.graphicsToPhysicsVertexMapping[i];
+			const XMFLOAT3& physics_position = mesh.vertex_positions[softbody.physicsToGraphicsVertexMapping[physicsIndex]];
+			valid &= position.x == physics_position.x && position.y == physics_position.y && position.z == physics_position.z;
+			valid &= softbody.weights[physicsIndex] == (position.z == 0 ? 0.0f : 1.0f);
+		}
+		ss += "\nSoft body mesh: " + std::to_string(reordered) + " of " + std::to_string(vertex_remap.size()) + " vertices reordered, " + std::to_string(physics_vertex_count) + " physics vertices, mappings and weights: " + (valid ? "OK" : "FAILED") + "\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunVertexQuantizationTest()
+{
+	static wi::scene::Scene quantization_scene;
+
+	std::string ss = "Vertex quantization test, positions are 16-bit normalized within the mesh bounds, normals are octahedral encoded\n";
+	ss += "The CPU round trip error is compared to the full precision format, which stores the normal with 8 bits per component\n";
+	ss += "You can find out more in Tests.cpp, RunVertexQuantizationTest() function.\n\n";
+
+	ForEachTestModel(quantization_scene, arraysize(test_models), [&](const char* model) {
+		size_t quantized_count = 0;
+		float position_error = 0;
+		float position_error_relative = 0;
+		float normal_error_full = 0;
+		float normal_error_quantized = 0;
+		uint64_t memory_before = 0;
+		uint64_t memory_after = 0;
+		for (size_t i = 0; i < quantization_scene.meshes.GetCount(); ++i)
+		{
+			wi::scene::MeshComponent& mesh = quantization_scene.meshes[i];
+			memory_before += mesh.generalBuffer.GetDesc().size;
+
+			float max_error = 0;
+			if (mesh.CanQuantizePositions(&max_error))
+			{
+				quantized_count++;
+				position_error = std::max(position_error, max_error);
+				const float extent = wi::math::Length(mesh.aabb.getHalfWidth()) * 2;
+				position_error_relative = std::max(position_error_relative, extent > 0 ? max_error / extent : 0);
+
+				// Round trip of the normals, the angle error is measured in degrees:
+				for (size_t j = 0; j < mesh.vertex_normals.size(); ++j)
+				{
+					XMFLOAT3 nor;
+					XMStoreFloat3(&nor, XMVector3Normalize(XMLoadFloat3(&mesh.vertex_normals[j])));
+					const XMVECTOR N = XMLoadFloat3(&nor);
+
+					wi::scene::MeshComponent::Vertex_POS full;
+					full.FromFULL(mesh.vertex_positions[j], nor, 0xFF);
+					const float dot_full = XMVectorGetX(XMVector3Dot(N, XMVector3Normalize(full.LoadNOR())));
+					normal_error_full = std::max(normal_error_full, XMConvertToDegrees(std::acos(wi::math::Clamp(dot_full, -1, 1))));
+
+					wi::scene::MeshComponent::Vertex_POS16 quantized;
+					quantized.FromFULL(mesh.aabb, mesh.vertex_positions[j], nor);
+					const XMFLOAT3 nor_quantized = quantized.GetNor_FULL();
+					const float dot_quantized = XMVectorGetX(XMVector3Dot(N, XMLoadFloat3(&nor_quantized)));
+					normal_error_quantized = std::max(normal_error_quantized, XMConvertToDegrees(std::acos(wi::math::Clamp(dot_quantized, -1, 1))));
+				}
+			}
+
+			mesh.SetQuantizedPositions(true);
+			mesh.CreateRenderData();
+			memory_after += mesh.generalBuffer.GetDesc().size;
+		}
+		const float saving = memory_before > 0 ? 100.0f * float(memory_before - memory_after) / float(memory_before) : 0.0f;
+
+		ss += std::string(model) + ": " + std::to_string(quantized_count) + " / " + std::to_string(quantization_scene.meshes.GetCount()) + " meshes quantized\n";
+		ss += "\tmax position error: " + std::to_string(position_error) + " (" + std::to_string(position_error_relative * 100) + "% of bounds diagonal)";
+		ss += ", max normal error: " + std::to_string(normal_error_quantized) + " degrees (full precision: " + std::to_string(normal_error_full) + " degrees)\n";
+		ss += "\tGPU memory: " + std::to_string(memory_before / 1024) + " KB -> " + std::to_string(memory_after / 1024) + " KB (" + std::to_string(saving) + "% saved)\n";
+	});
+
+	// Lightmap rendering needs full precision vertices, the mesh is only kept in full precision while it's requested:
+	for (size_t i = 0; i < quantization_scene.objects.GetCount(); ++i)
+	{
+		wi::scene::ObjectComponent& object = quantization_scene.objects[i];
+		wi::scene::MeshComponent* mesh = quantization_scene.meshes.GetComponent(object.meshID);
+		if (mesh == nullptr || !mesh->positions_quantized)
+			continue;
+		object.SetLightmapRenderRequest(true);
+		quantization_scene.Update(0);
+		const bool full_precision = !mesh->positions_quantized && mesh->IsQuantizedPositions();
+		object.SetLightmapRenderRequest(false);
+		quantization_scene.Update(0);
+		const bool requantized = mesh->positions_quantized;
+		ss += "\nFull precision while lightmap is rendered: " + std::string(full_precision ? "OK" : "FAILED");
+		ss += ", quantized again after: " + std::string(requantized ? "OK" : "FAILED") + "\n";
+		break;
+	}
+
+	quantization_scene.Clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunMeshletCullingTest()
+{
+	static wi::scene::Scene meshlet_scene;
+
+	std::string ss = "Meshlet culling test, the meshlets are culled on the CPU by frustum and normal cone from cameras around the model\n";
+	ss += "You can find out more in Tests.cpp, RunMeshletCullingTest() function.\n\n";
+
+	ForEachTestModel(meshlet_scene, arraysize(test_models), [&](const char* model) {
+		meshlet_scene.Update(0); // updates object matrices and scene bounds
+
+		uint32_t meshlet_count = 0;
+		uint32_t node_count = 0;
+		wi::Timer timer;
+		for (size_t i = 0; i < meshlet_scene.meshes.GetCount(); ++i)
+		{
+			wi::scene::MeshComponent::MeshletBuildStatistics statistics;
+			meshlet_scene.meshes[i].BuildMeshlets(&statistics);
+			meshlet_count += statistics.meshlet_count;
+			node_count += statistics.node_count;
+		}
+		const double build_milliseconds = timer.elapsed();
+
+		// Cameras are placed on a circle around the model, looking at its center:
+		const XMFLOAT3 center = meshlet_scene.bounds.getCenter();
+		const float radius = wi::math::Length(meshlet_scene.bounds.getHalfWidth());
+		const XMMATRIX P = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, radius * 4);
+		const uint32_t camera_count = 8;
+		wi::scene::MeshComponent::MeshletCullStatistics statistics;
+		wi::vector<uint32_t> visible_meshlets;
+		timer.record_elapsed_seconds();
+		for (uint32_t camera = 0; camera < camera_count; ++camera)
+		{
+			const float angle = XM_2PI * camera / camera_count;
+			const XMVECTOR eye = XMLoadFloat3(&center) + XMVectorSet(std::sin(angle), 0.5f, std::cos(angle), 0) * radius * 1.5f;
+			const XMMATRIX VP = XMMatrixLookAtLH(eye, XMLoadFloat3(&center), XMVectorSet(0, 1, 0, 0)) * P;
+
+			for (size_t i = 0; i < meshlet_scene.objects.GetCount(); ++i)
+			{
+				const wi::scene::ObjectComponent& object = meshlet_scene.objects[i];
+				const wi::scene::MeshComponent* mesh = meshlet_scene.meshes.GetComponent(object.meshID);
+				if (mesh == nullptr || !mesh->HasMeshlets())
+					continue;
+
+				// The culling is performed in the local space of the mesh:
+				const XMMATRIX W = XMLoadFloat4x4(&object.worldMatrix);
+				wi::primitive::Frustum frustum;
+				frustum.Create(W * VP);
+				XMFLOAT3 camera_position;
+				XMStoreFloat3(&camera_position, XMVector3Transform(eye, XMMatrixInverse(nullptr, W)));
+
+				for (uint32_t subsetIndex = 0; subsetIndex < (uint32_t)mesh->subsets.size(); ++subsetIndex)
+				{
+					const wi::scene::MaterialComponent* material = meshlet_scene.materials.GetComponent(mesh->subsets[subsetIndex].materialID);
+					const bool backface_culling = !mesh->IsDoubleSided() && (material == nullptr || !material->IsDoubleSided());
+					visible_meshlets.clear();
+					mesh->CullMeshlets(subsetIndex, frustum, camera_position, backface_culling, visible_meshlets, &statistics);
+				}
+			}
+		}
+		const double cull_milliseconds = timer.elapsed() / camera_count;
+		const float triangles_total = std::max(1.0f, (float)statistics.triangles_total);
+
+		ss += std::string(model) + ": " + std::to_string(meshlet_count) + " meshlets, " + std::to_string(node_count) + " hierarchy nodes, build: " + std::to_string(build_milliseconds) + " ms\n";
+		ss += "\tculled triangles: " + std::to_string(100.0f * statistics.triangles_frustum_culled / triangles_total) + "% by frustum, ";
+		ss += std::to_string(100.0f * statistics.triangles_backface_culled / triangles_total) + "% by normal cone";
+		ss += ", cull: " + std::to_string(cull_milliseconds) + " ms per camera\n";
+	});
+
+	meshlet_scene.Clear();
+
+	// The mesh modifying functions must rebuild the meshlets, and modifications outside of them must invalidate the meshlets:
+	{
+		const uint32_t grid = 64;
+		wi::scene::MeshComponent mesh;
+		for (uint32_t z = 0; z <= grid; ++z)
+		{
+			for (uint32_t x = 0; x <= grid; ++x)
+			{
+				mesh.vertex_positions.push_back(XMFLOAT3(float(x), std::sin(x * 0.3f) * std::cos(z * 0.3f), float(z)));
+			}
+		}
+		for (uint32_t z = 0; z < grid; ++z)
+		{
+			for (uint32_t x = 0; x < grid; ++x)
+			{
+				const uint32_t i = z * (grid + 1) + x;
+				const uint32_t quad[] = { i, i + grid + 1, i + 1, i + 1, i + grid + 1, i + grid + 2 };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + arraysize(quad));
+			}
+		}
+		mesh.subsets.emplace_back().indexCount = (uint32_t)mesh.indices.size();
+		mesh.BuildMeshlets();
+
+		std::string results;
+		auto check = [&](const char* name) {
+			results += std::string(" ") + name + (mesh.HasMeshlets() ? ": OK" : ": FAILED");
+		};
+		check("build");
+		mesh.ComputeNormals(wi::scene::MeshComponent::COMPUTE_NORMALS_HARD);
+		check("hard normals");
+		mesh.ComputeNormals(wi::scene::MeshComponent::COMPUTE_NORMALS_SMOOTH);
+		check("smooth normals");
+		mesh.FlipCulling();
+		check("flip culling");
+		mesh.Recenter();
+		check("recenter");
+		mesh.Optimize();
+		check("optimize");
+
+		mesh.indices.resize(mesh.indices.size() - 3);
+		mesh.subsets.back().indexCount -= 3;
+		results += std::string(" external edit: ") + (mesh.HasMeshlets() ? "FAILED" : "OK");
+		ss += "\nMeshlet invalidation:" + results + "\n";
+	}
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+// The single threaded MeshComponent::ComputeNormals() that the parallel one replaced, it is used to verify that the results are identical
+static void ComputeNormalsReference(MeshComponent& mesh, MeshComponent::COMPUTE_NORMALS compute)
+{
+	if (compute != MeshComponent::COMPUTE_NORMALS_SMOOTH_FAST)
+	{
+		wi::vector<uint32_t> newIndexBuffer;
+		wi::vector<XMFLOAT3> newPositionsBuffer;
+		wi::vector<XMFLOAT3> newNormalsBuffer;
+		wi::vector<XMFLOAT2> newUV0Buffer;
+		for (size_t face = 0; face < mesh.indices.size() / 3; face++)
+		{
+			uint32_t i0 = mesh.indices[face * 3 + 0];
+			uint32_t i1 = mesh.indices[face * 3 + 1];
+			uint32_t i2 = mesh.indices[face * 3 + 2];
+			XMFLOAT3& p0 = mesh.vertex_positions[i0];
+			XMFLOAT3& p1 = mesh.vertex_positions[i1];
+			XMFLOAT3& p2 = mesh.vertex_positions[i2];
+			XMVECTOR U = XMLoadFloat3(&p2) - XMLoadFloat3(&p0);
+			XMVECTOR V = XMLoadFloat3(&p1) - XMLoadFloat3(&p0);
+			XMVECTOR N = XMVector3Cross(U, V);
+			N = XMVector3Normalize(N);
+			XMFLOAT3 normal;
+			XMStoreFloat3(&normal, N);
+			newPositionsBuffer.push_back(p0);
+			newPositionsBuffer.push_back(p1);
+			newPositionsBuffer.push_back(p2);
+			newNormalsBuffer.push_back(normal);
+			newNormalsBuffer.push_back(normal);
+			newNormalsBuffer.push_back(normal);
+			if (!mesh.vertex_uvset_0.empty())
+			{
+				newUV0Buffer.push_back(mesh.vertex_uvset_0[i0]);
+				newUV0Buffer.push_back(mesh.vertex_uvset_0[i1]);
+				newUV0Buffer.push_back(mesh.vertex_uvset_0[i2]);
+			}
+			newIndexBuffer.push_back(static_cast<uint32_t>(newIndexBuffer.size()));
+			newIndexBuffer.push_back(static_cast<uint32_t>(newIndexBuffer.size()));
+			newIndexBuffer.push_back(static_cast<uint32_t>(newIndexBuffer.size()));
+		}
+		mesh.vertex_positions = newPositionsBuffer;
+		mesh.vertex_normals = newNormalsBuffer;
+		mesh.vertex_uvset_0 = newUV0Buffer;
+		mesh.indices = newIndexBuffer;
+	}
+
+	if (compute == MeshComponent::COMPUTE_NORMALS_SMOOTH)
+	{
+		for (size_t i = 0; i < mesh.vertex_normals.size(); i++)
+		{
+			mesh.vertex_normals[i] = XMFLOAT3(0, 0, 0);
+		}
+		for (size_t i = 0; i < mesh.vertex_positions.size(); i++)
+		{
+			XMFLOAT3& v_search_pos = mesh.vertex_positions[i];
+			for (size_t ind = 0; ind < mesh.indices.size() / 3; ++ind)
+			{
+				XMFLOAT3& v0 = mesh.vertex_positions[mesh.indices[ind * 3 + 0]];
+				XMFLOAT3& v1 = mesh.vertex_positions[mesh.indices[ind * 3 + 1]];
+				XMFLOAT3& v2 = mesh.vertex_positions[mesh.indices[ind * 3 + 2]];
+				bool match_pos0 = fabs(v_search_pos.x - v0.x) < FLT_EPSILON && fabs(v_search_pos.y - v0.y) < FLT_EPSILON && fabs(v_search_pos.z - v0.z) < FLT_EPSILON;
+				bool match_pos1 = fabs(v_search_pos.x - v1.x) < FLT_EPSILON && fabs(v_search_pos.y - v1.y) < FLT_EPSILON && fabs(v_search_pos.z - v1.z) < FLT_EPSILON;
+				bool match_pos2 = fabs(v_search_pos.x - v2.x) < FLT_EPSILON && fabs(v_search_pos.y - v2.y) < FLT_EPSILON && fabs(v_search_pos.z - v2.z) < FLT_EPSILON;
+				if (match_pos0 || match_pos1 || match_pos2)
+				{
+					XMVECTOR U = XMLoadFloat3(&v2) - XMLoadFloat3(&v0);
+					XMVECTOR V = XMLoadFloat3(&v1) - XMLoadFloat3(&v0);
+					XMVECTOR N = XMVector3Cross(U, V);
+					N = XMVector3Normalize(N);
+					XMFLOAT3 normal;
+					XMStoreFloat3(&normal, N);
+					mesh.vertex_normals[i].x += normal.x;
+					mesh.vertex_normals[i].y += normal.y;
+					mesh.vertex_normals[i].z += normal.z;
+				}
+			}
+		}
+		for (auto& subset : mesh.subsets)
+		{
+			for (uint32_t i = 0; i < subset.indexCount - 1; i++)
+			{
+				uint32_t ind0 = mesh.indices[subset.indexOffset + (uint32_t)i];
+				const XMFLOAT3& p0 = mesh.vertex_positions[ind0];
+				const XMFLOAT2& u00 = mesh.vertex_uvset_0.empty() ? XMFLOAT2(0, 0) : mesh.vertex_uvset_0[ind0];
+				for (uint32_t j = i + 1; j < subset.indexCount; j++)
+				{
+					uint32_t ind1 = mesh.indices[subset.indexOffset + (uint32_t)j];
+					if (ind1 == ind0)
+					{
+						continue;
+					}
+					const XMFLOAT3& p1 = mesh.vertex_positions[ind1];
+					const XMFLOAT2& u01 = mesh.vertex_uvset_0.empty() ? XMFLOAT2(0, 0) : mesh.vertex_uvset_0[ind1];
+					const bool duplicated_pos = fabs(p0.x - p1.x) < FLT_EPSILON && fabs(p0.y - p1.y) < FLT_EPSILON && fabs(p0.z - p1.z) < FLT_EPSILON;
+					const bool duplicated_uv0 = fabs(u00.x - u01.x) < FLT_EPSILON && fabs(u00.y - u01.y) < FLT_EPSILON;
+					if (duplicated_pos && duplicated_uv0)
+					{
+						mesh.vertex_positions.erase(mesh.vertex_positions.begin() + ind1);
+						mesh.vertex_normals.erase(mesh.vertex_normals.begin() + ind1);
+						if (ind1 < mesh.vertex_uvset_0.size())
+						{
+							mesh.vertex_uvset_0.erase(mesh.vertex_uvset_0.begin() + ind1);
+						}
+						for (auto& index : mesh.indices)
+						{
+							if (index > ind1 && index > 0)
+							{
+								index--;
+							}
+							else if (index == ind1)
+							{
+								index = ind0;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	else if (compute == MeshComponent::COMPUTE_NORMALS_SMOOTH_FAST)
+	{
+		for (size_t i = 0; i < mesh.vertex_normals.size(); i++)
+		{
+			mesh.vertex_normals[i] = XMFLOAT3(0, 0, 0);
+		}
+		for (size_t i = 0; i < mesh.indices.size() / 3; ++i)
+		{
+			uint32_t index1 = mesh.indices[i * 3];
+			uint32_t index2 = mesh.indices[i * 3 + 1];
+			uint32_t index3 = mesh.indices[i * 3 + 2];
+			XMVECTOR side1 = XMLoadFloat3(&mesh.vertex_positions[index1]) - XMLoadFloat3(&mesh.vertex_positions[index3]);
+			XMVECTOR side2 = XMLoadFloat3(&mesh.vertex_positions[index1]) - XMLoadFloat3(&mesh.vertex_positions[index2]);
+			XMVECTOR N = XMVector3Normalize(XMVector3Cross(side1, side2));
+			XMFLOAT3 normal;
+			XMStoreFloat3(&normal, N);
+			for (uint32_t index : { index1, index2, index3 })
+			{
+				mesh.vertex_normals[index].x += normal.x;
+				mesh.vertex_normals[index].y += normal.y;
+				mesh.vertex_normals[index].z += normal.z;
+			}
+		}
+	}
+}
+
+void TestsRenderer::RunComputeNormalsTest()
+{
+	// Wavy grid with two subsets, the vertices at the border of the subsets are duplicated by smooth normals:
+	auto create_grid = [](MeshComponent& mesh, uint32_t resolution) {
+		mesh = {};
+		for (uint32_t z = 0; z <= resolution; ++z)
+		{
+			for (uint32_t x = 0; x <= resolution; ++x)
+			{
+				const float fx = float(x) / resolution;
+				const float fz = float(z) / resolution;
+				mesh.vertex_positions.push_back(XMFLOAT3(fx * 100, std::sin(fx * 40) * std::cos(fz * 30) * 2, fz * 100));
+				mesh.vertex_normals.push_back(XMFLOAT3(0, 1, 0));
+				mesh.vertex_uvset_0.push_back(XMFLOAT2(fx, fz));
+			}
+		}
+		for (uint32_t z = 0; z < resolution; ++z)
+		{
+			for (uint32_t x = 0; x < resolution; ++x)
+			{
+				const uint32_t i = z * (resolution + 1) + x;
+				mesh.indices.push_back(i);
+				mesh.indices.push_back(i + resolution + 1);
+				mesh.indices.push_back(i + 1);
+				mesh.indices.push_back(i + 1);
+				mesh.indices.push_back(i + resolution + 1);
+				mesh.indices.push_back(i + resolution + 2);
+			}
+		}
+		const uint32_t half = uint32_t(mesh.indices.size() / 6) * 3;
+		MeshComponent::MeshSubset& subset0 = mesh.subsets.emplace_back();
+		subset0.indexOffset = 0;
+		subset0.indexCount = half;
+		MeshComponent::MeshSubset& subset1 = mesh.subsets.emplace_back();
+		subset1.indexOffset = half;
+		subset1.indexCount = uint32_t(mesh.indices.size()) - half;
+	};
+	auto identical = [](const MeshComponent& a, const MeshComponent& b) {
+		auto equal = [](const auto& x, const auto& y) {
+			return x.size() == y.size() && (x.empty() || std::memcmp(x.data(), y.data(), x.size() * sizeof(x[0])) == 0);
+		};
+		return
+			equal(a.vertex_positions, b.vertex_positions) &&
+			equal(a.vertex_normals, b.vertex_normals) &&
+			equal(a.vertex_uvset_0, b.vertex_uvset_0) &&
+			equal(a.indices, b.indices);
+	};
+
+	const char* names[] = { "HARD", "SMOOTH", "SMOOTH_FAST" };
+	const MeshComponent::COMPUTE_NORMALS modes[] = {
+		MeshComponent::COMPUTE_NORMALS_HARD,
+		MeshComponent::COMPUTE_NORMALS_SMOOTH,
+		MeshComponent::COMPUTE_NORMALS_SMOOTH_FAST,
+	};
+
+	std::string ss = "Compute normals test, the parallel implementation is compared against the previous single threaded one\n";
+	ss += "The previous smooth normals are quadratic, so they are only compared on a small mesh\n";
+	ss += "You can find out more in Tests.cpp, RunComputeNormalsTest() function.\n\n";
+
+	static MeshComponent mesh;
+	static MeshComponent reference;
+	const uint32_t resolutions[] = { 24, 1582 }; // 1152 and 5005448 triangles
+	for (uint32_t resolution : resolutions)
+	{
+		ss += std::to_string(resolution * resolution * 2) + " triangles:\n";
+		for (int i = 0; i < arraysize(modes); ++i)
+		{
+			create_grid(mesh, resolution);
+			wi::Timer timer;
+			mesh.ComputeNormals(modes[i]);
+			const double milliseconds = timer.elapsed();
+			ss += std::string("\t") + names[i] + ": " + std::to_string(milliseconds) + " ms, " + std::to_string(mesh.vertex_positions.size()) + " vertices";
+
+			if (modes[i] != MeshComponent::COMPUTE_NORMALS_SMOOTH || resolution < 100)
+			{
+				create_grid(reference, resolution);
+				timer.record_elapsed_seconds();
+				ComputeNormalsReference(reference, modes[i]);
+				const double reference_milliseconds = timer.elapsed();
+				ss += ", previous: " + std::to_string(reference_milliseconds) + " ms, ";
+				ss += identical(mesh, reference) ? "identical" : "DIFFERENT";
+			}
+			ss += "\n";
+		}
+	}
+	mesh = {};
+	reference = {};
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunAtlasGenerationTest()
+{
+	// Lathe meshes with random profiles, like the props of a level, every fourth mesh is a copy of an other one:
+	auto create_lathe = [](MeshComponent& mesh, uint32_t seed) {
+		mesh = {};
+		std::mt19937 rand(seed);
+		std::uniform_real_distribution<float> distribution(0.2f, 1.0f);
+		const uint32_t sectors = 8 + seed % 17;
+		const uint32_t rings = 4 + seed % 9;
+		wi::vector<float> radius(rings + 1);
+		for (auto& x : radius)
+		{
+			x = distribution(rand);
+		}
+		for (uint32_t ring = 0; ring <= rings; ++ring)
+		{
+			for (uint32_t sector = 0; sector <= sectors; ++sector)
+			{
+				const float angle = XM_2PI * sector / sectors;
+				const XMFLOAT3 normal = XMFLOAT3(std::cos(angle), 0, std::sin(angle));
+				mesh.vertex_positions.push_back(XMFLOAT3(normal.x * radius[ring], float(ring) / rings * 2, normal.z * radius[ring]));
+				mesh.vertex_normals.push_back(normal);
+				mesh.vertex_uvset_0.push_back(XMFLOAT2(float(sector) / sectors, float(ring) / rings));
+			}
+		}
+		for (uint32_t ring = 0; ring < rings; ++ring)
+		{
+			for (uint32_t sector = 0; sector < sectors; ++sector)
+			{
+				const uint32_t i = ring * (sectors + 1) + sector;
+				mesh.indices.push_back(i);
+				mesh.indices.push_back(i + sectors + 1);
+				mesh.indices.push_back(i + 1);
+				mesh.indices.push_back(i + 1);
+				mesh.indices.push_back(i + sectors + 1);
+				mesh.indices.push_back(i + sectors + 2);
+			}
+		}
+		MeshComponent::MeshSubset& subset = mesh.subsets.emplace_back();
+		subset.indexOffset = 0;
+		subset.indexCount = (uint32_t)mesh.indices.size();
+	};
+
+	const uint32_t mesh_count = 2000;
+	const uint32_t resolution = 128;
+	static wi::vector<MeshComponent> meshes;
+	meshes.resize(mesh_count);
+	wi::vector<MeshComponent*> mesh_pointers(mesh_count);
+	size_t triangle_count = 0;
+	auto create_level = [&]() {
+		triangle_count = 0;
+		for (uint32_t i = 0; i < mesh_count; ++i)
+		{
+			create_lathe(meshes[i], i % 4 == 3 ? i - 3 : i);
+			mesh_pointers[i] = &meshes[i];
+			triangle_count += meshes[i].indices.size() / 3;
+		}
+	};
+	auto statistics_text = [](const MeshComponent::AtlasGenerationStatistics& statistics) {
+		return
+			"generated: " + std::to_string(statistics.generated_count) +
+			", reused: " + std::to_string(statistics.reused_count) +
+			", skipped: " + std::to_string(statistics.skipped_count) +
+			", failed: " + std::to_string(statistics.failed_count);
+	};
+
+	std::string ss = "Lightmap atlas generation test for " + std::to_string(mesh_count) + " meshes with xatlas\n";
+	ss += "You can find out more in Tests.cpp, RunAtlasGenerationTest() function.\n\n";
+
+	// One mesh at a time without cache, like the editor used to do it:
+	create_level();
+	ss += std::to_string(triangle_count) + " triangles, atlas resolution: " + std::to_string(resolution) + "\n";
+	wi::Timer timer;
+	for (auto& mesh : meshes)
+	{
+		mesh.GenerateAtlas(resolution);
+	}
+	ss += "One mesh at a time: " + std::to_string(timer.elapsed()) + " ms\n";
+
+	create_level();
+	MeshComponent::AtlasCache cache;
+	MeshComponent::AtlasGenerationStatistics statistics;
+	timer.record_elapsed_seconds();
+	MeshComponent::GenerateAtlases(mesh_pointers.data(), mesh_pointers.size(), resolution, nullptr, &cache, &statistics);
+	ss += "Parallel: " + std::to_string(timer.elapsed()) + " ms (" + statistics_text(statistics) + ")\n";
+
+	timer.record_elapsed_seconds();
+	MeshComponent::GenerateAtlases(mesh_pointers.data(), mesh_pointers.size(), resolution, nullptr, &cache, &statistics);
+	ss += "Parallel, unchanged level: " + std::to_string(timer.elapsed()) + " ms (" + statistics_text(statistics) + ")\n";
+
+	for (uint32_t i = 0; i < mesh_count; i += 10)
+	{
+		for (auto& position : meshes[i].vertex_positions)
+		{
+			position.y *= 1.5f;
+		}
+	}
+	timer.record_elapsed_seconds();
+	MeshComponent::GenerateAtlases(mesh_pointers.data(), mesh_pointers.size(), resolution, nullptr, &cache, &statistics);
+	ss += "Parallel, 10% of meshes modified: " + std::to_string(timer.elapsed()) + " ms (" + statistics_text(statistics) + ")\n";
+	ss += "Cache entries: " + std::to_string(cache.entries.size()) + "\n";
+
+	// The cache is trimmed to the least recently used entries when it exceeds the limit:
+	cache.max_entries = 100;
+	MeshComponent::GenerateAtlases(mesh_pointers.data(), mesh_pointers.size(), resolution, nullptr, &cache, &statistics);
+	ss += "Cache entries with limit of " + std::to_string(cache.max_entries) + ": " + std::to_string(cache.entries.size()) + (cache.entries.size() <= cache.max_entries ? " (OK)\n" : " (FAILED)\n");
+
+	meshes.clear();
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
+
+void TestsRenderer::RunImpostorLODTest()
+{
+	// Forest of 8 tree types on 4x4 km, with larger trees switching to impostor farther away:
+	const uint32_t instance_count = 500000;
+	const uint32_t type_count = 8;
+	const float forest_size = 4000;
+	wi::vector<wi::ImpostorLOD::Instance> instances(instance_count);
+	std::mt19937 rand(42);
+	std::uniform_real_distribution<float> distribution(-0.5f, 0.5f);
+	for (uint32_t i = 0; i < instance_count; ++i)
+	{
+		wi::ImpostorLOD::Instance& instance = instances[i];
+		instance.center = XMFLOAT3(distribution(rand) * forest_size, 5 + distribution(rand) * 4, distribution(rand) * forest_size);
+		instance.type = i % type_count;
+		instance.distance = 100 + instance.type * 25 - 5; // swap in distance - radius
+		instance.id = i;
+	}
+
+	// Reference selection that scans every instance, like it was done for every object every frame:
+	wi::vector<wi::vector<uint32_t>> full_scan(type_count);
+	auto run_full_scan = [&](const XMFLOAT3& eye) {
+		for (auto& x : full_scan)
+		{
+			x.clear();
+		}
+		for (const wi::ImpostorLOD::Instance& instance : instances)
+		{
+			if (wi::math::Distance(eye, instance.center) >= instance.distance)
+			{
+				full_scan[instance.type].push_back(instance.id);
+			}
+		}
+	};
+	auto walk = [](uint32_t frame) {
+		// Walking outwards from the center of the forest on a spiral:
+		const float angle = frame * 0.002f;
+		return XMFLOAT3(std::sin(angle) * frame * 1.5f, 2, std::cos(angle) * frame * 1.5f * 0.5f);
+	};
+
+	std::string ss = "Impostor LOD selection test for a forest of " + std::to_string(instance_count) + " instances, " + std::to_string(type_count) + " impostor types\n";
+	ss += "You can find out more in Tests.cpp, RunImpostorLODTest() function.\n\n";
+
+	wi::ImpostorLOD lod;
+	wi::ImpostorLOD::Statistics statistics;
+	wi::Timer timer;
+	lod.Build(instances.data(), instance_count);
+	ss += "Build: " + std::to_string(timer.elapsed()) + " ms\n";
+
+	timer.record_elapsed_seconds();
+	lod.Update(walk(0), &statistics);
+	ss += "First update: " + std::to_string(timer.elapsed()) + " ms (" + std::to_string(statistics.cell_count) + " cells, " + std::to_string(statistics.selected_count) + " selected)\n";
+
+	const uint32_t frame_count = 2000;
+	double update_time = 0;
+	double update_time_max = 0;
+	uint64_t cells_evaluated = 0;
+	uint64_t instances_evaluated = 0;
+	uint32_t changed_frames = 0;
+	for (uint32_t frame = 1; frame <= frame_count; ++frame)
+	{
+		timer.record_elapsed_seconds();
+		lod.Update(walk(frame), &statistics);
+		const double elapsed = timer.elapsed();
+		update_time += elapsed;
+		update_time_max = std::max(update_time_max, elapsed);
+		cells_evaluated += statistics.cells_evaluated;
+		instances_evaluated += statistics.instances_evaluated;
+		changed_frames += statistics.changed ? 1 : 0;
+	}
+	ss += "Incremental update while walking, average: " + std::to_string(update_time / frame_count) + " ms, max: " + std::to_string(update_time_max) + " ms\n";
+	ss += "\tper frame: " + std::to_string(cells_evaluated / frame_count) + " cells, " + std::to_string(instances_evaluated / frame_count) + " instances evaluated, selection changed in " + std::to_string(changed_frames) + " of " + std::to_string(frame_count) + " frames\n";
+
+	timer.record_elapsed_seconds();
+	lod.Update(walk(frame_count), &statistics);
+	ss += "Update without camera movement: " + std::to_string(timer.elapsed()) + " ms (" + std::to_string(statistics.cells_evaluated) + " cells evaluated)\n";
+
+	const uint32_t full_scan_count = 100;
+	timer.record_elapsed_seconds();
+	for (uint32_t frame = frame_count - full_scan_count + 1; frame <= frame_count; ++frame)
+	{
+		run_full_scan(walk(frame));
+	}
+	ss += "Full scan of all instances every frame, average: " + std::to_string(timer.elapsed() / full_scan_count) + " ms\n";
+
+	bool match = true;
+	for (const wi::ImpostorLOD::Batch& batch : lod.batches)
+	{
+		wi::vector<uint32_t> ids = batch.ids;
+		std::sort(ids.begin(), ids.end());
+		match &= ids == full_scan[batch.type];
+	}
+	ss += std::string("Incremental selection matches full scan: ") + (match ? "yes" : "NO") + "\n";
+
+	timer.record_elapsed_seconds();
+	lod.Update(XMFLOAT3(-1500, 2, 1500), &statistics);
+	ss += "Teleport: " + std::to_string(timer.elapsed()) + " ms (" + std::to_string(statistics.cells_evaluated) + " cells, " + std::to_string(statistics.instances_evaluated) + " instances evaluated)\n";
+
+	static wi::SpriteFont font;
+	font = wi::SpriteFont(ss);
+	font.params.posX = GetLogicalWidth() / 2;
+	font.params.posY = GetLogicalHeight() / 2;
+	font.params.h_align = wi::font::WIFALIGN_CENTER;
+	font.params.v_align = wi::font::WIFALIGN_CENTER;
+	font.params.size = 24;
+	this->AddFont(&font);
+}
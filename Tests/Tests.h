@@ -17,6 +17,29 @@ public:
 	void RunSpriteTest();
 	void RunNetworkTest();
 	void ContainerTest();
+	void RunAsyncResourceLoadingTest();
+	void RunResourceCacheTest();
+	void RunTextureStreamingTest();
+	void RunPackageTest();
+	void RunTextureTranscodingTest();
+	void RunNoisePerformanceTest();
+	void RunTerrainGenerationTest();
+	void RunTerrainDiskCacheTest();
+	void RunTerrainHeightQueryTest();
+	void RunPhysicsQueryTest();
+	void RunPhysicsSimulationTest();
+	void RunPhysicsFixedTimeStepTest();
+	void RunPhysicsShapeCacheTest();
+	void RunSpringColliderTest();
+	void RunInverseKinematicsPerformanceTest();
+	void RunMorphTargetPerformanceTest();
+	void RunLODGenerationTest();
+	void RunMeshOptimizationTest();
+	void RunVertexQuantizationTest();
+	void RunMeshletCullingTest();
+	void RunComputeNormalsTest();
+	void RunAtlasGenerationTest();
+	void RunImpostorLODTest();
 };
 
 class Tests : public wi::Application
@@ -21,6 +21,7 @@ subject to the following restrictions:
 #include "BulletCollision/NarrowPhaseCollision/btGjkEpaPenetrationDepthSolver.h"
 #include "BulletCollision/CollisionShapes/btSphereShape.h" //for raycasting
 #include "BulletCollision/CollisionShapes/btBvhTriangleMeshShape.h" //for raycasting
+#include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h" //for raycasting
 #include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 #include "BulletCollision/CollisionShapes/btCompoundShape.h"
 #include "BulletCollision/NarrowPhaseCollision/btSubSimplexConvexCast.h"
@@ -387,6 +388,42 @@ void	btCollisionWorld::rayTestSingleInternal(const btTransform& rayFromTrans,con
 				rcb.m_hitFraction = resultCallback.m_closestHitFraction;
 				triangleMesh->performRaycast(&rcb,rayFromLocal,rayToLocal);
 			}
+			else if (collisionShape->getShapeType()==SCALED_TRIANGLE_MESH_SHAPE_PROXYTYPE &&
+				((btScaledBvhTriangleMeshShape*)collisionShape)->getLocalScaling().x() != btScalar(0) &&
+				((btScaledBvhTriangleMeshShape*)collisionShape)->getLocalScaling().y() != btScalar(0) &&
+				((btScaledBvhTriangleMeshShape*)collisionShape)->getLocalScaling().z() != btScalar(0))
+			{
+				///WickedEngine modification (see the Physics section of WickedEngine-Documentation.md):
+				///optimized version for btScaledBvhTriangleMeshShape, the ray is traversed in the unscaled space of the shared child bvh
+				///the hit fraction doesn't change with scaling, the normal is transformed by the inverse scaling
+				struct ScaledBridgeTriangleRaycastCallback : public BridgeTriangleRaycastCallback
+				{
+					btVector3 m_invScaling;
+
+					ScaledBridgeTriangleRaycastCallback(const btVector3& from,const btVector3& to,
+						btCollisionWorld::RayResultCallback* resultCallback, const btCollisionObject* collisionObject,const btConcaveShape* triangleMesh,const btTransform& colObjWorldTransform,const btVector3& invScaling):
+						BridgeTriangleRaycastCallback(from,to,resultCallback,collisionObject,triangleMesh,colObjWorldTransform),
+						m_invScaling(invScaling)
+					{
+					}
+
+					virtual btScalar reportHit(const btVector3& hitNormalLocal, btScalar hitFraction, int partId, int triangleIndex )
+					{
+						return BridgeTriangleRaycastCallback::reportHit((hitNormalLocal * m_invScaling).normalized(), hitFraction, partId, triangleIndex);
+					}
+				};
+
+				btScaledBvhTriangleMeshShape* scaledMesh = (btScaledBvhTriangleMeshShape*)collisionShape;
+				btBvhTriangleMeshShape* triangleMesh = scaledMesh->getChildShape();
+				const btVector3& scaling = scaledMesh->getLocalScaling();
+				const btVector3 invScaling(btScalar(1.0) / scaling.x(), btScalar(1.0) / scaling.y(), btScalar(1.0) / scaling.z());
+				const btVector3 rayFromUnscaled = rayFromLocal * invScaling;
+				const btVector3 rayToUnscaled = rayToLocal * invScaling;
+
+				ScaledBridgeTriangleRaycastCallback rcb(rayFromUnscaled,rayToUnscaled,&resultCallback,collisionObjectWrap->getCollisionObject(),triangleMesh,colObjWorldTransform,invScaling);
+				rcb.m_hitFraction = resultCallback.m_closestHitFraction;
+				triangleMesh->performRaycast(&rcb,rayFromUnscaled,rayToUnscaled);
+			}
 			else if(collisionShape->getShapeType()==GIMPACT_SHAPE_PROXYTYPE)
 			{
 				btGImpactMeshShape* concaveShape = (btGImpactMeshShape*)collisionShape;
@@ -21,6 +21,10 @@
 #define QOI_IMPLEMENTATION
 #include "qoi.h"
 
+// xatlas doesn't start its own threads, the engine generates atlases in parallel with the job system:
+#define XA_MULTITHREADED 0
+#include "xatlas/xatlas.cpp"
+
 
 
 // Basis Universal library sources are compiled below for simplicity:
@@ -59,6 +59,7 @@
 #include "wiFFTGenerator.h"
 #include "wiArguments.h"
 #include "wiGPUBVH.h"
+#include "wiBVH.h"
 #include "wiGPUSortLib.h"
 #include "wiJobSystem.h"
 #include "wiNetwork.h"
@@ -71,6 +72,8 @@
 #include "wiNoise.h"
 #include "wiConfig.h"
 #include "wiTerrain.h"
+#include "wiPackage.h"
+#include "wiImpostorLOD.h"
 
 #ifdef _WIN32
 #ifdef PLATFORM_UWP
@@ -0,0 +1,70 @@
+#include "WickedEngine.h"
+
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <string>
+
+int main(int argc, char* argv[])
+{
+	std::cout << "[Wicked Engine Offline Packager]" << std::endl;
+	std::cout << "Usage: offlinepackager <input directory> <output package> [compress]" << std::endl;
+	std::cout << "\tinput directory : \tAll files in this directory and its subdirectories will be packaged, with names relative to this directory" << std::endl;
+	std::cout << "\toutput package : \tThe package file to write, it can be mounted with wi::resourcemanager::MountPackage()" << std::endl;
+	std::cout << "\tcompress : \tFile contents will be compressed" << std::endl;
+
+	if (argc < 3)
+	{
+		std::cout << "Not enough command arguments!" << std::endl;
+		return -1;
+	}
+	const std::string input_directory = argv[1];
+	const std::string output_filename = argv[2];
+	bool compress = false;
+	for (int i = 3; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "compress")
+		{
+			compress = true;
+		}
+	}
+
+	std::error_code ec;
+	if (!std::filesystem::is_directory(input_directory, ec))
+	{
+		std::cout << "Input directory not found: " << input_directory << std::endl;
+		return -1;
+	}
+
+	wi::vector<wi::package::Entry> entries;
+	for (auto& it : std::filesystem::recursive_directory_iterator(input_directory, ec))
+	{
+		if (!it.is_regular_file())
+			continue;
+		wi::package::Entry& entry = entries.emplace_back();
+		entry.filename = it.path().string();
+		entry.name = std::filesystem::relative(it.path(), input_directory).generic_string();
+		entry.compress = compress;
+	}
+	// Sorted names result in the same package for the same input:
+	std::sort(entries.begin(), entries.end(), [](const wi::package::Entry& a, const wi::package::Entry& b) {
+		return a.name < b.name;
+	});
+
+	wi::Timer timer;
+	wi::package::WriteStatistics statistics;
+	if (!wi::package::Write(output_filename, entries, &statistics))
+	{
+		std::cout << "Writing package failed: " << output_filename << std::endl;
+		return -1;
+	}
+
+	std::cout << "Package written: " << output_filename << std::endl;
+	std::cout << "\tfiles: " << statistics.file_count << std::endl;
+	std::cout << "\tunique payloads: " << statistics.unique_count << std::endl;
+	std::cout << "\toriginal size: " << statistics.original_size << " bytes" << std::endl;
+	std::cout << "\tpackage size: " << statistics.package_size << " bytes" << std::endl;
+	std::cout << "\ttime: " << std::setprecision(4) << timer.elapsed_seconds() << " seconds" << std::endl;
+
+	return 0;
+}
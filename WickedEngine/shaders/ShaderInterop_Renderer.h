@@ -254,6 +254,7 @@ struct VisibilityTile
 static const uint SHADERMESH_FLAG_DOUBLE_SIDED = 1 << 0;
 static const uint SHADERMESH_FLAG_HAIRPARTICLE = 1 << 1;
 static const uint SHADERMESH_FLAG_EMITTEDPARTICLE = 1 << 2;
+static const uint SHADERMESH_FLAG_QUANTIZED_POSITIONS = 1 << 3; // vb_pos_nor_wind contains MeshComponent::Vertex_POS16, dequantized with aabb_min, aabb_max
 
 // This is equivalent to a Mesh + MeshSubset
 //	But because these are always loaded toghether by shaders, they are unrolled into one to reduce individual buffer loads
@@ -272,7 +273,7 @@ struct ShaderGeometry
 	uint materialIndex;
 	uint meshletOffset; // offset of this subset in meshlets
 	uint meshletCount;
-	int impostorSliceOffset;
+	uint impostorAtlasRect; // 0 if there is no impostor, otherwise packed with pack_impostor_atlas_rect()
 
 	float3 aabb_min;
 	uint flags;
@@ -294,7 +295,7 @@ struct ShaderGeometry
 		materialIndex = 0;
 		meshletOffset = 0;
 		meshletCount = 0;
-		impostorSliceOffset = -1;
+		impostorAtlasRect = 0;
 
 		aabb_min = float3(0, 0, 0);
 		flags = 0;
@@ -647,6 +648,21 @@ static const uint VISIBILITY_BLOCKSIZE = 8;
 static const uint VISIBILITY_TILED_CULLING_GRANULARITY = TILED_CULLING_BLOCKSIZE / VISIBILITY_BLOCKSIZE;
 
 static const int impostorCaptureAngles = 36;
+static const uint impostorCaptureGrid = 6; // the capture angles of an impostor are laid out in a square grid in the atlas
+static const uint IMPOSTOR_ATLAS_GRANULARITY = 16; // impostor atlas rects are aligned to this many texels
+
+// Packs the top left corner of an impostor in the atlas and the size of one capture angle in it, in IMPOSTOR_ATLAS_GRANULARITY units
+inline uint pack_impostor_atlas_rect(uint x, uint y, uint cell_size)
+{
+	return (x & 0x3FF) | ((y & 0x3FF) << 10u) | ((cell_size & 0xFFF) << 20u);
+}
+
+struct ImpostorPreparePush
+{
+	uint instance_count; // number of instance indices in the candidate buffer
+	uint padding;
+	float2 atlas_resolution_rcp;
+};
 
 // These option bits can be read from options constant buffer value:
 static const uint OPTION_BIT_TEMPORALAA_ENABLED = 1 << 0;
@@ -32,9 +32,9 @@ void main(uint3 DTid : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
 	uint i1 = bindless_ib[geometry.ib][startIndex + 1];
 	uint i2 = bindless_ib[geometry.ib][startIndex + 2];
 
-	uint4 data0 = bindless_buffers[geometry.vb_pos_nor_wind].Load4(i0 * 16);
-	uint4 data1 = bindless_buffers[geometry.vb_pos_nor_wind].Load4(i1 * 16);
-	uint4 data2 = bindless_buffers[geometry.vb_pos_nor_wind].Load4(i2 * 16);
+	uint4 data0 = load_vertex_pos_nor_wind(geometry, bindless_buffers[geometry.vb_pos_nor_wind], i0);
+	uint4 data1 = load_vertex_pos_nor_wind(geometry, bindless_buffers[geometry.vb_pos_nor_wind], i1);
+	uint4 data2 = load_vertex_pos_nor_wind(geometry, bindless_buffers[geometry.vb_pos_nor_wind], i2);
 	float3 p0 = asfloat(data0.xyz);
 	float3 p1 = asfloat(data1.xyz);
 	float3 p2 = asfloat(data2.xyz);
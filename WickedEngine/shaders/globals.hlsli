@@ -952,6 +952,28 @@ float3 decode_hemioct(float2 e)
 	return normalize(v);
 }
 
+// Loads a vertex from the vb_pos_nor_wind buffer of a geometry in the full precision layout (float3 position, uint normal_wind)
+//	Quantized positions are 16-bit normalized within the geometry bounds with an octahedral normal (MeshComponent::Vertex_POS16)
+inline uint4 load_vertex_pos_nor_wind(in ShaderGeometry geometry, in ByteAddressBuffer buf, in uint vertexID)
+{
+	[branch]
+	if (geometry.flags & SHADERMESH_FLAG_QUANTIZED_POSITIONS)
+	{
+		const uint2 data = buf.Load2(vertexID * sizeof(uint2));
+		const float3 snorm = max(-1, float3(
+			(int)(data.x << 16u) >> 16,
+			(int)data.x >> 16,
+			(int)(data.y << 16u) >> 16
+		) / 32767.0);
+		const float3 center = (geometry.aabb_min + geometry.aabb_max) * 0.5;
+		const float3 extent = (geometry.aabb_max - geometry.aabb_min) * 0.5;
+		const float3 position = center + snorm * extent;
+		const float3 normal = decode_oct(float2((data.y >> 16u) & 0xFF, (data.y >> 24u) & 0xFF) / 255.0 * 2 - 1);
+		return uint4(asuint(position), pack_unitvector(normal) | (0xFFu << 24u));
+	}
+	return buf.Load4(vertexID * sizeof(uint4));
+}
+
 // Source: https://github.com/GPUOpen-Effects/FidelityFX-Denoiser/blob/master/ffx-shadows-dnsr/ffx_denoiser_shadows_util.h
 //  LANE TO 8x8 MAPPING
 //  ===================
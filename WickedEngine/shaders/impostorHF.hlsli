@@ -5,12 +5,12 @@ struct VSOut
 {
 	precise float4 pos				: SV_Position;
 	float2 uv						: TEXCOORD;
-	uint slice						: SLICE;
 	nointerpolation float dither	: DITHER;
 	float3 pos3D					: WORLDPOSITION;
 	uint instanceColor				: COLOR;
 };
 
+// The impostor atlas has 3 slices: color, normal, surface
 Texture2DArray<float4> impostorTex : register(t1);
 
 #endif // WI_IMPOSTOR_HF
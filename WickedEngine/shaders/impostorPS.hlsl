@@ -5,9 +5,9 @@
 [earlydepthstencil]
 float4 main(VSOut input) : SV_Target
 {
-	float3 uv_col = float3(input.uv, input.slice);
-	float3 uv_nor = float3(input.uv, input.slice + 1);
-	float3 uv_sur = float3(input.uv, input.slice + 2);
+	float3 uv_col = float3(input.uv, 0);
+	float3 uv_nor = float3(input.uv, 1);
+	float3 uv_sur = float3(input.uv, 2);
 
 	float4 baseColor = impostorTex.Sample(sampler_linear_clamp, uv_col);
 	baseColor.rgb = DEGAMMA(baseColor.rgb);
@@ -5,7 +5,7 @@
 uint main(VSOut input, in uint primitiveID : SV_PrimitiveID, out uint coverage : SV_Coverage) : SV_Target
 {
 	clip(dither(input.pos.xy + GetTemporalAASampleRotation()) - input.dither);
-	float3 uv_col = float3(input.uv, input.slice);
+	float3 uv_col = float3(input.uv, 0);
 	float alpha = impostorTex.Sample(sampler_linear_clamp, uv_col).a;
 	coverage = AlphaToCoverage(alpha, 0.75, input.pos);
 
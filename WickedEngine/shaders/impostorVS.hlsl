@@ -13,14 +13,15 @@ ByteAddressBuffer impostor_data : register(t2);
 
 VSOut main(uint vertexID : SV_VertexID)
 {
-	uint2 data = impostor_data.Load2((vertexID / 4u) * sizeof(uint2));
+	uint4 data = impostor_data.Load4((vertexID / 4u) * sizeof(uint4));
+	const float2 uv_offset = float2(data.z & 0xFFFF, data.z >> 16u) / 65535.0;
+	const float2 uv_size = float2(data.w & 0xFFFF, data.w >> 16u) / 65535.0;
 
 	VSOut Out;
 	Out.pos3D = asfloat(vb_pos_nor.Load3(vertexID * sizeof(uint4)));
 	Out.pos = mul(GetCamera().view_projection, float4(Out.pos3D, 1));
-	Out.uv = float2(BILLBOARD[vertexID % 4u] * float2(0.5f, -0.5f) + 0.5f);
-	Out.slice = data.x & 0xFFFFFF;
-	Out.dither = float((data.x >> 24u) & 0xFF) / 255.0;
+	Out.uv = uv_offset + float2(BILLBOARD[vertexID % 4u] * float2(0.5f, -0.5f) + 0.5f) * uv_size;
+	Out.dither = float(data.x & 0xFF) / 255.0;
 	Out.instanceColor = data.y;
 	return Out;
 }
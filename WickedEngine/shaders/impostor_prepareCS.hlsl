@@ -9,30 +9,34 @@ static const float3 BILLBOARD[] = {
 	float3(1, 1, 0),
 };
 
+ByteAddressBuffer input_instances : register(t0); // instance indices that were selected on the CPU to be in impostor distance
+
 RWBuffer<uint> output_indices : register(u0);
 RWByteAddressBuffer output_vertices_pos_nor : register(u1);
 RWByteAddressBuffer output_impostor_data : register(u2);
 RWStructuredBuffer<IndirectDrawArgsIndexedInstanced> output_indirect : register(u3);
 
-struct ObjectCount
+PUSHCONSTANT(push, ImpostorPreparePush);
+
+inline uint pack_unorm16x2(float2 value)
 {
-	uint count;
-};
-PUSHCONSTANT(push, ObjectCount);
+	const uint2 u = uint2(saturate(value) * 65535.0 + 0.5);
+	return u.x | (u.y << 16u);
+}
 
 [numthreads(THREADCOUNT, 1, 1)]
 void main(uint3 DTid : SV_DispatchThreadID)
 {
 	[branch]
-	if (DTid.x >= push.count)
+	if (DTid.x >= push.instance_count)
 		return;
 
-	const uint instanceIndex = DTid.x;
+	const uint instanceIndex = input_instances.Load(DTid.x * sizeof(uint));
 	ShaderMeshInstance instance = load_instance(instanceIndex);
 	ShaderGeometry geometry = load_geometry(instance.geometryOffset);
 
 	[branch]
-	if (geometry.impostorSliceOffset < 0)
+	if (geometry.impostorAtlasRect == 0)
 		return;
 
 	float dist = distance(GetCamera().position, instance.center);
@@ -71,8 +75,7 @@ void main(uint3 DTid : SV_DispatchThreadID)
 	face = normalize(face);
 	float3 right = normalize(cross(face, up));
 
-	// Decide which slice to show according to billboard facing direction:
-	uint slice = uint(geometry.impostorSliceOffset);
+	// Decide which capture angle to show according to billboard facing direction:
 	float angle = acos(dot(face.xz, float2(0, 1))) / PI;
 	if (cross(face, float3(0, 0, 1)).y < 0)
 	{
@@ -80,16 +83,26 @@ void main(uint3 DTid : SV_DispatchThreadID)
 	}
 	angle *= 0.5f;
 	angle = saturate(angle - 0.0001);
-	slice += uint(angle * impostorCaptureAngles) * 3;
+	const uint capture = uint(angle * impostorCaptureAngles);
+
+	// Atlas region of the capture angle, inset by half texel to not filter from the neighbors:
+	//	The uvs are stored as unorm16, which is precise to a quarter texel in the largest atlas, so the inset is still respected
+	const uint rect = geometry.impostorAtlasRect;
+	const float cell_size = float((rect >> 20u) & 0xFFF) * IMPOSTOR_ATLAS_GRANULARITY;
+	float2 cell_offset = float2(rect & 0x3FF, (rect >> 10u) & 0x3FF) * IMPOSTOR_ATLAS_GRANULARITY;
+	cell_offset += float2(capture % impostorCaptureGrid, capture / impostorCaptureGrid) * cell_size;
+	const float2 uv_offset = (cell_offset + 0.5) * push.atlas_resolution_rcp;
+	const float2 uv_size = (cell_size - 1) * push.atlas_resolution_rcp;
 
 	const float dither = max(0, instance.fadeDistance - dist) / instance.radius;
 
 	// Write out per impostor data:
-	uint2 data = 0;
-	data.x |= slice & 0xFFFFFF;
-	data.x |= (uint(dither * 255) & 0xFF) << 24u;
+	uint4 data = 0;
+	data.x = uint(dither * 255) & 0xFF;
 	data.y = instance.color;
-	output_impostor_data.Store2(impostorOffset * sizeof(uint2), data);
+	data.z = pack_unorm16x2(uv_offset);
+	data.w = pack_unorm16x2(uv_size);
+	output_impostor_data.Store4(impostorOffset * sizeof(uint4), data);
 
 	// Write out vertices:
 	for (uint vertexID = 0; vertexID < 4; ++vertexID)
@@ -134,11 +134,11 @@ struct VertexInput
 
 	float4 GetPosition()
 	{
-		return float4(bindless_buffers[GetMesh().vb_pos_nor_wind].Load<float3>(vertexID * sizeof(uint4)), 1);
+		return float4(asfloat(load_vertex_pos_nor_wind(GetMesh(), bindless_buffers[GetMesh().vb_pos_nor_wind], vertexID).xyz), 1);
 	}
 	float3 GetNormal()
 	{
-		const uint normal_wind = bindless_buffers[GetMesh().vb_pos_nor_wind].Load<uint4>(vertexID * sizeof(uint4)).w;
+		const uint normal_wind = load_vertex_pos_nor_wind(GetMesh(), bindless_buffers[GetMesh().vb_pos_nor_wind], vertexID).w;
 		float3 normal;
 		normal.x = (float)((normal_wind >> 0u) & 0xFF) / 255.0 * 2 - 1;
 		normal.y = (float)((normal_wind >> 8u) & 0xFF) / 255.0 * 2 - 1;
@@ -147,7 +147,7 @@ struct VertexInput
 	}
 	float GetWindWeight()
 	{
-		const uint normal_wind = bindless_buffers[GetMesh().vb_pos_nor_wind].Load<uint4>(vertexID * sizeof(uint4)).w;
+		const uint normal_wind = load_vertex_pos_nor_wind(GetMesh(), bindless_buffers[GetMesh().vb_pos_nor_wind], vertexID).w;
 		return ((normal_wind >> 24u) & 0xFF) / 255.0;
 	}
 
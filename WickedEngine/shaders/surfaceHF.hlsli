@@ -274,9 +274,9 @@ struct Surface
 		i2 = indexBuffer[startIndex + 2];
 
 		ByteAddressBuffer buf = bindless_buffers[NonUniformResourceIndex(geometry.vb_pos_nor_wind)];
-		data0 = buf.Load4(i0 * sizeof(uint4));
-		data1 = buf.Load4(i1 * sizeof(uint4));
-		data2 = buf.Load4(i2 * sizeof(uint4));
+		data0 = load_vertex_pos_nor_wind(geometry, buf, i0);
+		data1 = load_vertex_pos_nor_wind(geometry, buf, i1);
+		data2 = load_vertex_pos_nor_wind(geometry, buf, i2);
 
 		return true;
 	}
@@ -15,6 +15,7 @@
 #include "wiFont.h"
 #include "wiImage.h"
 #include "wiEventHandler.h"
+#include "wiResourceManager.h"
 
 #include "wiGraphicsDevice_DX12.h"
 #include "wiGraphicsDevice_Vulkan.h"
@@ -142,6 +143,9 @@ namespace wi
 
 		const float dt = framerate_lock ? (1.0f / targetFrameRate) : deltaTime;
 
+		// Apply finished texture streaming and start new streaming requests:
+		wi::resourcemanager::UpdateStreamingResources(dt);
+
 		fadeManager.Update(dt);
 
 		if (GetActivePath() != nullptr)
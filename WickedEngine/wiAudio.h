@@ -59,6 +59,8 @@ namespace wi::audio
 #ifdef SDL2
 	bool CreateSound(SDL_RWops* data, Sound* sound);
 #endif
+	// Returns the size of the decoded sound data in bytes
+	size_t GetSoundMemorySize(const Sound* sound);
 	bool CreateSoundInstance(const Sound* sound, SoundInstance* instance);
 
 	void Play(SoundInstance* instance);
@@ -0,0 +1,159 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiPrimitive.h"
+#include "wiVector.h"
+
+#include <algorithm>
+
+namespace wi
+{
+	// Bounding volume hierarchy on the CPU, it is built from an array of AABBs
+	//	Queries will return the indices of the AABBs that were used in Build()
+	struct BVH
+	{
+		struct Node
+		{
+			wi::primitive::AABB aabb;
+			uint32_t left = 0; // index of the left child node, the right child node is left + 1
+			uint32_t offset = 0; // offset into leaf_indices for leaf nodes
+			uint32_t count = 0; // number of leaf_indices for leaf nodes, interior nodes have zero
+			constexpr bool IsLeaf() const { return count > 0; }
+		};
+		wi::vector<Node> nodes;
+		wi::vector<uint32_t> leaf_indices;
+		wi::vector<wi::primitive::AABB> leaf_aabbs; // matching leaf_indices
+
+		static constexpr uint32_t LEAF_SIZE = 4;
+
+		inline bool IsValid() const { return !nodes.empty(); }
+		inline void Clear()
+		{
+			nodes.clear();
+			leaf_indices.clear();
+			leaf_aabbs.clear();
+		}
+
+		void Build(const wi::primitive::AABB* aabbs, uint32_t count)
+		{
+			Clear();
+			if (count == 0)
+				return;
+
+			leaf_indices.resize(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				leaf_indices[i] = i;
+			}
+			nodes.reserve(count * 2); // a binary tree can't have more nodes than this, so the node references will remain valid while building
+			Node& root = nodes.emplace_back();
+			root.offset = 0;
+			root.count = count;
+			Subdivide(0, aabbs);
+
+			leaf_aabbs.resize(count);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				leaf_aabbs[i] = aabbs[leaf_indices[i]];
+			}
+		}
+
+		// Calls the callback with the index of every AABB that intersects with the query AABB
+		template<typename F>
+		void Intersects(const wi::primitive::AABB& aabb, F&& callback) const
+		{
+			if (nodes.empty())
+				return;
+
+			uint32_t stack[64];
+			uint32_t stack_count = 0;
+			stack[stack_count++] = 0;
+			while (stack_count > 0)
+			{
+				const Node& node = nodes[stack[--stack_count]];
+				if (!Overlaps(node.aabb, aabb))
+					continue;
+				if (node.IsLeaf())
+				{
+					for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+					{
+						if (Overlaps(leaf_aabbs[i], aabb))
+						{
+							callback(leaf_indices[i]);
+						}
+					}
+				}
+				else
+				{
+					stack[stack_count++] = node.left;
+					stack[stack_count++] = node.left + 1;
+				}
+			}
+		}
+
+	private:
+		static constexpr bool Overlaps(const wi::primitive::AABB& a, const wi::primitive::AABB& b)
+		{
+			return
+				a._min.x <= b._max.x && a._max.x >= b._min.x &&
+				a._min.y <= b._max.y && a._max.y >= b._min.y &&
+				a._min.z <= b._max.z && a._max.z >= b._min.z;
+		}
+
+		void Subdivide(uint32_t nodeIndex, const wi::primitive::AABB* aabbs, uint32_t depth = 0)
+		{
+			Node& node = nodes[nodeIndex];
+			wi::primitive::AABB centroid_bounds;
+			for (uint32_t i = 0; i < node.count; ++i)
+			{
+				const wi::primitive::AABB& aabb = aabbs[leaf_indices[node.offset + i]];
+				node.aabb = wi::primitive::AABB::Merge(node.aabb, aabb);
+				const XMFLOAT3 center = aabb.getCenter();
+				centroid_bounds = wi::primitive::AABB::Merge(centroid_bounds, wi::primitive::AABB(center, center));
+			}
+
+			// The depth limit keeps the query stack from overflowing:
+			if (node.count <= LEAF_SIZE || depth >= 30)
+				return;
+
+			// Split along the longest axis of the centroids by the median:
+			const XMFLOAT3 extent = XMFLOAT3(
+				centroid_bounds._max.x - centroid_bounds._min.x,
+				centroid_bounds._max.y - centroid_bounds._min.y,
+				centroid_bounds._max.z - centroid_bounds._min.z
+			);
+			int axis = 0;
+			if (extent.y > extent.x)
+				axis = 1;
+			if (extent.z > (axis == 0 ? extent.x : extent.y))
+				axis = 2;
+			auto get_center = [&](uint32_t index) {
+				const wi::primitive::AABB& aabb = aabbs[index];
+				switch (axis)
+				{
+				default:
+				case 0: return aabb._min.x + aabb._max.x;
+				case 1: return aabb._min.y + aabb._max.y;
+				case 2: return aabb._min.z + aabb._max.z;
+				}
+			};
+			const uint32_t left_count = node.count / 2;
+			uint32_t* first = leaf_indices.data() + node.offset;
+			std::nth_element(first, first + left_count, first + node.count, [&](uint32_t a, uint32_t b) {
+				return get_center(a) < get_center(b);
+			});
+
+			const uint32_t left = (uint32_t)nodes.size();
+			Node& left_node = nodes.emplace_back();
+			left_node.offset = node.offset;
+			left_node.count = left_count;
+			Node& right_node = nodes.emplace_back();
+			right_node.offset = node.offset + left_count;
+			right_node.count = node.count - left_count;
+			node.left = left;
+			node.count = 0;
+
+			Subdivide(left, aabbs, depth + 1);
+			Subdivide(left + 1, aabbs, depth + 1);
+		}
+	};
+}
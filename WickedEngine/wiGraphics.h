@@ -1239,6 +1239,28 @@ namespace wi::graphics
 		return ((value + alignment - 1) / alignment) * alignment;
 	}
 
+	// Computes the size of a texture's data including all array slices and mip levels (without any padding that the GPU might apply)
+	constexpr uint64_t ComputeTextureMemorySizeInBytes(const TextureDesc& desc)
+	{
+		if (desc.format == Format::UNKNOWN)
+		{
+			return 0;
+		}
+		const uint32_t bytes_per_block = GetFormatStride(desc.format);
+		const uint32_t pixels_per_block = GetFormatBlockSize(desc.format);
+		uint64_t size = 0;
+		for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
+		{
+			const uint32_t mip_width = desc.width >> mip > 0 ? desc.width >> mip : 1;
+			const uint32_t mip_height = desc.height >> mip > 0 ? desc.height >> mip : 1;
+			const uint32_t mip_depth = desc.depth >> mip > 0 ? desc.depth >> mip : 1;
+			const uint64_t num_blocks_x = (mip_width + pixels_per_block - 1) / pixels_per_block;
+			const uint64_t num_blocks_y = (mip_height + pixels_per_block - 1) / pixels_per_block;
+			size += num_blocks_x * num_blocks_y * mip_depth * bytes_per_block;
+		}
+		return size * desc.array_size * desc.sample_count;
+	}
+
 }
 
 template<>
@@ -37,6 +37,13 @@ extern basist::etc1_global_selector_codebook g_basis_global_codebook;
 #include "Utility/portable-file-dialogs.h"
 #endif // _WIN32
 
+#ifdef PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // PLATFORM_LINUX
+
 
 namespace wi::helper
 {
@@ -675,7 +682,7 @@ namespace wi::helper
 	}
 
 	template<template<typename T, typename A> typename vector_interface>
-	bool FileRead_Impl(const std::string& fileName, vector_interface<uint8_t, std::allocator<uint8_t>>& data)
+	bool FileRead_Impl(const std::string& fileName, vector_interface<uint8_t, std::allocator<uint8_t>>& data, size_t max_read = ~0ull, size_t offset = 0)
 	{
 #ifndef PLATFORM_UWP
 #ifdef SDL_FILESYSTEM_UNIX
@@ -688,7 +695,13 @@ namespace wi::helper
 		if (file.is_open())
 		{
 			size_t dataSize = (size_t)file.tellg();
-			file.seekg(0, file.beg);
+			if (offset > dataSize)
+			{
+				file.close();
+				return false;
+			}
+			dataSize = std::min(dataSize - offset, max_read);
+			file.seekg(offset, file.beg);
 			data.resize(dataSize);
 			file.read((char*)data.data(), dataSize);
 			file.close();
@@ -710,8 +723,17 @@ namespace wi::helper
 				auto file = co_await StorageFile::GetFileFromPathAsync(wstr);
 				auto buffer = co_await FileIO::ReadBufferAsync(file);
 				auto reader = DataReader::FromBuffer(buffer);
-				auto size = buffer.Length();
-				data.resize((size_t)size);
+				size_t size = (size_t)buffer.Length();
+				if (offset > size)
+				{
+					co_return;
+				}
+				for (size_t i = 0; i < offset; ++i)
+				{
+					reader.ReadByte();
+				}
+				size = std::min(size - offset, max_read);
+				data.resize(size);
 				for (auto& x : data)
 				{
 					x = reader.ReadByte();
@@ -755,6 +777,10 @@ namespace wi::helper
 	{
 		return FileRead_Impl(fileName, data);
 	}
+	bool FileRead(const std::string& fileName, wi::vector<uint8_t>& data, size_t max_read, size_t offset)
+	{
+		return FileRead_Impl(fileName, data, max_read, offset);
+	}
 #if WI_VECTOR_TYPE
 	bool FileRead(const std::string& fileName, std::vector<uint8_t>& data)
 	{
@@ -835,6 +861,108 @@ namespace wi::helper
 		return false;
 	}
 
+	struct MappedFileInternal
+	{
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+#if defined(_WIN32)
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+#endif // _WIN32
+
+		~MappedFileInternal()
+		{
+#if defined(_WIN32)
+			if (data != nullptr)
+			{
+				UnmapViewOfFile(data);
+			}
+			if (mapping != NULL)
+			{
+				CloseHandle(mapping);
+			}
+			if (file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(file);
+			}
+#elif defined(PLATFORM_LINUX)
+			if (data != nullptr)
+			{
+				munmap((void*)data, size);
+			}
+#endif // _WIN32
+		}
+
+		bool Map(const std::string& fileName)
+		{
+#if defined(_WIN32)
+			std::wstring wfilename;
+			StringConvert(fileName, wfilename);
+#ifdef PLATFORM_UWP
+			file = CreateFile2(wfilename.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+#else
+			file = CreateFileW(wfilename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+#endif // PLATFORM_UWP
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			LARGE_INTEGER filesize = {};
+			if (!GetFileSizeEx(file, &filesize) || filesize.QuadPart == 0)
+				return false;
+			size = (size_t)filesize.QuadPart;
+#ifdef PLATFORM_UWP
+			mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+			if (mapping == NULL)
+				return false;
+			data = (const uint8_t*)MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+#else
+			mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapping == NULL)
+				return false;
+			data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#endif // PLATFORM_UWP
+			return data != nullptr;
+#elif defined(PLATFORM_LINUX)
+			int fd = open(fileName.c_str(), O_RDONLY);
+			if (fd < 0)
+				return false;
+			struct stat st = {};
+			if (fstat(fd, &st) != 0 || st.st_size == 0)
+			{
+				close(fd);
+				return false;
+			}
+			size = (size_t)st.st_size;
+			void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			close(fd); // the mapping stays valid after closing the file
+			if (mapped == MAP_FAILED)
+				return false;
+			data = (const uint8_t*)mapped;
+			return true;
+#else
+			return false;
+#endif // _WIN32
+		}
+	};
+	const uint8_t* MappedFile::GetData() const
+	{
+		return ((MappedFileInternal*)internal_state.get())->data;
+	}
+	size_t MappedFile::GetSize() const
+	{
+		return ((MappedFileInternal*)internal_state.get())->size;
+	}
+	bool FileMap(const std::string& fileName, MappedFile& mapped)
+	{
+		auto internal = std::make_shared<MappedFileInternal>();
+		if (!internal->Map(fileName))
+		{
+			mapped = {};
+			return false;
+		}
+		mapped.internal_state = internal;
+		return true;
+	}
+
 	bool FileExists(const std::string& fileName)
 	{
 #ifndef PLATFORM_UWP
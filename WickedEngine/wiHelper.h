@@ -5,6 +5,7 @@
 
 #include <string>
 #include <functional>
+#include <memory>
 
 #if WI_VECTOR_TYPE
 namespace std
@@ -38,6 +39,20 @@ namespace wi::helper
 		return hash;
 	}
 
+	// 64-bit FNV-1a hash of a byte range, the result is the same on every platform, so it can be used for persistent keys
+	//	seed: the result of a previous call can be passed to continue hashing with more data
+	inline uint64_t hash_fnv1a(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
 	std::string toUpper(const std::string& s);
 
 	std::string toLower(const std::string& s);
@@ -86,6 +101,11 @@ namespace wi::helper
 
 	bool FileRead(const std::string& fileName, wi::vector<uint8_t>& data);
 
+	// Read a byte range of a file
+	//	max_read : maximum number of bytes to read, reading will stop at the end of file
+	//	offset : byte offset from the beginning of the file to start reading from
+	bool FileRead(const std::string& fileName, wi::vector<uint8_t>& data, size_t max_read, size_t offset = 0);
+
 #if WI_VECTOR_TYPE
 	// This version is provided if std::vector != wi::vector
 	bool FileRead(const std::string& fileName, std::vector<uint8_t>& data);
@@ -93,6 +113,18 @@ namespace wi::helper
 
 	bool FileWrite(const std::string& fileName, const uint8_t* data, size_t size);
 
+	// Read only memory mapped view of a file
+	struct MappedFile
+	{
+		std::shared_ptr<void> internal_state;
+		inline bool IsValid() const { return internal_state.get() != nullptr; }
+
+		const uint8_t* GetData() const;
+		size_t GetSize() const;
+	};
+	// Maps a file into memory for reading, the data remains valid while the mapped file is alive
+	bool FileMap(const std::string& fileName, MappedFile& mapped);
+
 	bool FileExists(const std::string& fileName);
 
 	std::string GetTempDirectoryPath();
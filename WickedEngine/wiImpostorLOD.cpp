@@ -0,0 +1,327 @@
+#include "wiImpostorLOD.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace wi
+{
+	void ImpostorLOD::Build(const Instance* instances, uint32_t count, float cell_size)
+	{
+		Clear();
+		version++; // the selection was cleared
+		if (count == 0)
+			return;
+
+		cell_size = std::max(cell_size, 0.001f);
+		bucket_size = cell_size;
+
+		XMFLOAT2 bounds_min = XMFLOAT2(FLT_MAX, FLT_MAX);
+		XMFLOAT2 bounds_max = XMFLOAT2(-FLT_MAX, -FLT_MAX);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const XMFLOAT3& center = instances[i].center;
+			bounds_min.x = std::min(bounds_min.x, center.x);
+			bounds_min.y = std::min(bounds_min.y, center.z);
+			bounds_max.x = std::max(bounds_max.x, center.x);
+			bounds_max.y = std::max(bounds_max.y, center.z);
+		}
+		const uint32_t grid_width = (uint32_t)std::min((bounds_max.x - bounds_min.x) / cell_size + 1.0f, 65536.0f);
+		const uint32_t grid_height = (uint32_t)std::min((bounds_max.y - bounds_min.y) / cell_size + 1.0f, 65536.0f);
+
+		// One batch for every used type:
+		wi::vector<uint32_t> types(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			types[i] = instances[i].type;
+		}
+		std::sort(types.begin(), types.end());
+		types.erase(std::unique(types.begin(), types.end()), types.end());
+		batches.resize(types.size());
+		batch_sorted_indices.resize(types.size());
+		for (size_t i = 0; i < types.size(); ++i)
+		{
+			batches[i].type = types[i];
+		}
+
+		// Sort instances by cell, so every cell is a contiguous range:
+		struct Key
+		{
+			uint32_t cell;
+			uint32_t index;
+		};
+		wi::vector<Key> keys(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Instance& instance = instances[i];
+			const uint32_t x = std::min(uint32_t(std::max(0.0f, (instance.center.x - bounds_min.x) / cell_size)), grid_width - 1);
+			const uint32_t z = std::min(uint32_t(std::max(0.0f, (instance.center.z - bounds_min.y) / cell_size)), grid_height - 1);
+			keys[i].cell = z * grid_width + x;
+			keys[i].index = i;
+		}
+		std::sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) {
+			if (a.cell != b.cell)
+				return a.cell < b.cell;
+			return a.index < b.index;
+		});
+
+		sorted_instances.resize(count);
+		sorted_ids.resize(count);
+		sorted_batches.resize(count);
+		slots.resize(count);
+		std::fill(slots.begin(), slots.end(), ~0u);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Key& key = keys[i];
+			const Instance& instance = instances[key.index];
+			sorted_instances[i] = XMFLOAT4(instance.center.x, instance.center.y, instance.center.z, instance.distance);
+			sorted_ids[i] = instance.id;
+			sorted_batches[i] = uint32_t(std::lower_bound(types.begin(), types.end(), instance.type) - types.begin());
+
+			if (i == 0 || keys[i - 1].cell != key.cell)
+			{
+				Cell& cell = cells.emplace_back();
+				cell.offset = i;
+				cell.center_min = instance.center;
+				cell.center_max = instance.center;
+				cell.distance_min = instance.distance;
+				cell.distance_max = instance.distance;
+			}
+			Cell& cell = cells.back();
+			cell.count++;
+			cell.center_min = wi::math::Min(cell.center_min, instance.center);
+			cell.center_max = wi::math::Max(cell.center_max, instance.center);
+			cell.distance_min = std::min(cell.distance_min, instance.distance);
+			cell.distance_max = std::max(cell.distance_max, instance.distance);
+		}
+	}
+
+	bool ImpostorLOD::Update(const XMFLOAT3& eye, Statistics* statistics)
+	{
+		Statistics stats;
+		stats.cell_count = (uint32_t)cells.size();
+
+		bool changed = false;
+		if (evaluate_all)
+		{
+			evaluate_all = false;
+			for (auto& bucket : buckets)
+			{
+				bucket.clear();
+			}
+			overflow.clear();
+			overflow_bucket = ~0ull;
+			travel = 0;
+			current_bucket = 0;
+			eye_prev = eye;
+			for (uint32_t cellIndex = 0; cellIndex < (uint32_t)cells.size(); ++cellIndex)
+			{
+				changed |= Evaluate(cellIndex, eye, &stats);
+				Insert(cellIndex);
+			}
+		}
+		else
+		{
+			const float moved = wi::math::Distance(eye, eye_prev);
+			if (moved > 0)
+			{
+				// The distance of any instance to the camera can't change more than the length of the camera path:
+				eye_prev = eye;
+				travel += moved;
+				const uint64_t target_bucket = uint64_t(travel / bucket_size);
+
+				// Buckets that the camera path went through are fully expired, the bucket of the current travel distance can be partially expired.
+				//	Evaluated cells are inserted only after all buckets were processed, so they are not evaluated twice:
+				evaluated.clear();
+				const uint64_t last_bucket = std::min(target_bucket, current_bucket + BUCKET_COUNT - 1);
+				for (uint64_t b = current_bucket; b <= last_bucket; ++b)
+				{
+					wi::vector<uint32_t>& bucket = buckets[b % BUCKET_COUNT];
+					size_t keep = 0;
+					for (size_t i = 0; i < bucket.size(); ++i)
+					{
+						const uint32_t cellIndex = bucket[i];
+						if (cells[cellIndex].expiry <= travel)
+						{
+							changed |= Evaluate(cellIndex, eye, &stats);
+							evaluated.push_back(cellIndex);
+						}
+						else
+						{
+							bucket[keep++] = cellIndex;
+						}
+					}
+					bucket.resize(keep);
+				}
+				current_bucket = target_bucket;
+
+				// Cells that were too far in the future for the buckets are redistributed when the buckets reach them:
+				if (current_bucket + BUCKET_COUNT > overflow_bucket)
+				{
+					wi::vector<uint32_t> pending;
+					std::swap(pending, overflow);
+					overflow_bucket = ~0ull;
+					for (uint32_t cellIndex : pending)
+					{
+						if (cells[cellIndex].expiry <= travel)
+						{
+							changed |= Evaluate(cellIndex, eye, &stats);
+						}
+						Insert(cellIndex);
+					}
+				}
+
+				for (uint32_t cellIndex : evaluated)
+				{
+					Insert(cellIndex);
+				}
+			}
+		}
+
+		if (changed)
+		{
+			version++;
+		}
+
+		stats.selected_count = GetSelectedCount();
+		stats.changed = changed;
+		if (statistics != nullptr)
+		{
+			*statistics = stats;
+		}
+		return changed;
+	}
+
+	void ImpostorLOD::Clear()
+	{
+		batches.clear();
+		cells.clear();
+		sorted_instances.clear();
+		sorted_ids.clear();
+		sorted_batches.clear();
+		slots.clear();
+		batch_sorted_indices.clear();
+		for (auto& bucket : buckets)
+		{
+			bucket.clear();
+		}
+		overflow.clear();
+		overflow_bucket = ~0ull;
+		evaluated.clear();
+		travel = 0;
+		current_bucket = 0;
+		evaluate_all = true;
+	}
+
+	uint32_t ImpostorLOD::GetSelectedCount() const
+	{
+		uint32_t count = 0;
+		for (const Batch& batch : batches)
+		{
+			count += (uint32_t)batch.ids.size();
+		}
+		return count;
+	}
+
+	void ImpostorLOD::Insert(uint32_t cellIndex)
+	{
+		const uint64_t bucket_index = std::max(current_bucket, uint64_t(cells[cellIndex].expiry / bucket_size));
+		if (bucket_index < current_bucket + BUCKET_COUNT)
+		{
+			buckets[bucket_index % BUCKET_COUNT].push_back(cellIndex);
+		}
+		else
+		{
+			overflow.push_back(cellIndex);
+			overflow_bucket = std::min(overflow_bucket, bucket_index);
+		}
+	}
+
+	bool ImpostorLOD::Evaluate(uint32_t cellIndex, const XMFLOAT3& eye, Statistics* statistics)
+	{
+		Cell& cell = cells[cellIndex];
+		statistics->cells_evaluated++;
+
+		// Closest and farthest distance from the camera to the instance centers in the cell:
+		const float nx = std::max(0.0f, std::max(cell.center_min.x - eye.x, eye.x - cell.center_max.x));
+		const float ny = std::max(0.0f, std::max(cell.center_min.y - eye.y, eye.y - cell.center_max.y));
+		const float nz = std::max(0.0f, std::max(cell.center_min.z - eye.z, eye.z - cell.center_max.z));
+		const float fx = std::max(std::abs(eye.x - cell.center_min.x), std::abs(eye.x - cell.center_max.x));
+		const float fy = std::max(std::abs(eye.y - cell.center_min.y), std::abs(eye.y - cell.center_max.y));
+		const float fz = std::max(std::abs(eye.z - cell.center_min.z), std::abs(eye.z - cell.center_max.z));
+		const float dist_min = std::sqrt(nx * nx + ny * ny + nz * nz);
+		const float dist_max = std::sqrt(fx * fx + fy * fy + fz * fz);
+
+		bool changed = false;
+		float slack = 0;
+		STATE state;
+		if (dist_min >= cell.distance_max)
+		{
+			state = STATE_FAR;
+			slack = dist_min - cell.distance_max;
+		}
+		else if (dist_max < cell.distance_min)
+		{
+			state = STATE_NEAR;
+			slack = cell.distance_min - dist_max;
+		}
+		else
+		{
+			state = STATE_MIXED;
+			slack = FLT_MAX;
+			const XMFLOAT4* instances = sorted_instances.data() + cell.offset;
+			for (uint32_t i = 0; i < cell.count; ++i)
+			{
+				const XMFLOAT4& instance = instances[i];
+				const float dx = instance.x - eye.x;
+				const float dy = instance.y - eye.y;
+				const float dz = instance.z - eye.z;
+				const float dist = std::sqrt(dx * dx + dy * dy + dz * dz);
+				changed |= Select(cell.offset + i, dist >= instance.w);
+				slack = std::min(slack, std::abs(dist - instance.w));
+			}
+			statistics->instances_evaluated += cell.count;
+		}
+
+		if (state != STATE_MIXED && state != cell.state)
+		{
+			const bool selected = state == STATE_FAR;
+			for (uint32_t i = 0; i < cell.count; ++i)
+			{
+				changed |= Select(cell.offset + i, selected);
+			}
+		}
+
+		cell.state = state;
+		cell.expiry = travel + (double)slack;
+		return changed;
+	}
+
+	bool ImpostorLOD::Select(uint32_t sortedIndex, bool selected)
+	{
+		uint32_t& slot = slots[sortedIndex];
+		if (selected == (slot != ~0u))
+			return false;
+
+		const uint32_t batchIndex = sorted_batches[sortedIndex];
+		wi::vector<uint32_t>& ids = batches[batchIndex].ids;
+		wi::vector<uint32_t>& indices = batch_sorted_indices[batchIndex];
+		if (selected)
+		{
+			slot = (uint32_t)ids.size();
+			ids.push_back(sorted_ids[sortedIndex]);
+			indices.push_back(sortedIndex);
+		}
+		else
+		{
+			// Swap with the last element, so removal doesn't need to move the rest of the batch:
+			const uint32_t last = indices.back();
+			ids[slot] = ids.back();
+			indices[slot] = last;
+			slots[last] = slot;
+			ids.pop_back();
+			indices.pop_back();
+			slot = ~0u;
+		}
+		return true;
+	}
+}
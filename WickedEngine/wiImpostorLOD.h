@@ -0,0 +1,93 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiMath.h"
+#include "wiVector.h"
+
+namespace wi
+{
+	// CPU side impostor selection for a large amount of instances (eg. forests)
+	//	Instances are binned into a grid of cells on the XZ plane, and every cell remembers how far the camera can travel
+	//	before any of its instances could switch between mesh and impostor. Cells are stored in distance buckets by that travel distance,
+	//	so Update() only evaluates cells whose bucket was reached by the camera path instead of rescanning all instances every frame.
+	//	The selected instances are kept in one list per type, so they can be uploaded and drawn as batches.
+	//	The lists are modified only by the instances that switched, not rebuilt
+	struct ImpostorLOD
+	{
+		struct Instance
+		{
+			XMFLOAT3 center = XMFLOAT3(0, 0, 0);
+			float distance = 0; // the instance is selected when the camera is at least this far from the center
+			uint32_t type = 0; // instances of the same type will be output next to each other
+			uint32_t id = 0; // user data that will be written to the selection
+		};
+		struct Batch
+		{
+			uint32_t type = 0;
+			wi::vector<uint32_t> ids; // ids of the selected instances of this type, in no particular order
+		};
+		struct Statistics
+		{
+			uint32_t cell_count = 0; // number of non-empty cells
+			uint32_t cells_evaluated = 0; // number of cells that were evaluated in the last Update()
+			uint32_t instances_evaluated = 0; // number of instances that needed a distance test in the last Update()
+			uint32_t selected_count = 0; // number of selected instances
+			bool changed = false; // whether the selection changed in the last Update()
+		};
+
+		wi::vector<Batch> batches; // one batch for every type that was used in Build(), sorted by type
+		uint64_t version = 0; // incremented every time the selection changes
+
+		// Rebuilds the grid from an array of instances, the next Update() will evaluate everything
+		//	cell_size: size of the grid cells in world units on the XZ plane
+		void Build(const Instance* instances, uint32_t count, float cell_size = 32.0f);
+
+		// Updates the selection for a new camera position
+		//	Returns true if the selection changed
+		bool Update(const XMFLOAT3& eye, Statistics* statistics = nullptr);
+
+		void Clear();
+		inline bool IsValid() const { return !cells.empty(); }
+		uint32_t GetSelectedCount() const;
+
+	private:
+		enum STATE : uint8_t
+		{
+			STATE_UNKNOWN,
+			STATE_NEAR, // no instances in the cell are selected
+			STATE_FAR, // all instances in the cell are selected
+			STATE_MIXED, // some instances are selected, slots store which ones
+		};
+		struct Cell
+		{
+			XMFLOAT3 center_min = XMFLOAT3(0, 0, 0); // bounds of instance centers
+			XMFLOAT3 center_max = XMFLOAT3(0, 0, 0);
+			float distance_min = 0;
+			float distance_max = 0;
+			uint32_t offset = 0; // offset into sorted instances
+			uint32_t count = 0;
+			double expiry = 0; // travel distance at which the cell must be evaluated again
+			STATE state = STATE_UNKNOWN;
+		};
+		wi::vector<Cell> cells;
+		wi::vector<XMFLOAT4> sorted_instances; // xyz: center, w: distance
+		wi::vector<uint32_t> sorted_ids;
+		wi::vector<uint32_t> sorted_batches; // batch index per sorted instance
+		wi::vector<uint32_t> slots; // position in the batch per sorted instance, ~0u if not selected
+		wi::vector<wi::vector<uint32_t>> batch_sorted_indices; // sorted instance index for every entry in the batch ids
+
+		static constexpr uint32_t BUCKET_COUNT = 64;
+		wi::vector<uint32_t> buckets[BUCKET_COUNT]; // cell indices by expiry
+		wi::vector<uint32_t> overflow; // cells with expiry beyond the buckets
+		uint64_t overflow_bucket = ~0ull; // the lowest bucket index in overflow
+		wi::vector<uint32_t> evaluated;
+		double bucket_size = 32.0; // travel distance per bucket
+		double travel = 0; // accumulated camera path length, double precision so that small steps are not lost after a long path
+		uint64_t current_bucket = 0;
+		XMFLOAT3 eye_prev = XMFLOAT3(0, 0, 0);
+		bool evaluate_all = true;
+
+		void Insert(uint32_t cellIndex);
+		bool Evaluate(uint32_t cellIndex, const XMFLOAT3& eye, Statistics* statistics);
+		bool Select(uint32_t sortedIndex, bool selected);
+	};
+}
@@ -67,7 +67,7 @@ namespace wi::jobsystem
 	{
 		uint32_t numCores = 0;
 		uint32_t numThreads = 0;
-		std::unique_ptr<JobQueue[]> jobQueuePerThread;
+		std::unique_ptr<JobQueue[]> jobQueuePerThread[int(Priority::Count)];
 		std::shared_ptr<WorkerState> worker_state = std::make_shared<WorkerState>(); // kept alive by both threads and internal_state
 		std::atomic<uint32_t> nextQueue{ 0 };
 		~InternalState()
@@ -75,24 +75,27 @@ namespace wi::jobsystem
 			worker_state->alive.store(false); // indicate that new jobs cannot be started from this point
 			worker_state->wakeCondition.notify_all(); // wakes up sleeping worker threads
 			// wait until all currently running jobs finish:
-			for (uint32_t i = 0; i < numThreads; ++i)
+			for (auto& jobQueues : jobQueuePerThread)
 			{
-				while (jobQueuePerThread[i].processing.load())
+				for (uint32_t i = 0; i < numThreads; ++i)
 				{
-					std::this_thread::yield();
+					while (jobQueues[i].processing.load())
+					{
+						std::this_thread::yield();
+					}
 				}
 			}
 		}
 	} static internal_state;
 
-	// Start working on a job queue
-	//	After the job queue is finished, it can switch to an other queue and steal jobs from there
-	inline void work(uint32_t startingQueue)
+	// Start working on a job queue of the given priority
+	//	After the job queue is finished, it can switch to an other queue of the same priority and steal jobs from there
+	inline void work(uint32_t startingQueue, Priority priority)
 	{
 		Job job;
 		for (uint32_t i = 0; i < internal_state.numThreads; ++i)
 		{
-			JobQueue& job_queue = internal_state.jobQueuePerThread[startingQueue % internal_state.numThreads];
+			JobQueue& job_queue = internal_state.jobQueuePerThread[int(priority)][startingQueue % internal_state.numThreads];
 			while (job_queue.pop_front(job))
 			{
 				JobArgs args;
@@ -136,7 +139,10 @@ namespace wi::jobsystem
 
 		// Calculate the actual number of worker threads we want (-1 main thread):
 		internal_state.numThreads = std::min(maxThreadCount, std::max(1u, internal_state.numCores - 1));
-		internal_state.jobQueuePerThread.reset(new JobQueue[internal_state.numThreads]);
+		for (auto& jobQueues : internal_state.jobQueuePerThread)
+		{
+			jobQueues.reset(new JobQueue[internal_state.numThreads]);
+		}
 
 		for (uint32_t threadID = 0; threadID < internal_state.numThreads; ++threadID)
 		{
@@ -146,7 +152,9 @@ namespace wi::jobsystem
 
 				while (worker_state->alive.load())
 				{
-					work(threadID);
+					// Low priority jobs are only started after the high priority jobs that could be found were finished:
+					work(threadID, Priority::High);
+					work(threadID, Priority::Low);
 
 					// finished with jobs, put to sleep
 					std::unique_lock<std::mutex> lock(worker_state->wakeMutex);
@@ -218,7 +226,7 @@ namespace wi::jobsystem
 		job.groupJobEnd = 1;
 		job.sharedmemory_size = 0;
 
-		internal_state.jobQueuePerThread[internal_state.nextQueue.fetch_add(1) % internal_state.numThreads].push_back(job);
+		internal_state.jobQueuePerThread[int(ctx.priority)][internal_state.nextQueue.fetch_add(1) % internal_state.numThreads].push_back(job);
 		internal_state.worker_state->wakeCondition.notify_one();
 	}
 
@@ -246,7 +254,7 @@ namespace wi::jobsystem
 			job.groupJobOffset = groupID * groupSize;
 			job.groupJobEnd = std::min(job.groupJobOffset + groupSize, jobCount);
 
-			internal_state.jobQueuePerThread[internal_state.nextQueue.fetch_add(1) % internal_state.numThreads].push_back(job);
+			internal_state.jobQueuePerThread[int(ctx.priority)][internal_state.nextQueue.fetch_add(1) % internal_state.numThreads].push_back(job);
 		}
 
 		internal_state.worker_state->wakeCondition.notify_all();
@@ -272,7 +280,7 @@ namespace wi::jobsystem
 			internal_state.worker_state->wakeCondition.notify_all();
 
 			// work() will pick up any jobs that are on stand by and execute them on this thread:
-			work(internal_state.nextQueue.fetch_add(1) % internal_state.numThreads);
+			work(internal_state.nextQueue.fetch_add(1) % internal_state.numThreads, ctx.priority);
 
 			while (IsBusy(ctx))
 			{
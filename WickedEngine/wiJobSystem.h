@@ -19,10 +19,18 @@ namespace wi::jobsystem
 
 	uint32_t GetThreadCount();
 
+	enum class Priority
+	{
+		High,	// default, for jobs that are waited on soon
+		Low,	// for long running background jobs, waiting on a high priority context will not execute these on the waiting thread
+		Count
+	};
+
 	// Defines a state of execution, can be waited on
 	struct context
 	{
 		std::atomic<uint32_t> counter{ 0 };
+		Priority priority = Priority::High; // jobs of this context will be executed with this priority
 	};
 
 	// Add a task to execute asynchronously. Any idle thread will execute this.
@@ -41,6 +49,6 @@ namespace wi::jobsystem
 	bool IsBusy(const context& ctx);
 
 	// Wait until all threads become idle
-	//	Current thread will become a worker thread, executing jobs
+	//	Current thread will become a worker thread, executing jobs of the same priority as the context
 	void Wait(const context& ctx);
 }
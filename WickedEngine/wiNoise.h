@@ -99,6 +99,147 @@ namespace wi::noise
 			return result;
 		}
 
+		// Computes 4 noise values at once, this is the vectorized version of compute(x, y, z)
+		//	returns noise in range [-1, 1]
+		inline XMVECTOR compute(XMVECTOR x, XMVECTOR y, XMVECTOR z) const
+		{
+			// Gradient directions for all hash values, equivalent to grad():
+			static constexpr float gradients[16][3] = {
+				{ 1, 1, 0}, {-1, 1, 0}, { 1,-1, 0}, {-1,-1, 0},
+				{ 1, 0, 1}, {-1, 0, 1}, { 1, 0,-1}, {-1, 0,-1},
+				{ 0, 1, 1}, { 0,-1, 1}, { 0, 1,-1}, { 0,-1,-1},
+				{ 1, 1, 0}, { 0,-1, 1}, {-1, 1, 0}, { 0,-1,-1},
+			};
+
+			const XMVECTOR _x = XMVectorFloor(x);
+			const XMVECTOR _y = XMVectorFloor(y);
+			const XMVECTOR _z = XMVectorFloor(z);
+
+			XMFLOAT4A ix, iy, iz;
+			XMStoreFloat4A(&ix, _x);
+			XMStoreFloat4A(&iy, _y);
+			XMStoreFloat4A(&iz, _z);
+
+			const XMVECTOR fx = x - _x;
+			const XMVECTOR fy = y - _y;
+			const XMVECTOR fz = z - _z;
+
+			// Permutation lookups can't be vectorized, they are gathered per lane into gradient components:
+			XMFLOAT4A gx[8], gy[8], gz[8];
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				const int X = int((&ix.x)[lane]) & 255;
+				const int Y = int((&iy.x)[lane]) & 255;
+				const int Z = int((&iz.x)[lane]) & 255;
+
+				const uint8_t A = (state[X] + Y) & 255;
+				const uint8_t B = (state[(X + 1) & 255] + Y) & 255;
+
+				const uint8_t AA = (state[A] + Z) & 255;
+				const uint8_t AB = (state[(A + 1) & 255] + Z) & 255;
+
+				const uint8_t BA = (state[B] + Z) & 255;
+				const uint8_t BB = (state[(B + 1) & 255] + Z) & 255;
+
+				const uint8_t hashes[8] = {
+					state[AA],
+					state[BA],
+					state[AB],
+					state[BB],
+					state[(AA + 1) & 255],
+					state[(BA + 1) & 255],
+					state[(AB + 1) & 255],
+					state[(BB + 1) & 255],
+				};
+				for (int i = 0; i < 8; ++i)
+				{
+					const float* g = gradients[hashes[i] & 15];
+					(&gx[i].x)[lane] = g[0];
+					(&gy[i].x)[lane] = g[1];
+					(&gz[i].x)[lane] = g[2];
+				}
+			}
+
+			const XMVECTOR one = XMVectorReplicate(1);
+			const XMVECTOR fx1 = fx - one;
+			const XMVECTOR fy1 = fy - one;
+			const XMVECTOR fz1 = fz - one;
+			auto grad = [&](int i, XMVECTOR x, XMVECTOR y, XMVECTOR z) {
+				return XMLoadFloat4A(&gx[i]) * x + XMLoadFloat4A(&gy[i]) * y + XMLoadFloat4A(&gz[i]) * z;
+			};
+			const XMVECTOR p0 = grad(0, fx, fy, fz);
+			const XMVECTOR p1 = grad(1, fx1, fy, fz);
+			const XMVECTOR p2 = grad(2, fx, fy1, fz);
+			const XMVECTOR p3 = grad(3, fx1, fy1, fz);
+			const XMVECTOR p4 = grad(4, fx, fy, fz1);
+			const XMVECTOR p5 = grad(5, fx1, fy, fz1);
+			const XMVECTOR p6 = grad(6, fx, fy1, fz1);
+			const XMVECTOR p7 = grad(7, fx1, fy1, fz1);
+
+			auto fade = [](XMVECTOR t) {
+				return t * t * t * (t * (t * 6 - XMVectorReplicate(15)) + XMVectorReplicate(10));
+			};
+			const XMVECTOR u = fade(fx);
+			const XMVECTOR v = fade(fy);
+			const XMVECTOR w = fade(fz);
+
+			const XMVECTOR q0 = XMVectorLerpV(p0, p1, u);
+			const XMVECTOR q1 = XMVectorLerpV(p2, p3, u);
+			const XMVECTOR q2 = XMVectorLerpV(p4, p5, u);
+			const XMVECTOR q3 = XMVectorLerpV(p6, p7, u);
+
+			const XMVECTOR r0 = XMVectorLerpV(q0, q1, v);
+			const XMVECTOR r1 = XMVectorLerpV(q2, q3, v);
+
+			return XMVectorLerpV(r0, r1, w);
+		}
+		// Computes 4 multi-octave (fBm) noise values at once
+		//	returns noise in range [-1, 1]
+		inline XMVECTOR compute(XMVECTOR x, XMVECTOR y, XMVECTOR z, int octaves, float persistence = 0.5f) const
+		{
+			XMVECTOR result = XMVectorZero();
+			float amplitude = 1;
+			for (int i = 0; i < octaves; ++i)
+			{
+				result += compute(x, y, z) * amplitude;
+				x *= 2;
+				y *= 2;
+				z *= 2;
+				amplitude *= persistence;
+			}
+			return result;
+		}
+		// Computes multi-octave (fBm) noise for many samples at once, the coordinates are given as separate arrays
+		//	x, y, z : input coordinate arrays with count elements. z can be nullptr, then it will be 0 for every sample
+		//	result : output array with count elements, it receives noise in range [-1, 1]
+		inline void compute(const float* x, const float* y, const float* z, float* result, size_t count, int octaves = 1, float persistence = 0.5f) const
+		{
+			size_t i = 0;
+			for (; i + 4 <= count; i += 4)
+			{
+				const XMVECTOR X = XMLoadFloat4((const XMFLOAT4*)(x + i));
+				const XMVECTOR Y = XMLoadFloat4((const XMFLOAT4*)(y + i));
+				const XMVECTOR Z = z == nullptr ? XMVectorZero() : XMLoadFloat4((const XMFLOAT4*)(z + i));
+				XMStoreFloat4((XMFLOAT4*)(result + i), compute(X, Y, Z, octaves, persistence));
+			}
+			if (i < count)
+			{
+				// Remainder is computed with zero padding:
+				XMFLOAT4 X = {}, Y = {}, Z = {}, R;
+				for (size_t j = 0; j < count - i; ++j)
+				{
+					(&X.x)[j] = x[i + j];
+					(&Y.x)[j] = y[i + j];
+					(&Z.x)[j] = z == nullptr ? 0 : z[i + j];
+				}
+				XMStoreFloat4(&R, compute(XMLoadFloat4(&X), XMLoadFloat4(&Y), XMLoadFloat4(&Z), octaves, persistence));
+				for (size_t j = 0; j < count - i; ++j)
+				{
+					result[i + j] = (&R.x)[j];
+				}
+			}
+		}
+
 		void Serialize(wi::Archive& archive)
 		{
 			if (archive.IsReadMode())
@@ -170,5 +311,66 @@ namespace wi::noise
 
 			return result;
 		}
+
+		// Computes 4 voronoi values at once, this is the vectorized version of compute(x, y, seed)
+		inline void compute(XMVECTOR x, XMVECTOR y, float seed, XMVECTOR& distance, XMVECTOR& cell_id)
+		{
+			const XMVECTOR nx = XMVectorFloor(x);
+			const XMVECTOR ny = XMVectorFloor(y);
+			const XMVECTOR fx = x - nx;
+			const XMVECTOR fy = y - ny;
+			const XMVECTOR half = XMVectorReplicate(0.5f);
+
+			XMVECTOR m = XMVectorReplicate(8);
+			XMVECTOR mx = XMVectorZero();
+			XMVECTOR my = XMVectorZero();
+			for (int j = -1; j <= 1; j++)
+			{
+				for (int i = -1; i <= 1; i++)
+				{
+					const XMVECTOR gx = XMVectorReplicate(float(i));
+					const XMVECTOR gy = XMVectorReplicate(float(j));
+					const XMVECTOR px = nx + gx;
+					const XMVECTOR py = ny + gy;
+					const XMVECTOR ox = fract(XMVectorSin(px * 127.1f + py * 311.7f) * 18.5453f);
+					const XMVECTOR oy = fract(XMVectorSin(px * 269.5f + py * 183.3f) * 18.5453f);
+					const XMVECTOR rx = gx - fx + (half + half * XMVectorSin(ox * seed));
+					const XMVECTOR ry = gy - fy + (half + half * XMVectorSin(oy * seed));
+					const XMVECTOR d = rx * rx + ry * ry;
+					const XMVECTOR closer = XMVectorLess(d, m);
+					m = XMVectorSelect(m, d, closer);
+					mx = XMVectorSelect(mx, ox, closer);
+					my = XMVectorSelect(my, oy, closer);
+				}
+			}
+
+			distance = XMVectorSqrt(m);
+			cell_id = mx + my;
+		}
+		// Computes voronoi for many samples at once, the coordinates are given as separate arrays
+		//	x, y : input coordinate arrays with count elements
+		//	distance, cell_id : output arrays with count elements
+		inline void compute(const float* x, const float* y, float seed, float* distance, float* cell_id, size_t count)
+		{
+			for (size_t i = 0; i < count; i += 4)
+			{
+				const size_t remaining = std::min(count - i, size_t(4));
+				XMFLOAT4 X = {}, Y = {}, D, C;
+				for (size_t j = 0; j < remaining; ++j)
+				{
+					(&X.x)[j] = x[i + j];
+					(&Y.x)[j] = y[i + j];
+				}
+				XMVECTOR distance4, cell_id4;
+				compute(XMLoadFloat4(&X), XMLoadFloat4(&Y), seed, distance4, cell_id4);
+				XMStoreFloat4(&D, distance4);
+				XMStoreFloat4(&C, cell_id4);
+				for (size_t j = 0; j < remaining; ++j)
+				{
+					distance[i + j] = (&D.x)[j];
+					cell_id[i + j] = (&C.x)[j];
+				}
+			}
+		}
 	};
 }
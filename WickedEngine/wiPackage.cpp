@@ -0,0 +1,404 @@
+#include "wiPackage.h"
+#include "wiHelper.h"
+#include "wiPlatform.h"
+#include "wiBacklog.h"
+#include "wiUnorderedMap.h"
+
+#include "Utility/basis_universal/zstd/zstd.h"
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace wi::package
+{
+	// Package file layout:
+	//	Header
+	//	Payloads (4K aligned)
+	//	Blob table: one entry for every unique payload
+	//	Entry table: one entry for every file name
+	//	Bucket table: open addressing hash table of entry indices, the bucket count is a power of two
+	//	Name table: all file names, not null terminated
+	static constexpr char PACKAGE_MAGIC[4] = { 'W','I','P','K' };
+	static constexpr uint32_t PACKAGE_VERSION = 1;
+	static constexpr uint64_t PACKAGE_ALIGNMENT = 4096;
+	static constexpr uint32_t INVALID_ENTRY = ~0u;
+
+	enum class Compression : uint32_t
+	{
+		NONE,
+		ZSTD,
+	};
+
+	struct Header
+	{
+		char magic[4];
+		uint32_t version;
+		uint32_t entry_count;
+		uint32_t blob_count;
+		uint32_t bucket_count;
+		uint32_t reserved;
+		uint64_t blob_table_offset;
+		uint64_t entry_table_offset;
+		uint64_t bucket_table_offset;
+		uint64_t name_table_offset;
+		uint64_t name_table_size;
+	};
+	struct Blob
+	{
+		uint64_t offset;
+		uint64_t size; // stored size
+		uint64_t original_size; // size after decompression
+		uint64_t content_hash;
+		Compression compression;
+		uint32_t reserved;
+	};
+	struct EntryData
+	{
+		uint64_t name_hash;
+		uint32_t name_offset;
+		uint32_t name_length;
+		uint32_t blob;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(Header) % 8 == 0);
+	static_assert(sizeof(Blob) % 8 == 0);
+	static_assert(sizeof(EntryData) % 8 == 0);
+
+	struct PackageInternal
+	{
+		std::string filename;
+		const uint8_t* data = nullptr;
+		size_t size = 0;
+		const Header* header = nullptr;
+		const Blob* blobs = nullptr;
+		const EntryData* entries = nullptr;
+		const uint32_t* buckets = nullptr;
+		const char* names = nullptr;
+
+		wi::helper::MappedFile file;
+
+		bool Map()
+		{
+			if (!wi::helper::FileMap(filename, file))
+				return false;
+			data = file.GetData();
+			size = file.GetSize();
+			return true;
+		}
+
+		bool Validate()
+		{
+			if (size < sizeof(Header))
+				return false;
+			header = (const Header*)data;
+			if (std::memcmp(header->magic, PACKAGE_MAGIC, sizeof(PACKAGE_MAGIC)) != 0 || header->version != PACKAGE_VERSION)
+				return false;
+			if (header->bucket_count == 0 || (header->bucket_count & (header->bucket_count - 1)) != 0)
+				return false;
+			auto in_range = [&](uint64_t offset, uint64_t bytes) {
+				return offset <= size && bytes <= size - offset;
+			};
+			if (!in_range(header->blob_table_offset, uint64_t(header->blob_count) * sizeof(Blob)) ||
+				!in_range(header->entry_table_offset, uint64_t(header->entry_count) * sizeof(EntryData)) ||
+				!in_range(header->bucket_table_offset, uint64_t(header->bucket_count) * sizeof(uint32_t)) ||
+				!in_range(header->name_table_offset, header->name_table_size))
+				return false;
+			blobs = (const Blob*)(data + header->blob_table_offset);
+			entries = (const EntryData*)(data + header->entry_table_offset);
+			buckets = (const uint32_t*)(data + header->bucket_table_offset);
+			names = (const char*)(data + header->name_table_offset);
+			for (uint32_t i = 0; i < header->blob_count; ++i)
+			{
+				if (!in_range(blobs[i].offset, blobs[i].size))
+					return false;
+			}
+			for (uint32_t i = 0; i < header->entry_count; ++i)
+			{
+				if (entries[i].blob >= header->blob_count ||
+					uint64_t(entries[i].name_offset) + entries[i].name_length > header->name_table_size)
+					return false;
+			}
+			return true;
+		}
+
+		const EntryData* Find(const std::string& name) const
+		{
+			const uint64_t hash = wi::helper::hash_fnv1a(name.data(), name.size());
+			const uint32_t mask = header->bucket_count - 1;
+			for (uint32_t i = 0; i < header->bucket_count; ++i)
+			{
+				const uint32_t entry_index = buckets[(uint32_t(hash) + i) & mask];
+				if (entry_index == INVALID_ENTRY)
+					return nullptr;
+				if (entry_index >= header->entry_count)
+					return nullptr;
+				const EntryData& entry = entries[entry_index];
+				if (entry.name_hash == hash && entry.name_length == name.size() &&
+					std::memcmp(names + entry.name_offset, name.data(), name.size()) == 0)
+				{
+					return &entry;
+				}
+			}
+			return nullptr;
+		}
+	};
+	static PackageInternal* to_internal(const Package* param)
+	{
+		return static_cast<PackageInternal*>(param->internal_state.get());
+	}
+
+	const std::string& Package::GetFileName() const
+	{
+		static const std::string empty;
+		return IsValid() ? to_internal(this)->filename : empty;
+	}
+	size_t Package::GetFileCount() const
+	{
+		return IsValid() ? to_internal(this)->header->entry_count : 0;
+	}
+	std::string Package::GetName(size_t index) const
+	{
+		if (index >= GetFileCount())
+			return "";
+		const PackageInternal* internal = to_internal(this);
+		const EntryData& entry = internal->entries[index];
+		return std::string(internal->names + entry.name_offset, entry.name_length);
+	}
+	bool Package::Contains(const std::string& name) const
+	{
+		return IsValid() && to_internal(this)->Find(NormalizeName(name)) != nullptr;
+	}
+	const uint8_t* Package::GetData(const std::string& name, size_t* size) const
+	{
+		if (!IsValid())
+			return nullptr;
+		const PackageInternal* internal = to_internal(this);
+		const EntryData* entry = internal->Find(NormalizeName(name));
+		if (entry == nullptr)
+			return nullptr;
+		const Blob& blob = internal->blobs[entry->blob];
+		if (blob.compression != Compression::NONE)
+			return nullptr;
+		if (size != nullptr)
+		{
+			*size = (size_t)blob.size;
+		}
+		return internal->data + blob.offset;
+	}
+	bool Package::Read(const std::string& name, wi::vector<uint8_t>& data) const
+	{
+		if (!IsValid())
+			return false;
+		const PackageInternal* internal = to_internal(this);
+		const EntryData* entry = internal->Find(NormalizeName(name));
+		if (entry == nullptr)
+			return false;
+		const Blob& blob = internal->blobs[entry->blob];
+		const uint8_t* src = internal->data + blob.offset;
+		switch (blob.compression)
+		{
+		case Compression::NONE:
+			data.resize((size_t)blob.size);
+			std::memcpy(data.data(), src, data.size());
+			return true;
+		case Compression::ZSTD:
+		{
+			data.resize((size_t)blob.original_size);
+			size_t result = ZSTD_decompress(data.data(), data.size(), src, (size_t)blob.size);
+			if (ZSTD_isError(result) || result != data.size())
+			{
+				wi::backlog::post("wi::package::Read decompression failed: " + name + " (" + ZSTD_getErrorName(result) + ")", wi::backlog::LogLevel::Error);
+				data.clear();
+				return false;
+			}
+			return true;
+		}
+		default:
+			return false;
+		}
+	}
+
+	bool Open(const std::string& filename, Package* package)
+	{
+		std::shared_ptr<PackageInternal> internal = std::make_shared<PackageInternal>();
+		internal->filename = filename;
+		if (!internal->Map() || !internal->Validate())
+		{
+			wi::backlog::post("wi::package::Open failed: " + filename, wi::backlog::LogLevel::Error);
+			return false;
+		}
+		package->internal_state = internal;
+		return true;
+	}
+
+	std::string NormalizeName(const std::string& name)
+	{
+		std::string ret = name;
+		std::replace(ret.begin(), ret.end(), '\\', '/');
+		return ret;
+	}
+
+	bool Write(const std::string& filename, const wi::vector<Entry>& entries, WriteStatistics* statistics)
+	{
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			wi::backlog::post("wi::package::Write failed to create file: " + filename, wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		auto load_data = [](const Entry& entry, wi::vector<uint8_t>& data) {
+			if (!entry.data.empty() || entry.filename.empty())
+			{
+				data = entry.data;
+				return true;
+			}
+			return wi::helper::FileRead(entry.filename, data);
+		};
+		auto write_padding = [&]() {
+			static const uint8_t zeroes[PACKAGE_ALIGNMENT] = {};
+			const uint64_t pos = (uint64_t)file.tellp();
+			file.write((const char*)zeroes, std::streamsize(((pos + PACKAGE_ALIGNMENT - 1) / PACKAGE_ALIGNMENT * PACKAGE_ALIGNMENT) - pos));
+		};
+
+		Header header = {};
+		std::memcpy(header.magic, PACKAGE_MAGIC, sizeof(PACKAGE_MAGIC));
+		header.version = PACKAGE_VERSION;
+		file.write((const char*)&header, sizeof(header)); // placeholder, it will be rewritten at the end
+		write_padding();
+
+		wi::vector<Blob> blobs;
+		wi::vector<size_t> blob_sources; // index of the entry that the blob was created from, for deduplication
+		wi::vector<EntryData> entry_datas;
+		wi::unordered_map<std::string, uint32_t> entry_lookup; // for replacing duplicate names
+		std::string name_table;
+		wi::unordered_map<uint64_t, wi::vector<uint32_t>> blob_lookup; // content hash -> blob indices
+		WriteStatistics stats;
+
+		wi::vector<uint8_t> data;
+		wi::vector<uint8_t> other;
+		wi::vector<uint8_t> compressed;
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			const Entry& entry = entries[i];
+			if (!load_data(entry, data))
+			{
+				wi::backlog::post("wi::package::Write failed to read file: " + entry.filename, wi::backlog::LogLevel::Error);
+				return false;
+			}
+			stats.file_count++;
+			stats.original_size += data.size();
+
+			// Deduplication:
+			const uint64_t content_hash = wi::helper::hash_fnv1a(data.data(), data.size());
+			uint32_t blob_index = INVALID_ENTRY;
+			auto& candidates = blob_lookup[content_hash];
+			for (uint32_t candidate : candidates)
+			{
+				if (blobs[candidate].original_size != data.size())
+					continue;
+				if (!load_data(entries[blob_sources[candidate]], other))
+					continue;
+				if (other.size() == data.size() && std::memcmp(other.data(), data.data(), data.size()) == 0)
+				{
+					blob_index = candidate;
+					break;
+				}
+			}
+
+			if (blob_index == INVALID_ENTRY)
+			{
+				Blob blob = {};
+				blob.offset = (uint64_t)file.tellp();
+				blob.original_size = data.size();
+				blob.content_hash = content_hash;
+				blob.compression = Compression::NONE;
+				const uint8_t* payload = data.data();
+				size_t payload_size = data.size();
+				if (entry.compress && !data.empty())
+				{
+					compressed.resize(ZSTD_compressBound(data.size()));
+					size_t result = ZSTD_compress(compressed.data(), compressed.size(), data.data(), data.size(), ZSTD_CLEVEL_DEFAULT);
+					if (!ZSTD_isError(result) && result < data.size())
+					{
+						blob.compression = Compression::ZSTD;
+						payload = compressed.data();
+						payload_size = result;
+					}
+				}
+				blob.size = payload_size;
+				file.write((const char*)payload, std::streamsize(payload_size));
+				write_padding();
+
+				blob_index = (uint32_t)blobs.size();
+				blobs.push_back(blob);
+				blob_sources.push_back(i);
+				candidates.push_back(blob_index);
+			}
+
+			const std::string name = NormalizeName(entry.name);
+			auto it = entry_lookup.find(name);
+			if (it != entry_lookup.end())
+			{
+				entry_datas[it->second].blob = blob_index; // the later entry replaces the earlier one with the same name
+				continue;
+			}
+			EntryData entry_data = {};
+			entry_data.name_hash = wi::helper::hash_fnv1a(name.data(), name.size());
+			entry_data.name_offset = (uint32_t)name_table.size();
+			entry_data.name_length = (uint32_t)name.size();
+			entry_data.blob = blob_index;
+			entry_lookup[name] = (uint32_t)entry_datas.size();
+			entry_datas.push_back(entry_data);
+			name_table += name;
+		}
+
+		// Hash table with at most 50% load factor:
+		uint32_t bucket_count = 1;
+		while (bucket_count < entry_datas.size() * 2)
+		{
+			bucket_count <<= 1;
+		}
+		wi::vector<uint32_t> buckets(bucket_count, INVALID_ENTRY);
+		for (uint32_t i = 0; i < (uint32_t)entry_datas.size(); ++i)
+		{
+			uint32_t bucket = uint32_t(entry_datas[i].name_hash) & (bucket_count - 1);
+			while (buckets[bucket] != INVALID_ENTRY)
+			{
+				bucket = (bucket + 1) & (bucket_count - 1);
+			}
+			buckets[bucket] = i;
+		}
+
+		header.entry_count = (uint32_t)entry_datas.size();
+		header.blob_count = (uint32_t)blobs.size();
+		header.bucket_count = bucket_count;
+		header.blob_table_offset = (uint64_t)file.tellp();
+		file.write((const char*)blobs.data(), std::streamsize(blobs.size() * sizeof(Blob)));
+		header.entry_table_offset = (uint64_t)file.tellp();
+		file.write((const char*)entry_datas.data(), std::streamsize(entry_datas.size() * sizeof(EntryData)));
+		header.bucket_table_offset = (uint64_t)file.tellp();
+		file.write((const char*)buckets.data(), std::streamsize(buckets.size() * sizeof(uint32_t)));
+		header.name_table_offset = (uint64_t)file.tellp();
+		header.name_table_size = name_table.size();
+		file.write(name_table.data(), std::streamsize(name_table.size()));
+		stats.package_size = (size_t)file.tellp();
+
+		file.seekp(0);
+		file.write((const char*)&header, sizeof(header));
+		file.close();
+		if (file.fail())
+		{
+			wi::backlog::post("wi::package::Write failed to write file: " + filename, wi::backlog::LogLevel::Error);
+			return false;
+		}
+
+		stats.unique_count = blobs.size();
+		if (statistics != nullptr)
+		{
+			*statistics = stats;
+		}
+		return true;
+	}
+}
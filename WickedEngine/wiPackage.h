@@ -0,0 +1,59 @@
+#pragma once
+#include "CommonInclude.h"
+#include "wiVector.h"
+
+#include <string>
+#include <memory>
+
+namespace wi::package
+{
+	// A package is a single file containing many assets
+	//	- file names are stored in a hash table, so lookup is O(1) without touching the file system
+	//	- file contents are deduplicated by content hash, so the same data is only stored once
+	//	- file contents are 4K aligned in the package, so they can be read directly from the memory mapped file
+	//	- file contents can be optionally compressed
+	struct Package
+	{
+		std::shared_ptr<void> internal_state;
+		inline bool IsValid() const { return internal_state.get() != nullptr; }
+
+		// Returns the package file name
+		const std::string& GetFileName() const;
+		// Returns the number of files in the package
+		size_t GetFileCount() const;
+		// Returns the name of a file in the package
+		std::string GetName(size_t index) const;
+		// Check whether a file with the given name is in the package
+		bool Contains(const std::string& name) const;
+		// Returns the pointer to the file data inside the memory mapped package, or nullptr if the file is compressed or not found
+		//	The pointer is valid until the package is destroyed
+		const uint8_t* GetData(const std::string& name, size_t* size) const;
+		// Reads a file from the package, decompressing it if necessary
+		bool Read(const std::string& name, wi::vector<uint8_t>& data) const;
+	};
+
+	// Opens a package file, it will be memory mapped while the package is alive
+	bool Open(const std::string& filename, Package* package);
+
+	struct Entry
+	{
+		std::string name; // name that is used to find the file in the package
+		std::string filename; // file to read the data from if data is empty
+		wi::vector<uint8_t> data; // data to be written, if empty, the data will be read from filename
+		bool compress = false; // store the data compressed
+	};
+	struct WriteStatistics
+	{
+		size_t file_count = 0;
+		size_t unique_count = 0; // number of unique data payloads after deduplication
+		size_t original_size = 0; // sum of file sizes
+		size_t package_size = 0; // size of the package file
+	};
+	// Writes a package file from a list of entries
+	//	Names are case sensitive, back slashes are converted to forward slashes
+	//	Entries whose data is equal will be stored only once
+	bool Write(const std::string& filename, const wi::vector<Entry>& entries, WriteStatistics* statistics = nullptr);
+
+	// Converts a name to the format that is used for lookup in packages
+	std::string NormalizeName(const std::string& name);
+}
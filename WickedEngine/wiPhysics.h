@@ -21,6 +21,28 @@ namespace wi::physics
 	void SetDebugDrawEnabled(bool value);
 	bool IsDebugDrawEnabled();
 
+	// Enable/disable multithreaded simulation (default: disabled)
+	//	Collision detection, simulation island solving and rigid body integration will be distributed across the job system
+	//	The results are only the same as the single threaded simulation if deterministic mode is also enabled
+	void SetMultithreaded(bool value);
+	bool IsMultithreaded();
+
+	// Enable/disable deterministic results when the simulation is multithreaded
+	//	When enabled, the simulation result doesn't depend on how the work was distributed between threads, at a small cost
+	void SetDeterministic(bool value);
+	bool IsDeterministic();
+
+	// Enable/disable fixed time step simulation
+	//	The simulation will be stepped with a constant time step on a background job, decoupled from the frame rate
+	//	The transforms of rigid bodies are interpolated between the last two simulation steps, so they lag behind by at most one step
+	//	The simulation result doesn't depend on the frame rate, and the frame doesn't wait for the simulation to complete
+	void SetFixedTimeStepEnabled(bool value);
+	bool IsFixedTimeStepEnabled();
+
+	// Set the time step of the fixed time step simulation in seconds (default: 1.0f / 60.0f)
+	void SetFixedTimeStep(float value);
+	float GetFixedTimeStep();
+
 	// Set the accuracy of the simulation
 	//	This value corresponds to maximum simulation step count
 	//	Higher values will be slower but more accurate
@@ -34,6 +56,27 @@ namespace wi::physics
 		float dt
 	);
 
+	// Rigid bodies with convex hull or triangle mesh shape that were created from the same mesh share their cooked collision shape
+	struct CollisionShapeStatistics
+	{
+		uint32_t cooked_shape_count = 0; // number of unique cooked collision shapes
+		uint32_t rigidbody_count = 0; // number of rigid bodies that are using the cooked collision shapes
+		size_t cooked_memory = 0; // approximate memory of the cooked collision shape data in bytes
+	};
+	CollisionShapeStatistics GetCollisionShapeStatistics(const wi::scene::Scene& scene);
+
+	// Serialize the cooked triangle mesh collision shapes (bvh trees) of the scene
+	//	This is serialized alongside the scene by Scene::Serialize(), so the triangle meshes don't need to be cooked again after loading
+	//	The serialized data will be only used for meshes whose data didn't change
+	void SerializeCollisionShapes(
+		wi::scene::Scene& scene,
+		wi::Archive& archive,
+		wi::ecs::EntitySerializer& seri
+	);
+	// Moves the serialized collision shapes that were not used yet from the src scene to the dst scene
+	//	This is used by Scene::Merge()
+	void MergeCollisionShapes(wi::scene::Scene& dst, wi::scene::Scene& src);
+
 	// Set linear velocity to rigid body
 	void SetLinearVelocity(
 		wi::scene::RigidBodyPhysicsComponent& physicscomponent,
@@ -91,4 +134,82 @@ namespace wi::physics
 		wi::scene::SoftBodyPhysicsComponent& physicscomponent,
 		ActivationState state
 	);
+
+	// Scene queries:
+	//	These are using the broadphase acceleration structure of the physics world, so only physics bodies are tested
+	//	The physics world state is from the last RunPhysicsUpdateSystem(), queries must not be used while that is running
+	//	Queries are only reading the physics world, so they can be run from multiple threads at the same time
+
+	struct QueryResult
+	{
+		wi::ecs::Entity entity = wi::ecs::INVALID_ENTITY;
+		XMFLOAT3 position = XMFLOAT3(0, 0, 0);
+		XMFLOAT3 normal = XMFLOAT3(0, 0, 0);
+		float distance = std::numeric_limits<float>::max();
+	};
+	// Shape that can be used in ConvexSweep() and Overlap()
+	struct QueryShape
+	{
+		enum class Type
+		{
+			Sphere,
+			Capsule,
+			Box,
+		} type = Type::Sphere;
+		float radius = 1; // sphere and capsule
+		float height = 1; // capsule
+		XMFLOAT3 halfextents = XMFLOAT3(1, 1, 1); // box
+		XMFLOAT3 position = XMFLOAT3(0, 0, 0);
+		XMFLOAT4 rotation = XMFLOAT4(0, 0, 0, 1);
+	};
+
+	// Returns the closest hit along the ray between ray.TMin and ray.TMax, result.entity is INVALID_ENTITY if nothing was hit
+	//	If ray.TMax is not finite, the ray length is limited to 1000000 units
+	QueryResult RayCast(
+		const wi::scene::Scene& scene,
+		const wi::primitive::Ray& ray,
+		uint32_t layerMask = ~0u
+	);
+	// Returns every hit along the ray, sorted by distance
+	void RayCastAll(
+		const wi::scene::Scene& scene,
+		const wi::primitive::Ray& ray,
+		wi::vector<QueryResult>& results,
+		uint32_t layerMask = ~0u
+	);
+	// Moves the shape from its position by the motion vector and returns the first hit
+	//	result.position is the contact point, result.distance is the distance the shape could move until the contact
+	QueryResult ConvexSweep(
+		const wi::scene::Scene& scene,
+		const QueryShape& shape,
+		const XMFLOAT3& motion,
+		uint32_t layerMask = ~0u
+	);
+	// Returns the entities of rigid bodies that are intersecting with the shape
+	void Overlap(
+		const wi::scene::Scene& scene,
+		const QueryShape& shape,
+		wi::vector<wi::ecs::Entity>& entities,
+		uint32_t layerMask = ~0u
+	);
+
+	// Batched queries, they are dispatched into the job system context, wait on the context to get the results
+	//	The scene, the input and output arrays must be kept alive until the queries are finished
+	void RayCastBatch(
+		wi::jobsystem::context& ctx,
+		const wi::scene::Scene& scene,
+		const wi::primitive::Ray* rays,
+		QueryResult* results,
+		uint32_t count,
+		uint32_t layerMask = ~0u
+	);
+	void ConvexSweepBatch(
+		wi::jobsystem::context& ctx,
+		const wi::scene::Scene& scene,
+		const QueryShape* shapes,
+		const XMFLOAT3* motions,
+		QueryResult* results,
+		uint32_t count,
+		uint32_t layerMask = ~0u
+	);
 }
@@ -5,15 +5,25 @@
 #include "wiJobSystem.h"
 #include "wiRenderer.h"
 #include "wiTimer.h"
+#include "wiHelper.h"
 
 #include "btBulletDynamicsCommon.h"
 #include "BulletSoftBody/btSoftBodyHelpers.h"
 #include "BulletSoftBody/btDefaultSoftBodySolver.h"
 #include "BulletSoftBody/btSoftRigidDynamicsWorld.h"
 #include "BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h"
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "BulletCollision/NarrowPhaseCollision/btGjkEpa2.h"
+#include "BulletCollision/CollisionShapes/btTriangleShape.h"
+#include "BulletCollision/CollisionShapes/btConvexPointCloudShape.h"
+#include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"
+#include "BulletCollision/CollisionDispatch/btConvexConvexAlgorithm.h"
+#include "BulletCollision/NarrowPhaseCollision/btVoronoiSimplexSolver.h"
 
 #include <mutex>
 #include <memory>
+#include <algorithm>
+#include <atomic>
 
 using namespace wi::ecs;
 using namespace wi::scene;
@@ -25,6 +35,11 @@ namespace wi::physics
 		bool ENABLED = true;
 		bool SIMULATION_ENABLED = true;
 		bool DEBUGDRAW_ENABLED = false;
+		std::atomic<bool> MULTITHREADED{ false }; // atomic, because these are read by the background simulation job
+		std::atomic<bool> DETERMINISTIC{ false };
+		std::atomic<bool> FIXED_TIMESTEP_ENABLED{ false };
+		float FIXED_TIMESTEP = 1.0f / 60.0f;
+		constexpr uint32_t FIXED_TIMESTEP_MAX_COUNT = 8; // simulation steps per frame are limited, so slow frames will not cause even more work
 		int ACCURACY = 1;
 		int softbodyIterationCount = 5;
 		std::mutex physicsLock;
@@ -70,14 +85,496 @@ namespace wi::physics
 		};
 		DebugDraw debugDraw;
 
+		// Runs func(index) for every index in [0, count), distributed across the job system when multithreading is enabled
+		template<typename F>
+		void ParallelFor(uint32_t count, uint32_t groupSize, const F& func)
+		{
+			if (!MULTITHREADED || count <= groupSize)
+			{
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					func(i);
+				}
+				return;
+			}
+			wi::jobsystem::context ctx;
+			wi::jobsystem::Dispatch(ctx, count, groupSize, [&](wi::jobsystem::JobArgs args) {
+				func(args.jobIndex);
+			});
+			wi::jobsystem::Wait(ctx);
+		}
+
+		// The convex-convex collision algorithm uses a simplex solver that keeps state while processing a pair
+		//	Bullet shares one simplex solver between all the algorithms, so here every algorithm owns one instead, to allow processing pairs in parallel
+		class ConvexConvexAlgorithm final : public btConvexConvexAlgorithm
+		{
+			btVoronoiSimplexSolver simplexSolver; // the base class only stores its address when constructed
+
+		public:
+			ConvexConvexAlgorithm(
+				const btCollisionAlgorithmConstructionInfo& ci,
+				const btCollisionObjectWrapper* body0Wrap,
+				const btCollisionObjectWrapper* body1Wrap,
+				const btConvexConvexAlgorithm::CreateFunc& params
+			) : btConvexConvexAlgorithm(ci.m_manifold, ci, body0Wrap, body1Wrap, &simplexSolver, params.m_pdSolver, params.m_numPerturbationIterations, params.m_minimumPointsPerturbationThreshold)
+			{
+			}
+
+			struct CreateFunc final : public btCollisionAlgorithmCreateFunc
+			{
+				const btConvexConvexAlgorithm::CreateFunc* params = nullptr; // the original create function, its settings are used
+
+				btCollisionAlgorithm* CreateCollisionAlgorithm(btCollisionAlgorithmConstructionInfo& ci, const btCollisionObjectWrapper* body0Wrap, const btCollisionObjectWrapper* body1Wrap) override
+				{
+					void* mem = ci.m_dispatcher1->allocateCollisionAlgorithm(sizeof(ConvexConvexAlgorithm));
+					return new(mem) ConvexConvexAlgorithm(ci, body0Wrap, body1Wrap, *params);
+				}
+			};
+		};
+
+		// Replaces the convex-convex collision algorithm with ConvexConvexAlgorithm, the other algorithms are the same as in Bullet
+		class CollisionConfiguration final : public btSoftBodyRigidBodyCollisionConfiguration
+		{
+			ConvexConvexAlgorithm::CreateFunc convexConvexCreateFunc;
+
+			static btDefaultCollisionConstructionInfo GetConstructionInfo()
+			{
+				btDefaultCollisionConstructionInfo info;
+				info.m_customCollisionAlgorithmMaxElementSize = sizeof(ConvexConvexAlgorithm);
+				return info;
+			}
+
+		public:
+			CollisionConfiguration() : btSoftBodyRigidBodyCollisionConfiguration(GetConstructionInfo())
+			{
+				convexConvexCreateFunc.params = (const btConvexConvexAlgorithm::CreateFunc*)m_convexConvexCreateFunc;
+			}
+
+			btCollisionAlgorithmCreateFunc* getCollisionAlgorithmCreateFunc(int proxyType0, int proxyType1) override
+			{
+				btCollisionAlgorithmCreateFunc* createFunc = btSoftBodyRigidBodyCollisionConfiguration::getCollisionAlgorithmCreateFunc(proxyType0, proxyType1);
+				if (createFunc == m_convexConvexCreateFunc)
+				{
+					return &convexConvexCreateFunc;
+				}
+				return createFunc;
+			}
+		};
+
+		// The collision dispatcher processes the overlapping pairs in parallel
+		//	Creating and destroying collision algorithms and contact manifolds is locked, the rest of the narrowphase is per pair
+		//	Pairs with soft bodies are processed serially, because soft body collisions are stored in the soft body
+		class Dispatcher final : public btCollisionDispatcher
+		{
+			std::mutex locker;
+			wi::vector<btBroadphasePair*> parallel_pairs;
+			wi::vector<btBroadphasePair*> serial_pairs;
+			wi::vector<btPersistentManifold*> sorted_manifolds;
+			wi::vector<uint8_t> sorted_flags;
+			btManifoldArray algorithm_manifolds;
+
+			// The contact manifolds are reordered to follow the overlapping pair order
+			//	Otherwise the order would depend on which thread created a manifold first, and that affects the solver
+			void SortManifolds(btBroadphasePairArray& pairs)
+			{
+				const int manifold_count = m_manifoldsPtr.size();
+				sorted_manifolds.clear();
+				sorted_flags.clear();
+				sorted_flags.resize(manifold_count);
+				for (int i = 0; i < pairs.size(); ++i)
+				{
+					if (pairs[i].m_algorithm == nullptr)
+						continue;
+					algorithm_manifolds.resize(0);
+					pairs[i].m_algorithm->getAllContactManifolds(algorithm_manifolds);
+					for (int j = 0; j < algorithm_manifolds.size(); ++j)
+					{
+						btPersistentManifold* manifold = algorithm_manifolds[j];
+						const int index = manifold->m_index1a;
+						if (index >= 0 && index < manifold_count && m_manifoldsPtr[index] == manifold && sorted_flags[index] == 0)
+						{
+							sorted_flags[index] = 1;
+							sorted_manifolds.push_back(manifold);
+						}
+					}
+				}
+				for (int i = 0; i < manifold_count; ++i)
+				{
+					if (sorted_flags[i] == 0)
+					{
+						sorted_manifolds.push_back(m_manifoldsPtr[i]);
+					}
+				}
+				for (int i = 0; i < manifold_count; ++i)
+				{
+					m_manifoldsPtr[i] = sorted_manifolds[i];
+					m_manifoldsPtr[i]->m_index1a = i;
+				}
+			}
+
+		public:
+			Dispatcher(btCollisionConfiguration* collisionConfiguration) : btCollisionDispatcher(collisionConfiguration) {}
+
+			btPersistentManifold* getNewManifold(const btCollisionObject* b0, const btCollisionObject* b1) override
+			{
+				std::scoped_lock lock(locker);
+				return btCollisionDispatcher::getNewManifold(b0, b1);
+			}
+			void releaseManifold(btPersistentManifold* manifold) override
+			{
+				std::scoped_lock lock(locker);
+				btCollisionDispatcher::releaseManifold(manifold);
+			}
+			void* allocateCollisionAlgorithm(int size) override
+			{
+				std::scoped_lock lock(locker);
+				return btCollisionDispatcher::allocateCollisionAlgorithm(size);
+			}
+			void freeCollisionAlgorithm(void* ptr) override
+			{
+				std::scoped_lock lock(locker);
+				btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+			}
+
+			void dispatchAllCollisionPairs(btOverlappingPairCache* pairCache, const btDispatcherInfo& dispatchInfo, btDispatcher* dispatcher) override
+			{
+				if (!MULTITHREADED || dispatchInfo.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE)
+				{
+					btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+					return;
+				}
+
+				btBroadphasePairArray& pairs = pairCache->getOverlappingPairArray();
+				parallel_pairs.clear();
+				serial_pairs.clear();
+				for (int i = 0; i < pairs.size(); ++i)
+				{
+					btBroadphasePair& pair = pairs[i];
+					const btCollisionObject* colObj0 = (const btCollisionObject*)pair.m_pProxy0->m_clientObject;
+					const btCollisionObject* colObj1 = (const btCollisionObject*)pair.m_pProxy1->m_clientObject;
+					if ((colObj0->getInternalType() | colObj1->getInternalType()) & btCollisionObject::CO_SOFT_BODY)
+					{
+						serial_pairs.push_back(&pair);
+					}
+					else
+					{
+						parallel_pairs.push_back(&pair);
+					}
+				}
+
+				btNearCallback nearCallback = getNearCallback();
+				ParallelFor((uint32_t)parallel_pairs.size(), 64, [&](uint32_t i) {
+					nearCallback(*parallel_pairs[i], *this, dispatchInfo);
+				});
+				for (btBroadphasePair* pair : serial_pairs)
+				{
+					nearCallback(*pair, *this, dispatchInfo);
+				}
+
+				if (DETERMINISTIC)
+				{
+					SortManifolds(pairs);
+				}
+			}
+		};
+
+		inline int GetConstraintIslandId(const btTypedConstraint* constraint)
+		{
+			const btCollisionObject& colObj0 = constraint->getRigidBodyA();
+			const btCollisionObject& colObj1 = constraint->getRigidBodyB();
+			return colObj0.getIslandTag() >= 0 ? colObj0.getIslandTag() : colObj1.getIslandTag();
+		}
+
+		// Collects the simulation islands into batches that can be solved independently from each other
+		//	Small islands are merged into one batch until it reaches the minimum solver batch size
+		//	Kinematic bodies can be in multiple islands and the solver writes to them, so those batches are solved serially
+		struct IslandBatcher final : public btSimulationIslandManager::IslandCallback
+		{
+			struct Batch
+			{
+				uint32_t body_offset = 0;
+				uint32_t body_count = 0;
+				uint32_t manifold_offset = 0;
+				uint32_t manifold_count = 0;
+				uint32_t constraint_offset = 0;
+				uint32_t constraint_count = 0;
+				bool serial = false;
+			};
+			wi::vector<Batch> batches;
+			wi::vector<btCollisionObject*> bodies;
+			wi::vector<btPersistentManifold*> manifolds;
+			wi::vector<btTypedConstraint*> constraints;
+
+			btTypedConstraint** sorted_constraints = nullptr;
+			int sorted_constraint_count = 0;
+			int sorted_constraint_cursor = 0;
+			uint32_t batch_size = 0;
+
+			void setup(btTypedConstraint** sortedConstraints, int numConstraints, int minimumSolverBatchSize)
+			{
+				batches.clear();
+				bodies.clear();
+				manifolds.clear();
+				constraints.clear();
+				sorted_constraints = sortedConstraints;
+				sorted_constraint_count = numConstraints;
+				sorted_constraint_cursor = 0;
+				batch_size = (uint32_t)std::max(1, minimumSolverBatchSize);
+			}
+
+			void processIsland(btCollisionObject** islandBodies, int numBodies, btPersistentManifold** islandManifolds, int numManifolds, int islandId) override
+			{
+				if (batches.empty() || (batches.back().manifold_count + batches.back().constraint_count) >= batch_size)
+				{
+					Batch& batch = batches.emplace_back();
+					batch.body_offset = (uint32_t)bodies.size();
+					batch.manifold_offset = (uint32_t)manifolds.size();
+					batch.constraint_offset = (uint32_t)constraints.size();
+				}
+				Batch& batch = batches.back();
+
+				for (int i = 0; i < numBodies; ++i)
+				{
+					bodies.push_back(islandBodies[i]);
+				}
+				for (int i = 0; i < numManifolds; ++i)
+				{
+					btPersistentManifold* manifold = islandManifolds[i];
+					manifolds.push_back(manifold);
+					batch.serial |= manifold->getBody0()->isKinematicObject() || manifold->getBody1()->isKinematicObject();
+				}
+
+				// Islands are processed in increasing id order, same as the constraints are sorted:
+				while (sorted_constraint_cursor < sorted_constraint_count && GetConstraintIslandId(sorted_constraints[sorted_constraint_cursor]) < islandId)
+				{
+					sorted_constraint_cursor++;
+				}
+				while (sorted_constraint_cursor < sorted_constraint_count && GetConstraintIslandId(sorted_constraints[sorted_constraint_cursor]) == islandId)
+				{
+					btTypedConstraint* constraint = sorted_constraints[sorted_constraint_cursor++];
+					constraints.push_back(constraint);
+					batch.serial |= constraint->getRigidBodyA().isKinematicObject() || constraint->getRigidBodyB().isKinematicObject();
+				}
+
+				batch.body_count = (uint32_t)bodies.size() - batch.body_offset;
+				batch.manifold_count = (uint32_t)manifolds.size() - batch.manifold_offset;
+				batch.constraint_count = (uint32_t)constraints.size() - batch.constraint_offset;
+			}
+		};
+
+		// The dynamics world distributes simulation islands and rigid body integration across the job system
+		//	Every thread that solves islands uses its own constraint solver from a pool
+		//	Soft body simulation remains serial, because soft bodies update the broadphase and apply impulses to rigid bodies
+		class DynamicsWorld final : public btSoftRigidDynamicsWorld
+		{
+			btSoftBodySolver* softBodySolver = nullptr;
+			IslandBatcher islandBatcher;
+			wi::vector<uint32_t> parallel_batches;
+			wi::vector<uint32_t> serial_batches;
+			std::mutex solvers_locker;
+			wi::vector<std::unique_ptr<btSequentialImpulseConstraintSolver>> solvers; // solvers that are not in use
+
+			std::unique_ptr<btSequentialImpulseConstraintSolver> AcquireSolver()
+			{
+				std::scoped_lock lock(solvers_locker);
+				if (solvers.empty())
+				{
+					return std::make_unique<btSequentialImpulseConstraintSolver>();
+				}
+				std::unique_ptr<btSequentialImpulseConstraintSolver> solver = std::move(solvers.back());
+				solvers.pop_back();
+				return solver;
+			}
+			void ReleaseSolver(std::unique_ptr<btSequentialImpulseConstraintSolver>&& solver)
+			{
+				std::scoped_lock lock(solvers_locker);
+				solvers.push_back(std::move(solver));
+			}
+			void SolveBatch(const IslandBatcher::Batch& batch, const btContactSolverInfo& solverInfo)
+			{
+				std::unique_ptr<btSequentialImpulseConstraintSolver> solver = AcquireSolver();
+				if (DETERMINISTIC)
+				{
+					// The randomized solver order must not depend on which solver was used previously:
+					solver->setRandSeed(0);
+				}
+				solver->solveGroup(
+					islandBatcher.bodies.data() + batch.body_offset,
+					(int)batch.body_count,
+					islandBatcher.manifolds.data() + batch.manifold_offset,
+					(int)batch.manifold_count,
+					islandBatcher.constraints.data() + batch.constraint_offset,
+					(int)batch.constraint_count,
+					solverInfo,
+					nullptr,
+					m_dispatcher1
+				);
+				ReleaseSolver(std::move(solver));
+			}
+
+		protected:
+			void predictUnconstraintMotion(btScalar timeStep) override
+			{
+				ParallelFor((uint32_t)m_nonStaticRigidBodies.size(), 256, [&](uint32_t i) {
+					btRigidBody* body = m_nonStaticRigidBodies[i];
+					if (!body->isStaticOrKinematicObject())
+					{
+						body->applyDamping(timeStep);
+						body->predictIntegratedTransform(timeStep, body->getInterpolationWorldTransform());
+					}
+				});
+				softBodySolver->predictMotion(timeStep);
+			}
+
+			void integrateTransforms(btScalar timeStep) override
+			{
+				bool continuous = false;
+				if (getDispatchInfo().m_useContinuous)
+				{
+					for (int i = 0; i < m_nonStaticRigidBodies.size() && !continuous; ++i)
+					{
+						continuous = m_nonStaticRigidBodies[i]->getCcdSquareMotionThreshold() > 0;
+					}
+				}
+				if (!MULTITHREADED || continuous || m_applySpeculativeContactRestitution)
+				{
+					// Motion clamping uses world queries that can't be done in parallel
+					btSoftRigidDynamicsWorld::integrateTransforms(timeStep);
+					return;
+				}
+
+				ParallelFor((uint32_t)m_nonStaticRigidBodies.size(), 256, [&](uint32_t i) {
+					btRigidBody* body = m_nonStaticRigidBodies[i];
+					body->setHitFraction(1);
+					if (body->isActive() && !body->isStaticOrKinematicObject())
+					{
+						btTransform predictedTrans;
+						body->predictIntegratedTransform(timeStep, predictedTrans);
+						body->proceedToTransform(predictedTrans);
+					}
+				});
+			}
+
+			void solveConstraints(btContactSolverInfo& solverInfo) override
+			{
+				if (!MULTITHREADED || !m_islandManager->getSplitIslands())
+				{
+					btSoftRigidDynamicsWorld::solveConstraints(solverInfo);
+					return;
+				}
+
+				m_sortedConstraints.resize(m_constraints.size());
+				for (int i = 0; i < m_constraints.size(); ++i)
+				{
+					m_sortedConstraints[i] = m_constraints[i];
+				}
+				std::stable_sort(&m_sortedConstraints[0], &m_sortedConstraints[0] + m_sortedConstraints.size(), [](const btTypedConstraint* a, const btTypedConstraint* b) {
+					return GetConstraintIslandId(a) < GetConstraintIslandId(b);
+				});
+
+				islandBatcher.setup(m_sortedConstraints.size() > 0 ? &m_sortedConstraints[0] : nullptr, m_sortedConstraints.size(), solverInfo.m_minimumSolverBatchSize);
+				m_islandManager->buildAndProcessIslands(getDispatcher(), getCollisionWorld(), &islandBatcher);
+
+				parallel_batches.clear();
+				serial_batches.clear();
+				for (uint32_t i = 0; i < (uint32_t)islandBatcher.batches.size(); ++i)
+				{
+					if (islandBatcher.batches[i].serial)
+					{
+						serial_batches.push_back(i);
+					}
+					else
+					{
+						parallel_batches.push_back(i);
+					}
+				}
+				ParallelFor((uint32_t)parallel_batches.size(), 1, [&](uint32_t i) {
+					SolveBatch(islandBatcher.batches[parallel_batches[i]], solverInfo);
+				});
+				for (uint32_t i : serial_batches)
+				{
+					SolveBatch(islandBatcher.batches[i], solverInfo);
+				}
+			}
+
+		public:
+			DynamicsWorld(
+				btDispatcher* dispatcher,
+				btBroadphaseInterface* pairCache,
+				btConstraintSolver* constraintSolver,
+				btCollisionConfiguration* collisionConfiguration,
+				btSoftBodySolver* softBodySolver
+			) : btSoftRigidDynamicsWorld(dispatcher, pairCache, constraintSolver, collisionConfiguration, softBodySolver), softBodySolver(softBodySolver)
+			{
+			}
+		};
+
+		// Cooked collision shape that is shared by every rigid body that was created from the same mesh
+		//	Rigid bodies reference it with their own lightweight shape, which stores the local scaling
+		struct CookedShape
+		{
+			uint64_t hash = 0; // hash of the mesh data that this was cooked from, to detect when the mesh was modified
+
+			btAlignedObjectArray<btVector3> points; // convex hull
+			wi::vector<XMFLOAT3> vertices; // triangle mesh data is copied, so it doesn't depend on the lifetime of the mesh
+			wi::vector<int> indices;
+			btTriangleIndexVertexArray triangles;
+			std::unique_ptr<btBvhTriangleMeshShape> triangleMesh;
+			btOptimizedBvh* loadedBvh = nullptr; // deserialized bvh, it is not owned by triangleMesh
+
+			~CookedShape()
+			{
+				triangleMesh.reset();
+				if (loadedBvh != nullptr)
+				{
+					loadedBvh->~btOptimizedBvh();
+					btAlignedFree(loadedBvh);
+				}
+			}
+		};
+
 		struct PhysicsScene
 		{
-			btSoftBodyRigidBodyCollisionConfiguration collisionConfiguration;
+			CollisionConfiguration collisionConfiguration;
 			btDbvtBroadphase overlappingPairCache;
 			btSequentialImpulseConstraintSolver solver;
-			btCollisionDispatcher dispatcher = btCollisionDispatcher(&collisionConfiguration);
-			btSoftRigidDynamicsWorld dynamicsWorld = btSoftRigidDynamicsWorld(&dispatcher, &overlappingPairCache, &solver, &collisionConfiguration);
+			btDefaultSoftBodySolver softBodySolver;
+			Dispatcher dispatcher = Dispatcher(&collisionConfiguration);
+			DynamicsWorld dynamicsWorld = DynamicsWorld(&dispatcher, &overlappingPairCache, &solver, &collisionConfiguration, &softBodySolver);
+
+			// Fixed time step simulation runs asynchronously in this context
+			//	It has low priority, so a thread that waits on other jobs will not pick up the whole simulation:
+			wi::jobsystem::context simulation_ctx;
+			float accumulator = 0; // simulation time that was not yet simulated
+			bool interpolation_valid = false; // whether the saved transforms of rigid bodies are up to date
+
+			// Cooked collision shapes by mesh, shape type and LOD, they are alive while rigid bodies are using them:
+			wi::unordered_map<uint64_t, std::weak_ptr<CookedShape>> cooked_shapes;
+			// Serialized bvh trees that can be used instead of cooking triangle meshes, if the mesh data is unchanged:
+			struct SerializedBvh
+			{
+				uint64_t hash = 0;
+				wi::vector<uint8_t> data;
+			};
+			wi::unordered_map<uint64_t, SerializedBvh> serialized_bvhs;
+
+			PhysicsScene()
+			{
+				simulation_ctx.priority = wi::jobsystem::Priority::Low;
+			}
+			~PhysicsScene()
+			{
+				wi::jobsystem::Wait(simulation_ctx);
+			}
 		};
+		// The physics world must not be accessed while the asynchronous simulation is running
+		inline void WaitSimulation(const std::shared_ptr<void>& physics_scene)
+		{
+			if (physics_scene != nullptr)
+			{
+				wi::jobsystem::Wait(((const PhysicsScene*)physics_scene.get())->simulation_ctx);
+			}
+		}
 		PhysicsScene& GetPhysicsScene(Scene& scene)
 		{
 			if (scene.physics_scene == nullptr)
@@ -108,14 +605,18 @@ namespace wi::physics
 		struct RigidBody
 		{
 			std::shared_ptr<void> physics_scene;
+			std::shared_ptr<CookedShape> cookedShape;
 			std::unique_ptr<btCollisionShape> shape;
 			std::unique_ptr<btRigidBody> rigidBody;
 			btDefaultMotionState motionState;
-			btTriangleIndexVertexArray triangles;
+			// The last two simulated states in fixed time step mode, these are interpolated to get the transform for the system:
+			btTransform previous_transform = btTransform::getIdentity();
+			btTransform current_transform = btTransform::getIdentity();
 			~RigidBody()
 			{
 				if (physics_scene == nullptr)
 					return;
+				WaitSimulation(physics_scene);
 				btSoftRigidDynamicsWorld& dynamicsWorld = ((PhysicsScene*)physics_scene.get())->dynamicsWorld;
 				dynamicsWorld.removeRigidBody(rigidBody.get());
 			}
@@ -128,11 +629,178 @@ namespace wi::physics
 			{
 				if (physics_scene == nullptr)
 					return;
+				WaitSimulation(physics_scene);
 				btSoftRigidDynamicsWorld& dynamicsWorld = ((PhysicsScene*)physics_scene.get())->dynamicsWorld;
 				dynamicsWorld.removeSoftBody(softBody.get());
 			}
 		};
 
+		// Physics world for queries, nullptr if the scene doesn't have physics yet
+		const PhysicsScene* GetPhysicsSceneForQuery(const Scene& scene)
+		{
+			WaitSimulation(scene.physics_scene);
+			return (const PhysicsScene*)scene.physics_scene.get();
+		}
+		bool IsQueryable(const Scene& scene, const btCollisionObject* collisionobject, uint32_t layerMask)
+		{
+			const Entity entity = (Entity)collisionobject->getUserIndex();
+			const LayerComponent* layer = scene.layers.GetComponent(entity);
+			return layer == nullptr || (layer->GetLayerMask() & layerMask) != 0;
+		}
+
+		// The broadphase traversal functions of btDbvtBroadphase are using a shared stack, so they can't be used from multiple threads
+		//	Instead, the broadphase trees are traversed here with the btDbvt functions that are using a local stack
+		template<typename T>
+		void BroadphaseRayTest(const PhysicsScene& physics_scene, const btVector3& from, const btVector3& to, T& collide)
+		{
+			const btDbvtBroadphase& broadphase = physics_scene.overlappingPairCache;
+			btDbvt::rayTest(broadphase.m_sets[0].m_root, from, to, collide);
+			btDbvt::rayTest(broadphase.m_sets[1].m_root, from, to, collide);
+		}
+		template<typename T>
+		void BroadphaseAabbTest(const PhysicsScene& physics_scene, const btVector3& aabb_min, const btVector3& aabb_max, T& collide)
+		{
+			const btDbvtBroadphase& broadphase = physics_scene.overlappingPairCache;
+			const ATTRIBUTE_ALIGNED16(btDbvtVolume) volume = btDbvtVolume::FromMM(aabb_min, aabb_max);
+			broadphase.m_sets[0].collideTV(broadphase.m_sets[0].m_root, volume, collide);
+			broadphase.m_sets[1].collideTV(broadphase.m_sets[1].m_root, volume, collide);
+		}
+		inline btCollisionObject* GetCollisionObject(const btDbvtNode* leaf)
+		{
+			return (btCollisionObject*)((btBroadphaseProxy*)leaf->data)->m_clientObject;
+		}
+
+		struct QueryRayCollide : public btDbvt::ICollide
+		{
+			const Scene* scene = nullptr;
+			uint32_t layerMask = ~0u;
+			btTransform from;
+			btTransform to;
+			btCollisionWorld::RayResultCallback* callback = nullptr;
+
+			void Process(const btDbvtNode* leaf)
+			{
+				btCollisionObject* collisionobject = GetCollisionObject(leaf);
+				if (!callback->needsCollision(collisionobject->getBroadphaseHandle()) || !IsQueryable(*scene, collisionobject, layerMask))
+					return;
+				btCollisionWorld::rayTestSingle(from, to, collisionobject, collisionobject->getCollisionShape(), collisionobject->getWorldTransform(), *callback);
+			}
+		};
+		struct QuerySweepCollide : public btDbvt::ICollide
+		{
+			const Scene* scene = nullptr;
+			uint32_t layerMask = ~0u;
+			const btConvexShape* shape = nullptr;
+			btTransform from;
+			btTransform to;
+			btCollisionWorld::ConvexResultCallback* callback = nullptr;
+
+			void Process(const btDbvtNode* leaf)
+			{
+				btCollisionObject* collisionobject = GetCollisionObject(leaf);
+				if (!callback->needsCollision(collisionobject->getBroadphaseHandle()) || !IsQueryable(*scene, collisionobject, layerMask))
+					return;
+				btCollisionWorld::objectQuerySingle(shape, from, to, collisionobject, collisionobject->getCollisionShape(), collisionobject->getWorldTransform(), *callback, 0);
+			}
+		};
+
+		// Convex shapes are tested with GJK, the shape margins are not part of the GJK result, so they are added here:
+		bool IsOverlapping(const btConvexShape* shape0, const btTransform& transform0, const btConvexShape* shape1, const btTransform& transform1)
+		{
+			btGjkEpaSolver2::sResults results;
+			if (btGjkEpaSolver2::Distance(shape0, transform0, shape1, transform1, btVector3(1, 0, 0), results))
+			{
+				return results.distance < shape0->getMargin() + shape1->getMargin();
+			}
+			return results.status == btGjkEpaSolver2::sResults::Penetrating;
+		}
+		struct QueryOverlapTriangleCallback : public btTriangleCallback
+		{
+			const btConvexShape* shape = nullptr;
+			btTransform transform; // transform of shape in the triangle mesh's local space
+			bool overlapping = false;
+
+			void processTriangle(btVector3* triangle, int partId, int triangleIndex) override
+			{
+				if (overlapping)
+					return;
+				btTriangleShape triangle_shape(triangle[0], triangle[1], triangle[2]);
+				triangle_shape.setMargin(0);
+				overlapping = IsOverlapping(shape, transform, &triangle_shape, btTransform::getIdentity());
+			}
+		};
+		struct QueryOverlapCollide : public btDbvt::ICollide
+		{
+			const Scene* scene = nullptr;
+			uint32_t layerMask = ~0u;
+			const btConvexShape* shape = nullptr;
+			btTransform transform;
+			wi::vector<Entity>* entities = nullptr;
+
+			void Process(const btDbvtNode* leaf)
+			{
+				btCollisionObject* collisionobject = GetCollisionObject(leaf);
+				if (btRigidBody::upcast(collisionobject) == nullptr || !IsQueryable(*scene, collisionobject, layerMask))
+					return;
+				const btCollisionShape* collisionshape = collisionobject->getCollisionShape();
+				const btTransform& collisiontransform = collisionobject->getWorldTransform();
+				bool overlapping = false;
+				if (collisionshape->isConvex())
+				{
+					overlapping = IsOverlapping(shape, transform, (const btConvexShape*)collisionshape, collisiontransform);
+				}
+				else if (collisionshape->isConcave())
+				{
+					QueryOverlapTriangleCallback callback;
+					callback.shape = shape;
+					callback.transform = collisiontransform.inverse() * transform;
+					btVector3 aabb_min, aabb_max;
+					shape->getAabb(callback.transform, aabb_min, aabb_max);
+					((const btConcaveShape*)collisionshape)->processAllTriangles(&callback, aabb_min, aabb_max);
+					overlapping = callback.overlapping;
+				}
+				if (overlapping)
+				{
+					entities->push_back((Entity)collisionobject->getUserIndex());
+				}
+			}
+		};
+
+		// Creates the Bullet shape for a query shape on the stack and calls the function with it
+		template<typename F>
+		void WithQueryShape(const wi::physics::QueryShape& shape, F&& func)
+		{
+			switch (shape.type)
+			{
+			default:
+			case wi::physics::QueryShape::Type::Sphere:
+				{
+					btSphereShape sphere(btScalar(shape.radius));
+					func(sphere);
+				}
+				break;
+			case wi::physics::QueryShape::Type::Capsule:
+				{
+					btCapsuleShape capsule(btScalar(shape.radius), btScalar(shape.height));
+					func(capsule);
+				}
+				break;
+			case wi::physics::QueryShape::Type::Box:
+				{
+					btBoxShape box(btVector3(shape.halfextents.x, shape.halfextents.y, shape.halfextents.z));
+					func(box);
+				}
+				break;
+			}
+		}
+		inline btTransform GetQueryShapeTransform(const wi::physics::QueryShape& shape)
+		{
+			return btTransform(
+				btQuaternion(shape.rotation.x, shape.rotation.y, shape.rotation.z, shape.rotation.w),
+				btVector3(shape.position.x, shape.position.y, shape.position.z)
+			);
+		}
+
 		RigidBody& GetRigidBody(wi::scene::RigidBodyPhysicsComponent& physicscomponent)
 		{
 			if (physicscomponent.physicsobject == nullptr)
@@ -149,6 +817,167 @@ namespace wi::physics
 			}
 			return *(SoftBody*)physicscomponent.physicsobject.get();
 		}
+		// Returns the rigid body if it is registered to the physics world, and waits for the simulation to be able to modify it
+		btRigidBody* GetRigidBodyForModify(wi::scene::RigidBodyPhysicsComponent& physicscomponent)
+		{
+			if (physicscomponent.physicsobject == nullptr)
+				return nullptr;
+			RigidBody& physicsobject = GetRigidBody(physicscomponent);
+			WaitSimulation(physicsobject.physics_scene);
+			return physicsobject.rigidBody.get();
+		}
+		btSoftBody* GetSoftBodyForModify(wi::scene::SoftBodyPhysicsComponent& physicscomponent)
+		{
+			if (physicscomponent.physicsobject == nullptr)
+				return nullptr;
+			SoftBody& physicsobject = GetSoftBody(physicscomponent);
+			WaitSimulation(physicsobject.physics_scene);
+			return physicsobject.softBody.get();
+		}
+		// Stores the current state of dynamic rigid bodies for interpolation
+		void SaveTransforms(btSoftRigidDynamicsWorld& dynamicsWorld, bool previous)
+		{
+			for (int i = 0; i < dynamicsWorld.getCollisionObjectArray().size(); ++i)
+			{
+				btRigidBody* rigidbody = btRigidBody::upcast(dynamicsWorld.getCollisionObjectArray()[i]);
+				if (rigidbody == nullptr || rigidbody->isStaticOrKinematicObject())
+					continue;
+				RigidBody* physicsobject = (RigidBody*)rigidbody->getUserPointer();
+				if (previous)
+				{
+					physicsobject->previous_transform = rigidbody->getWorldTransform();
+				}
+				else
+				{
+					physicsobject->current_transform = rigidbody->getWorldTransform();
+				}
+			}
+		}
+
+		inline uint64_t GetCookedShapeKey(Entity meshID, RigidBodyPhysicsComponent::CollisionShape shape, uint32_t lod)
+		{
+			return uint64_t(meshID) | (uint64_t(shape) << 32ull) | (uint64_t(lod) << 40ull);
+		}
+		// Hash of the mesh data that the shape is cooked from: the vertex positions, and the indices of the LOD for triangle meshes
+		uint64_t ComputeCookedShapeSourceHash(const MeshComponent& mesh, RigidBodyPhysicsComponent::CollisionShape shape, uint32_t lod)
+		{
+			uint64_t hash = wi::helper::hash_fnv1a(mesh.vertex_positions.data(), mesh.vertex_positions.size() * sizeof(XMFLOAT3));
+			if (shape == RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH)
+			{
+				uint32_t first_subset = 0;
+				uint32_t last_subset = 0;
+				mesh.GetLODSubsetRange(lod, first_subset, last_subset);
+				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+				{
+					const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
+					hash = wi::helper::hash_fnv1a(mesh.indices.data() + subset.indexOffset, subset.indexCount / 3 * 3 * sizeof(uint32_t), hash);
+				}
+			}
+			return hash;
+		}
+		// Returns the cooked collision shape of a mesh, it will be cooked only if it's not already in use by an other rigid body
+		//	The cooked shape is reused only if the mesh data is unchanged, even if it was modified in place
+		std::shared_ptr<CookedShape> GetCookedShape(
+			PhysicsScene& physics_scene,
+			const MeshComponent& mesh,
+			Entity meshID,
+			RigidBodyPhysicsComponent::CollisionShape shape,
+			uint32_t lod
+		)
+		{
+			const uint64_t key = GetCookedShapeKey(meshID, shape, lod);
+			const uint64_t hash = ComputeCookedShapeSourceHash(mesh, shape, lod);
+			std::weak_ptr<CookedShape>& cached = physics_scene.cooked_shapes[key];
+			std::shared_ptr<CookedShape> cooked = cached.lock();
+			if (cooked != nullptr && cooked->hash == hash)
+			{
+				return cooked;
+			}
+
+			cooked = std::make_shared<CookedShape>();
+			cooked->hash = hash;
+
+			switch (shape)
+			{
+			case RigidBodyPhysicsComponent::CollisionShape::CONVEX_HULL:
+			{
+				// Duplicate vertices (for example at UV seams) are not needed by the hull:
+				wi::vector<XMFLOAT3> points = mesh.vertex_positions;
+				std::sort(points.begin(), points.end(), [](const XMFLOAT3& a, const XMFLOAT3& b) {
+					return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+				});
+				points.erase(std::unique(points.begin(), points.end(), [](const XMFLOAT3& a, const XMFLOAT3& b) {
+					return a.x == b.x && a.y == b.y && a.z == b.z;
+				}), points.end());
+				cooked->points.reserve(int(points.size()));
+				for (auto& pos : points)
+				{
+					cooked->points.push_back(btVector3(pos.x, pos.y, pos.z));
+				}
+			}
+			break;
+			case RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH:
+			{
+				uint32_t first_subset = 0;
+				uint32_t last_subset = 0;
+				mesh.GetLODSubsetRange(lod, first_subset, last_subset);
+				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+				{
+					const MeshComponent::MeshSubset& subset = mesh.subsets[subsetIndex];
+					const int* indices = (const int*)mesh.indices.data() + subset.indexOffset;
+					cooked->indices.insert(cooked->indices.end(), indices, indices + subset.indexCount / 3 * 3);
+				}
+				cooked->vertices = mesh.vertex_positions;
+				if (cooked->indices.empty() || cooked->vertices.empty())
+					break;
+
+				cooked->triangles = btTriangleIndexVertexArray(
+					int(cooked->indices.size() / 3),
+					cooked->indices.data(),
+					3 * int(sizeof(int)),
+					int(cooked->vertices.size()),
+					(btScalar*)cooked->vertices.data(),
+					int(sizeof(XMFLOAT3))
+				);
+
+				bool useQuantizedAabbCompression = true;
+
+				// Try to use the serialized bvh instead of building it:
+				auto it = physics_scene.serialized_bvhs.find(key);
+				if (it != physics_scene.serialized_bvhs.end())
+				{
+					const PhysicsScene::SerializedBvh& serialized = it->second;
+					if (serialized.hash == hash && serialized.data.size() >= sizeof(btOptimizedBvh))
+					{
+						void* buffer = btAlignedAlloc(serialized.data.size(), 16);
+						std::memcpy(buffer, serialized.data.data(), serialized.data.size());
+						cooked->loadedBvh = btOptimizedBvh::deSerializeInPlace(buffer, (unsigned int)serialized.data.size(), false);
+						if (cooked->loadedBvh == nullptr)
+						{
+							btAlignedFree(buffer);
+						}
+					}
+					physics_scene.serialized_bvhs.erase(it);
+				}
+
+				if (cooked->loadedBvh != nullptr)
+				{
+					cooked->triangleMesh = std::make_unique<btBvhTriangleMeshShape>(&cooked->triangles, useQuantizedAabbCompression, false);
+					cooked->triangleMesh->setOptimizedBvh(cooked->loadedBvh);
+				}
+				else
+				{
+					cooked->triangleMesh = std::make_unique<btBvhTriangleMeshShape>(&cooked->triangles, useQuantizedAabbCompression);
+				}
+			}
+			break;
+			default:
+				break;
+			}
+
+			cached = cooked;
+			return cooked;
+		}
 	}
 	using namespace bullet;
 
@@ -168,6 +997,18 @@ namespace wi::physics
 	bool IsDebugDrawEnabled() { return DEBUGDRAW_ENABLED; }
 	void SetDebugDrawEnabled(bool value) { DEBUGDRAW_ENABLED = value; }
 
+	bool IsMultithreaded() { return MULTITHREADED; }
+	void SetMultithreaded(bool value) { MULTITHREADED = value; }
+
+	bool IsDeterministic() { return DETERMINISTIC; }
+	void SetDeterministic(bool value) { DETERMINISTIC = value; }
+
+	bool IsFixedTimeStepEnabled() { return FIXED_TIMESTEP_ENABLED; }
+	void SetFixedTimeStepEnabled(bool value) { FIXED_TIMESTEP_ENABLED = value; }
+
+	float GetFixedTimeStep() { return FIXED_TIMESTEP; }
+	void SetFixedTimeStep(float value) { FIXED_TIMESTEP = std::max(0.0001f, value); }
+
 	int GetAccuracy() { return ACCURACY; }
 	void SetAccuracy(int value) { ACCURACY = value; }
 
@@ -176,7 +1017,8 @@ namespace wi::physics
 		Entity entity,
 		wi::scene::RigidBodyPhysicsComponent& physicscomponent,
 		const wi::scene::TransformComponent& transform,
-		const wi::scene::MeshComponent* mesh
+		const wi::scene::MeshComponent* mesh,
+		Entity meshID
 	)
 	{
 		RigidBody& physicsobject = GetRigidBody(physicscomponent);
@@ -196,14 +1038,13 @@ namespace wi::physics
 		case RigidBodyPhysicsComponent::CollisionShape::CONVEX_HULL:
 			if(mesh != nullptr)
 			{
-				physicsobject.shape = std::make_unique<btConvexHullShape>();
-				btConvexHullShape* convexHull = (btConvexHullShape*)physicsobject.shape.get();
-				for (auto& pos : mesh->vertex_positions)
+				// The hull points are shared between bodies of the same mesh, the point cloud shape only references them:
+				physicsobject.cookedShape = GetCookedShape(GetPhysicsScene(scene), *mesh, meshID, physicscomponent.shape, 0);
+				if (physicsobject.cookedShape->points.size() > 0)
 				{
-					convexHull->addPoint(btVector3(pos.x, pos.y, pos.z));
+					btVector3 S(transform.scale_local.x, transform.scale_local.y, transform.scale_local.z);
+					physicsobject.shape = std::make_unique<btConvexPointCloudShape>(&physicsobject.cookedShape->points[0], physicsobject.cookedShape->points.size(), S);
 				}
-				btVector3 S(transform.scale_local.x, transform.scale_local.y, transform.scale_local.z);
-				physicsobject.shape->setLocalScaling(S);
 			}
 			else
 			{
@@ -215,34 +1056,14 @@ namespace wi::physics
 		case RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH:
 			if(mesh != nullptr)
 			{
-				int totalTriangles = 0;
-				int* indices = nullptr;
-				uint32_t first_subset = 0;
-				uint32_t last_subset = 0;
-				mesh->GetLODSubsetRange(physicscomponent.mesh_lod, first_subset, last_subset);
-				for (uint32_t subsetIndex = first_subset; subsetIndex < last_subset; ++subsetIndex)
+				// The triangle bvh is shared between bodies of the same mesh, the scaled shape only references it:
+				//	Ray tests against the scaled shape use the bvh because of a modification in the Bullet library (btCollisionWorld::rayTestSingleInternal)
+				physicsobject.cookedShape = GetCookedShape(GetPhysicsScene(scene), *mesh, meshID, physicscomponent.shape, physicscomponent.mesh_lod);
+				if (physicsobject.cookedShape->triangleMesh != nullptr)
 				{
-					const MeshComponent::MeshSubset& subset = mesh->subsets[subsetIndex];
-					if (indices == nullptr)
-					{
-						indices = (int*)(mesh->indices.data() + subset.indexOffset);
-					}
-					totalTriangles += int(subset.indexCount / 3);
+					btVector3 S(transform.scale_local.x, transform.scale_local.y, transform.scale_local.z);
+					physicsobject.shape = std::make_unique<btScaledBvhTriangleMeshShape>(physicsobject.cookedShape->triangleMesh.get(), S);
 				}
-
-				physicsobject.triangles = btTriangleIndexVertexArray(
-					totalTriangles,
-					indices,
-					3 * int(sizeof(int)),
-					int(mesh->vertex_positions.size()),
-					(btScalar*)mesh->vertex_positions.data(),
-					int(sizeof(XMFLOAT3))
-				);
-
-				bool useQuantizedAabbCompression = true;
-				physicsobject.shape = std::make_unique<btBvhTriangleMeshShape>(&physicsobject.triangles, useQuantizedAabbCompression);
-				btVector3 S(transform.scale_local.x, transform.scale_local.y, transform.scale_local.z);
-				physicsobject.shape->setLocalScaling(S);
 			}
 			else
 			{
@@ -296,6 +1117,9 @@ namespace wi::physics
 
 			physicsobject.rigidBody = std::make_unique<btRigidBody>(rbInfo);
 			physicsobject.rigidBody->setUserIndex(entity);
+			physicsobject.rigidBody->setUserPointer(&physicsobject);
+			physicsobject.previous_transform = shapeTransform;
+			physicsobject.current_transform = shapeTransform;
 
 			if (physicscomponent.IsKinematic())
 			{
@@ -481,7 +1305,12 @@ namespace wi::physics
 
 		auto range = wi::profiler::BeginRangeCPU("Physics");
 
-		btSoftRigidDynamicsWorld& dynamicsWorld = GetPhysicsScene(scene).dynamicsWorld;
+		PhysicsScene& physics_scene = GetPhysicsScene(scene);
+
+		// The fixed time step simulation that was started in the previous frame must be finished before accessing the world:
+		wi::jobsystem::Wait(physics_scene.simulation_ctx);
+
+		btSoftRigidDynamicsWorld& dynamicsWorld = physics_scene.dynamicsWorld;
 		dynamicsWorld.setGravity(btVector3(scene.weather.gravity.x, scene.weather.gravity.y, scene.weather.gravity.z));
 
 		btVector3 wind = btVector3(scene.weather.windDirection.x, scene.weather.windDirection.y, scene.weather.windDirection.z);
@@ -497,12 +1326,14 @@ namespace wi::physics
 				TransformComponent& transform = *scene.transforms.GetComponent(entity);
 				const ObjectComponent* object = scene.objects.GetComponent(entity);
 				const MeshComponent* mesh = nullptr;
+				Entity meshID = INVALID_ENTITY;
 				if (object != nullptr)
 				{
-					mesh = scene.meshes.GetComponent(object->meshID);
+					meshID = object->meshID;
+					mesh = scene.meshes.GetComponent(meshID);
 				}
 				physicsLock.lock();
-				AddRigidBody(scene, entity, physicscomponent, transform, mesh);
+				AddRigidBody(scene, entity, physicscomponent, transform, mesh, meshID);
 				physicsLock.unlock();
 			}
 
@@ -537,6 +1368,10 @@ namespace wi::physics
 					{
 						// This is a more direct way of manipulating rigid body:
 						rigidbody->setWorldTransform(physicsTransform);
+
+						RigidBody& physicsobject = GetRigidBody(physicscomponent);
+						physicsobject.previous_transform = physicsTransform;
+						physicsobject.current_transform = physicsTransform;
 					}
 
 					btCollisionShape* shape = rigidbody->getCollisionShape();
@@ -604,8 +1439,20 @@ namespace wi::physics
 
 		wi::jobsystem::Wait(ctx);
 
+		// With fixed time step, the simulation is running asynchronously and lags behind by one step,
+		//	the system state is interpolated between the last two steps by the remaining unsimulated time:
+		const bool fixed_timestep = IsFixedTimeStepEnabled() && IsSimulationEnabled();
+		const float interpolation = fixed_timestep ? wi::math::saturate(physics_scene.accumulator / FIXED_TIMESTEP) : 1;
+		if (fixed_timestep && !physics_scene.interpolation_valid)
+		{
+			// Switched to fixed time step, there is nothing to interpolate from yet:
+			SaveTransforms(dynamicsWorld, true);
+			SaveTransforms(dynamicsWorld, false);
+		}
+		physics_scene.interpolation_valid = fixed_timestep;
+
 		// Perform internal simulation step:
-		if (IsSimulationEnabled())
+		if (IsSimulationEnabled() && !fixed_timestep)
 		{
 			dynamicsWorld.stepSimulation(dt, ACCURACY);
 		}
@@ -626,9 +1473,20 @@ namespace wi::physics
 				{
 					TransformComponent& transform = *scene.transforms.GetComponent(entity);
 	
-					btTransform physicsTransform = rigidbody->getWorldTransform();
-					btVector3 T = physicsTransform.getOrigin();
-					btQuaternion R = physicsTransform.getRotation();
+					btVector3 T;
+					btQuaternion R;
+					if (fixed_timestep)
+					{
+						const RigidBody& physicsobject = GetRigidBody(*physicscomponent);
+						T = physicsobject.previous_transform.getOrigin().lerp(physicsobject.current_transform.getOrigin(), interpolation);
+						R = physicsobject.previous_transform.getRotation().slerp(physicsobject.current_transform.getRotation(), interpolation);
+					}
+					else
+					{
+						btTransform physicsTransform = rigidbody->getWorldTransform();
+						T = physicsTransform.getOrigin();
+						R = physicsTransform.getRotation();
+					}
 
 					transform.translation_local = XMFLOAT3(T.x(), T.y(), T.z());
 					transform.rotation_local = XMFLOAT4(R.x(), R.y(), R.z(), R.w());
@@ -770,19 +1628,157 @@ namespace wi::physics
 			dynamicsWorld.debugDrawWorld();
 		}
 
+		// Start the fixed time step simulation, it will run in the background while the frame continues:
+		if (fixed_timestep)
+		{
+			physics_scene.accumulator += dt;
+			const uint32_t steps = std::min(uint32_t(physics_scene.accumulator / FIXED_TIMESTEP), FIXED_TIMESTEP_MAX_COUNT);
+			physics_scene.accumulator -= steps * FIXED_TIMESTEP;
+			// The time that is left over because of the step limit is discarded on purpose, so the simulation doesn't keep falling further behind after a slow frame:
+			physics_scene.accumulator = std::min(physics_scene.accumulator, FIXED_TIMESTEP);
+
+			if (steps > 0)
+			{
+				const float timestep = FIXED_TIMESTEP;
+				btSoftRigidDynamicsWorld* world = &dynamicsWorld;
+				wi::jobsystem::Execute(physics_scene.simulation_ctx, [world, steps, timestep](wi::jobsystem::JobArgs args) {
+					auto range = wi::profiler::BeginRangeCPU("Physics Simulation");
+					for (uint32_t step = 0; step < steps; ++step)
+					{
+						if (step == steps - 1)
+						{
+							SaveTransforms(*world, true);
+						}
+						world->stepSimulation(timestep, 0);
+					}
+					SaveTransforms(*world, false);
+					wi::profiler::EndRange(range);
+				});
+			}
+		}
+
 		wi::profiler::EndRange(range); // Physics
 	}
 
 
 
+	CollisionShapeStatistics GetCollisionShapeStatistics(const wi::scene::Scene& scene)
+	{
+		CollisionShapeStatistics statistics;
+		WaitSimulation(scene.physics_scene);
+		const PhysicsScene* physics_scene = (const PhysicsScene*)scene.physics_scene.get();
+		if (physics_scene == nullptr)
+			return statistics;
+
+		for (auto& it : physics_scene->cooked_shapes)
+		{
+			std::shared_ptr<CookedShape> cooked = it.second.lock();
+			if (cooked == nullptr)
+				continue;
+			statistics.cooked_shape_count++;
+			statistics.rigidbody_count += uint32_t(cooked.use_count() - 1);
+			statistics.cooked_memory += sizeof(CookedShape);
+			statistics.cooked_memory += cooked->points.capacity() * sizeof(btVector3);
+			statistics.cooked_memory += cooked->vertices.capacity() * sizeof(XMFLOAT3);
+			statistics.cooked_memory += cooked->indices.capacity() * sizeof(int);
+			if (cooked->triangleMesh != nullptr)
+			{
+				statistics.cooked_memory += sizeof(btBvhTriangleMeshShape);
+				statistics.cooked_memory += cooked->triangleMesh->getOptimizedBvh()->calculateSerializeBufferSize();
+			}
+		}
+		return statistics;
+	}
+
+	void SerializeCollisionShapes(
+		wi::scene::Scene& scene,
+		wi::Archive& archive,
+		wi::ecs::EntitySerializer& seri
+	)
+	{
+		WaitSimulation(scene.physics_scene);
+
+		if (archive.IsReadMode())
+		{
+			uint32_t count = 0;
+			archive >> count;
+			if (count == 0)
+				return;
+			PhysicsScene& physics_scene = GetPhysicsScene(scene);
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				Entity meshID = INVALID_ENTITY;
+				uint32_t lod = 0;
+				PhysicsScene::SerializedBvh serialized;
+				SerializeEntity(archive, meshID, seri);
+				archive >> lod;
+				archive >> serialized.hash;
+				archive >> serialized.data;
+				const uint64_t key = GetCookedShapeKey(meshID, RigidBodyPhysicsComponent::CollisionShape::TRIANGLE_MESH, lod);
+				physics_scene.serialized_bvhs[key] = std::move(serialized);
+			}
+		}
+		else
+		{
+			wi::vector<std::pair<uint64_t, std::shared_ptr<CookedShape>>> triangle_meshes;
+			const PhysicsScene* physics_scene = (const PhysicsScene*)scene.physics_scene.get();
+			if (physics_scene != nullptr)
+			{
+				for (auto& it : physics_scene->cooked_shapes)
+				{
+					std::shared_ptr<CookedShape> cooked = it.second.lock();
+					if (cooked != nullptr && cooked->triangleMesh != nullptr)
+					{
+						triangle_meshes.emplace_back(it.first, cooked);
+					}
+				}
+			}
+
+			archive << (uint32_t)triangle_meshes.size();
+			for (auto& it : triangle_meshes)
+			{
+				Entity meshID = Entity(it.first & 0xFFFFFFFFull);
+				uint32_t lod = uint32_t(it.first >> 40ull);
+				const btOptimizedBvh* bvh = it.second->triangleMesh->getOptimizedBvh();
+				const unsigned int size = bvh->calculateSerializeBufferSize();
+				void* buffer = btAlignedAlloc(size, 16);
+				bvh->serializeInPlace(buffer, size, false);
+				wi::vector<uint8_t> data((const uint8_t*)buffer, (const uint8_t*)buffer + size);
+				btAlignedFree(buffer);
+
+				SerializeEntity(archive, meshID, seri);
+				archive << lod;
+				archive << it.second->hash;
+				archive << data;
+			}
+		}
+	}
+
+	void MergeCollisionShapes(wi::scene::Scene& dst, wi::scene::Scene& src)
+	{
+		PhysicsScene* src_physics_scene = (PhysicsScene*)src.physics_scene.get();
+		if (src_physics_scene == nullptr || src_physics_scene->serialized_bvhs.empty())
+			return;
+		wi::jobsystem::Wait(src_physics_scene->simulation_ctx);
+
+		PhysicsScene& dst_physics_scene = GetPhysicsScene(dst);
+		wi::jobsystem::Wait(dst_physics_scene.simulation_ctx);
+		for (auto& it : src_physics_scene->serialized_bvhs)
+		{
+			dst_physics_scene.serialized_bvhs[it.first] = std::move(it.second);
+		}
+		src_physics_scene->serialized_bvhs.clear();
+	}
+
 	void SetLinearVelocity(
 		wi::scene::RigidBodyPhysicsComponent& physicscomponent,
 		const XMFLOAT3& velocity
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			GetRigidBody(physicscomponent).rigidBody->setLinearVelocity(btVector3(velocity.x, velocity.y, velocity.z));
+			rigidbody->setLinearVelocity(btVector3(velocity.x, velocity.y, velocity.z));
 		}
 	}
 	void SetAngularVelocity(
@@ -790,9 +1786,10 @@ namespace wi::physics
 		const XMFLOAT3& velocity
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			GetRigidBody(physicscomponent).rigidBody->setAngularVelocity(btVector3(velocity.x, velocity.y, velocity.z));
+			rigidbody->setAngularVelocity(btVector3(velocity.x, velocity.y, velocity.z));
 		}
 	}
 
@@ -801,9 +1798,10 @@ namespace wi::physics
 		const XMFLOAT3& force
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			GetRigidBody(physicscomponent).rigidBody->applyCentralForce(btVector3(force.x, force.y, force.z));
+			rigidbody->applyCentralForce(btVector3(force.x, force.y, force.z));
 		}
 	}
 	void ApplyForceAt(
@@ -812,9 +1810,10 @@ namespace wi::physics
 		const XMFLOAT3& at
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			GetRigidBody(physicscomponent).rigidBody->applyForce(btVector3(force.x, force.y, force.z), btVector3(at.x, at.y, at.z));
+			rigidbody->applyForce(btVector3(force.x, force.y, force.z), btVector3(at.x, at.y, at.z));
 		}
 	}
 
@@ -823,9 +1822,10 @@ namespace wi::physics
 		const XMFLOAT3& impulse
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			GetRigidBody(physicscomponent).rigidBody->applyCentralImpulse(btVector3(impulse.x, impulse.y, impulse.z));
+			rigidbody->applyCentralImpulse(btVector3(impulse.x, impulse.y, impulse.z));
 		}
 	}
 	void ApplyImpulseAt(
@@ -834,9 +1834,10 @@ namespace wi::physics
 		const XMFLOAT3& at
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			GetRigidBody(physicscomponent).rigidBody->applyImpulse(btVector3(impulse.x, impulse.y, impulse.z), btVector3(at.x, at.y, at.z));
+			rigidbody->applyImpulse(btVector3(impulse.x, impulse.y, impulse.z), btVector3(at.x, at.y, at.z));
 		}
 	}
 
@@ -845,9 +1846,10 @@ namespace wi::physics
 		const XMFLOAT3& torque
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			GetRigidBody(physicscomponent).rigidBody->applyTorque(btVector3(torque.x, torque.y, torque.z));
+			rigidbody->applyTorque(btVector3(torque.x, torque.y, torque.z));
 		}
 	}
 	void ApplyTorqueImpulse(
@@ -855,9 +1857,10 @@ namespace wi::physics
 		const XMFLOAT3& torque
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			GetRigidBody(physicscomponent).rigidBody->applyTorqueImpulse(btVector3(torque.x, torque.y, torque.z));
+			rigidbody->applyTorqueImpulse(btVector3(torque.x, torque.y, torque.z));
 		}
 	}
 
@@ -877,10 +1880,11 @@ namespace wi::physics
 		ActivationState state
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btRigidBody* rigidbody = GetRigidBodyForModify(physicscomponent);
+		if (rigidbody != nullptr)
 		{
-			//GetRigidBody(physicscomponent).rigidBody->setActivationState(to_internal(state));
-			GetRigidBody(physicscomponent).rigidBody->forceActivationState(to_internal(state));
+			//rigidbody->setActivationState(to_internal(state));
+			rigidbody->forceActivationState(to_internal(state));
 		}
 	}
 	void SetActivationState(
@@ -888,10 +1892,185 @@ namespace wi::physics
 		ActivationState state
 	)
 	{
-		if (physicscomponent.physicsobject != nullptr)
+		btSoftBody* softbody = GetSoftBodyForModify(physicscomponent);
+		if (softbody != nullptr)
+		{
+			//softbody->setActivationState(to_internal(state));
+			softbody->forceActivationState(to_internal(state));
+		}
+	}
+
+	QueryResult RayCast(
+		const wi::scene::Scene& scene,
+		const wi::primitive::Ray& ray,
+		uint32_t layerMask
+	)
+	{
+		QueryResult result;
+		const PhysicsScene* physics_scene = GetPhysicsSceneForQuery(scene);
+		if (physics_scene == nullptr)
+			return result;
+
+		const btVector3 origin = btVector3(ray.origin.x, ray.origin.y, ray.origin.z);
+		const btVector3 direction = btVector3(ray.direction.x, ray.direction.y, ray.direction.z).normalized();
+		const float tmin = ray.TMin;
+		const float tmax = std::min(ray.TMax, 1000000.0f);
+
+		QueryRayCollide collide;
+		collide.scene = &scene;
+		collide.layerMask = layerMask;
+		collide.from = btTransform(btQuaternion::getIdentity(), origin + direction * tmin);
+		collide.to = btTransform(btQuaternion::getIdentity(), origin + direction * tmax);
+		btCollisionWorld::ClosestRayResultCallback callback(collide.from.getOrigin(), collide.to.getOrigin());
+		collide.callback = &callback;
+		BroadphaseRayTest(*physics_scene, collide.from.getOrigin(), collide.to.getOrigin(), collide);
+
+		if (callback.hasHit())
 		{
-			//GetSoftBody(physicscomponent).softBody->setActivationState(to_internal(state));
-			GetSoftBody(physicscomponent).softBody->forceActivationState(to_internal(state));
+			const btVector3 normal = callback.m_hitNormalWorld.normalized();
+			result.entity = (Entity)callback.m_collisionObject->getUserIndex();
+			result.position = XMFLOAT3(callback.m_hitPointWorld.x(), callback.m_hitPointWorld.y(), callback.m_hitPointWorld.z());
+			result.normal = XMFLOAT3(normal.x(), normal.y(), normal.z());
+			result.distance = tmin + (tmax - tmin) * callback.m_closestHitFraction;
 		}
+		return result;
+	}
+	void RayCastAll(
+		const wi::scene::Scene& scene,
+		const wi::primitive::Ray& ray,
+		wi::vector<QueryResult>& results,
+		uint32_t layerMask
+	)
+	{
+		results.clear();
+		const PhysicsScene* physics_scene = GetPhysicsSceneForQuery(scene);
+		if (physics_scene == nullptr)
+			return;
+
+		const btVector3 origin = btVector3(ray.origin.x, ray.origin.y, ray.origin.z);
+		const btVector3 direction = btVector3(ray.direction.x, ray.direction.y, ray.direction.z).normalized();
+		const float tmin = ray.TMin;
+		const float tmax = std::min(ray.TMax, 1000000.0f);
+
+		QueryRayCollide collide;
+		collide.scene = &scene;
+		collide.layerMask = layerMask;
+		collide.from = btTransform(btQuaternion::getIdentity(), origin + direction * tmin);
+		collide.to = btTransform(btQuaternion::getIdentity(), origin + direction * tmax);
+		btCollisionWorld::AllHitsRayResultCallback callback(collide.from.getOrigin(), collide.to.getOrigin());
+		collide.callback = &callback;
+		BroadphaseRayTest(*physics_scene, collide.from.getOrigin(), collide.to.getOrigin(), collide);
+
+		results.resize(callback.m_collisionObjects.size());
+		for (int i = 0; i < callback.m_collisionObjects.size(); ++i)
+		{
+			const btVector3& position = callback.m_hitPointWorld[i];
+			const btVector3 normal = callback.m_hitNormalWorld[i].normalized();
+			QueryResult& result = results[i];
+			result.entity = (Entity)callback.m_collisionObjects[i]->getUserIndex();
+			result.position = XMFLOAT3(position.x(), position.y(), position.z());
+			result.normal = XMFLOAT3(normal.x(), normal.y(), normal.z());
+			result.distance = tmin + (tmax - tmin) * callback.m_hitFractions[i];
+		}
+		std::sort(results.begin(), results.end(), [](const QueryResult& a, const QueryResult& b) {
+			return a.distance < b.distance;
+		});
+	}
+	QueryResult ConvexSweep(
+		const wi::scene::Scene& scene,
+		const QueryShape& shape,
+		const XMFLOAT3& motion,
+		uint32_t layerMask
+	)
+	{
+		QueryResult result;
+		const PhysicsScene* physics_scene = GetPhysicsSceneForQuery(scene);
+		if (physics_scene == nullptr)
+			return result;
+
+		WithQueryShape(shape, [&](const btConvexShape& convex) {
+			QuerySweepCollide collide;
+			collide.scene = &scene;
+			collide.layerMask = layerMask;
+			collide.shape = &convex;
+			collide.from = GetQueryShapeTransform(shape);
+			collide.to = collide.from;
+			collide.to.setOrigin(collide.from.getOrigin() + btVector3(motion.x, motion.y, motion.z));
+			btCollisionWorld::ClosestConvexResultCallback callback(collide.from.getOrigin(), collide.to.getOrigin());
+			collide.callback = &callback;
+
+			// The broadphase is tested with the bounding box of the whole sweep:
+			btVector3 aabb_min, aabb_max, aabb_min_to, aabb_max_to;
+			convex.getAabb(collide.from, aabb_min, aabb_max);
+			convex.getAabb(collide.to, aabb_min_to, aabb_max_to);
+			aabb_min.setMin(aabb_min_to);
+			aabb_max.setMax(aabb_max_to);
+			BroadphaseAabbTest(*physics_scene, aabb_min, aabb_max, collide);
+
+			if (callback.hasHit())
+			{
+				const btVector3 normal = callback.m_hitNormalWorld.normalized();
+				result.entity = (Entity)callback.m_hitCollisionObject->getUserIndex();
+				result.position = XMFLOAT3(callback.m_hitPointWorld.x(), callback.m_hitPointWorld.y(), callback.m_hitPointWorld.z());
+				result.normal = XMFLOAT3(normal.x(), normal.y(), normal.z());
+				result.distance = wi::math::Length(motion) * callback.m_closestHitFraction;
+			}
+		});
+		return result;
+	}
+	void Overlap(
+		const wi::scene::Scene& scene,
+		const QueryShape& shape,
+		wi::vector<wi::ecs::Entity>& entities,
+		uint32_t layerMask
+	)
+	{
+		entities.clear();
+		const PhysicsScene* physics_scene = GetPhysicsSceneForQuery(scene);
+		if (physics_scene == nullptr)
+			return;
+
+		WithQueryShape(shape, [&](const btConvexShape& convex) {
+			QueryOverlapCollide collide;
+			collide.scene = &scene;
+			collide.layerMask = layerMask;
+			collide.shape = &convex;
+			collide.transform = GetQueryShapeTransform(shape);
+			collide.entities = &entities;
+
+			btVector3 aabb_min, aabb_max;
+			convex.getAabb(collide.transform, aabb_min, aabb_max);
+			BroadphaseAabbTest(*physics_scene, aabb_min, aabb_max, collide);
+		});
+	}
+
+	void RayCastBatch(
+		wi::jobsystem::context& ctx,
+		const wi::scene::Scene& scene,
+		const wi::primitive::Ray* rays,
+		QueryResult* results,
+		uint32_t count,
+		uint32_t layerMask
+	)
+	{
+		const Scene* scene_ptr = &scene;
+		wi::jobsystem::Dispatch(ctx, count, 64, [=](wi::jobsystem::JobArgs args) {
+			results[args.jobIndex] = RayCast(*scene_ptr, rays[args.jobIndex], layerMask);
+		});
+	}
+	void ConvexSweepBatch(
+		wi::jobsystem::context& ctx,
+		const wi::scene::Scene& scene,
+		const QueryShape* shapes,
+		const XMFLOAT3* motions,
+		QueryResult* results,
+		uint32_t count,
+		uint32_t layerMask
+	)
+	{
+		const Scene* scene_ptr = &scene;
+		wi::jobsystem::Dispatch(ctx, count, 16, [=](wi::jobsystem::JobArgs args) {
+			results[args.jobIndex] = ConvexSweep(*scene_ptr, shapes[args.jobIndex], motions[args.jobIndex], layerMask);
+		});
 	}
 }
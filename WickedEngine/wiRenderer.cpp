@@ -21,6 +21,7 @@
 #include "wiTimer.h"
 #include "wiUnorderedMap.h" // leave it here for shader dump!
 #include "wiFont.h"
+#include "wiResourceManager.h"
 
 #include "shaders/ShaderInterop_Postprocess.h"
 #include "shaders/ShaderInterop_Raytracing.h"
@@ -2829,6 +2830,8 @@ void UpdateVisibility(Visibility& vis)
 	{
 		// Cull objects:
 		vis.visibleObjects.resize(vis.scene->aabb_objects.GetCount());
+		const bool streaming_enabled = wi::resourcemanager::IsStreamingEnabled() && vis.camera->height > 0;
+		const float streaming_fov_scale = std::tan(vis.camera->fov * 0.5f) * 2;
 		wi::jobsystem::Dispatch(ctx, (uint32_t)vis.scene->aabb_objects.GetCount(), groupSize, [&](wi::jobsystem::JobArgs args) {
 
 			// Setup stream compaction:
@@ -2869,6 +2872,25 @@ void UpdateVisibility(Visibility& vis)
 					}
 				}
 
+				if (streaming_enabled && object.mesh_index < vis.scene->meshes.GetCount())
+				{
+					// Request texture resolution for streaming textures from the approximate screen size of the object:
+					const float distance = std::max(0.001f, wi::math::Distance(vis.camera->Eye, object.center) - object.radius);
+					const float screen_size = object.radius * 2 / (distance * streaming_fov_scale) * vis.camera->height;
+					const MeshComponent& mesh = vis.scene->meshes[object.mesh_index];
+					for (auto& subset : mesh.subsets)
+					{
+						if (subset.materialIndex >= vis.scene->materials.GetCount())
+							continue;
+						const MaterialComponent& material = vis.scene->materials[subset.materialIndex];
+						const uint32_t resolution = (uint32_t)std::ceil(screen_size * std::max(material.texMulAdd.x, material.texMulAdd.y));
+						for (auto& x : material.textures)
+						{
+							x.resource.StreamingRequestResolution(resolution);
+						}
+					}
+				}
+
 				if (vis.flags & Visibility::ALLOW_OCCLUSION_CULLING)
 				{
 					if (object.IsRenderable() && object.occlusionQueries[vis.scene->queryheap_idx] < 0)
@@ -3976,19 +3998,45 @@ void UpdateRenderData(
 		clear_indirect.start_instance_location = 0;
 		device->UpdateBuffer(&vis.scene->impostorIndirectBuffer, &clear_indirect, cmd, sizeof(clear_indirect), 0);
 		barrier_stack.push_back(GPUBarrier::Buffer(&vis.scene->impostorIndirectBuffer, ResourceState::COPY_DST, ResourceState::UNORDERED_ACCESS));
+
+		// The candidates that were selected on the CPU are only uploaded when the selection changed, every impostor type is a contiguous range:
+		const wi::ImpostorLOD& impostorLOD = vis.scene->impostorLOD;
+		const uint32_t candidate_count = impostorLOD.GetSelectedCount();
+		if (vis.scene->impostorCandidateVersion != impostorLOD.version && vis.scene->impostorCandidateBuffer.IsValid())
+		{
+			vis.scene->impostorCandidateVersion = impostorLOD.version;
+			uint64_t offset = 0;
+			for (const wi::ImpostorLOD::Batch& batch : impostorLOD.batches)
+			{
+				if (batch.ids.empty())
+					continue;
+				const uint64_t size = batch.ids.size() * sizeof(uint32_t);
+				device->UpdateBuffer(&vis.scene->impostorCandidateBuffer, batch.ids.data(), cmd, size, offset);
+				offset += size;
+			}
+			barrier_stack.push_back(GPUBarrier::Buffer(&vis.scene->impostorCandidateBuffer, ResourceState::COPY_DST, ResourceState::SHADER_RESOURCE));
+		}
+
 		barrier_stack.push_back(GPUBarrier::Buffer(&vis.scene->impostorBuffer, ResourceState::SHADER_RESOURCE, ResourceState::UNORDERED_ACCESS));
 		barrier_stack_flush(cmd);
 
-		device->BindComputeShader(&shaders[CSTYPE_IMPOSTOR_PREPARE], cmd);
-		device->BindUAV(&vis.scene->impostorBuffer, 0, cmd, vis.scene->impostor_ib.subresource_uav);
-		device->BindUAV(&vis.scene->impostorBuffer, 1, cmd, vis.scene->impostor_vb.subresource_uav);
-		device->BindUAV(&vis.scene->impostorBuffer, 2, cmd, vis.scene->impostor_data.subresource_uav);
-		device->BindUAV(&vis.scene->impostorIndirectBuffer, 3, cmd);
+		if (candidate_count > 0 && vis.scene->impostorArray.IsValid())
+		{
+			device->BindComputeShader(&shaders[CSTYPE_IMPOSTOR_PREPARE], cmd);
+			device->BindResource(&vis.scene->impostorCandidateBuffer, 0, cmd);
+			device->BindUAV(&vis.scene->impostorBuffer, 0, cmd, vis.scene->impostor_ib.subresource_uav);
+			device->BindUAV(&vis.scene->impostorBuffer, 1, cmd, vis.scene->impostor_vb.subresource_uav);
+			device->BindUAV(&vis.scene->impostorBuffer, 2, cmd, vis.scene->impostor_data.subresource_uav);
+			device->BindUAV(&vis.scene->impostorIndirectBuffer, 3, cmd);
 
-		uint object_count = (uint)vis.scene->objects.GetCount();
-		device->PushConstants(&object_count, sizeof(object_count), cmd);
+			ImpostorPreparePush push = {};
+			push.instance_count = candidate_count;
+			push.atlas_resolution_rcp.x = 1.0f / vis.scene->impostorArray.desc.width;
+			push.atlas_resolution_rcp.y = 1.0f / vis.scene->impostorArray.desc.height;
+			device->PushConstants(&push, sizeof(push), cmd);
 
-		device->Dispatch((object_count + 63u) / 64u, 1, 1, cmd);
+			device->Dispatch((candidate_count + 63u) / 64u, 1, 1, cmd);
+		}
 
 		barrier_stack.push_back(GPUBarrier::Buffer(&vis.scene->impostorBuffer, ResourceState::UNORDERED_ACCESS, ResourceState::SHADER_RESOURCE));
 		barrier_stack.push_back(GPUBarrier::Buffer(&vis.scene->impostorIndirectBuffer,ResourceState::UNORDERED_ACCESS, ResourceState::INDIRECT_ARGUMENT));
@@ -6978,25 +7026,32 @@ void RefreshImpostors(const Scene& scene, CommandList cmd)
 	if (!scene.impostorArray.IsValid())
 		return;
 
+	// The whole atlas is cleared by the render pass, so all impostors are rendered if any of them needs it:
+	bool render_dirty = false;
+	for (uint32_t impostorIndex = 0; impostorIndex < scene.impostors.GetCount(); ++impostorIndex)
+	{
+		render_dirty |= scene.impostors[impostorIndex].render_dirty;
+	}
+	if (!render_dirty)
+		return;
+
 	device->EventBegin("Impostor Refresh", cmd);
 
 	device->BindPipelineState(&PSO_captureimpostor, cmd);
 
-	Viewport viewport;
-	viewport.width = viewport.height = (float)scene.impostorTextureDim;
-	device->BindViewports(1, &viewport, cmd);
-
 	BindCommonResources(cmd);
 
 	barrier_stack.push_back(GPUBarrier::Image(&scene.impostorArray, ResourceState::SHADER_RESOURCE, ResourceState::RENDERTARGET));
 	barrier_stack_flush(cmd);
 
+	device->RenderPassBegin(&scene.renderpass_impostor, cmd);
+
 	for (uint32_t impostorIndex = 0; impostorIndex < scene.impostors.GetCount(); ++impostorIndex)
 	{
 		const ImpostorComponent& impostor = scene.impostors[impostorIndex];
-		if (!impostor.render_dirty)
-			continue;
 		impostor.render_dirty = false;
+		if (impostor.atlas_rect.w <= 0)
+			continue;
 
 		Entity entity = scene.impostors.GetEntity(impostorIndex);
 		const MeshComponent& mesh = *scene.meshes.GetComponent(entity);
@@ -7006,6 +7061,8 @@ void RefreshImpostors(const Scene& scene, CommandList cmd)
 
 		device->BindIndexBuffer(&mesh.generalBuffer, mesh.GetIndexFormat(), mesh.ib.offset, cmd);
 
+		const float cell_size = float(uint32_t(impostor.atlas_rect.w) / impostorCaptureGrid * IMPOSTOR_ATLAS_GRANULARITY);
+
 		for (size_t i = 0; i < impostorCaptureAngles; ++i)
 		{
 			CameraComponent impostorcamera;
@@ -7026,8 +7083,13 @@ void RefreshImpostors(const Scene& scene, CommandList cmd)
 
 			BindCameraCB(impostorcamera, impostorcamera, impostorcamera, cmd);
 
-			int slice = (int)(impostor.textureIndex * impostorCaptureAngles + i);
-			device->RenderPassBegin(&scene.renderpasses_impostor[slice], cmd);
+			// Every capture angle is rendered into its own cell of the impostor's atlas region:
+			Viewport viewport;
+			viewport.top_left_x = float(impostor.atlas_rect.x * IMPOSTOR_ATLAS_GRANULARITY) + float(i % impostorCaptureGrid) * cell_size;
+			viewport.top_left_y = float(impostor.atlas_rect.y * IMPOSTOR_ATLAS_GRANULARITY) + float(i / impostorCaptureGrid) * cell_size;
+			viewport.width = cell_size;
+			viewport.height = cell_size;
+			device->BindViewports(1, &viewport, cmd);
 
 			uint32_t first_subset = 0;
 			uint32_t last_subset = 0;
@@ -7049,12 +7111,12 @@ void RefreshImpostors(const Scene& scene, CommandList cmd)
 
 				device->DrawIndexedInstanced(subset.indexCount, 1, subset.indexOffset, 0, 0, cmd);
 			}
-
-			device->RenderPassEnd(cmd);
 		}
 
 	}
 
+	device->RenderPassEnd(cmd);
+
 	barrier_stack.push_back(GPUBarrier::Image(&scene.impostorArray, ResourceState::RENDERTARGET, ResourceState::SHADER_RESOURCE));
 	barrier_stack_flush(cmd);
 
@@ -4,6 +4,8 @@
 #include "wiTextureHelper.h"
 #include "wiUnorderedMap.h"
 #include "wiBacklog.h"
+#include "wiEventHandler.h"
+#include "wiPackage.h"
 
 #include "Utility/stb_image.h"
 #include "Utility/qoi.h"
@@ -13,11 +15,28 @@ extern basist::etc1_global_selector_codebook g_basis_global_codebook;
 
 #include <algorithm>
 #include <mutex>
+#include <shared_mutex>
+#include <list>
 
 using namespace wi::graphics;
 
 namespace wi
 {
+	struct StreamingTexture
+	{
+		std::string filename;
+		TextureDesc desc; // full resolution texture description
+		wi::vector<size_t> mip_offsets; // file offset of every mip level, and the end offset of the last one
+		uint32_t resident_mips = 0; // number of lowest resolution mips in the current texture
+		std::atomic<uint32_t> requested_resolution{ 0 };
+		uint32_t resolution = 0;
+		float request_age = 0;
+
+		// Result of background streaming, will be applied by UpdateStreamingResources():
+		wi::graphics::Texture streamed_texture;
+		uint32_t streamed_mips = 0;
+	};
+
 	struct ResourceInternal
 	{
 		resourcemanager::Flags flags = resourcemanager::Flags::NONE;
@@ -25,6 +44,9 @@ namespace wi
 		wi::audio::Sound sound;
 		std::string script;
 		wi::vector<uint8_t> filedata;
+		size_t cpu_size = 0;
+		size_t gpu_size = 0;
+		std::unique_ptr<StreamingTexture> streaming;
 	};
 
 	const wi::vector<uint8_t>& Resource::GetFileData() const
@@ -94,12 +116,189 @@ namespace wi
 		resourceinternal->script = script;
 	}
 
+	void Resource::StreamingRequestResolution(uint32_t resolution) const
+	{
+		const ResourceInternal* resourceinternal = (ResourceInternal*)internal_state.get();
+		if (resourceinternal == nullptr || resourceinternal->streaming == nullptr)
+			return;
+		std::atomic<uint32_t>& requested = resourceinternal->streaming->requested_resolution;
+		uint32_t prev = requested.load();
+		while (prev < resolution && !requested.compare_exchange_weak(prev, resolution));
+	}
+
 	namespace resourcemanager
 	{
-		static std::mutex locker;
+		static std::shared_mutex locker; // cache lookups are shared, modifications are exclusive
 		static wi::unordered_map<std::string, std::weak_ptr<ResourceInternal>> resources;
 		static Mode mode = Mode::DISCARD_FILEDATA_AFTER_LOAD;
 
+		struct LoadFutureInternal
+		{
+			std::string name;
+			Flags flags = Flags::NONE;
+			Resource resource;
+			wi::jobsystem::context ctx; // busy while the load is in flight
+
+			std::mutex callback_locker;
+			bool finished = false;
+			wi::vector<std::function<void(Resource)>> callbacks;
+		};
+		static wi::unordered_map<std::string, std::shared_ptr<LoadFutureInternal>> inflight; // protected by locker
+
+		static std::mutex streaming_locker;
+		static wi::vector<std::weak_ptr<ResourceInternal>> streaming_resources;
+		static wi::jobsystem::context streaming_ctx;
+		static std::atomic<size_t> streaming_budget{ 0 };
+		static std::atomic<size_t> streaming_usage{ 0 };
+		static std::atomic<uint32_t> streaming_base_mips{ 6 };
+		struct MountedPackage
+		{
+			wi::package::Package package;
+			std::string mount_point;
+		};
+		static std::shared_mutex packages_locker;
+		static wi::vector<MountedPackage> packages;
+
+		static constexpr float streaming_request_timeout = 2; // seconds until an unrequested texture drops its higher resolution mips
+
+		// The resource manager gives out handles that share the resource core, the core is released to the cache when the last handle is destroyed
+		//	Only unreferenced resources are in the cache, so every entry can be evicted and only those count toward the budget
+		struct CacheEntry
+		{
+			std::string name;
+			std::shared_ptr<ResourceInternal> resource;
+		};
+		static std::mutex cache_locker;
+		static std::list<CacheEntry> cache_lru; // front is the most recently released
+		static wi::unordered_map<std::string, std::list<CacheEntry>::iterator> cache_lookup;
+		static size_t cache_cpu_budget = 0;
+		static size_t cache_gpu_budget = 0;
+		static size_t cache_cpu_usage = 0; // usage of the unreferenced resources in the cache
+		static size_t cache_gpu_usage = 0;
+		static std::atomic_bool cache_enabled{ false };
+		static std::atomic<uint64_t> cache_generation{ 0 }; // incremented by Clear(), handles from before that are not cached when released
+		static std::atomic<uint64_t> cache_hits{ 0 };
+		static std::atomic<uint64_t> cache_misses{ 0 };
+		static std::atomic<uint64_t> cache_evictions{ 0 };
+
+		// Evicts the least recently released resources, until the budget is satisfied
+		//	cache_locker must be locked by the caller
+		static void CacheEvict()
+		{
+			auto over_budget = []() {
+				return
+					(cache_cpu_budget > 0 && cache_cpu_usage > cache_cpu_budget) ||
+					(cache_gpu_budget > 0 && cache_gpu_usage > cache_gpu_budget);
+			};
+			while (over_budget() && !cache_lru.empty())
+			{
+				CacheEntry& entry = cache_lru.back();
+				cache_cpu_usage -= entry.resource->cpu_size;
+				cache_gpu_usage -= entry.resource->gpu_size;
+				cache_lookup.erase(entry.name);
+				cache_lru.pop_back();
+				cache_evictions.fetch_add(1);
+			}
+		}
+		// Removes the entry from the cache
+		//	cache_locker must be locked by the caller
+		static void CacheRemove(std::list<CacheEntry>::iterator it)
+		{
+			cache_cpu_usage -= it->resource->cpu_size;
+			cache_gpu_usage -= it->resource->gpu_size;
+			cache_lookup.erase(it->name);
+			cache_lru.erase(it);
+		}
+		// Called when the last handle of a resource was destroyed
+		//	This must not be called while cache_locker is locked, so handles must not be released while holding it
+		static void CacheRelease(std::string name, std::shared_ptr<ResourceInternal> resource, uint64_t generation)
+		{
+			if (generation != cache_generation.load())
+			{
+				return;
+			}
+			std::scoped_lock lock(cache_locker);
+			if (!cache_enabled.load())
+			{
+				return;
+			}
+			auto it = cache_lookup.find(name);
+			if (it != cache_lookup.end())
+			{
+				CacheRemove(it->second); // an older resource with the same name, it was reloaded since
+			}
+			cache_cpu_usage += resource->cpu_size;
+			cache_gpu_usage += resource->gpu_size;
+			cache_lru.push_front({ std::move(name), std::move(resource) });
+			cache_lookup[cache_lru.front().name] = cache_lru.begin();
+			CacheEvict();
+		}
+		// Takes the resource out of the cache if it's there, because it will be referenced again
+		static std::shared_ptr<ResourceInternal> CacheRevive(const std::string& name)
+		{
+			std::shared_ptr<ResourceInternal> resource;
+			if (!cache_enabled.load())
+			{
+				return resource;
+			}
+			std::scoped_lock lock(cache_locker);
+			auto it = cache_lookup.find(name);
+			if (it != cache_lookup.end())
+			{
+				resource = it->second->resource;
+				CacheRemove(it->second);
+			}
+			return resource;
+		}
+		static void CacheClear()
+		{
+			std::list<CacheEntry> evicted; // destroyed after the lock is released
+			std::scoped_lock lock(cache_locker);
+			evicted.swap(cache_lru);
+			cache_lookup.clear();
+			cache_cpu_usage = 0;
+			cache_gpu_usage = 0;
+		}
+
+		// The handle references the core resource, and releases it to the cache when the handle is no longer referenced:
+		struct HandleDeleter
+		{
+			std::string name;
+			std::shared_ptr<ResourceInternal> resource;
+			uint64_t generation = 0;
+			void operator()(ResourceInternal*)
+			{
+				// The deleter itself is kept alive by the weak references in the resources map, so the core is moved out:
+				CacheRelease(std::move(name), std::move(resource), generation);
+			}
+		};
+		static std::shared_ptr<ResourceInternal> CreateHandle(const std::string& name, const std::shared_ptr<ResourceInternal>& resource)
+		{
+			return std::shared_ptr<ResourceInternal>(resource.get(), HandleDeleter{ name, resource, cache_generation.load() });
+		}
+
+		// Completion callbacks of async loads are deferred to the thread safe point:
+		static std::mutex deferred_locker;
+		static wi::vector<std::pair<std::function<void(Resource)>, Resource>> deferred_callbacks;
+		static wi::eventhandler::Handle deferred_handle;
+		static std::once_flag deferred_init;
+
+		bool LoadFuture::IsReady() const
+		{
+			if (!IsValid())
+				return true;
+			const LoadFutureInternal* future = (LoadFutureInternal*)internal_state.get();
+			return !wi::jobsystem::IsBusy(future->ctx);
+		}
+		Resource LoadFuture::Get() const
+		{
+			if (!IsValid())
+				return Resource();
+			const LoadFutureInternal* future = (LoadFutureInternal*)internal_state.get();
+			wi::jobsystem::Wait(future->ctx);
+			return future->resource;
+		}
+
 		void SetMode(Mode param)
 		{
 			mode = param;
@@ -166,44 +365,436 @@ namespace wi
 			return ret;
 		}
 
-		Resource Load(const std::string& name, Flags flags, const uint8_t* filedata, size_t filesize)
+		static Format ConvertDDSFormat(tinyddsloader::DDSFile::DXGIFormat format)
 		{
-			if (mode == Mode::DISCARD_FILEDATA_AFTER_LOAD)
+			switch (format)
 			{
-				flags &= ~Flags::IMPORT_RETAIN_FILEDATA;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_Float: return Format::R32G32B32A32_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_UInt: return Format::R32G32B32A32_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_SInt: return Format::R32G32B32A32_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_Float: return Format::R32G32B32_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_UInt: return Format::R32G32B32_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_SInt: return Format::R32G32B32_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_Float: return Format::R16G16B16A16_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_UNorm: return Format::R16G16B16A16_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_UInt: return Format::R16G16B16A16_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_SNorm: return Format::R16G16B16A16_SNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_SInt: return Format::R16G16B16A16_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32_Float: return Format::R32G32_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32_UInt: return Format::R32G32_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32G32_SInt: return Format::R32G32_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R10G10B10A2_UNorm: return Format::R10G10B10A2_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R10G10B10A2_UInt: return Format::R10G10B10A2_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R11G11B10_Float: return Format::R11G11B10_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::B8G8R8X8_UNorm: return Format::B8G8R8A8_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm: return Format::B8G8R8A8_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm_SRGB: return Format::B8G8R8A8_UNORM_SRGB;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm: return Format::R8G8B8A8_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm_SRGB: return Format::R8G8B8A8_UNORM_SRGB;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UInt: return Format::R8G8B8A8_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SNorm: return Format::R8G8B8A8_SNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SInt: return Format::R8G8B8A8_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16_Float: return Format::R16G16_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16_UNorm: return Format::R16G16_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16_UInt: return Format::R16G16_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16_SNorm: return Format::R16G16_SNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R16G16_SInt: return Format::R16G16_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::D32_Float: return Format::D32_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32_Float: return Format::R32_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32_UInt: return Format::R32_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R32_SInt: return Format::R32_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8_UNorm: return Format::R8G8_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8_UInt: return Format::R8G8_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8_SNorm: return Format::R8G8_SNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R8G8_SInt: return Format::R8G8_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R16_Float: return Format::R16_FLOAT;
+			case tinyddsloader::DDSFile::DXGIFormat::D16_UNorm: return Format::D16_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R16_UNorm: return Format::R16_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R16_UInt: return Format::R16_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R16_SNorm: return Format::R16_SNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R16_SInt: return Format::R16_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R8_UNorm: return Format::R8_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R8_UInt: return Format::R8_UINT;
+			case tinyddsloader::DDSFile::DXGIFormat::R8_SNorm: return Format::R8_SNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::R8_SInt: return Format::R8_SINT;
+			case tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm: return Format::BC1_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm_SRGB: return Format::BC1_UNORM_SRGB;
+			case tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm: return Format::BC2_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm_SRGB: return Format::BC2_UNORM_SRGB;
+			case tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm: return Format::BC3_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm_SRGB: return Format::BC3_UNORM_SRGB;
+			case tinyddsloader::DDSFile::DXGIFormat::BC4_UNorm: return Format::BC4_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::BC4_SNorm: return Format::BC4_SNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::BC5_UNorm: return Format::BC5_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::BC5_SNorm: return Format::BC5_SNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm: return Format::BC7_UNORM;
+			case tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm_SRGB: return Format::BC7_UNORM_SRGB;
+			default:
+				break;
 			}
+			return Format::UNKNOWN;
+		}
 
-			locker.lock();
-			std::weak_ptr<ResourceInternal>& weak_resource = resources[name];
-			std::shared_ptr<ResourceInternal> resource = weak_resource.lock();
+		struct BasisTarget
+		{
+			basist::transcoder_texture_format fmt;
+			Format format;
+		};
+		// Returns the format that basis universal textures are transcoded to
+		//	Block compressed formats are required by every graphics device implementation, so the selection only depends on alpha
+		static const BasisTarget& GetBasisTarget(bool alpha)
+		{
+			static const BasisTarget targets[] = {
+				{ basist::transcoder_texture_format::cTFBC1_RGB, Format::BC1_UNORM },
+				{ basist::transcoder_texture_format::cTFBC3_RGBA, Format::BC3_UNORM },
+			};
+			return targets[alpha ? 1 : 0];
+		}
+		// A single subresource (mip level of a layer/face) to transcode
+		struct TranscodeJob
+		{
+			uint32_t level = 0;
+			uint32_t layer = 0;
+			uint32_t face = 0;
+			uint32_t total_blocks = 0;
+			size_t offset = 0; // offset in the combined transcoder destination allocation
+			uint32_t row_pitch = 0;
+			uint32_t slice_pitch = 0;
+		};
 
-			static bool basis_init = false; // within lock!
-			if (!basis_init)
+		// Finds a resource in the mounted packages
+		//	package : the package that contains the resource
+		//	package_name : the name of the resource inside the package
+		static bool FindInPackages(const std::string& name, wi::package::Package& package, std::string& package_name)
+		{
+			std::shared_lock lock(packages_locker);
+			if (packages.empty())
 			{
-				basis_init = true;
-				basist::basisu_transcoder_init();
+				return false;
 			}
+			const std::string normalized = wi::package::NormalizeName(name);
+			for (auto it = packages.rbegin(); it != packages.rend(); ++it)
+			{
+				if (normalized.compare(0, it->mount_point.size(), it->mount_point) != 0)
+					continue;
+				std::string candidate = normalized.substr(it->mount_point.size());
+				if (it->package.Contains(candidate))
+				{
+					package = it->package;
+					package_name = std::move(candidate);
+					return true;
+				}
+			}
+			return false;
+		}
 
-			if (resource == nullptr)
+		static size_t ComputeMipSize(const TextureDesc& desc, uint32_t mip)
+		{
+			TextureDesc mipdesc = desc;
+			mipdesc.width = std::max(1u, desc.width >> mip);
+			mipdesc.height = std::max(1u, desc.height >> mip);
+			mipdesc.depth = 1;
+			mipdesc.array_size = 1;
+			mipdesc.mip_levels = 1;
+			return (size_t)ComputeTextureMemorySizeInBytes(mipdesc);
+		}
+
+		// Reads the lowest resolution mips of a streaming texture from its file and creates a texture from them
+		//	Only the byte range of the requested mips is read from file
+		static bool CreateStreamingTexture(const StreamingTexture& streaming, uint32_t mip_count, Texture& texture)
+		{
+			const uint32_t first_mip = streaming.desc.mip_levels - mip_count;
+			const size_t begin = streaming.mip_offsets[first_mip];
+			const size_t end = streaming.mip_offsets.back();
+			wi::vector<uint8_t> data;
+			if (!wi::helper::FileRead(streaming.filename, data, end - begin, begin) || data.size() != end - begin)
 			{
-				resource = std::make_shared<ResourceInternal>();
-				resources[name] = resource;
-				locker.unlock();
+				return false;
+			}
+
+			TextureDesc desc = streaming.desc;
+			desc.width = std::max(1u, desc.width >> first_mip);
+			desc.height = std::max(1u, desc.height >> first_mip);
+			desc.mip_levels = mip_count;
+
+			const uint32_t bytes_per_block = GetFormatStride(desc.format);
+			const uint32_t pixels_per_block = GetFormatBlockSize(desc.format);
+			wi::vector<SubresourceData> InitData(mip_count);
+			for (uint32_t i = 0; i < mip_count; ++i)
+			{
+				const uint32_t mip = first_mip + i;
+				const uint32_t num_blocks_x = (std::max(1u, streaming.desc.width >> mip) + pixels_per_block - 1) / pixels_per_block;
+				const uint32_t num_blocks_y = (std::max(1u, streaming.desc.height >> mip) + pixels_per_block - 1) / pixels_per_block;
+				InitData[i].data_ptr = data.data() + streaming.mip_offsets[mip] - begin;
+				InitData[i].row_pitch = num_blocks_x * bytes_per_block;
+				InitData[i].slice_pitch = InitData[i].row_pitch * num_blocks_y;
+			}
+
+			if (IsFormatBlockCompressed(desc.format))
+			{
+				desc.width = std::max(GetFormatBlockSize(desc.format), desc.width);
+				desc.height = std::max(GetFormatBlockSize(desc.format), desc.height);
+			}
+
+			GraphicsDevice* device = wi::graphics::GetDevice();
+			bool success = device->CreateTexture(&desc, InitData.data(), &texture);
+			device->SetName(&texture, streaming.filename.c_str());
+			return success;
+		}
+
+		// Loads a DDS texture as streaming texture, by only reading its header and lowest resolution mips
+		//	Returns false if the texture is not suitable for streaming
+		static bool LoadStreamingDDS(ResourceInternal* resource, const std::string& name)
+		{
+			using tinyddsloader::DDSFile;
+
+			wi::vector<uint8_t> header_data;
+			if (!wi::helper::FileRead(name, header_data, sizeof(uint32_t) + sizeof(DDSFile::Header) + sizeof(DDSFile::HeaderDXT10)))
+			{
+				return false;
+			}
+			if (header_data.size() < sizeof(uint32_t) + sizeof(DDSFile::Header) || std::memcmp(header_data.data(), DDSFile::Magic, sizeof(DDSFile::Magic)) != 0)
+			{
+				return false;
+			}
+			const DDSFile::Header* header = (const DDSFile::Header*)(header_data.data() + sizeof(uint32_t));
+			if (header->m_size != sizeof(DDSFile::Header) || header->m_pixelFormat.m_size != sizeof(DDSFile::PixelFormat))
+			{
+				return false;
+			}
+
+			size_t offset = sizeof(uint32_t) + sizeof(DDSFile::Header);
+			DDSFile::DXGIFormat format;
+			if ((header->m_pixelFormat.m_flags & uint32_t(DDSFile::PixelFormatFlagBits::FourCC)) &&
+				DDSFile::MakeFourCC('D', 'X', '1', '0') == header->m_pixelFormat.m_fourCC)
+			{
+				if (header_data.size() < offset + sizeof(DDSFile::HeaderDXT10))
+				{
+					return false;
+				}
+				const DDSFile::HeaderDXT10* header_dxt10 = (const DDSFile::HeaderDXT10*)(header_data.data() + offset);
+				if (header_dxt10->m_resourceDimension != DDSFile::TextureDimension::Texture2D ||
+					header_dxt10->m_arraySize != 1 ||
+					(header_dxt10->m_miscFlag & uint32_t(DDSFile::DXT10MiscFlagBits::TextureCube)))
+				{
+					return false;
+				}
+				format = header_dxt10->m_format;
+				offset += sizeof(DDSFile::HeaderDXT10);
 			}
 			else
 			{
-				locker.unlock();
-				Resource retVal;
-				retVal.internal_state = resource;
-				return retVal;
+				if ((header->m_flags & uint32_t(DDSFile::HeaderFlagBits::Volume)) ||
+					(header->m_caps2 & uint32_t(DDSFile::HeaderCaps2FlagBits::CubemapAllFaces)))
+				{
+					return false;
+				}
+				format = DDSFile::GetDXGIFormat(header->m_pixelFormat);
+			}
+
+			auto streaming = std::make_unique<StreamingTexture>();
+			streaming->filename = name;
+			TextureDesc& desc = streaming->desc;
+			desc.format = ConvertDDSFormat(format);
+			desc.width = header->m_width;
+			desc.height = header->m_height;
+			desc.mip_levels = std::max(1u, header->m_mipMapCount);
+			desc.bind_flags = BindFlag::SHADER_RESOURCE;
+			desc.layout = ResourceState::SHADER_RESOURCE;
+			const uint32_t base_mips = std::max(1u, streaming_base_mips.load());
+			if (desc.format == Format::UNKNOWN || desc.mip_levels <= base_mips)
+			{
+				return false; // not supported or nothing to stream
+			}
+
+			streaming->mip_offsets.resize(desc.mip_levels + 1);
+			for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
+			{
+				streaming->mip_offsets[mip] = offset;
+				offset += ComputeMipSize(desc, mip);
+			}
+			streaming->mip_offsets.back() = offset;
+
+			if (!CreateStreamingTexture(*streaming, base_mips, resource->texture))
+			{
+				return false;
+			}
+			streaming->resident_mips = base_mips;
+			resource->streaming = std::move(streaming);
+			return true;
+		}
+
+		static void DeferCallback(const std::function<void(Resource)>& callback, const Resource& resource)
+		{
+			std::call_once(deferred_init, [] {
+				deferred_handle = wi::eventhandler::Subscribe(wi::eventhandler::EVENT_THREAD_SAFE_POINT, [](uint64_t userdata) {
+					wi::vector<std::pair<std::function<void(Resource)>, Resource>> callbacks;
+					deferred_locker.lock();
+					std::swap(callbacks, deferred_callbacks);
+					deferred_locker.unlock();
+					for (auto& x : callbacks)
+					{
+						x.first(x.second);
+					}
+				});
+			});
+
+			deferred_locker.lock();
+			deferred_callbacks.push_back(std::make_pair(callback, resource));
+			deferred_locker.unlock();
+		}
+
+		static void MakeFinishedFuture(const std::string& name, std::shared_ptr<ResourceInternal> resource, std::shared_ptr<LoadFutureInternal>& future)
+		{
+			future = std::make_shared<LoadFutureInternal>();
+			future->name = name;
+			future->flags = resource->flags;
+			future->resource.internal_state = std::move(resource);
+			future->finished = true;
+		}
+
+		// Looks up the resource in the referenced resources, the in-flight loads and the cache
+		//	Returns true if the caller is responsible to perform the load and call FinishLoad() after
+		static bool BeginLoad(const std::string& name, Flags flags, std::shared_ptr<LoadFutureInternal>& future)
+		{
+			auto lookup = [&]() {
+				auto it = resources.find(name);
+				if (it != resources.end())
+				{
+					std::shared_ptr<ResourceInternal> resource = it->second.lock();
+					if (resource != nullptr)
+					{
+						cache_hits.fetch_add(1);
+						MakeFinishedFuture(name, std::move(resource), future);
+						return true;
+					}
+				}
+				auto it_inflight = inflight.find(name);
+				if (it_inflight != inflight.end())
+				{
+					cache_hits.fetch_add(1);
+					future = it_inflight->second;
+					return true;
+				}
+				return false;
+			};
+
+			// Most of the time the resource will be found, so first only take shared lock:
+			{
+				std::shared_lock lock(locker);
+				if (lookup())
+				{
+					return false;
+				}
+			}
+
+			std::unique_lock lock(locker);
+			if (lookup()) // it could have been started by an other thread since the shared lock was released
+			{
+				return false;
+			}
+			std::shared_ptr<ResourceInternal> cached = CacheRevive(name);
+			if (cached != nullptr)
+			{
+				std::shared_ptr<ResourceInternal> resource = CreateHandle(name, cached);
+				resources[name] = resource;
+				cache_hits.fetch_add(1);
+				MakeFinishedFuture(name, std::move(resource), future);
+				return false;
+			}
+			future = std::make_shared<LoadFutureInternal>();
+			future->name = name;
+			future->flags = flags;
+			future->ctx.counter.fetch_add(1); // will be released by FinishLoad()
+			inflight[name] = future;
+			cache_misses.fetch_add(1);
+			return true;
+		}
+
+		// Publishes the result of a load started by BeginLoad() and schedules its completion callbacks
+		static void FinishLoad(LoadFutureInternal& future, std::shared_ptr<ResourceInternal> resource)
+		{
+			std::shared_ptr<ResourceInternal> handle;
+			if (resource != nullptr)
+			{
+				handle = CreateHandle(future.name, resource);
+				future.resource.internal_state = handle;
+			}
+
+			locker.lock();
+			if (handle != nullptr)
+			{
+				resources[future.name] = handle;
+			}
+			inflight.erase(future.name);
+			locker.unlock();
+
+			if (resource != nullptr && resource->streaming != nullptr)
+			{
+				streaming_locker.lock();
+				streaming_resources.push_back(resource);
+				streaming_locker.unlock();
+			}
+
+			future.callback_locker.lock();
+			future.finished = true;
+			for (auto& callback : future.callbacks)
+			{
+				DeferCallback(callback, future.resource);
+			}
+			future.callbacks.clear();
+			future.callback_locker.unlock();
+
+			future.ctx.counter.fetch_sub(1);
+		}
+
+		// Reads and decodes file data and creates the resource. This can be called from any thread
+		static bool LoadInternal(ResourceInternal* resource, const std::string& name, Flags flags, const uint8_t* filedata, size_t filesize)
+		{
+			static bool basis_init = [] {
+				basist::basisu_transcoder_init();
+				return true;
+			}();
+			(void)basis_init;
+
+			wi::package::Package package; // keeps the memory mapped package alive while loading
+			if (filedata == nullptr || filesize == 0)
+			{
+				std::string package_name;
+				if (FindInPackages(name, package, package_name))
+				{
+					filedata = package.GetData(package_name, &filesize);
+					if (filedata == nullptr)
+					{
+						// compressed data:
+						if (!package.Read(package_name, resource->filedata))
+						{
+							return false;
+						}
+						filedata = resource->filedata.data();
+						filesize = resource->filedata.size();
+					}
+				}
+			}
+
+			if (has_flag(flags, Flags::STREAMING) &&
+				(filedata == nullptr || filesize == 0) &&
+				IsStreamingEnabled() &&
+				!wi::helper::toUpper(wi::helper::GetExtensionFromFileName(name)).compare("DDS") &&
+				LoadStreamingDDS(resource, name))
+			{
+				// Streaming texture was created without reading the whole file
+				//	The file data is not kept in memory even with IMPORT_RETAIN_FILEDATA, but the flag is kept so that Serialize() can read it from the file
+				resource->flags = flags;
+				resource->gpu_size = (size_t)ComputeTextureMemorySizeInBytes(resource->texture.desc);
+				return true;
 			}
 
 			if (filedata == nullptr || filesize == 0)
 			{
 				if (!wi::helper::FileRead(name, resource->filedata))
 				{
-					resource.reset();
-					return Resource();
+					return false;
 				}
 				filedata = resource->filedata.data();
 				filesize = resource->filedata.size();
@@ -221,7 +812,7 @@ namespace wi
 				}
 				else
 				{
-					return Resource();
+					return false;
 				}
 			}
 
@@ -248,89 +839,91 @@ namespace wi
 							desc.misc_flags = ResourceMiscFlag::TEXTURECUBE;
 						}
 
-						basist::transcoder_texture_format fmt;
-						if (transcoder.get_has_alpha())
-						{
-							fmt = basist::transcoder_texture_format::cTFBC3_RGBA;
-							desc.format = Format::BC3_UNORM;
-						}
-						else
-						{
-							fmt = basist::transcoder_texture_format::cTFBC1_RGB;
-							desc.format = Format::BC1_UNORM;
-						}
-						uint32_t bytes_per_block = basis_get_bytes_per_block_or_pixel(fmt);
+						const BasisTarget& target = GetBasisTarget(transcoder.get_has_alpha());
+						desc.format = target.format;
+						const uint32_t bytes_per_block = basis_get_bytes_per_block_or_pixel(target.fmt);
 
 						if (transcoder.start_transcoding())
 						{
 							// all subresources will use one allocation for transcoder destination, so compute combined size:
+							wi::vector<TranscodeJob> jobs;
 							size_t transcoded_data_size = 0;
+							bool valid = true;
 							const uint32_t layers = std::max(1u, transcoder.get_layers());
 							const uint32_t faces = transcoder.get_faces();
 							const uint32_t levels = transcoder.get_levels();
-							for (uint32_t layer = 0; layer < layers; ++layer)
+							jobs.reserve(layers * faces * levels);
+							for (uint32_t layer = 0; layer < layers && valid; ++layer)
 							{
-								for (uint32_t face = 0; face < faces; ++face)
+								for (uint32_t face = 0; face < faces && valid; ++face)
 								{
-									for (uint32_t mip = 0; mip < levels; ++mip)
+									for (uint32_t mip = 0; mip < levels && valid; ++mip)
 									{
 										basist::ktx2_image_level_info level_info;
 										if (transcoder.get_image_level_info(level_info, mip, layer, face))
 										{
+											TranscodeJob& job = jobs.emplace_back();
+											job.level = mip;
+											job.layer = layer;
+											job.face = face;
+											job.offset = transcoded_data_size;
+											job.total_blocks = level_info.m_total_blocks;
+											job.row_pitch = level_info.m_num_blocks_x * bytes_per_block;
+											job.slice_pitch = job.row_pitch * level_info.m_num_blocks_y;
 											transcoded_data_size += level_info.m_total_blocks * bytes_per_block;
 										}
-									}
-								}
-							}
-							wi::vector<uint8_t> transcoded_data(transcoded_data_size);
-
-							wi::vector<SubresourceData> InitData;
-							size_t transcoded_data_offset = 0;
-							for (uint32_t layer = 0; layer < layers; ++layer)
-							{
-								for (uint32_t face = 0; face < faces; ++face)
-								{
-									for (uint32_t mip = 0; mip < levels; ++mip)
-									{
-										basist::ktx2_image_level_info level_info;
-										if (transcoder.get_image_level_info(level_info, mip, layer, face))
-										{
-											void* data_ptr = transcoded_data.data() + transcoded_data_offset;
-											transcoded_data_offset += level_info.m_total_blocks * bytes_per_block;
-											if (transcoder.transcode_image_level(
-												mip,
-												layer,
-												face,
-												data_ptr,
-												level_info.m_total_blocks,
-												fmt
-											))
-											{
-												SubresourceData subresourceData;
-												subresourceData.data_ptr = data_ptr;
-												subresourceData.row_pitch = level_info.m_num_blocks_x * bytes_per_block;
-												subresourceData.slice_pitch = subresourceData.row_pitch * level_info.m_num_blocks_y;
-												InitData.push_back(subresourceData);
-											}
-											else
-											{
-												wi::backlog::post("KTX2 transcoding error while loading image!", wi::backlog::LogLevel::Error);
-												assert(0);
-											}
-										}
 										else
 										{
 											wi::backlog::post("KTX2 transcoding error while loading image level info!", wi::backlog::LogLevel::Error);
-											assert(0);
+											valid = false;
 										}
 									}
 								}
 							}
 
-							if (!InitData.empty())
+							if (valid)
 							{
-								success = device->CreateTexture(&desc, InitData.data(), &resource->texture);
-								device->SetName(&resource->texture, name.c_str());
+								wi::vector<uint8_t> transcoded_data(transcoded_data_size);
+
+								// Every subresource is transcoded by a separate job, each with its own transcoder state:
+								std::atomic_bool transcode_success{ true };
+								wi::jobsystem::context ctx;
+								wi::jobsystem::Dispatch(ctx, (uint32_t)jobs.size(), 1, [&](wi::jobsystem::JobArgs args) {
+									const TranscodeJob& job = jobs[args.jobIndex];
+									basist::ktx2_transcoder_state state;
+									state.clear();
+									if (!transcoder.transcode_image_level(
+										job.level,
+										job.layer,
+										job.face,
+										transcoded_data.data() + job.offset,
+										job.total_blocks,
+										target.fmt,
+										0, 0, 0, -1, -1,
+										&state
+									))
+									{
+										transcode_success.store(false);
+									}
+								});
+								wi::jobsystem::Wait(ctx);
+
+								if (transcode_success.load())
+								{
+									wi::vector<SubresourceData> InitData(jobs.size());
+									for (size_t i = 0; i < jobs.size(); ++i)
+									{
+										InitData[i].data_ptr = transcoded_data.data() + jobs[i].offset;
+										InitData[i].row_pitch = jobs[i].row_pitch;
+										InitData[i].slice_pitch = jobs[i].slice_pitch;
+									}
+									success = device->CreateTexture(&desc, InitData.data(), &resource->texture);
+									device->SetName(&resource->texture, name.c_str());
+								}
+								else
+								{
+									wi::backlog::post("KTX2 transcoding error while loading image!", wi::backlog::LogLevel::Error);
+								}
 							}
 						}
 						transcoder.clear();
@@ -354,76 +947,81 @@ namespace wi
 								desc.height = info.m_height;
 								desc.mip_levels = info.m_total_levels;
 
-								basist::transcoder_texture_format fmt;
-								if (info.m_alpha_flag)
-								{
-									fmt = basist::transcoder_texture_format::cTFBC3_RGBA;
-									desc.format = Format::BC3_UNORM;
-								}
-								else
-								{
-									fmt = basist::transcoder_texture_format::cTFBC1_RGB;
-									desc.format = Format::BC1_UNORM;
-								}
-								uint32_t bytes_per_block = basis_get_bytes_per_block_or_pixel(fmt);
+								const BasisTarget& target = GetBasisTarget(info.m_alpha_flag);
+								desc.format = target.format;
+								const uint32_t bytes_per_block = basis_get_bytes_per_block_or_pixel(target.fmt);
 
 								if (transcoder.start_transcoding(filedata, (uint32_t)filesize))
 								{
 									// all subresources will use one allocation for transcoder destination, so compute combined size:
+									wi::vector<TranscodeJob> jobs;
 									size_t transcoded_data_size = 0;
-									for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
+									bool valid = true;
+									jobs.reserve(desc.mip_levels);
+									for (uint32_t mip = 0; mip < desc.mip_levels && valid; ++mip)
 									{
 										basist::basisu_image_level_info level_info;
 										if (transcoder.get_image_level_info(filedata, (uint32_t)filesize, level_info, image_index, mip))
 										{
+											TranscodeJob& job = jobs.emplace_back();
+											job.level = mip;
+											job.offset = transcoded_data_size;
+											job.total_blocks = level_info.m_total_blocks;
+											job.row_pitch = level_info.m_num_blocks_x * bytes_per_block;
+											job.slice_pitch = job.row_pitch * level_info.m_num_blocks_y;
 											transcoded_data_size += level_info.m_total_blocks * bytes_per_block;
 										}
+										else
+										{
+											wi::backlog::post("BASIS transcoding error while loading image level info!", wi::backlog::LogLevel::Error);
+											valid = false;
+										}
 									}
-									wi::vector<uint8_t> transcoded_data(transcoded_data_size);
 
-									wi::vector<SubresourceData> InitData;
-									size_t transcoded_data_offset = 0;
-									for (uint32_t mip = 0; mip < desc.mip_levels; ++mip)
+									if (valid)
 									{
-										basist::basisu_image_level_info level_info;
-										if (transcoder.get_image_level_info(filedata, (uint32_t)filesize, level_info, 0, mip))
-										{
-											void* data_ptr = transcoded_data.data() + transcoded_data_offset;
-											transcoded_data_offset += level_info.m_total_blocks * bytes_per_block;
-											if (transcoder.transcode_image_level(
+										wi::vector<uint8_t> transcoded_data(transcoded_data_size);
+
+										// Every mip level is transcoded by a separate job, each with its own transcoder state:
+										std::atomic_bool transcode_success{ true };
+										wi::jobsystem::context ctx;
+										wi::jobsystem::Dispatch(ctx, (uint32_t)jobs.size(), 1, [&](wi::jobsystem::JobArgs args) {
+											const TranscodeJob& job = jobs[args.jobIndex];
+											basist::basisu_transcoder_state state;
+											if (!transcoder.transcode_image_level(
 												filedata,
 												(uint32_t)filesize,
 												image_index,
-												mip,
-												data_ptr,
-												level_info.m_total_blocks,
-												fmt
+												job.level,
+												transcoded_data.data() + job.offset,
+												job.total_blocks,
+												target.fmt,
+												0, 0,
+												&state
 											))
 											{
-												SubresourceData subresourceData;
-												subresourceData.data_ptr = data_ptr;
-												subresourceData.row_pitch = level_info.m_num_blocks_x * bytes_per_block;
-												subresourceData.slice_pitch = subresourceData.row_pitch * level_info.m_num_blocks_y;
-												InitData.push_back(subresourceData);
+												transcode_success.store(false);
 											}
-											else
+										});
+										wi::jobsystem::Wait(ctx);
+
+										if (transcode_success.load())
+										{
+											wi::vector<SubresourceData> InitData(jobs.size());
+											for (size_t i = 0; i < jobs.size(); ++i)
 											{
-												wi::backlog::post("BASIS transcoding error while loading image!", wi::backlog::LogLevel::Error);
-												assert(0);
+												InitData[i].data_ptr = transcoded_data.data() + jobs[i].offset;
+												InitData[i].row_pitch = jobs[i].row_pitch;
+												InitData[i].slice_pitch = jobs[i].slice_pitch;
 											}
+											success = device->CreateTexture(&desc, InitData.data(), &resource->texture);
+											device->SetName(&resource->texture, name.c_str());
 										}
 										else
 										{
-											wi::backlog::post("BASIS transcoding error while loading image level info!", wi::backlog::LogLevel::Error);
-											assert(0);
+											wi::backlog::post("BASIS transcoding error while loading image!", wi::backlog::LogLevel::Error);
 										}
 									}
-
-									if (!InitData.empty())
-									{
-										success = device->CreateTexture(&desc, InitData.data(), &resource->texture);
-										device->SetName(&resource->texture, name.c_str());
-									}
 								}
 							}
 						}
@@ -454,73 +1052,14 @@ namespace wi
 							desc.misc_flags |= ResourceMiscFlag::TEXTURECUBE;
 						}
 
-						auto ddsFormat = dds.GetFormat();
-
-						switch (ddsFormat)
+						const Format format = ConvertDDSFormat(dds.GetFormat());
+						if (format != Format::UNKNOWN)
 						{
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_Float: desc.format = Format::R32G32B32A32_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_UInt: desc.format = Format::R32G32B32A32_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32B32A32_SInt: desc.format = Format::R32G32B32A32_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_Float: desc.format = Format::R32G32B32_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_UInt: desc.format = Format::R32G32B32_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32B32_SInt: desc.format = Format::R32G32B32_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_Float: desc.format = Format::R16G16B16A16_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_UNorm: desc.format = Format::R16G16B16A16_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_UInt: desc.format = Format::R16G16B16A16_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_SNorm: desc.format = Format::R16G16B16A16_SNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16B16A16_SInt: desc.format = Format::R16G16B16A16_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32_Float: desc.format = Format::R32G32_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32_UInt: desc.format = Format::R32G32_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32G32_SInt: desc.format = Format::R32G32_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R10G10B10A2_UNorm: desc.format = Format::R10G10B10A2_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R10G10B10A2_UInt: desc.format = Format::R10G10B10A2_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R11G11B10_Float: desc.format = Format::R11G11B10_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::B8G8R8X8_UNorm: desc.format = Format::B8G8R8A8_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm: desc.format = Format::B8G8R8A8_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::B8G8R8A8_UNorm_SRGB: desc.format = Format::B8G8R8A8_UNORM_SRGB; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm: desc.format = Format::R8G8B8A8_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UNorm_SRGB: desc.format = Format::R8G8B8A8_UNORM_SRGB; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_UInt: desc.format = Format::R8G8B8A8_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SNorm: desc.format = Format::R8G8B8A8_SNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8B8A8_SInt: desc.format = Format::R8G8B8A8_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16_Float: desc.format = Format::R16G16_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16_UNorm: desc.format = Format::R16G16_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16_UInt: desc.format = Format::R16G16_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16_SNorm: desc.format = Format::R16G16_SNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16G16_SInt: desc.format = Format::R16G16_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::D32_Float: desc.format = Format::D32_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32_Float: desc.format = Format::R32_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32_UInt: desc.format = Format::R32_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R32_SInt: desc.format = Format::R32_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8_UNorm: desc.format = Format::R8G8_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8_UInt: desc.format = Format::R8G8_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8_SNorm: desc.format = Format::R8G8_SNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8G8_SInt: desc.format = Format::R8G8_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16_Float: desc.format = Format::R16_FLOAT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::D16_UNorm: desc.format = Format::D16_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16_UNorm: desc.format = Format::R16_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16_UInt: desc.format = Format::R16_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16_SNorm: desc.format = Format::R16_SNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R16_SInt: desc.format = Format::R16_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8_UNorm: desc.format = Format::R8_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8_UInt: desc.format = Format::R8_UINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8_SNorm: desc.format = Format::R8_SNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::R8_SInt: desc.format = Format::R8_SINT; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm: desc.format = Format::BC1_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC1_UNorm_SRGB: desc.format = Format::BC1_UNORM_SRGB; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm: desc.format = Format::BC2_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC2_UNorm_SRGB: desc.format = Format::BC2_UNORM_SRGB; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm: desc.format = Format::BC3_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC3_UNorm_SRGB: desc.format = Format::BC3_UNORM_SRGB; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC4_UNorm: desc.format = Format::BC4_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC4_SNorm: desc.format = Format::BC4_SNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC5_UNorm: desc.format = Format::BC5_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC5_SNorm: desc.format = Format::BC5_SNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm: desc.format = Format::BC7_UNORM; break;
-						case tinyddsloader::DDSFile::DXGIFormat::BC7_UNorm_SRGB: desc.format = Format::BC7_UNORM_SRGB; break;
-						default:
-							assert(0); // incoming format is not supported 
-							break;
+							desc.format = format;
+						}
+						else
+						{
+							assert(0); // incoming format is not supported
 						}
 
 						wi::vector<SubresourceData> InitData;
@@ -703,41 +1242,443 @@ namespace wi
 					resource->filedata.clear();
 				}
 
+				resource->cpu_size = resource->filedata.size() + resource->script.size() + wi::audio::GetSoundMemorySize(&resource->sound);
+				resource->gpu_size = (size_t)ComputeTextureMemorySizeInBytes(resource->texture.desc);
+
 				if (type == DataType::IMAGE && resource->texture.desc.mip_levels > 1
 					&& has_flag(resource->texture.desc.bind_flags, BindFlag::UNORDERED_ACCESS))
 				{
 					wi::renderer::AddDeferredMIPGen(resource->texture, true);
 				}
+			}
+
+			return success;
+		}
+
+		Resource Load(const std::string& name, Flags flags, const uint8_t* filedata, size_t filesize)
+		{
+			if (mode == Mode::DISCARD_FILEDATA_AFTER_LOAD)
+			{
+				flags &= ~Flags::IMPORT_RETAIN_FILEDATA;
+			}
+
+			std::shared_ptr<LoadFutureInternal> future;
+			if (!BeginLoad(name, flags, future))
+			{
+				// Either already loaded, or an other thread is loading it:
+				wi::jobsystem::Wait(future->ctx);
+				return future->resource;
+			}
+
+			std::shared_ptr<ResourceInternal> resource = std::make_shared<ResourceInternal>();
+			if (!LoadInternal(resource.get(), name, flags, filedata, filesize))
+			{
+				resource.reset();
+			}
+			FinishLoad(*future, resource);
+
+			return future->resource;
+		}
+
+		LoadFuture LoadAsync(const std::string& name, Flags flags, std::function<void(Resource)> callback)
+		{
+			if (mode == Mode::DISCARD_FILEDATA_AFTER_LOAD)
+			{
+				flags &= ~Flags::IMPORT_RETAIN_FILEDATA;
+			}
+
+			std::shared_ptr<LoadFutureInternal> future;
+			const bool owner = BeginLoad(name, flags, future);
+
+			if (callback != nullptr)
+			{
+				future->callback_locker.lock();
+				if (future->finished)
+				{
+					DeferCallback(callback, future->resource);
+				}
+				else
+				{
+					future->callbacks.push_back(callback);
+				}
+				future->callback_locker.unlock();
+			}
+
+			if (owner)
+			{
+				wi::jobsystem::Execute(future->ctx, [future](wi::jobsystem::JobArgs args) {
+					std::shared_ptr<ResourceInternal> resource = std::make_shared<ResourceInternal>();
+					if (!LoadInternal(resource.get(), future->name, future->flags, nullptr, 0))
+					{
+						resource.reset();
+					}
+					FinishLoad(*future, resource);
+				});
+			}
+
+			LoadFuture retVal;
+			retVal.internal_state = future;
+			return retVal;
+		}
 
-				Resource retVal;
-				retVal.internal_state = resource;
-				return retVal;
+		wi::vector<LoadFuture> LoadAsyncBatch(const wi::vector<std::string>& names, Flags flags, std::function<void(const wi::vector<Resource>&)> callback)
+		{
+			wi::vector<LoadFuture> futures(names.size());
+			if (names.empty())
+			{
+				return futures;
+			}
+
+			struct BatchState
+			{
+				wi::vector<Resource> resources;
+				size_t remaining = 0;
+				std::function<void(const wi::vector<Resource>&)> callback;
+			};
+			std::shared_ptr<BatchState> batch;
+			if (callback != nullptr)
+			{
+				batch = std::make_shared<BatchState>();
+				batch->resources.resize(names.size());
+				batch->remaining = names.size();
+				batch->callback = callback;
+			}
+
+			for (size_t i = 0; i < names.size(); ++i)
+			{
+				std::function<void(Resource)> item_callback;
+				if (batch != nullptr)
+				{
+					// Deferred callbacks are all executed on the thread safe point, so the batch state is not accessed concurrently:
+					item_callback = [batch, i](Resource resource) {
+						batch->resources[i] = resource;
+						batch->remaining--;
+						if (batch->remaining == 0)
+						{
+							batch->callback(batch->resources);
+						}
+					};
+				}
+				futures[i] = LoadAsync(names[i], flags, item_callback);
 			}
 
-			return Resource();
+			return futures;
 		}
 
 		bool Contains(const std::string& name)
 		{
-			bool result = false;
-			locker.lock();
-			auto it = resources.find(name);
-			if (it != resources.end())
 			{
-				auto resource = it->second.lock();
-				result = resource != nullptr;
+				std::shared_lock lock(locker);
+				auto it = resources.find(name);
+				if (it != resources.end() && !it->second.expired())
+				{
+					return true;
+				}
 			}
-			locker.unlock();
-			return result;
+			std::scoped_lock lock(cache_locker);
+			return cache_lookup.count(name) > 0;
 		}
 
 		void Clear()
 		{
 			locker.lock();
 			resources.clear();
+			cache_generation.fetch_add(1);
 			locker.unlock();
+			CacheClear();
+		}
+
+		bool MountPackage(const std::string& filename, const std::string& mount_point)
+		{
+			MountedPackage mounted;
+			if (!wi::package::Open(filename, &mounted.package))
+			{
+				return false;
+			}
+			mounted.mount_point = wi::package::NormalizeName(mount_point);
+			std::scoped_lock lock(packages_locker);
+			packages.push_back(std::move(mounted));
+			return true;
+		}
+		void UnmountPackage(const std::string& filename)
+		{
+			std::scoped_lock lock(packages_locker);
+			packages.erase(std::remove_if(packages.begin(), packages.end(), [&](const MountedPackage& x) {
+				return x.package.GetFileName() == filename;
+			}), packages.end());
+		}
+		bool IsInMountedPackage(const std::string& name)
+		{
+			wi::package::Package package;
+			std::string package_name;
+			return FindInPackages(name, package, package_name);
 		}
 
+		void SetCacheBudget(size_t cpu_budget, size_t gpu_budget)
+		{
+			const bool enabled = cpu_budget > 0 || gpu_budget > 0;
+			if (!enabled)
+			{
+				cache_enabled.store(false);
+				CacheClear();
+				return;
+			}
+			std::scoped_lock lock(cache_locker);
+			cache_cpu_budget = cpu_budget;
+			cache_gpu_budget = gpu_budget;
+			cache_enabled.store(true);
+			CacheEvict();
+		}
+		bool IsCacheEnabled()
+		{
+			return cache_enabled.load();
+		}
+
+		wi::vector<ResourceInfo> GetResourceInfos()
+		{
+			wi::vector<ResourceInfo> infos;
+			// The handles are only released after the cache_locker is unlocked, because releasing the last one would enter the cache:
+			wi::vector<std::shared_ptr<ResourceInternal>> handles;
+			{
+				std::shared_lock lock(locker);
+				for (auto& it : resources)
+				{
+					std::shared_ptr<ResourceInternal> resource = it.second.lock();
+					if (resource == nullptr)
+					{
+						continue;
+					}
+					ResourceInfo& info = infos.emplace_back();
+					info.name = it.first;
+					info.cpu_size = resource->cpu_size;
+					info.gpu_size = resource->gpu_size;
+					info.referenced = true;
+					handles.push_back(std::move(resource));
+				}
+			}
+			{
+				std::scoped_lock lock(cache_locker);
+				for (auto& entry : cache_lru)
+				{
+					ResourceInfo& info = infos.emplace_back();
+					info.name = entry.name;
+					info.cpu_size = entry.resource->cpu_size;
+					info.gpu_size = entry.resource->gpu_size;
+					info.cached = true;
+				}
+			}
+			handles.clear();
+			return infos;
+		}
+
+		CacheStatistics GetCacheStatistics()
+		{
+			CacheStatistics stats;
+			for (auto& info : GetResourceInfos())
+			{
+				stats.resource_count++;
+				stats.cpu_usage += info.cpu_size;
+				stats.gpu_usage += info.gpu_size;
+				if (info.cached)
+				{
+					stats.cached_count++;
+					stats.cached_cpu_usage += info.cpu_size;
+					stats.cached_gpu_usage += info.gpu_size;
+				}
+			}
+			stats.hits = cache_hits.load();
+			stats.misses = cache_misses.load();
+			stats.evictions = cache_evictions.load();
+			return stats;
+		}
+		void ResetCacheStatistics()
+		{
+			cache_hits.store(0);
+			cache_misses.store(0);
+			cache_evictions.store(0);
+		}
+
+
+		void SetStreamingMemoryBudget(size_t budget)
+		{
+			streaming_budget.store(budget);
+		}
+		size_t GetStreamingMemoryBudget()
+		{
+			return streaming_budget.load();
+		}
+		bool IsStreamingEnabled()
+		{
+			return streaming_budget.load() > 0;
+		}
+		void SetStreamingBaseMipCount(uint32_t count)
+		{
+			streaming_base_mips.store(std::max(1u, count));
+		}
+		size_t GetStreamingMemoryUsage()
+		{
+			return streaming_usage.load();
+		}
+
+		void UpdateStreamingResources(float dt)
+		{
+			if (wi::jobsystem::IsBusy(streaming_ctx))
+			{
+				return; // previous streaming is still in progress
+			}
+
+			std::scoped_lock lock(streaming_locker);
+
+			wi::vector<std::shared_ptr<ResourceInternal>> active;
+			active.reserve(streaming_resources.size());
+			for (size_t i = 0; i < streaming_resources.size();)
+			{
+				std::shared_ptr<ResourceInternal> resource = streaming_resources[i].lock();
+				if (resource == nullptr)
+				{
+					streaming_resources[i] = std::move(streaming_resources.back());
+					streaming_resources.pop_back();
+					continue;
+				}
+				i++;
+
+				StreamingTexture& streaming = *resource->streaming;
+				if (streaming.streamed_texture.IsValid())
+				{
+					// The previous texture will be destroyed by the graphics device when the GPU is no longer using it
+					resource->texture = std::move(streaming.streamed_texture);
+					streaming.streamed_texture = {};
+					streaming.resident_mips = streaming.streamed_mips;
+				}
+
+				const uint32_t requested = streaming.requested_resolution.exchange(0);
+				if (requested > 0)
+				{
+					streaming.resolution = requested;
+					streaming.request_age = 0;
+				}
+				else
+				{
+					streaming.request_age += dt;
+					if (streaming.request_age > streaming_request_timeout)
+					{
+						streaming.resolution = 0;
+					}
+				}
+
+				active.push_back(resource);
+			}
+
+			wi::vector<StreamingResidencyRequest> requests(active.size());
+			wi::vector<uint32_t> resident_mips(active.size());
+			size_t usage = 0;
+			const uint32_t base_mips = streaming_base_mips.load();
+			for (size_t i = 0; i < active.size(); ++i)
+			{
+				const StreamingTexture& streaming = *active[i]->streaming;
+				requests[i].desc = streaming.desc;
+				requests[i].base_mips = base_mips;
+				requests[i].resolution = streaming.resolution;
+				for (uint32_t mip = streaming.desc.mip_levels - streaming.resident_mips; mip < streaming.desc.mip_levels; ++mip)
+				{
+					usage += ComputeMipSize(streaming.desc, mip);
+				}
+			}
+			streaming_usage.store(usage);
+
+			ComputeStreamingResidency(requests.data(), requests.size(), streaming_budget.load(), resident_mips.data());
+
+			for (size_t i = 0; i < active.size(); ++i)
+			{
+				const uint32_t mip_count = resident_mips[i];
+				if (mip_count == active[i]->streaming->resident_mips)
+				{
+					continue;
+				}
+				std::shared_ptr<ResourceInternal> resource = active[i];
+				wi::jobsystem::Execute(streaming_ctx, [resource, mip_count](wi::jobsystem::JobArgs args) {
+					StreamingTexture& streaming = *resource->streaming;
+					if (CreateStreamingTexture(streaming, mip_count, streaming.streamed_texture))
+					{
+						streaming.streamed_mips = mip_count;
+					}
+					else
+					{
+						streaming.streamed_texture = {};
+					}
+				});
+			}
+		}
+
+		size_t ComputeStreamingResidency(const StreamingResidencyRequest* requests, size_t count, size_t budget, uint32_t* resident_mips)
+		{
+			struct Candidate
+			{
+				uint32_t index;
+				uint32_t mip;
+				uint32_t resolution;
+				size_t size;
+			};
+			wi::vector<Candidate> candidates;
+			size_t usage = 0;
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const StreamingResidencyRequest& request = requests[i];
+				const uint32_t mip_levels = std::max(1u, request.desc.mip_levels);
+				const uint32_t base_mips = std::min(mip_levels, std::max(1u, request.base_mips));
+				resident_mips[i] = base_mips;
+				for (uint32_t mip = mip_levels - base_mips; mip < mip_levels; ++mip)
+				{
+					usage += ComputeMipSize(request.desc, mip);
+				}
+				if (request.resolution == 0)
+				{
+					continue;
+				}
+				// Every mip above the base mips is a candidate, until the requested resolution is reached:
+				for (uint32_t mip = mip_levels - base_mips; mip > 0;)
+				{
+					mip--;
+					Candidate candidate;
+					candidate.index = (uint32_t)i;
+					candidate.mip = mip;
+					candidate.resolution = std::max(request.desc.width >> mip, request.desc.height >> mip);
+					candidate.size = ComputeMipSize(request.desc, mip);
+					candidates.push_back(candidate);
+					if (candidate.resolution >= request.resolution)
+					{
+						break;
+					}
+				}
+			}
+
+			// Lower resolution mips first, so the budget is distributed evenly across all textures:
+			std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+				if (a.resolution != b.resolution)
+					return a.resolution < b.resolution;
+				if (a.size != b.size)
+					return a.size < b.size;
+				return a.index < b.index;
+			});
+
+			for (const Candidate& candidate : candidates)
+			{
+				const uint32_t mip_levels = std::max(1u, requests[candidate.index].desc.mip_levels);
+				if (mip_levels - resident_mips[candidate.index] != candidate.mip + 1)
+				{
+					continue; // a lower resolution mip of this texture didn't fit, so this can't be resident either
+				}
+				if (usage + candidate.size > budget)
+				{
+					continue;
+				}
+				usage += candidate.size;
+				resident_mips[candidate.index]++;
+			}
+
+			return usage;
+		}
 
 		void Serialize(wi::Archive& archive, ResourceSerializer& seri)
 		{
@@ -783,7 +1724,7 @@ namespace wi
 			}
 			else
 			{
-				locker.lock();
+				locker.lock_shared();
 				size_t serializable_count = 0;
 
 				if (mode == Mode::ALLOW_RETAIN_FILEDATA_BUT_DISABLE_EMBEDDING)
@@ -794,34 +1735,53 @@ namespace wi
 				}
 				else
 				{
-					// Count embedded resources:
+					// Collect embedded resources:
+					struct EmbeddedResource
+					{
+						std::string name;
+						std::shared_ptr<ResourceInternal> resource;
+						wi::vector<uint8_t> filedata; // file data that is not kept in memory by the resource
+					};
+					wi::vector<EmbeddedResource> embedded_resources;
 					for (auto& it : resources)
 					{
 						std::shared_ptr<ResourceInternal> resource = it.second.lock();
-						if (resource != nullptr && !resource->filedata.empty())
+						if (resource == nullptr)
+							continue;
+						if (!resource->filedata.empty())
 						{
-							serializable_count++;
+							EmbeddedResource& embedded = embedded_resources.emplace_back();
+							embedded.name = it.first;
+							embedded.resource = resource;
+						}
+						else if (has_flag(resource->flags, Flags::IMPORT_RETAIN_FILEDATA) && has_flag(resource->flags, Flags::STREAMING))
+						{
+							// Streaming textures don't keep the file data in memory, it is read from the file that they are streamed from:
+							EmbeddedResource& embedded = embedded_resources.emplace_back();
+							embedded.name = it.first;
+							embedded.resource = resource;
+							if (!wi::helper::FileRead(it.first, embedded.filedata) || embedded.filedata.empty())
+							{
+								wi::backlog::post("Streaming resource couldn't be embedded, because its file couldn't be read: " + it.first, wi::backlog::LogLevel::Warning);
+								embedded_resources.pop_back();
+							}
 						}
 					}
+					serializable_count = embedded_resources.size();
 
 					// Write all embedded resources:
 					archive << serializable_count;
-					for (auto& it : resources)
+					for (auto& embedded : embedded_resources)
 					{
-						std::shared_ptr<ResourceInternal> resource = it.second.lock();
+						std::string name = embedded.name;
+						wi::helper::MakePathRelative(archive.GetSourceDirectory(), name);
 
-						if (resource != nullptr && !resource->filedata.empty())
-						{
-							std::string name = it.first;
-							wi::helper::MakePathRelative(archive.GetSourceDirectory(), name);
-
-							archive << name;
-							archive << (uint32_t)resource->flags;
-							archive << resource->filedata;
-						}
+						archive << name;
+						archive << (uint32_t)embedded.resource->flags;
+						archive << (embedded.filedata.empty() ? embedded.resource->filedata : embedded.filedata);
 					}
 				}
-				locker.unlock();
+				locker.unlock_shared();
 			}
 		}
 
@@ -7,6 +7,7 @@
 #include "wiVector.h"
 
 #include <memory>
+#include <functional>
 
 namespace wi
 {
@@ -27,6 +28,11 @@ namespace wi
 		void SetTexture(const wi::graphics::Texture& texture);
 		void SetSound(const wi::audio::Sound& sound);
 		void SetScript(const std::string& script);
+
+		// Request a texture resolution for a streaming texture (that was loaded with Flags::STREAMING)
+		//	The largest resolution that was requested since the last wi::resourcemanager::UpdateStreamingResources() will be considered
+		//	This is thread safe, and does nothing if the resource is not a streaming texture
+		void StreamingRequestResolution(uint32_t resolution) const;
 	};
 
 	namespace resourcemanager
@@ -49,6 +55,7 @@ namespace wi
 			NONE = 0,
 			IMPORT_COLORGRADINGLUT = 1 << 0, // image import will convert resource to 3D color grading LUT
 			IMPORT_RETAIN_FILEDATA = 1 << 1, // file data will be kept for later reuse. This is necessary for keeping the resource serializable
+			STREAMING = 1 << 2, // image will be created with only the lowest resolution mips, higher resolution mips will be streamed in on demand. Only works for DDS 2D textures loaded from file, and if streaming is enabled with SetStreamingMemoryBudget(). Streaming textures don't keep the file data in memory even with IMPORT_RETAIN_FILEDATA, Serialize() reads it from the file instead
 		};
 
 		// Load a resource
@@ -62,17 +69,128 @@ namespace wi
 			const uint8_t* filedata = nullptr,
 			size_t filesize = 0
 		);
+		// Handle to a resource that is being loaded asynchronously
+		//	It is returned by wi::resourcemanager::LoadAsync()
+		struct LoadFuture
+		{
+			std::shared_ptr<void> internal_state;
+			inline bool IsValid() const { return internal_state.get() != nullptr; }
+
+			// Check if the load finished (either successfully or not), this doesn't block
+			//	An invalid future is always ready
+			bool IsReady() const;
+			// Wait until the load finishes and return the resource (it will be invalid if loading failed or the future is invalid)
+			//	The current thread will help executing jobs while waiting
+			Resource Get() const;
+		};
+
+		// Load a resource asynchronously. File reading and decoding will be performed by wi::jobsystem worker threads
+		//	Multiple requests for the same resource name that are in flight at the same time will be loaded only once
+		//	name : file name of resource
+		//	flags : specify flags that modify behaviour (optional)
+		//	callback : will be called when loading finished, at the next wi::eventhandler::EVENT_THREAD_SAFE_POINT (optional)
+		LoadFuture LoadAsync(
+			const std::string& name,
+			Flags flags = Flags::NONE,
+			std::function<void(Resource)> callback = nullptr
+		);
+		// Load multiple resources asynchronously, all of them will be loading in parallel
+		//	names : file names of resources
+		//	flags : specify flags that modify behaviour (optional)
+		//	callback : will be called when all resources finished loading, at the next wi::eventhandler::EVENT_THREAD_SAFE_POINT.
+		//		The resources are in the same order as names (optional)
+		wi::vector<LoadFuture> LoadAsyncBatch(
+			const wi::vector<std::string>& names,
+			Flags flags = Flags::NONE,
+			std::function<void(const wi::vector<Resource>&)> callback = nullptr
+		);
 		// Check if a resource is currently loaded
 		bool Contains(const std::string& name);
 		// Invalidate all resources
 		void Clear();
 
+		// Enable the resource cache, which keeps resources alive after they are no longer referenced, so they can be reloaded quickly
+		//	Resources enter the cache when their last reference is released, and leave it when they are loaded again
+		//	When memory usage of the cached resources exceeds the budget, the least recently released ones will be evicted
+		//	Referenced resources don't count toward the budget, because evicting them wouldn't free memory
+		//	cpu_budget : budget for CPU memory in bytes (file data, scripts, sounds), 0 means no limit
+		//	gpu_budget : budget for GPU memory in bytes (textures), 0 means no limit
+		//	If both budgets are 0, the cache is disabled (default)
+		void SetCacheBudget(size_t cpu_budget, size_t gpu_budget);
+		bool IsCacheEnabled();
+
+		struct ResourceInfo
+		{
+			std::string name;
+			size_t cpu_size = 0;
+			size_t gpu_size = 0;
+			bool cached = false;		// resource is not referenced, only kept alive by the cache
+			bool referenced = false;	// resource is referenced from outside of the resource manager
+		};
+		// Returns information about every resource that is currently alive
+		wi::vector<ResourceInfo> GetResourceInfos();
+
+		struct CacheStatistics
+		{
+			size_t cpu_usage = 0;			// CPU memory of all alive resources
+			size_t gpu_usage = 0;			// GPU memory of all alive resources
+			size_t cached_cpu_usage = 0;	// CPU memory of resources that are only kept alive by the cache
+			size_t cached_gpu_usage = 0;	// GPU memory of resources that are only kept alive by the cache
+			size_t resource_count = 0;		// number of alive resources
+			size_t cached_count = 0;		// number of resources that are only kept alive by the cache
+			uint64_t hits = 0;				// number of loads that were served without loading from file
+			uint64_t misses = 0;			// number of loads that needed to load from file
+			uint64_t evictions = 0;			// number of resources that were evicted from the cache
+		};
+		CacheStatistics GetCacheStatistics();
+		// Resets the hits, misses and evictions counters
+		void ResetCacheStatistics();
+
 		struct ResourceSerializer
 		{
 			wi::vector<Resource> resources;
 		};
+		// Texture streaming: textures loaded with Flags::STREAMING will start with the lowest resolution mips resident only
+		//	Higher resolution mips are streamed in (or dropped) in the background, based on the requested resolutions and the memory budget
+		//	budget : GPU memory budget in bytes for all streaming textures, 0 disables streaming (default)
+		//	The lowest resolution base mips are always resident, even if they don't fit into the budget
+		void SetStreamingMemoryBudget(size_t budget);
+		size_t GetStreamingMemoryBudget();
+		bool IsStreamingEnabled();
+		// Set the number of lowest resolution mips that are loaded initially and always kept resident (default: 6, which means 32x32 resolution)
+		void SetStreamingBaseMipCount(uint32_t count);
+		// Returns the GPU memory that is currently used by streaming textures
+		size_t GetStreamingMemoryUsage();
+		// Applies finished streaming and starts streaming for textures whose required mip levels changed
+		//	This is called by wi::Application once per frame, at the thread safe point
+		//	dt : elapsed time, textures that were not requested for some time will drop their higher resolution mips
+		void UpdateStreamingResources(float dt);
+
+		struct StreamingResidencyRequest
+		{
+			wi::graphics::TextureDesc desc;	// full resolution texture description
+			uint32_t base_mips = 1;			// number of lowest resolution mips that are always resident
+			uint32_t resolution = 0;		// requested resolution in texels (0: not requested)
+		};
+		// Computes the number of resident mip levels for every streaming texture, so that the total memory stays within the budget
+		//	Lower resolution mips are given priority over higher resolution mips across all textures
+		//	This doesn't use the GPU, so it can be used to simulate streaming decisions
+		//	resident_mips : output array of mip counts, must have the same size as requests
+		//	returns the total memory size of the resident mips
+		size_t ComputeStreamingResidency(const StreamingResidencyRequest* requests, size_t count, size_t budget, uint32_t* resident_mips);
+
+		// Mount a package file (see wiPackage.h), Load() will look up resource names in mounted packages before the file system
+		//	mount_point : this is removed from the beginning of resource names before looking them up in the package, it can be a directory path
+		//	Packages that were mounted later take precedence
+		bool MountPackage(const std::string& filename, const std::string& mount_point = "");
+		// Unmount a package that was mounted with MountPackage()
+		void UnmountPackage(const std::string& filename);
+		// Check whether a resource name can be found in any of the mounted packages
+		bool IsInMountedPackage(const std::string& name);
+
 		// Serializes all resources that are compatible
 		//	Compatible resources are those whose file data is kept around using the IMPORT_RETAIN_FILEDATA flag when loading.
+		//	Streaming textures loaded with IMPORT_RETAIN_FILEDATA are also compatible, their file data is read from the file when writing the archive.
 		void Serialize(wi::Archive& archive, ResourceSerializer& seri);
 	}
 
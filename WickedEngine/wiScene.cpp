@@ -270,6 +270,33 @@ namespace wi::scene
 			bounds = AABB::Merge(bounds, group_bound);
 		}
 
+		// Impostor selection (depends on object update system):
+		if (impostor_lod_dirty.load())
+		{
+			impostor_lod_dirty.store(false);
+			wi::vector<wi::ImpostorLOD::Instance> impostor_instances;
+			for (const wi::ImpostorLOD::Instance& instance : impostor_lod_instances)
+			{
+				if (instance.type != ~0u)
+				{
+					impostor_instances.push_back(instance);
+				}
+			}
+			impostorLOD.Build(impostor_instances.data(), (uint32_t)impostor_instances.size());
+
+			if (impostorCandidateBuffer.desc.size < impostor_instances.size() * sizeof(uint))
+			{
+				GPUBufferDesc desc;
+				desc.size = impostor_instances.size() * sizeof(uint) * 2; // *2 to grow fast
+				desc.bind_flags = BindFlag::SHADER_RESOURCE;
+				desc.misc_flags = ResourceMiscFlag::BUFFER_RAW;
+				device->CreateBuffer(&desc, nullptr, &impostorCandidateBuffer);
+				device->SetName(&impostorCandidateBuffer, "impostorCandidateBuffer");
+				impostorCandidateVersion = ~0ull;
+			}
+		}
+		impostorLOD.Update(camera.Eye);
+
 		// Meshlet buffer:
 		uint32_t meshletCount = meshletAllocator.load();
 		if(meshletBuffer.desc.size < meshletCount * sizeof(ShaderMeshlet))
@@ -478,7 +505,7 @@ namespace wi::scene
 
 		impostor_ib_format = (((objects.GetCount() * 4) < 655536) ? Format::R16_UINT : Format::R32_UINT);
 		const size_t impostor_index_stride = impostor_ib_format == Format::R16_UINT ? sizeof(uint16_t) : sizeof(uint32_t);
-		const uint64_t required_impostor_buffer_size = objects.GetCount() * (sizeof(impostor_index_stride) * 6 + sizeof(uint4) * 4 + sizeof(uint2));
+		const uint64_t required_impostor_buffer_size = objects.GetCount() * (sizeof(impostor_index_stride) * 6 + sizeof(uint4) * 4 + sizeof(uint4));
 		if (impostorBuffer.desc.size < required_impostor_buffer_size)
 		{
 			GPUBufferDesc desc;
@@ -509,7 +536,7 @@ namespace wi::scene
 			impostor_vb.descriptor_uav = device->GetDescriptorIndex(&impostorBuffer, SubresourceType::UAV, impostor_vb.subresource_uav);
 
 			impostor_data.offset = buffer_offset;
-			impostor_data.size = objects.GetCount() * sizeof(uint2);
+			impostor_data.size = objects.GetCount() * sizeof(uint4);
 			buffer_offset += AlignTo(impostor_data.size, alignment);
 			impostor_data.subresource_srv = device->CreateSubresource(&impostorBuffer, SubresourceType::SRV, impostor_data.offset, impostor_data.size);
 			impostor_data.subresource_uav = device->CreateSubresource(&impostorBuffer, SubresourceType::UAV, impostor_data.offset, impostor_data.size);
@@ -613,6 +640,7 @@ namespace wi::scene
 		TLAS = RaytracingAccelerationStructure();
 		BVH.Clear();
 		waterRipples.clear();
+		full_precision_meshes.clear();
 
 		surfelBuffer = {};
 		surfelDataBuffer = {};
@@ -638,6 +666,10 @@ namespace wi::scene
 		{
 			ddgi = std::move(other.ddgi);
 		}
+
+		full_precision_meshes.insert(full_precision_meshes.end(), other.full_precision_meshes.begin(), other.full_precision_meshes.end());
+
+		wi::physics::MergeCollisionShapes(*this, other);
 	}
 	void Scene::FindAllEntities(wi::unordered_set<wi::ecs::Entity>& entities) const
 	{
@@ -2153,6 +2185,7 @@ namespace wi::scene
 	{
 		colliders_cpu.clear();
 		colliders_gpu.clear();
+		colliders_cpu_aabb.clear();
 
 		for (size_t i = 0; i < colliders.GetCount(); ++i)
 		{
@@ -2202,12 +2235,35 @@ namespace wi::scene
 			if (collider.IsCPUEnabled())
 			{
 				colliders_cpu.push_back(collider);
+
+				// Conservative bounds for the spring collision broadphase:
+				AABB aabb;
+				switch (collider.shape)
+				{
+				default:
+				case ColliderComponent::Shape::Sphere:
+					aabb.createFromHalfWidth(collider.sphere.center, XMFLOAT3(collider.sphere.radius, collider.sphere.radius, collider.sphere.radius));
+					break;
+				case ColliderComponent::Shape::Capsule:
+					aabb = collider.capsule.getAABB();
+					break;
+				case ColliderComponent::Shape::Plane:
+					// The plane affects springs only inside its projection volume:
+					aabb = AABB(XMFLOAT3(-1, -1, -1), XMFLOAT3(1, 1, 1)).transform(XMMatrixInverse(nullptr, XMLoadFloat4x4(&collider.planeProjection)));
+					break;
+				}
+				const float margin = 0.01f; // against floating point differences of the narrow phase
+				aabb._min = XMFLOAT3(aabb._min.x - margin, aabb._min.y - margin, aabb._min.z - margin);
+				aabb._max = XMFLOAT3(aabb._max.x + margin, aabb._max.y + margin, aabb._max.z + margin);
+				colliders_cpu_aabb.push_back(aabb);
 			}
 			if (collider.IsGPUEnabled())
 			{
 				colliders_gpu.push_back(collider);
 			}
 		}
+
+		collider_bvh.Build(colliders_cpu_aabb.data(), (uint32_t)colliders_cpu_aabb.size());
 	}
 	void Scene::RunSpringUpdateSystem(wi::jobsystem::context& ctx)
 	{
@@ -2215,214 +2271,354 @@ namespace wi::scene
 		time += dt;
 		const XMVECTOR windDir = XMLoadFloat3(&weather.windDirection);
 
-		for (size_t i = 0; i < springs.GetCount(); ++i)
+		// Group springs into chains by their root spring, the chains don't depend on each other so they can be updated in parallel:
+		const uint32_t spring_count = (uint32_t)springs.GetCount();
+		wi::vector<uint32_t> spring_chain_ids(spring_count);
+		wi::vector<uint32_t> spring_chain_counts;
+		wi::unordered_map<Entity, uint32_t> spring_chain_lookup;
+		for (uint32_t i = 0; i < spring_count; ++i)
 		{
-			SpringComponent& spring = springs[i];
-			if (spring.IsDisabled())
+			Entity root = springs.GetEntity(i);
+			for (int depth = 0; depth < 256; ++depth) // depth limit against circular hierarchy
 			{
-				continue;
+				const HierarchyComponent* hier = hierarchy.GetComponent(root);
+				if (hier == nullptr || !springs.Contains(hier->parentID))
+					break;
+				root = hier->parentID;
 			}
-			Entity entity = springs.GetEntity(i);
-			size_t transform_index = transforms.GetIndex(entity);
-			if (transform_index == ~0ull)
+			auto it = spring_chain_lookup.find(root);
+			if (it == spring_chain_lookup.end())
 			{
-				continue;
+				it = spring_chain_lookup.insert({ root, (uint32_t)spring_chain_counts.size() }).first;
+				spring_chain_counts.push_back(0);
 			}
-			TransformComponent& transform = transforms[transform_index];
+			spring_chain_ids[i] = it->second;
+			spring_chain_counts[it->second]++;
+		}
+		const uint32_t spring_chain_count = (uint32_t)spring_chain_counts.size();
+		spring_chain_offsets.resize(spring_chain_count + 1);
+		spring_chain_offsets[0] = 0;
+		for (uint32_t chain = 0; chain < spring_chain_count; ++chain)
+		{
+			spring_chain_offsets[chain + 1] = spring_chain_offsets[chain] + spring_chain_counts[chain];
+			spring_chain_counts[chain] = spring_chain_offsets[chain]; // from now on, this is the write position of the chain
+		}
+		spring_queue.resize(spring_count);
+		for (uint32_t i = 0; i < spring_count; ++i)
+		{
+			spring_queue[spring_chain_counts[spring_chain_ids[i]]++] = i;
+		}
 
-			//XMVECTOR rotation_local = XMLoadFloat4(&transform.rotation_local);
-			XMVECTOR rotation_parent_world = XMQuaternionIdentity();
-			XMMATRIX parentWorldMatrix = XMMatrixIdentity();
+		// Collider candidates are gathered into the shared memory of the job group, if they don't fit, all colliders will be checked:
+		static constexpr uint32_t collider_candidates_capacity = 256;
+		struct ColliderCandidates
+		{
+			uint32_t count;
+			uint32_t indices[collider_candidates_capacity];
+		};
 
-			const HierarchyComponent* hier = hierarchy.GetComponent(entity);
-			size_t parent_index = hier == nullptr ? ~0ull : transforms.GetIndex(hier->parentID);
-			if (parent_index != ~0ull)
-			{
-				// Spring hierarchy resolve depends on spring component order!
-				//	It works best when parent spring is located before child spring!
-				//	It will work the other way, but results will be less convincing
-				const TransformComponent& parent_transform = transforms[parent_index];
-				transform.UpdateTransform_Parented(parent_transform);
-				rotation_parent_world = parent_transform.GetRotationV();
-				parentWorldMatrix = XMLoadFloat4x4(&parent_transform.world);
-			}
+		wi::jobsystem::Dispatch(ctx, spring_chain_count, 16, [&](wi::jobsystem::JobArgs args) {
 
-			XMVECTOR position_root = transform.GetPositionV();
-			//XMVECTOR rotation_combined = XMQuaternionNormalize(XMQuaternionMultiply(rotation_parent_world, rotation_local));
+			ColliderCandidates& candidates = *(ColliderCandidates*)args.sharedmemory;
 
-			if (spring.IsResetting() && dt > 0)
+			for (uint32_t queue_index = spring_chain_offsets[args.jobIndex]; queue_index < spring_chain_offsets[args.jobIndex + 1]; ++queue_index)
 			{
-				spring.Reset(false);
+				const uint32_t i = spring_queue[queue_index];
+				SpringComponent& spring = springs[i];
+				if (spring.IsDisabled())
+				{
+					continue;
+				}
+				Entity entity = springs.GetEntity(i);
+				size_t transform_index = transforms.GetIndex(entity);
+				if (transform_index == ~0ull)
+				{
+					continue;
+				}
+				TransformComponent& transform = transforms[transform_index];
 
-				XMVECTOR tail = position_root + XMVectorSet(0, 1, 0, 0);
-				// Search for child to find the rest pose tail position:
-				bool child_found = false;
-				for (size_t j = 0; j < hierarchy.GetCount(); ++j)
+				//XMVECTOR rotation_local = XMLoadFloat4(&transform.rotation_local);
+				XMVECTOR rotation_parent_world = XMQuaternionIdentity();
+				XMMATRIX parentWorldMatrix = XMMatrixIdentity();
+
+				const HierarchyComponent* hier = hierarchy.GetComponent(entity);
+				size_t parent_index = hier == nullptr ? ~0ull : transforms.GetIndex(hier->parentID);
+				if (parent_index != ~0ull)
 				{
-					const HierarchyComponent& hier = hierarchy[j];
-					Entity child = hierarchy.GetEntity(j);
-					if (hier.parentID == entity && transforms.Contains(child))
-					{
-						const TransformComponent& child_transform = *transforms.GetComponent(child);
-						tail = child_transform.GetPositionV();
-						child_found = true;
-						break;
-					}
+					// Spring hierarchy resolve depends on spring component order!
+					//	It works best when parent spring is located before child spring!
+					//	It will work the other way, but results will be less convincing
+					const TransformComponent& parent_transform = transforms[parent_index];
+					transform.UpdateTransform_Parented(parent_transform);
+					rotation_parent_world = parent_transform.GetRotationV();
+					parentWorldMatrix = XMLoadFloat4x4(&parent_transform.world);
 				}
-				if (!child_found)
+
+				XMVECTOR position_root = transform.GetPositionV();
+				//XMVECTOR rotation_combined = XMQuaternionNormalize(XMQuaternionMultiply(rotation_parent_world, rotation_local));
+
+				if (spring.IsResetting() && dt > 0)
 				{
-					// No child, try to guess tail position compared to parent (if it has parent):
-					const HierarchyComponent* hier = hierarchy.GetComponent(entity);
-					if (hier != nullptr && transforms.Contains(hier->parentID))
+					spring.Reset(false);
+
+					XMVECTOR tail = position_root + XMVectorSet(0, 1, 0, 0);
+					// Search for child to find the rest pose tail position:
+					bool child_found = false;
+					for (size_t j = 0; j < hierarchy.GetCount(); ++j)
+					{
+						const HierarchyComponent& hier = hierarchy[j];
+						Entity child = hierarchy.GetEntity(j);
+						if (hier.parentID == entity && transforms.Contains(child))
+						{
+							const TransformComponent& child_transform = *transforms.GetComponent(child);
+							tail = child_transform.GetPositionV();
+							child_found = true;
+							break;
+						}
+					}
+					if (!child_found)
 					{
-						const TransformComponent& parent_transform = *transforms.GetComponent(hier->parentID);
-						XMVECTOR ab = position_root - parent_transform.GetPositionV();
-						tail = position_root + ab;
+						// No child, try to guess tail position compared to parent (if it has parent):
+						const HierarchyComponent* hier = hierarchy.GetComponent(entity);
+						if (hier != nullptr && transforms.Contains(hier->parentID))
+						{
+							const TransformComponent& parent_transform = *transforms.GetComponent(hier->parentID);
+							XMVECTOR ab = position_root - parent_transform.GetPositionV();
+							tail = position_root + ab;
+						}
 					}
+					XMVECTOR axis = tail - position_root;
+					XMVECTOR length = XMVector3Length(axis);
+					//axis = XMVector3Rotate(axis, XMQuaternionNormalize(XMQuaternionInverse(rotation_combined)));
+					axis /= length;
+					XMStoreFloat3(&spring.boneAxis, axis);
+					XMStoreFloat3(&spring.currentTail, tail);
+					spring.prevTail = spring.currentTail;
+					spring.boneLength = XMVectorGetX(length);
 				}
-				XMVECTOR axis = tail - position_root;
-				XMVECTOR length = XMVector3Length(axis);
-				//axis = XMVector3Rotate(axis, XMQuaternionNormalize(XMQuaternionInverse(rotation_combined)));
-				axis /= length;
-				XMStoreFloat3(&spring.boneAxis, axis);
-				XMStoreFloat3(&spring.currentTail, tail);
-				spring.prevTail = spring.currentTail;
-				spring.boneLength = XMVectorGetX(length);
-			}
 
-			XMVECTOR boneAxis = XMLoadFloat3(&spring.boneAxis);
-			//boneAxis = XMVector3Normalize(XMVector3Rotate(boneAxis, rotation_combined));
+				XMVECTOR boneAxis = XMLoadFloat3(&spring.boneAxis);
+				//boneAxis = XMVector3Normalize(XMVector3Rotate(boneAxis, rotation_combined));
 
-			const float boneLength = spring.boneLength;
-			const float dragForce = spring.dragForce;
-			const float stiffnessForce = spring.stiffnessForce;
-			const XMVECTOR gravityDir = XMLoadFloat3(&spring.gravityDir);
-			const float gravityPower = spring.gravityPower;
+				const float boneLength = spring.boneLength;
+				const float dragForce = spring.dragForce;
+				const float stiffnessForce = spring.stiffnessForce;
+				const XMVECTOR gravityDir = XMLoadFloat3(&spring.gravityDir);
+				const float gravityPower = spring.gravityPower;
 
 #if 0
-			// Debug axis:
-			wi::renderer::RenderableLine line;
-			line.color_start = line.color_end = XMFLOAT4(1, 1, 0, 1);
-			XMStoreFloat3(&line.start, position_root);
-			XMStoreFloat3(&line.end, position_root + boneAxis * boneLength);
-			wi::renderer::DrawLine(line);
+				// Debug axis:
+				wi::renderer::RenderableLine line;
+				line.color_start = line.color_end = XMFLOAT4(1, 1, 0, 1);
+				XMStoreFloat3(&line.start, position_root);
+				XMStoreFloat3(&line.end, position_root + boneAxis * boneLength);
+				wi::renderer::DrawLine(line);
 #endif
 
-			const XMVECTOR tail_current = XMLoadFloat3(&spring.currentTail);
-			const XMVECTOR tail_prev = XMLoadFloat3(&spring.prevTail);
+				const XMVECTOR tail_current = XMLoadFloat3(&spring.currentTail);
+				const XMVECTOR tail_prev = XMLoadFloat3(&spring.prevTail);
 
-			XMVECTOR inertia = (tail_current - tail_prev) * (1 - dragForce);
-			XMVECTOR stiffness = boneAxis * stiffnessForce;
-			XMVECTOR external = XMVectorZero();
+				XMVECTOR inertia = (tail_current - tail_prev) * (1 - dragForce);
+				XMVECTOR stiffness = boneAxis * stiffnessForce;
+				XMVECTOR external = XMVectorZero();
 
-			if (spring.windForce > 0)
-			{
-				external += std::sin(time * weather.windSpeed + XMVectorGetX(XMVector3Dot(tail_current, windDir))) * windDir * spring.windForce;
-			}
-			if (spring.IsGravityEnabled())
-			{
-				external += gravityDir * gravityPower;
-			}
+				if (spring.windForce > 0)
+				{
+					external += std::sin(time * weather.windSpeed + XMVectorGetX(XMVector3Dot(tail_current, windDir))) * windDir * spring.windForce;
+				}
+				if (spring.IsGravityEnabled())
+				{
+					external += gravityDir * gravityPower;
+				}
 
-			XMVECTOR tail_next = tail_current + inertia + dt * (stiffness + external);
-			XMVECTOR to_tail = XMVector3Normalize(tail_next - position_root);
+				XMVECTOR tail_next = tail_current + inertia + dt * (stiffness + external);
+				XMVECTOR to_tail = XMVector3Normalize(tail_next - position_root);
 
-			if (!spring.IsStretchEnabled())
-			{
-				// Limit offset to keep distance from parent:
-				tail_next = position_root + to_tail * boneLength;
-			}
+				if (!spring.IsStretchEnabled())
+				{
+					// Limit offset to keep distance from parent:
+					tail_next = position_root + to_tail * boneLength;
+				}
 
 #if 1
-			// Collider checks:
-			//	apply scaling to radius:
-			XMFLOAT3 scale = transform.GetScale();
-			const float hitRadius = spring.hitRadius * std::max(scale.x, std::max(scale.y, scale.z));
-
-			for (size_t collider_index = 0; collider_index < colliders_cpu.size(); ++collider_index)
-			{
-				const ColliderComponent& collider = colliders_cpu[collider_index];
-
-				wi::primitive::Sphere tail_sphere;
-				XMStoreFloat3(&tail_sphere.center, tail_next); // tail_sphere center can change within loop!
-				tail_sphere.radius = hitRadius;
-				float dist = 0;
-				XMFLOAT3 direction = {};
-				switch (collider.shape)
+				// Collider checks:
+				//	apply scaling to radius:
+				XMFLOAT3 scale = transform.GetScale();
+				const float hitRadius = spring.hitRadius * std::max(scale.x, std::max(scale.y, scale.z));
+
+				// The tail sphere can be anywhere within this region while resolving the collisions, so only the colliders intersecting it are tested:
+				AABB region;
+				XMFLOAT3 region_center;
+				float region_extent = 0;
+				if (spring.IsStretchEnabled())
 				{
-				default:
-				case ColliderComponent::Shape::Sphere:
-					tail_sphere.intersects(collider.sphere, dist, direction);
-					break;
-				case ColliderComponent::Shape::Capsule:
-					tail_sphere.intersects(collider.capsule, dist, direction);
-					break;
-				case ColliderComponent::Shape::Plane:
-					dist = wi::math::GetPlanePointDistance(XMLoadFloat3(&collider.planeOrigin), XMLoadFloat3(&collider.planeNormal), tail_next);
-					direction = collider.planeNormal;
-					if (dist < 0)
+					XMStoreFloat3(&region_center, tail_next);
+					region_extent = hitRadius + boneLength;
+				}
+				else
+				{
+					// The tail is always kept at boneLength distance from the root:
+					XMStoreFloat3(&region_center, position_root);
+					region_extent = hitRadius + boneLength * 1.01f;
+				}
+				region.createFromHalfWidth(region_center, XMFLOAT3(region_extent, region_extent, region_extent));
+				candidates.count = 0;
+				bool candidates_overflow = false;
+				collider_bvh.Intersects(region, [&](uint32_t collider_index) {
+					if (candidates.count < collider_candidates_capacity)
+					{
+						candidates.indices[candidates.count++] = collider_index;
+					}
+					else
+					{
+						candidates_overflow = true;
+					}
+				});
+				// Colliders must be processed in the same order as without the broadphase:
+				std::sort(candidates.indices, candidates.indices + candidates.count);
+
+				auto collide = [&](size_t collider_index) {
+					const ColliderComponent& collider = colliders_cpu[collider_index];
+
+					wi::primitive::Sphere tail_sphere;
+					XMStoreFloat3(&tail_sphere.center, tail_next); // tail_sphere center can change within loop!
+					tail_sphere.radius = hitRadius;
+					float dist = 0;
+					XMFLOAT3 direction = {};
+					switch (collider.shape)
 					{
-						direction.x *= -1;
-						direction.y *= -1;
-						direction.z *= -1;
-						dist = std::abs(dist);
+					default:
+					case ColliderComponent::Shape::Sphere:
+						tail_sphere.intersects(collider.sphere, dist, direction);
+						break;
+					case ColliderComponent::Shape::Capsule:
+						tail_sphere.intersects(collider.capsule, dist, direction);
+						break;
+					case ColliderComponent::Shape::Plane:
+						dist = wi::math::GetPlanePointDistance(XMLoadFloat3(&collider.planeOrigin), XMLoadFloat3(&collider.planeNormal), tail_next);
+						direction = collider.planeNormal;
+						if (dist < 0)
+						{
+							direction.x *= -1;
+							direction.y *= -1;
+							direction.z *= -1;
+							dist = std::abs(dist);
+						}
+						dist = dist - tail_sphere.radius;
+						if (dist < 0)
+						{
+							XMMATRIX planeProjection = XMLoadFloat4x4(&collider.planeProjection);
+							XMVECTOR clipSpacePos = XMVector3Transform(tail_next, planeProjection);
+							XMVECTOR uvw = clipSpacePos * XMVectorSet(0.5f, -0.5f, 0.5f, 1) + XMVectorSet(0.5f, 0.5f, 0.5f, 0);
+							XMVECTOR uvw_sat = XMVectorSaturate(uvw);
+							if (std::abs(XMVectorGetX(uvw) - XMVectorGetX(uvw_sat)) > std::numeric_limits<float>::epsilon())
+								dist = 1; // force no collision
+							else if (std::abs(XMVectorGetY(uvw) - XMVectorGetY(uvw_sat)) > std::numeric_limits<float>::epsilon())
+								dist = 1; // force no collision
+							else if (std::abs(XMVectorGetZ(uvw) - XMVectorGetZ(uvw_sat)) > std::numeric_limits<float>::epsilon())
+								dist = 1; // force no collision
+						}
+						break;
 					}
-					dist = dist - tail_sphere.radius;
+
 					if (dist < 0)
 					{
-						XMMATRIX planeProjection = XMLoadFloat4x4(&collider.planeProjection);
-						XMVECTOR clipSpacePos = XMVector3Transform(tail_next, planeProjection);
-						XMVECTOR uvw = clipSpacePos * XMVectorSet(0.5f, -0.5f, 0.5f, 1) + XMVectorSet(0.5f, 0.5f, 0.5f, 0);
-						XMVECTOR uvw_sat = XMVectorSaturate(uvw);
-						if (std::abs(XMVectorGetX(uvw) - XMVectorGetX(uvw_sat)) > std::numeric_limits<float>::epsilon())
-							dist = 1; // force no collision
-						else if (std::abs(XMVectorGetY(uvw) - XMVectorGetY(uvw_sat)) > std::numeric_limits<float>::epsilon())
-							dist = 1; // force no collision
-						else if (std::abs(XMVectorGetZ(uvw) - XMVectorGetZ(uvw_sat)) > std::numeric_limits<float>::epsilon())
-							dist = 1; // force no collision
+						tail_next = tail_next - XMLoadFloat3(&direction) * dist;
+						to_tail = XMVector3Normalize(tail_next - position_root);
+
+						if (!spring.IsStretchEnabled())
+						{
+							// Limit offset to keep distance from parent:
+							tail_next = position_root + to_tail * boneLength;
+						}
 					}
-					break;
-				}
+				};
+				auto inside_region = [&]() {
+					XMFLOAT3 tail;
+					XMStoreFloat3(&tail, tail_next);
+					return
+						tail.x - hitRadius >= region._min.x && tail.x + hitRadius <= region._max.x &&
+						tail.y - hitRadius >= region._min.y && tail.y + hitRadius <= region._max.y &&
+						tail.z - hitRadius >= region._min.z && tail.z + hitRadius <= region._max.z;
+				};
 
-				if (dist < 0)
+				size_t collider_next = 0;
+				if (collider_bvh.IsValid() && !candidates_overflow)
 				{
-					tail_next = tail_next - XMLoadFloat3(&direction) * dist;
-					to_tail = XMVector3Normalize(tail_next - position_root);
-
-					if (!spring.IsStretchEnabled())
+					for (uint32_t candidate = 0; candidate < candidates.count && inside_region(); ++candidate)
 					{
-						// Limit offset to keep distance from parent:
-						tail_next = position_root + to_tail * boneLength;
+						collide(candidates.indices[candidate]);
+						collider_next = candidates.indices[candidate] + 1;
+					}
+					if (inside_region())
+					{
+						collider_next = colliders_cpu.size();
 					}
 				}
-			}
+				// Without broadphase, or if the tail was pushed out of the region, the remaining colliders are checked one by one:
+				for (size_t collider_index = collider_next; collider_index < colliders_cpu.size(); ++collider_index)
+				{
+					collide(collider_index);
+				}
 #endif
 
-			XMStoreFloat3(&spring.prevTail, tail_current);
-			XMStoreFloat3(&spring.currentTail, tail_next);
+				XMStoreFloat3(&spring.prevTail, tail_current);
+				XMStoreFloat3(&spring.currentTail, tail_next);
 
-			// Rotate to face tail position:
-			const XMVECTOR axis = XMVector3Normalize(XMVector3Cross(boneAxis, to_tail));
-			const float angle = XMScalarACos(XMVectorGetX(XMVector3Dot(boneAxis, to_tail)));
-			const XMVECTOR Q = XMQuaternionNormalize(XMQuaternionRotationNormal(axis, angle));
-			TransformComponent tmp = transform;
-			tmp.ApplyTransform();
-			tmp.Rotate(Q);
-			tmp.UpdateTransform();
-			transform.world = tmp.world; // only store world space result, not modifying actual local space!
+				// Rotate to face tail position:
+				const XMVECTOR axis = XMVector3Normalize(XMVector3Cross(boneAxis, to_tail));
+				const float angle = XMScalarACos(XMVectorGetX(XMVector3Dot(boneAxis, to_tail)));
+				const XMVECTOR Q = XMQuaternionNormalize(XMQuaternionRotationNormal(axis, angle));
+				TransformComponent tmp = transform;
+				tmp.ApplyTransform();
+				tmp.Rotate(Q);
+				tmp.UpdateTransform();
+				transform.world = tmp.world; // only store world space result, not modifying actual local space!
 
-		}
+			}
+		}, sizeof(ColliderCandidates));
+
+		wi::jobsystem::Wait(ctx); // armatures depend on the spring transforms
 	}
 	void Scene::RunInverseKinematicsUpdateSystem(wi::jobsystem::context& ctx)
 	{
-		if (inverse_kinematics.GetCount() > 0)
-		{
-			transforms_temp.resize(transforms.GetCount());
-			transforms_temp = transforms.GetComponentArray(); // make copy
-		}
+		const uint32_t ik_count = (uint32_t)inverse_kinematics.GetCount();
+		if (ik_count == 0)
+			return;
 
-		bool recompute_hierarchy = false;
-		for (size_t i = 0; i < inverse_kinematics.GetCount(); ++i)
+		auto get_root = [&](Entity entity) {
+			for (int depth = 0; depth < 256; ++depth) // depth limit against circular hierarchy
+			{
+				const HierarchyComponent* hier = hierarchy.GetComponent(entity);
+				if (hier == nullptr)
+					break;
+				entity = hier->parentID;
+			}
+			return entity;
+		};
+
+		// Group inverse kinematics into rigs by the hierarchy roots of their chain and target, the rigs don't depend on each other:
+		wi::unordered_map<Entity, uint32_t> rig_lookup;
+		wi::vector<uint32_t> rig_parents; // union-find forest of rigs
+		auto find_rig = [&](uint32_t rig) {
+			while (rig_parents[rig] != rig)
+			{
+				rig_parents[rig] = rig_parents[rig_parents[rig]];
+				rig = rig_parents[rig];
+			}
+			return rig;
+		};
+		auto get_rig = [&](Entity root) {
+			auto it = rig_lookup.find(root);
+			if (it == rig_lookup.end())
+			{
+				it = rig_lookup.insert({ root, (uint32_t)rig_parents.size() }).first;
+				rig_parents.push_back(it->second);
+			}
+			return find_rig(it->second);
+		};
+		wi::vector<uint32_t> ik_rigs(ik_count, ~0u);
+		for (uint32_t i = 0; i < ik_count; ++i)
 		{
 			const InverseKinematicsComponent& ik = inverse_kinematics[i];
 			if (ik.IsDisabled())
@@ -2430,111 +2626,200 @@ namespace wi::scene
 				continue;
 			}
 			Entity entity = inverse_kinematics.GetEntity(i);
-			size_t transform_index = transforms.GetIndex(entity);
-			size_t target_index = transforms.GetIndex(ik.target);
-			const HierarchyComponent* hier = hierarchy.GetComponent(entity);
-			if (transform_index == ~0ull || target_index == ~0ull || hier == nullptr)
+			if (!transforms.Contains(entity) || !transforms.Contains(ik.target) || !hierarchy.Contains(entity))
 			{
 				continue;
 			}
-			TransformComponent& transform = transforms_temp[transform_index];
-			TransformComponent& target = transforms_temp[target_index];
+			const uint32_t rig = get_rig(get_root(entity));
+			const uint32_t target_rig = get_rig(get_root(ik.target));
+			rig_parents[target_rig] = rig;
+			ik_rigs[i] = rig;
+		}
 
-			const XMVECTOR target_pos = target.GetPositionV();
-			for (uint32_t iteration = 0; iteration < ik.iteration_count; ++iteration)
+		// The inverse kinematics of a rig are solved in component order, on scratch copies of the transforms that they use:
+		struct Rig
+		{
+			wi::vector<uint32_t> iks;
+			wi::vector<Entity> entities;
+			wi::vector<TransformComponent> transforms;
+			wi::vector<uint8_t> modified; // whether local space of the scratch transform was modified
+			wi::unordered_map<Entity, uint32_t> lookup;
+		};
+		wi::vector<Rig> rigs;
+		wi::unordered_map<uint32_t, uint32_t> rig_remap;
+		for (uint32_t i = 0; i < ik_count; ++i)
+		{
+			if (ik_rigs[i] == ~0u)
+				continue;
+			const uint32_t rig = find_rig(ik_rigs[i]);
+			auto it = rig_remap.find(rig);
+			if (it == rig_remap.end())
 			{
-				TransformComponent* stack[32] = {};
-				Entity parent_entity = hier->parentID;
-				TransformComponent* child_transform = &transform;
-				for (uint32_t chain = 0; chain < std::min(ik.chain_length, (uint32_t)arraysize(stack)); ++chain)
-				{
-					recompute_hierarchy = true; // any IK will trigger a full transform hierarchy recompute step at the end(**)
+				it = rig_remap.insert({ rig, (uint32_t)rigs.size() }).first;
+				rigs.emplace_back();
+			}
+			rigs[it->second].iks.push_back(i);
+		}
 
-					// stack stores all traversed chain links so far:
-					stack[chain] = child_transform;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)rigs.size(), 1, [&](wi::jobsystem::JobArgs args) {
 
-					// Compute required parent rotation that moves ik transform closer to target transform:
-					size_t parent_index = transforms.GetIndex(parent_entity);
-					if (parent_index == ~0ull)
-						continue;
-					TransformComponent& parent_transform = transforms_temp[parent_index];
-					const XMVECTOR parent_pos = parent_transform.GetPositionV();
-					const XMVECTOR dir_parent_to_ik = XMVector3Normalize(transform.GetPositionV() - parent_pos);
-					const XMVECTOR dir_parent_to_target = XMVector3Normalize(target_pos - parent_pos);
-					const XMVECTOR axis = XMVector3Normalize(XMVector3Cross(dir_parent_to_ik, dir_parent_to_target));
-					const float angle = XMScalarACos(XMVectorGetX(XMVector3Dot(dir_parent_to_ik, dir_parent_to_target)));
-					const XMVECTOR Q = XMQuaternionNormalize(XMQuaternionRotationNormal(axis, angle));
-
-					// parent to world space:
-					parent_transform.ApplyTransform();
-					// rotate parent:
-					parent_transform.Rotate(Q);
-					parent_transform.UpdateTransform();
-					// parent back to local space (if parent has parent):
-					const HierarchyComponent* hier_parent = hierarchy.GetComponent(parent_entity);
-					if (hier_parent != nullptr)
+			Rig& rig = rigs[args.jobIndex];
+
+			// Gather the transforms of the chains into scratch memory, the scratch array must not grow after this:
+			auto gather = [&](Entity entity) {
+				if (rig.lookup.find(entity) != rig.lookup.end())
+					return;
+				const TransformComponent* transform = transforms.GetComponent(entity);
+				if (transform == nullptr)
+					return;
+				rig.lookup[entity] = (uint32_t)rig.entities.size();
+				rig.entities.push_back(entity);
+				rig.transforms.push_back(*transform);
+				rig.modified.push_back(0);
+			};
+			for (uint32_t i : rig.iks)
+			{
+				const InverseKinematicsComponent& ik = inverse_kinematics[i];
+				Entity entity = inverse_kinematics.GetEntity(i);
+				gather(entity);
+				gather(ik.target);
+				// chain links and the parent of the last link:
+				const uint32_t chain_length = std::min(ik.chain_length, 32u);
+				for (uint32_t chain = 0; chain <= chain_length; ++chain)
+				{
+					const HierarchyComponent* hier = hierarchy.GetComponent(entity);
+					if (hier == nullptr)
+						break;
+					entity = hier->parentID;
+					gather(entity);
+				}
+			}
+			auto get_index = [&](Entity entity) {
+				auto it = rig.lookup.find(entity);
+				return it == rig.lookup.end() ? ~0u : it->second;
+			};
+
+			for (uint32_t i : rig.iks)
+			{
+				const InverseKinematicsComponent& ik = inverse_kinematics[i];
+				Entity entity = inverse_kinematics.GetEntity(i);
+				const HierarchyComponent* hier = hierarchy.GetComponent(entity);
+				TransformComponent& transform = rig.transforms[get_index(entity)];
+				TransformComponent& target = rig.transforms[get_index(ik.target)];
+
+				const XMVECTOR target_pos = target.GetPositionV();
+				for (uint32_t iteration = 0; iteration < ik.iteration_count; ++iteration)
+				{
+					TransformComponent* stack[32] = {};
+					Entity parent_entity = hier->parentID;
+					TransformComponent* child_transform = &transform;
+					for (uint32_t chain = 0; chain < std::min(ik.chain_length, (uint32_t)arraysize(stack)); ++chain)
 					{
-						Entity parent_of_parent_entity = hier_parent->parentID;
-						size_t parent_of_parent_index = transforms.GetIndex(parent_of_parent_entity);
-						if (parent_of_parent_index != ~0ull)
+						// stack stores all traversed chain links so far:
+						stack[chain] = child_transform;
+
+						// Compute required parent rotation that moves ik transform closer to target transform:
+						const uint32_t parent_index = get_index(parent_entity);
+						if (parent_index == ~0u)
+							continue;
+						TransformComponent& parent_transform = rig.transforms[parent_index];
+						rig.modified[parent_index] = 1; // the subtree of modified transforms will be recomputed at the end(**)
+						const XMVECTOR parent_pos = parent_transform.GetPositionV();
+						const XMVECTOR dir_parent_to_ik = XMVector3Normalize(transform.GetPositionV() - parent_pos);
+						const XMVECTOR dir_parent_to_target = XMVector3Normalize(target_pos - parent_pos);
+						const XMVECTOR axis = XMVector3Normalize(XMVector3Cross(dir_parent_to_ik, dir_parent_to_target));
+						const float angle = XMScalarACos(XMVectorGetX(XMVector3Dot(dir_parent_to_ik, dir_parent_to_target)));
+						const XMVECTOR Q = XMQuaternionNormalize(XMQuaternionRotationNormal(axis, angle));
+
+						// parent to world space:
+						parent_transform.ApplyTransform();
+						// rotate parent:
+						parent_transform.Rotate(Q);
+						parent_transform.UpdateTransform();
+						// parent back to local space (if parent has parent):
+						const HierarchyComponent* hier_parent = hierarchy.GetComponent(parent_entity);
+						if (hier_parent != nullptr)
 						{
-							const TransformComponent* transform_parent_of_parent = &transforms_temp[parent_of_parent_index];
-							XMMATRIX parent_of_parent_inverse = XMMatrixInverse(nullptr, XMLoadFloat4x4(&transform_parent_of_parent->world));
-							parent_transform.MatrixTransform(parent_of_parent_inverse);
-							// Do not call UpdateTransform() here, to keep parent world matrix in world space!
+							const uint32_t parent_of_parent_index = get_index(hier_parent->parentID);
+							if (parent_of_parent_index != ~0u)
+							{
+								const TransformComponent* transform_parent_of_parent = &rig.transforms[parent_of_parent_index];
+								XMMATRIX parent_of_parent_inverse = XMMatrixInverse(nullptr, XMLoadFloat4x4(&transform_parent_of_parent->world));
+								parent_transform.MatrixTransform(parent_of_parent_inverse);
+								// Do not call UpdateTransform() here, to keep parent world matrix in world space!
+							}
 						}
-					}
 
-					// update chain from parent to children:
-					const TransformComponent* recurse_parent = &parent_transform;
-					for (int recurse_chain = (int)chain; recurse_chain >= 0; --recurse_chain)
-					{
-						stack[recurse_chain]->UpdateTransform_Parented(*recurse_parent);
-						recurse_parent = stack[recurse_chain];
-					}
+						// update chain from parent to children:
+						const TransformComponent* recurse_parent = &parent_transform;
+						for (int recurse_chain = (int)chain; recurse_chain >= 0; --recurse_chain)
+						{
+							stack[recurse_chain]->UpdateTransform_Parented(*recurse_parent);
+							recurse_parent = stack[recurse_chain];
+						}
 
-					if (hier_parent == nullptr)
-					{
-						// chain root reached, exit
-						break;
-					}
+						if (hier_parent == nullptr)
+						{
+							// chain root reached, exit
+							break;
+						}
 
-					// move up in the chain by one:
-					child_transform = &parent_transform;
-					parent_entity = hier_parent->parentID;
-					assert(chain < (uint32_t)arraysize(stack) - 1); // if this is encountered, just extend stack array size
+						// move up in the chain by one:
+						child_transform = &parent_transform;
+						parent_entity = hier_parent->parentID;
+						assert(chain < (uint32_t)arraysize(stack) - 1); // if this is encountered, just extend stack array size
 
+					}
 				}
 			}
-		}
 
-		if (recompute_hierarchy)
-		{
-			// (**)If there was IK, we need to recompute transform hierarchy. This is only necessary for transforms that have parent
-			//	transforms that are IK. Because the IK chain is computed from child to parent upwards, IK that have child would not update
-			//	its transform properly in some cases (such as if animation writes to that child)
-			for (size_t i = 0; i < hierarchy.GetCount(); ++i)
+			// IK shouldn't modify local space, so only update the world matrices! (other rigs don't access these transforms)
+			for (size_t i = 0; i < rig.entities.size(); ++i)
 			{
-				const HierarchyComponent& parentcomponent = hierarchy[i];
-				Entity entity = hierarchy.GetEntity(i);
+				transforms.GetComponent(rig.entities[i])->world = rig.transforms[i].world;
+			}
+		});
 
-				size_t transform_index = transforms.GetIndex(entity);
-				size_t parent_index = transforms.GetIndex(parentcomponent.parentID);
-				if (transform_index != ~0ull && parent_index != ~0ull)
+		wi::jobsystem::Wait(ctx);
+
+		// (**)If there was IK, we need to recompute transform hierarchy. This is only necessary for transforms that have parent
+		//	transforms that are IK. Because the IK chain is computed from child to parent upwards, IK that have child would not update
+		//	its transform properly in some cases (such as if animation writes to that child)
+		//	Only the subtrees of the modified transforms are recomputed, in the same order as the full hierarchy would be
+		wi::unordered_map<Entity, const TransformComponent*> affected; // modified transforms with their scratch local space, and their descendants with nullptr
+		for (const Rig& rig : rigs)
+		{
+			for (size_t i = 0; i < rig.entities.size(); ++i)
+			{
+				if (rig.modified[i])
 				{
-					TransformComponent* transform_child = &transforms_temp[transform_index];
-					TransformComponent* transform_parent = &transforms_temp[parent_index];
-					transform_child->UpdateTransform_Parented(*transform_parent);
+					affected[rig.entities[i]] = &rig.transforms[i];
 				}
 			}
 		}
-
-		if (inverse_kinematics.GetCount() > 0)
+		if (affected.empty())
+			return;
+		for (size_t i = 0; i < hierarchy.GetCount(); ++i)
 		{
-			for (size_t i = 0; i < transforms.GetCount(); ++i)
+			const HierarchyComponent& parentcomponent = hierarchy[i];
+			Entity entity = hierarchy.GetEntity(i);
+
+			auto it = affected.find(entity);
+			const bool modified = it != affected.end();
+			if (!modified && affected.find(parentcomponent.parentID) == affected.end())
+				continue;
+
+			TransformComponent* transform_child = transforms.GetComponent(entity);
+			const TransformComponent* transform_parent = transforms.GetComponent(parentcomponent.parentID);
+			if (transform_child != nullptr && transform_parent != nullptr)
+			{
+				const TransformComponent& local = modified ? *it->second : *transform_child;
+				XMMATRIX W = local.GetLocalMatrix() * XMLoadFloat4x4(&transform_parent->world);
+				XMStoreFloat4x4(&transform_child->world, W);
+			}
+			if (!modified)
 			{
-				// IK shouldn't modify local space, so only update the world matrices!
-				transforms[i].world = transforms_temp[i].world;
+				affected[entity] = nullptr;
 			}
 		}
 	}
@@ -2601,6 +2886,60 @@ namespace wi::scene
 	}
 	void Scene::RunMeshUpdateSystem(wi::jobsystem::context& ctx)
 	{
+		// Particle systems, soft bodies and lightmap rendering read mesh vertices in the full precision layout,
+		//	so quantized meshes that are used by them are recreated without quantization while they are used
+		//	The quantization setting of the mesh is kept, so it will be quantized again when it's no longer used by them:
+		wi::vector<Entity> full_precision_meshes_prev;
+		std::swap(full_precision_meshes_prev, full_precision_meshes);
+		auto require_full_precision = [&](Entity meshID) {
+			MeshComponent* mesh = meshes.GetComponent(meshID);
+			if (mesh == nullptr)
+				return;
+			full_precision_meshes.push_back(meshID);
+			if (!mesh->full_precision_required)
+			{
+				mesh->full_precision_required = true;
+				if (mesh->positions_quantized)
+				{
+					mesh->CreateRenderData();
+				}
+			}
+		};
+		for (size_t i = 0; i < hairs.GetCount(); ++i)
+		{
+			require_full_precision(hairs[i].meshID);
+		}
+		for (size_t i = 0; i < emitters.GetCount(); ++i)
+		{
+			require_full_precision(emitters[i].meshID);
+		}
+		for (size_t i = 0; i < softbodies.GetCount(); ++i)
+		{
+			require_full_precision(softbodies.GetEntity(i));
+		}
+		for (size_t i = 0; i < objects.GetCount(); ++i)
+		{
+			if (objects[i].IsLightmapRenderRequested())
+			{
+				require_full_precision(objects[i].meshID);
+			}
+		}
+		std::sort(full_precision_meshes.begin(), full_precision_meshes.end());
+		full_precision_meshes.erase(std::unique(full_precision_meshes.begin(), full_precision_meshes.end()), full_precision_meshes.end());
+		for (Entity meshID : full_precision_meshes_prev)
+		{
+			if (std::binary_search(full_precision_meshes.begin(), full_precision_meshes.end(), meshID))
+				continue;
+			MeshComponent* mesh = meshes.GetComponent(meshID);
+			if (mesh == nullptr)
+				continue;
+			mesh->full_precision_required = false;
+			if (mesh->IsQuantizedPositions() && mesh->generalBuffer.IsValid() && mesh->CanQuantizePositions())
+			{
+				mesh->CreateRenderData();
+			}
+		}
+
 		wi::jobsystem::Dispatch(ctx, (uint32_t)meshes.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
 			Entity entity = meshes.GetEntity(args.jobIndex);
@@ -2625,65 +2964,98 @@ namespace wi::scene
 			// Update morph targets if needed:
 			if (mesh.dirty_morph && !mesh.morph_targets.empty())
 			{
-			    XMFLOAT3 _min = XMFLOAT3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
-			    XMFLOAT3 _max = XMFLOAT3(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest());
+				// The morphed vertices are kept between updates, and only the weight changes are applied to them.
+				//	They are rebuilt from the rest pose when weights are all zero or after many incremental updates, to not accumulate float errors
+				bool rebuild = mesh.morph_weights_applied.size() != mesh.morph_targets.size() || mesh.morph_temp_pos.size() != mesh.vertex_positions.size();
+				if (!rebuild)
+				{
+					bool rest = true;
+					for (const MeshComponent::MorphTarget& morph : mesh.morph_targets)
+					{
+						rest &= morph.weight <= 0;
+					}
+					rebuild = rest || mesh.morph_update_count >= 256;
+				}
+				if (rebuild)
+				{
+					mesh.morph_temp_pos = mesh.vertex_positions;
+					mesh.morph_temp_nor = mesh.vertex_normals;
+					mesh.morph_weights_applied.clear();
+					mesh.morph_weights_applied.resize(mesh.morph_targets.size());
+					mesh.morph_update_count = 0;
+				}
+				else
+				{
+					mesh.morph_update_count++;
+				}
 
-				mesh.morph_temp_pos = mesh.vertex_positions;
-				mesh.morph_temp_nor = mesh.vertex_normals;
+				// Range of vertices that need to be written to vertex_positions_morphed:
+				size_t dirty_begin = rebuild ? 0 : mesh.morph_temp_pos.size();
+				size_t dirty_end = rebuild ? mesh.morph_temp_pos.size() : 0;
 
-				for (const MeshComponent::MorphTarget& morph : mesh.morph_targets)
+				XMVECTOR _min = XMLoadFloat3(&mesh.morph_aabb_rest._min);
+				XMVECTOR _max = XMLoadFloat3(&mesh.morph_aabb_rest._max);
+				for (size_t j = 0; j < mesh.morph_targets.size(); ++j)
 				{
-					if (morph.weight <= 0)
+					const MeshComponent::MorphTarget& morph = mesh.morph_targets[j];
+					const float weight = std::max(0.0f, morph.weight);
+
+					// Bounds are extended by the weighted offset bounds of the targets (they can be larger than the exact bounds):
+					const XMVECTOR W = XMVectorReplicate(weight);
+					_min = XMVectorMultiplyAdd(XMLoadFloat3(&morph.aabb._min), W, _min);
+					_max = XMVectorMultiplyAdd(XMLoadFloat3(&morph.aabb._max), W, _max);
+
+					const float delta = weight - mesh.morph_weights_applied[j];
+					if (delta == 0)
 						continue;
+					mesh.morph_weights_applied[j] = weight;
+
+					const XMVECTOR D = XMVectorReplicate(delta);
+					const bool normals = !morph.vertex_normals.empty() && !mesh.morph_temp_nor.empty();
 					if (morph.sparse_indices.empty())
 					{
 						for (size_t i = 0; i < morph.vertex_positions.size(); ++i)
 						{
-							mesh.morph_temp_pos[i].x += morph.weight * morph.vertex_positions[i].x;
-							mesh.morph_temp_pos[i].y += morph.weight * morph.vertex_positions[i].y;
-							mesh.morph_temp_pos[i].z += morph.weight * morph.vertex_positions[i].z;
-
-							if (!morph.vertex_normals.empty())
+							XMStoreFloat3(&mesh.morph_temp_pos[i], XMVectorMultiplyAdd(XMLoadFloat3(&morph.vertex_positions[i]), D, XMLoadFloat3(&mesh.morph_temp_pos[i])));
+						}
+						if (normals)
+						{
+							for (size_t i = 0; i < morph.vertex_normals.size(); ++i)
 							{
-								mesh.morph_temp_nor[i].x += morph.weight * morph.vertex_normals[i].x;
-								mesh.morph_temp_nor[i].y += morph.weight * morph.vertex_normals[i].y;
-								mesh.morph_temp_nor[i].z += morph.weight * morph.vertex_normals[i].z;
+								XMStoreFloat3(&mesh.morph_temp_nor[i], XMVectorMultiplyAdd(XMLoadFloat3(&morph.vertex_normals[i]), D, XMLoadFloat3(&mesh.morph_temp_nor[i])));
 							}
 						}
+						dirty_begin = 0;
+						dirty_end = std::max(dirty_end, morph.vertex_positions.size());
 					}
 					else
 					{
 						for (size_t i = 0; i < morph.sparse_indices.size(); ++i)
 						{
 							const uint32_t ind = morph.sparse_indices[i];
-							mesh.morph_temp_pos[ind].x += morph.weight * morph.vertex_positions[i].x;
-							mesh.morph_temp_pos[ind].y += morph.weight * morph.vertex_positions[i].y;
-							mesh.morph_temp_pos[ind].z += morph.weight * morph.vertex_positions[i].z;
-
-							if (!morph.vertex_normals.empty())
+							XMStoreFloat3(&mesh.morph_temp_pos[ind], XMVectorMultiplyAdd(XMLoadFloat3(&morph.vertex_positions[i]), D, XMLoadFloat3(&mesh.morph_temp_pos[ind])));
+							if (normals)
 							{
-								mesh.morph_temp_nor[ind].x += morph.weight * morph.vertex_normals[i].x;
-								mesh.morph_temp_nor[ind].y += morph.weight * morph.vertex_normals[i].y;
-								mesh.morph_temp_nor[ind].z += morph.weight * morph.vertex_normals[i].z;
+								XMStoreFloat3(&mesh.morph_temp_nor[ind], XMVectorMultiplyAdd(XMLoadFloat3(&morph.vertex_normals[i]), D, XMLoadFloat3(&mesh.morph_temp_nor[ind])));
 							}
+							dirty_begin = std::min(dirty_begin, (size_t)ind);
+							dirty_end = std::max(dirty_end, (size_t)ind + 1);
 						}
 					}
 				}
 
-			    for (size_t i = 0; i < mesh.morph_temp_pos.size(); ++i)
-			    {
-					XMFLOAT3 pos = mesh.morph_temp_pos[i];
+				for (size_t i = dirty_begin; i < dirty_end; ++i)
+				{
+					const XMFLOAT3& pos = mesh.morph_temp_pos[i];
 					XMFLOAT3 nor = mesh.morph_temp_nor.empty() ? XMFLOAT3(1, 1, 1) : mesh.morph_temp_nor[i];
 					const uint8_t wind = mesh.vertex_windweights.empty() ? 0xFF : mesh.vertex_windweights[i];
 
 					XMStoreFloat3(&nor, XMVector3Normalize(XMLoadFloat3(&nor)));
 					mesh.vertex_positions_morphed[i].FromFULL(pos, nor, wind);
+				}
 
-					_min = wi::math::Min(_min, pos);
-					_max = wi::math::Max(_max, pos);
-			    }
-
-			    mesh.aabb = AABB(_min, _max);
+				XMStoreFloat3(&mesh.aabb._min, _min);
+				XMStoreFloat3(&mesh.aabb._max, _max);
 			}
 
 			ShaderGeometry geometry;
@@ -2713,16 +3085,14 @@ namespace wi::scene
 			geometry.aabb_max = mesh.aabb._max;
 			geometry.tessellation_factor = mesh.tessellationFactor;
 
-			const ImpostorComponent* impostor = impostors.GetComponent(entity);
-			if (impostor != nullptr && impostor->textureIndex >= 0)
-			{
-				geometry.impostorSliceOffset = impostor->textureIndex * impostorCaptureAngles * 3;
-			}
-
 			if (mesh.IsDoubleSided())
 			{
 				geometry.flags |= SHADERMESH_FLAG_DOUBLE_SIDED;
 			}
+			if (mesh.positions_quantized)
+			{
+				geometry.flags |= SHADERMESH_FLAG_QUANTIZED_POSITIONS;
+			}
 
 			mesh.meshletCount = 0;
 
@@ -2773,7 +3143,7 @@ namespace wi::scene
 						}
 						else
 						{
-							geometry.flags = RaytracingAccelerationStructureDesc::BottomLevel::Geometry::FLAG_OPAQUE;
+							geometry.flags |= RaytracingAccelerationStructureDesc::BottomLevel::Geometry::FLAG_OPAQUE;
 						}
 						if (flags != geometry.flags || mesh.dirty_morph)
 						{
@@ -2845,76 +3215,109 @@ namespace wi::scene
 	}
 	void Scene::RunImpostorUpdateSystem(wi::jobsystem::context& ctx)
 	{
-		if (impostors.GetCount() > 0 && !impostorArray.IsValid())
+		// The atlas is repacked when impostors were added, removed or modified:
+		bool repack = impostors.GetCount() != impostorAtlasCount;
+		for (size_t i = 0; i < impostors.GetCount(); ++i)
 		{
-			GraphicsDevice* device = wi::graphics::GetDevice();
-
-			TextureDesc desc;
-			desc.width = impostorTextureDim;
-			desc.height = impostorTextureDim;
-
-			desc.bind_flags = BindFlag::DEPTH_STENCIL;
-			desc.array_size = 1;
-			desc.format = Format::D16_UNORM;
-			desc.layout = ResourceState::DEPTHSTENCIL;
-			desc.misc_flags = ResourceMiscFlag::TRANSIENT_ATTACHMENT;
-			device->CreateTexture(&desc, nullptr, &impostorDepthStencil);
-			device->SetName(&impostorDepthStencil, "impostorDepthStencil");
+			ImpostorComponent& impostor = impostors[i];
+			if (impostor.IsDirty())
+			{
+				impostor.SetDirty(false);
+				repack = true;
+			}
+		}
 
-			desc.bind_flags = BindFlag::RENDER_TARGET | BindFlag::SHADER_RESOURCE | BindFlag::UNORDERED_ACCESS;
-			desc.array_size = maxImpostorCount * impostorCaptureAngles * 3;
-			desc.format = Format::R8G8B8A8_UNORM;
-			desc.layout = ResourceState::SHADER_RESOURCE;
-			desc.misc_flags = ResourceMiscFlag::NONE;
-			device->CreateTexture(&desc, nullptr, &impostorArray);
-			device->SetName(&impostorArray, "impostorArray");
+		if (repack)
+		{
+			impostorAtlasCount = (uint32_t)impostors.GetCount();
+
+			// Every impostor takes a square of impostorCaptureGrid * impostorCaptureGrid capture angles,
+			//	if they don't fit into the maximum atlas size, the resolutions are reduced until they do:
+			static_assert(maxImpostorAtlasDim / IMPOSTOR_ATLAS_GRANULARITY <= 1024, "impostor atlas rect position must fit into the 10 bits of pack_impostor_atlas_rect()");
+			wi::rectpacker::State packer;
+			float iterative_scaling = 1;
+			bool packed = false;
+			while (!packed && impostors.GetCount() > 0 && iterative_scaling > 0.03f)
+			{
+				packer.clear();
+				for (size_t i = 0; i < impostors.GetCount(); ++i)
+				{
+					const ImpostorComponent& impostor = impostors[i];
+					const uint32_t resolution = uint32_t(std::max(1u, impostor.resolution) * iterative_scaling);
+					const uint32_t cell_size = std::min(std::max(1u, (resolution + IMPOSTOR_ATLAS_GRANULARITY - 1) / IMPOSTOR_ATLAS_GRANULARITY), 0xFFFu);
+
+					wi::rectpacker::Rect rect = {};
+					rect.id = int(i);
+					rect.w = int(cell_size * impostorCaptureGrid);
+					rect.h = int(cell_size * impostorCaptureGrid);
+					packer.add_rect(rect);
+				}
+				packed = packer.pack(int(maxImpostorAtlasDim / IMPOSTOR_ATLAS_GRANULARITY));
+				iterative_scaling *= 0.5f;
+			}
 
-			for (uint32_t i = 0; i < desc.array_size; ++i)
+			for (size_t i = 0; i < impostors.GetCount(); ++i)
 			{
-				int subresource_index;
-				subresource_index = device->CreateSubresource(&impostorArray, SubresourceType::RTV, i, 1, 0, 1);
-				assert(subresource_index == i);
+				ImpostorComponent& impostor = impostors[i];
+				impostor.atlas_rect = packed ? packer.rects[i] : wi::rectpacker::Rect{};
+				impostor.render_dirty = packed;
+			}
+			if (!packed && impostors.GetCount() > 0)
+			{
+				wi::backlog::post("Impostor atlas packing failed, impostors will not be rendered!", wi::backlog::LogLevel::Warning);
 			}
 
-			renderpasses_impostor.resize(desc.array_size / 3);
-			for (uint32_t i = 0; i < desc.array_size / 3; ++i)
+			const uint32_t width = packed ? uint32_t(packer.width) * IMPOSTOR_ATLAS_GRANULARITY : 0;
+			const uint32_t height = packed ? uint32_t(packer.height) * IMPOSTOR_ATLAS_GRANULARITY : 0;
+			if (width == 0 || height == 0)
 			{
-				RenderPassDesc renderpassdesc;
-				renderpassdesc.attachments.push_back(
-					RenderPassAttachment::RenderTarget(
-						&impostorArray,
-						RenderPassAttachment::LoadOp::CLEAR,
-						RenderPassAttachment::StoreOp::STORE,
-						ResourceState::RENDERTARGET,
-						ResourceState::RENDERTARGET,
-						ResourceState::RENDERTARGET
-					)
-				);
-				renderpassdesc.attachments.back().subresource = i * 3;
+				impostorArray = {};
+				impostorDepthStencil = {};
+				renderpass_impostor = {};
+			}
+			else if (!impostorArray.IsValid() || impostorArray.desc.width != width || impostorArray.desc.height != height)
+			{
+				GraphicsDevice* device = wi::graphics::GetDevice();
+
+				TextureDesc desc;
+				desc.width = width;
+				desc.height = height;
+
+				desc.bind_flags = BindFlag::DEPTH_STENCIL;
+				desc.array_size = 1;
+				desc.format = Format::D16_UNORM;
+				desc.layout = ResourceState::DEPTHSTENCIL;
+				desc.misc_flags = ResourceMiscFlag::TRANSIENT_ATTACHMENT;
+				device->CreateTexture(&desc, nullptr, &impostorDepthStencil);
+				device->SetName(&impostorDepthStencil, "impostorDepthStencil");
+
+				desc.bind_flags = BindFlag::RENDER_TARGET | BindFlag::SHADER_RESOURCE | BindFlag::UNORDERED_ACCESS;
+				desc.array_size = 3;
+				desc.format = Format::R8G8B8A8_UNORM;
+				desc.layout = ResourceState::SHADER_RESOURCE;
+				desc.misc_flags = ResourceMiscFlag::NONE;
+				device->CreateTexture(&desc, nullptr, &impostorArray);
+				device->SetName(&impostorArray, "impostorArray");
 
-				renderpassdesc.attachments.push_back(
-					RenderPassAttachment::RenderTarget(
-						&impostorArray,
-						RenderPassAttachment::LoadOp::CLEAR,
-						RenderPassAttachment::StoreOp::STORE,
-						ResourceState::RENDERTARGET,
-						ResourceState::RENDERTARGET,
-						ResourceState::RENDERTARGET
-					)
-				);
-				renderpassdesc.attachments.back().subresource = i * 3 + 1;
+				RenderPassDesc renderpassdesc;
+				for (uint32_t i = 0; i < desc.array_size; ++i)
+				{
+					int subresource_index;
+					subresource_index = device->CreateSubresource(&impostorArray, SubresourceType::RTV, i, 1, 0, 1);
+					assert(subresource_index == i);
 
-				renderpassdesc.attachments.push_back(
-					RenderPassAttachment::RenderTarget(
-						&impostorArray,
-						RenderPassAttachment::LoadOp::CLEAR,
-						RenderPassAttachment::StoreOp::STORE,
-						ResourceState::RENDERTARGET,
-						ResourceState::RENDERTARGET,
-						ResourceState::RENDERTARGET
-					)
-				);
-				renderpassdesc.attachments.back().subresource = i * 3 + 2;
+					renderpassdesc.attachments.push_back(
+						RenderPassAttachment::RenderTarget(
+							&impostorArray,
+							RenderPassAttachment::LoadOp::CLEAR,
+							RenderPassAttachment::StoreOp::STORE,
+							ResourceState::RENDERTARGET,
+							ResourceState::RENDERTARGET,
+							ResourceState::RENDERTARGET
+						)
+					);
+					renderpassdesc.attachments.back().subresource = subresource_index;
+				}
 
 				renderpassdesc.attachments.push_back(
 					RenderPassAttachment::DepthStencil(
@@ -2924,47 +3327,23 @@ namespace wi::scene
 					)
 				);
 
-				device->CreateRenderPass(&renderpassdesc, &renderpasses_impostor[i]);
-			}
-		}
-
-		// reconstruct impostor array status:
-		bool impostorTaken[maxImpostorCount] = {};
-		for (size_t i = 0; i < impostors.GetCount(); ++i)
-		{
-			ImpostorComponent& impostor = impostors[i];
-			if (impostor.textureIndex >= 0 && impostor.textureIndex < maxImpostorCount)
-			{
-				impostorTaken[impostor.textureIndex] = true;
-			}
-			else
-			{
-				impostor.textureIndex = -1;
+				device->CreateRenderPass(&renderpassdesc, &renderpass_impostor);
 			}
 		}
 
+		// The impostor atlas regions are written into the mesh geometries, the mesh update system has already finished at this point:
 		for (size_t i = 0; i < impostors.GetCount(); ++i)
 		{
-			ImpostorComponent& impostor = impostors[i];
-
-			if (impostor.IsDirty())
-			{
-				impostor.SetDirty(false);
-				impostor.render_dirty = true;
-			}
-
-			if (impostor.render_dirty && impostor.textureIndex < 0)
+			const ImpostorComponent& impostor = impostors[i];
+			if (impostor.atlas_rect.w <= 0)
+				continue;
+			const MeshComponent* mesh = meshes.GetComponent(impostors.GetEntity(i));
+			if (mesh == nullptr || geometryArrayMapped == nullptr)
+				continue;
+			const uint32_t atlas_rect = pack_impostor_atlas_rect(uint32_t(impostor.atlas_rect.x), uint32_t(impostor.atlas_rect.y), uint32_t(impostor.atlas_rect.w) / impostorCaptureGrid);
+			for (size_t subsetIndex = 0; subsetIndex < mesh->subsets.size(); ++subsetIndex)
 			{
-				// need to take a free impostor texture slot:
-				for (int i = 0; i < arraysize(impostorTaken); ++i)
-				{
-					if (impostorTaken[i] == false)
-					{
-						impostorTaken[i] = true;
-						impostor.textureIndex = i;
-						break;
-					}
-				}
+				geometryArrayMapped[mesh->geometryOffset + subsetIndex].impostorAtlasRect = atlas_rect;
 			}
 		}
 
@@ -3000,6 +3379,12 @@ namespace wi::scene
 
 		parallel_bounds.clear();
 		parallel_bounds.resize((size_t)wi::jobsystem::DispatchGroupCount((uint32_t)objects.GetCount(), small_subtask_groupsize));
+
+		if (impostor_lod_instances.size() != objects.GetCount())
+		{
+			impostor_lod_instances.resize(objects.GetCount());
+			impostor_lod_dirty.store(true);
+		}
 		
 		wi::jobsystem::Dispatch(ctx, (uint32_t)objects.GetCount(), small_subtask_groupsize, [&](wi::jobsystem::JobArgs args) {
 
@@ -3044,6 +3429,10 @@ namespace wi::scene
 			object.SetRequestPlanarReflection(false);
 			object.fadeDistance = object.draw_distance;
 
+			wi::ImpostorLOD::Instance impostor_lod_instance;
+			impostor_lod_instance.type = ~0u;
+			impostor_lod_instance.id = args.jobIndex;
+
 			if (object.meshID != INVALID_ENTITY && meshes.Contains(object.meshID) && transforms.Contains(entity))
 			{
 				// These will only be valid for a single frame:
@@ -3128,6 +3517,14 @@ namespace wi::scene
 					object.center = aabb.getCenter();
 					object.radius = aabb.getRadius();
 
+					if (impostor != nullptr)
+					{
+						// The impostor prepare shader will show the impostor when the camera is at least this far:
+						impostor_lod_instance.center = object.center;
+						impostor_lod_instance.distance = object.fadeDistance - object.radius;
+						impostor_lod_instance.type = (uint32_t)impostors.GetIndex(object.meshID);
+					}
+
 					// Create GPU instance data:
 					GraphicsDevice* device = wi::graphics::GetDevice();
 					ShaderMeshInstance inst;
@@ -3275,6 +3672,14 @@ namespace wi::scene
 				}
 			}
 
+			// The impostor selection is only rebuilt when an impostor instance changed:
+			wi::ImpostorLOD::Instance& impostor_lod_instance_prev = impostor_lod_instances[args.jobIndex];
+			if (std::memcmp(&impostor_lod_instance_prev, &impostor_lod_instance, sizeof(impostor_lod_instance)) != 0)
+			{
+				impostor_lod_instance_prev = impostor_lod_instance;
+				impostor_lod_dirty.store(true);
+			}
+
 		}, sizeof(AABB));
 	}
 	void Scene::RunCameraUpdateSystem(wi::jobsystem::context& ctx)
@@ -3,6 +3,8 @@
 #include "wiJobSystem.h"
 #include "wiSpinLock.h"
 #include "wiGPUBVH.h"
+#include "wiBVH.h"
+#include "wiImpostorLOD.h"
 #include "wiSprite.h"
 #include "wiMath.h"
 #include "wiECS.h"
@@ -160,11 +162,16 @@ namespace wi::scene
 		wi::vector<wi::graphics::RenderPass> renderpasses_envmap_MSAA;
 
 		// Impostor state:
-		static constexpr uint32_t maxImpostorCount = 8;
-		static constexpr uint32_t impostorTextureDim = 128;
+		static constexpr uint32_t maxImpostorAtlasDim = 16384;
 		wi::graphics::Texture impostorDepthStencil;
-		wi::graphics::Texture impostorArray;
-		wi::vector<wi::graphics::RenderPass> renderpasses_impostor;
+		wi::graphics::Texture impostorArray; // atlas of all impostors, slices: color, normal, surface
+		wi::graphics::RenderPass renderpass_impostor;
+		uint32_t impostorAtlasCount = 0; // number of impostors that were packed into the atlas
+		wi::ImpostorLOD impostorLOD; // selects the objects that are in impostor distance, updated incrementally as the camera moves
+		wi::vector<wi::ImpostorLOD::Instance> impostor_lod_instances; // per object, type is ~0u for objects without impostor
+		std::atomic_bool impostor_lod_dirty{ true }; // impostorLOD needs to be rebuilt because an impostor instance changed
+		wi::graphics::GPUBuffer impostorCandidateBuffer; // object indices selected by impostorLOD, grouped by impostor
+		mutable uint64_t impostorCandidateVersion = ~0ull; // impostorLOD version that was uploaded to impostorCandidateBuffer
 		wi::graphics::GPUBuffer impostorBuffer;
 		MeshComponent::BufferView impostor_ib;
 		MeshComponent::BufferView impostor_vb;
@@ -176,11 +183,17 @@ namespace wi::scene
 		uint32_t impostorMaterialOffset = ~0u;
 
 		mutable std::atomic_bool lightmap_refresh_needed{ false };
-		wi::vector<TransformComponent> transforms_temp;
+		wi::vector<wi::ecs::Entity> full_precision_meshes; // meshes that are not quantized in this frame, because they are read in full precision
 
 		// CPU/GPU Colliders:
 		wi::vector<ColliderComponent> colliders_cpu;
 		wi::vector<ColliderComponent> colliders_gpu;
+		wi::vector<wi::primitive::AABB> colliders_cpu_aabb;
+		wi::BVH collider_bvh; // acceleration structure for colliders_cpu, used by spring collision checks
+
+		// Springs are updated in parallel by independent chains (a root spring and its descendant springs):
+		wi::vector<uint32_t> spring_queue; // spring component indices ordered by chain, keeping component order within a chain
+		wi::vector<uint32_t> spring_chain_offsets; // the start of each chain in spring_queue, and the end of spring_queue
 
 		// Ocean GPU state:
 		wi::Ocean ocean;
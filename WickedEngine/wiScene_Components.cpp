@@ -11,6 +11,10 @@
 #include "wiTimer.h"
 #include "wiUnorderedMap.h"
 #include "wiLua.h"
+#include "wiBVH.h"
+
+#include "Utility/meshoptimizer/meshoptimizer.h"
+#include "Utility/xatlas/xatlas.h"
 
 using namespace wi::ecs;
 using namespace wi::enums;
@@ -373,7 +377,7 @@ namespace wi::scene
 		{
 			if (!x.name.empty())
 			{
-				x.resource = wi::resourcemanager::Load(x.name, wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA);
+				x.resource = wi::resourcemanager::Load(x.name, wi::resourcemanager::Flags::IMPORT_RETAIN_FILEDATA | wi::resourcemanager::Flags::STREAMING);
 			}
 		}
 	}
@@ -398,6 +402,7 @@ namespace wi::scene
 		so_pos_nor_wind = {};
 		so_tan = {};
 		so_pre = {};
+		blas_transform = {};
 
 		if (vertex_tangents.empty() && !vertex_uvset_0.empty() && !vertex_normals.empty())
 		{
@@ -495,6 +500,9 @@ namespace wi::scene
 
 		const size_t uv_count = std::max(vertex_uvset_0.size(), vertex_uvset_1.size());
 
+		positions_quantized = IsQuantizedPositions() && !full_precision_required && CanQuantizePositions();
+		const size_t position_stride = positions_quantized ? sizeof(Vertex_POS16) : sizeof(Vertex_POS);
+
 		GPUBufferDesc bd;
 		bd.usage = Usage::DEFAULT;
 		bd.bind_flags = BindFlag::VERTEX_BUFFER | BindFlag::INDEX_BUFFER | BindFlag::SHADER_RESOURCE;
@@ -506,12 +514,13 @@ namespace wi::scene
 		const uint64_t alignment = device->GetMinOffsetAlignment(&bd);
 		bd.size =
 			AlignTo(indices.size() * GetIndexStride(), alignment) +
-			AlignTo(vertex_positions.size() * sizeof(Vertex_POS), alignment) +
+			AlignTo(vertex_positions.size() * position_stride, alignment) +
 			AlignTo(vertex_tangents.size() * sizeof(Vertex_TAN), alignment) +
 			AlignTo(uv_count * sizeof(Vertex_UVS), alignment) +
 			AlignTo(vertex_atlas.size() * sizeof(Vertex_TEX), alignment) +
 			AlignTo(vertex_colors.size() * sizeof(Vertex_COL), alignment) +
-			AlignTo(vertex_boneindices.size() * sizeof(Vertex_BON), alignment)
+			AlignTo(vertex_boneindices.size() * sizeof(Vertex_BON), alignment) +
+			(positions_quantized ? AlignTo(sizeof(float) * 12, alignment) : 0)
 			;
 
 		// single allocation storage for GPU buffer data:
@@ -554,24 +563,73 @@ namespace wi::scene
 			}
 
 			vb_pos_nor_wind.offset = buffer_offset;
-			vb_pos_nor_wind.size = vertex_positions.size() * sizeof(Vertex_POS);
-			Vertex_POS* vertices = (Vertex_POS*)(buffer_data.data() + buffer_offset);
+			vb_pos_nor_wind.size = vertex_positions.size() * position_stride;
 			buffer_offset += AlignTo(vb_pos_nor_wind.size, alignment);
-			for (size_t i = 0; i < vertex_positions.size(); ++i)
+			if (positions_quantized)
 			{
-				const XMFLOAT3& pos = vertex_positions[i];
-				XMFLOAT3 nor = vertex_normals.empty() ? XMFLOAT3(1, 1, 1) : vertex_normals[i];
-				XMStoreFloat3(&nor, XMVector3Normalize(XMLoadFloat3(&nor)));
-				const uint8_t wind = vertex_windweights.empty() ? 0xFF : vertex_windweights[i];
-				vertices[i].FromFULL(pos, nor, wind);
+				// The quantization bounds are needed before the vertices can be written:
+				for (size_t i = 0; i < vertex_positions.size(); ++i)
+				{
+					_min = wi::math::Min(_min, vertex_positions[i]);
+					_max = wi::math::Max(_max, vertex_positions[i]);
+				}
+				const AABB bounds = AABB(_min, _max);
+				Vertex_POS16* vertices = (Vertex_POS16*)(buffer_data.data() + vb_pos_nor_wind.offset);
+				for (size_t i = 0; i < vertex_positions.size(); ++i)
+				{
+					XMFLOAT3 nor = vertex_normals.empty() ? XMFLOAT3(1, 1, 1) : vertex_normals[i];
+					XMStoreFloat3(&nor, XMVector3Normalize(XMLoadFloat3(&nor)));
+					vertices[i].FromFULL(bounds, vertex_positions[i], nor);
+				}
 
-				_min = wi::math::Min(_min, pos);
-				_max = wi::math::Max(_max, pos);
+				// The BLAS reads the normalized positions, this transform maps them back into the bounds:
+				const XMFLOAT3 center = bounds.getCenter();
+				const XMFLOAT3 extent = bounds.getHalfWidth();
+				blas_transform.offset = buffer_offset;
+				blas_transform.size = sizeof(float) * 12;
+				buffer_offset += AlignTo(blas_transform.size, alignment);
+				const float transform[12] = {
+					extent.x, 0, 0, center.x,
+					0, extent.y, 0, center.y,
+					0, 0, extent.z, center.z,
+				};
+				std::memcpy(buffer_data.data() + blas_transform.offset, transform, sizeof(transform));
+			}
+			else
+			{
+				Vertex_POS* vertices = (Vertex_POS*)(buffer_data.data() + vb_pos_nor_wind.offset);
+				for (size_t i = 0; i < vertex_positions.size(); ++i)
+				{
+					const XMFLOAT3& pos = vertex_positions[i];
+					XMFLOAT3 nor = vertex_normals.empty() ? XMFLOAT3(1, 1, 1) : vertex_normals[i];
+					XMStoreFloat3(&nor, XMVector3Normalize(XMLoadFloat3(&nor)));
+					const uint8_t wind = vertex_windweights.empty() ? 0xFF : vertex_windweights[i];
+					vertices[i].FromFULL(pos, nor, wind);
+
+					_min = wi::math::Min(_min, pos);
+					_max = wi::math::Max(_max, pos);
+				}
 			}
 		}
 
 		aabb = AABB(_min, _max);
 
+		if (!morph_targets.empty())
+		{
+			// Bounds of the morph target offsets, these are used to compute morphed bounds without iterating the vertices:
+			for (MorphTarget& morph : morph_targets)
+			{
+				morph.aabb = AABB(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0));
+				for (const XMFLOAT3& offset : morph.vertex_positions)
+				{
+					morph.aabb._min = wi::math::Min(morph.aabb._min, offset);
+					morph.aabb._max = wi::math::Max(morph.aabb._max, offset);
+				}
+			}
+			morph_aabb_rest = aabb;
+			morph_weights_applied.clear(); // full rebuild of the morphed vertices
+		}
+
 		// vertexBuffer - TANGENTS
 		if (!vertex_tangents.empty())
 		{
@@ -729,8 +787,19 @@ namespace wi::scene
 					geometry.triangles.index_count = subset.indexCount;
 					geometry.triangles.index_offset = ib.offset / GetIndexStride() + subset.indexOffset;
 					geometry.triangles.vertex_count = (uint32_t)vertex_positions.size();
-					geometry.triangles.vertex_format = Format::R32G32B32_FLOAT;
-					geometry.triangles.vertex_stride = sizeof(MeshComponent::Vertex_POS);
+					if (positions_quantized)
+					{
+						geometry.triangles.vertex_format = Vertex_POS16::FORMAT; // the fourth component (normal) is ignored
+						geometry.triangles.vertex_stride = sizeof(MeshComponent::Vertex_POS16);
+						geometry.flags |= RaytracingAccelerationStructureDesc::BottomLevel::Geometry::FLAG_USE_TRANSFORM;
+						geometry.triangles.transform_3x4_buffer = generalBuffer;
+						geometry.triangles.transform_3x4_buffer_offset = (uint32_t)blas_transform.offset;
+					}
+					else
+					{
+						geometry.triangles.vertex_format = Format::R32G32B32_FLOAT;
+						geometry.triangles.vertex_stride = sizeof(MeshComponent::Vertex_POS);
+					}
 				}
 
 				bool success = device->CreateRaytracingAccelerationStructure(&desc, &BLASes[lod]);
@@ -739,6 +808,38 @@ namespace wi::scene
 			}
 		}
 	}
+	bool MeshComponent::CanQuantizePositions(float* max_error) const
+	{
+		// These need full precision positions or wind weights:
+		if (vertex_positions.empty() || IsDynamic() || IsSkinned() || !vertex_boneindices.empty() || !morph_targets.empty() || !vertex_windweights.empty())
+		{
+			if (max_error != nullptr)
+			{
+				*max_error = std::numeric_limits<float>::max();
+			}
+			return false;
+		}
+
+		AABB bounds;
+		for (const XMFLOAT3& pos : vertex_positions)
+		{
+			bounds._min = wi::math::Min(bounds._min, pos);
+			bounds._max = wi::math::Max(bounds._max, pos);
+		}
+
+		float error = 0;
+		for (const XMFLOAT3& pos : vertex_positions)
+		{
+			Vertex_POS16 vertex;
+			vertex.FromFULL(bounds, pos, XMFLOAT3(0, 0, 1));
+			error = std::max(error, wi::math::Distance(pos, vertex.GetPos_FULL(bounds)));
+		}
+		if (max_error != nullptr)
+		{
+			*max_error = error;
+		}
+		return error <= quantization_threshold;
+	}
 	void MeshComponent::CreateStreamoutRenderData()
 	{
 		GraphicsDevice* device = wi::graphics::GetDevice();
@@ -794,31 +895,40 @@ namespace wi::scene
 	{
 		// Start recalculating normals:
 
+		wi::jobsystem::context ctx;
+		const uint32_t group_size = 4096;
+
 		if (compute != COMPUTE_NORMALS_SMOOTH_FAST)
 		{
 			// Compute hard surface normals:
 
 			// Right now they are always computed even before smooth setting
-
-			wi::vector<uint32_t> newIndexBuffer;
-			wi::vector<XMFLOAT3> newPositionsBuffer;
-			wi::vector<XMFLOAT3> newNormalsBuffer;
-			wi::vector<XMFLOAT2> newUV0Buffer;
-			wi::vector<XMFLOAT2> newUV1Buffer;
-			wi::vector<XMFLOAT2> newAtlasBuffer;
-			wi::vector<XMUINT4> newBoneIndicesBuffer;
-			wi::vector<XMFLOAT4> newBoneWeightsBuffer;
-			wi::vector<uint32_t> newColorsBuffer;
-
-			for (size_t face = 0; face < indices.size() / 3; face++)
-			{
-				uint32_t i0 = indices[face * 3 + 0];
-				uint32_t i1 = indices[face * 3 + 1];
-				uint32_t i2 = indices[face * 3 + 2];
-
-				XMFLOAT3& p0 = vertex_positions[i0];
-				XMFLOAT3& p1 = vertex_positions[i1];
-				XMFLOAT3& p2 = vertex_positions[i2];
+			//	Every face gets its own three vertices, so the faces are processed in parallel
+
+			const uint32_t face_count = uint32_t(indices.size() / 3);
+			const uint32_t new_vertex_count = face_count * 3;
+			wi::vector<uint32_t> newIndexBuffer(new_vertex_count);
+			wi::vector<XMFLOAT3> newPositionsBuffer(new_vertex_count);
+			wi::vector<XMFLOAT3> newNormalsBuffer(new_vertex_count);
+			wi::vector<XMFLOAT2> newUV0Buffer(vertex_uvset_0.empty() ? 0 : new_vertex_count);
+			wi::vector<XMFLOAT2> newUV1Buffer(vertex_uvset_1.empty() ? 0 : new_vertex_count);
+			wi::vector<XMFLOAT2> newAtlasBuffer(vertex_atlas.empty() ? 0 : new_vertex_count);
+			wi::vector<XMUINT4> newBoneIndicesBuffer(vertex_boneindices.empty() ? 0 : new_vertex_count);
+			wi::vector<XMFLOAT4> newBoneWeightsBuffer(vertex_boneweights.empty() ? 0 : new_vertex_count);
+			wi::vector<uint32_t> newColorsBuffer(vertex_colors.empty() ? 0 : new_vertex_count);
+			wi::vector<uint8_t> newWindWeightsBuffer(vertex_windweights.empty() ? 0 : new_vertex_count);
+
+			wi::jobsystem::Dispatch(ctx, face_count, group_size, [&](wi::jobsystem::JobArgs args) {
+				const uint32_t face = args.jobIndex;
+				const uint32_t v = face * 3;
+
+				uint32_t i0 = indices[v + 0];
+				uint32_t i1 = indices[v + 1];
+				uint32_t i2 = indices[v + 2];
+
+				const XMFLOAT3& p0 = vertex_positions[i0];
+				const XMFLOAT3& p1 = vertex_positions[i1];
+				const XMFLOAT3& p2 = vertex_positions[i2];
 
 				XMVECTOR U = XMLoadFloat3(&p2) - XMLoadFloat3(&p0);
 				XMVECTOR V = XMLoadFloat3(&p1) - XMLoadFloat3(&p0);
@@ -829,77 +939,47 @@ namespace wi::scene
 				XMFLOAT3 normal;
 				XMStoreFloat3(&normal, N);
 
-				newPositionsBuffer.push_back(p0);
-				newPositionsBuffer.push_back(p1);
-				newPositionsBuffer.push_back(p2);
-
-				newNormalsBuffer.push_back(normal);
-				newNormalsBuffer.push_back(normal);
-				newNormalsBuffer.push_back(normal);
-
-				if (!vertex_uvset_0.empty())
-				{
-					newUV0Buffer.push_back(vertex_uvset_0[i0]);
-					newUV0Buffer.push_back(vertex_uvset_0[i1]);
-					newUV0Buffer.push_back(vertex_uvset_0[i2]);
-				}
-
-				if (!vertex_uvset_1.empty())
-				{
-					newUV1Buffer.push_back(vertex_uvset_1[i0]);
-					newUV1Buffer.push_back(vertex_uvset_1[i1]);
-					newUV1Buffer.push_back(vertex_uvset_1[i2]);
-				}
-
-				if (!vertex_atlas.empty())
-				{
-					newAtlasBuffer.push_back(vertex_atlas[i0]);
-					newAtlasBuffer.push_back(vertex_atlas[i1]);
-					newAtlasBuffer.push_back(vertex_atlas[i2]);
-				}
-
-				if (!vertex_boneindices.empty())
-				{
-					newBoneIndicesBuffer.push_back(vertex_boneindices[i0]);
-					newBoneIndicesBuffer.push_back(vertex_boneindices[i1]);
-					newBoneIndicesBuffer.push_back(vertex_boneindices[i2]);
-				}
+				newPositionsBuffer[v + 0] = p0;
+				newPositionsBuffer[v + 1] = p1;
+				newPositionsBuffer[v + 2] = p2;
 
-				if (!vertex_boneweights.empty())
-				{
-					newBoneWeightsBuffer.push_back(vertex_boneweights[i0]);
-					newBoneWeightsBuffer.push_back(vertex_boneweights[i1]);
-					newBoneWeightsBuffer.push_back(vertex_boneweights[i2]);
-				}
+				newNormalsBuffer[v + 0] = normal;
+				newNormalsBuffer[v + 1] = normal;
+				newNormalsBuffer[v + 2] = normal;
 
-				if (!vertex_colors.empty())
-				{
-					newColorsBuffer.push_back(vertex_colors[i0]);
-					newColorsBuffer.push_back(vertex_colors[i1]);
-					newColorsBuffer.push_back(vertex_colors[i2]);
-				}
-
-				newIndexBuffer.push_back(static_cast<uint32_t>(newIndexBuffer.size()));
-				newIndexBuffer.push_back(static_cast<uint32_t>(newIndexBuffer.size()));
-				newIndexBuffer.push_back(static_cast<uint32_t>(newIndexBuffer.size()));
-			}
+				auto copy = [&](auto& dst, const auto& src) {
+					if (!dst.empty())
+					{
+						dst[v + 0] = src[i0];
+						dst[v + 1] = src[i1];
+						dst[v + 2] = src[i2];
+					}
+				};
+				copy(newUV0Buffer, vertex_uvset_0);
+				copy(newUV1Buffer, vertex_uvset_1);
+				copy(newAtlasBuffer, vertex_atlas);
+				copy(newBoneIndicesBuffer, vertex_boneindices);
+				copy(newBoneWeightsBuffer, vertex_boneweights);
+				copy(newColorsBuffer, vertex_colors);
+				copy(newWindWeightsBuffer, vertex_windweights);
+
+				newIndexBuffer[v + 0] = v + 0;
+				newIndexBuffer[v + 1] = v + 1;
+				newIndexBuffer[v + 2] = v + 2;
+			});
+			wi::jobsystem::Wait(ctx);
 
 			// For hard surface normals, we created a new mesh in the previous loop through faces, so swap data:
-			vertex_positions = newPositionsBuffer;
-			vertex_normals = newNormalsBuffer;
-			vertex_uvset_0 = newUV0Buffer;
-			vertex_uvset_1 = newUV1Buffer;
-			vertex_atlas = newAtlasBuffer;
-			vertex_colors = newColorsBuffer;
-			if (!vertex_boneindices.empty())
-			{
-				vertex_boneindices = newBoneIndicesBuffer;
-			}
-			if (!vertex_boneweights.empty())
-			{
-				vertex_boneweights = newBoneWeightsBuffer;
-			}
-			indices = newIndexBuffer;
+			vertex_positions = std::move(newPositionsBuffer);
+			vertex_normals = std::move(newNormalsBuffer);
+			vertex_uvset_0 = std::move(newUV0Buffer);
+			vertex_uvset_1 = std::move(newUV1Buffer);
+			vertex_atlas = std::move(newAtlasBuffer);
+			vertex_colors = std::move(newColorsBuffer);
+			vertex_boneindices = std::move(newBoneIndicesBuffer);
+			vertex_boneweights = std::move(newBoneWeightsBuffer);
+			vertex_windweights = std::move(newWindWeightsBuffer);
+			indices = std::move(newIndexBuffer);
 		}
 
 		switch (compute)
@@ -910,154 +990,230 @@ namespace wi::scene
 		case MeshComponent::COMPUTE_NORMALS_SMOOTH:
 		{
 			// Compute smooth surface normals:
-
-			// 1.) Zero normals, they will be averaged later
-			for (size_t i = 0; i < vertex_normals.size(); i++)
+			//	After the hard normal pass, vertex i belongs to face i / 3 and its normal is the face normal
+			//	Positions are considered identical if they are closer than FLT_EPSILON in every axis
+
+			const uint32_t vertex_count = (uint32_t)vertex_positions.size();
+			const uint32_t face_count = vertex_count / 3;
+			auto match_position = [](const XMFLOAT3& a, const XMFLOAT3& b) {
+				return
+					std::abs(a.x - b.x) < FLT_EPSILON &&
+					std::abs(a.y - b.y) < FLT_EPSILON &&
+					std::abs(a.z - b.z) < FLT_EPSILON;
+			};
+
+			// 1.) Spatial hash of positions:
+			//	The cells are larger than the tolerance, so a position can only match positions in the cells that its tolerance box overlaps
+			//	Vertices are sorted into buckets by cell hash in parallel, different cells can share a bucket, so every candidate is tested
+			//	The positions are also stored in bucket order and the vertices are processed in bucket order, which keeps the candidates in cache
+			AABB bounds;
+			for (const XMFLOAT3& p : vertex_positions)
 			{
-				vertex_normals[i] = XMFLOAT3(0, 0, 0);
+				bounds._min = wi::math::Min(bounds._min, p);
+				bounds._max = wi::math::Max(bounds._max, p);
 			}
-
-			// 2.) Find identical vertices by POSITION, accumulate face normals
-			for (size_t i = 0; i < vertex_positions.size(); i++)
+			const XMFLOAT3 extents = bounds.getHalfWidth();
+			const double cell_size = std::max(double(std::max(extents.x, std::max(extents.y, extents.z))) / 1048576.0, double(FLT_EPSILON) * 4);
+			uint32_t bucket_count = 1;
+			while (bucket_count * 4 < vertex_count)
 			{
-				XMFLOAT3& v_search_pos = vertex_positions[i];
-
-				for (size_t ind = 0; ind < indices.size() / 3; ++ind)
+				bucket_count <<= 1;
+			}
+			const uint32_t bucket_mask = bucket_count - 1;
+			auto get_cell = [&](double value) {
+				return (int64_t)std::floor(value / cell_size);
+			};
+			auto get_bucket = [&](int64_t x, int64_t y, int64_t z) {
+				const uint64_t h = uint64_t(x) * 73856093ull ^ uint64_t(y) * 19349663ull ^ uint64_t(z) * 83492791ull;
+				return uint32_t(h ^ (h >> 32)) & bucket_mask;
+			};
+
+			wi::vector<uint32_t> vertex_buckets(vertex_count);
+			wi::vector<std::atomic<uint32_t>> bucket_counters(bucket_count);
+			wi::jobsystem::Dispatch(ctx, vertex_count, group_size, [&](wi::jobsystem::JobArgs args) {
+				const XMFLOAT3& p = vertex_positions[args.jobIndex];
+				const uint32_t bucket = get_bucket(get_cell(p.x), get_cell(p.y), get_cell(p.z));
+				vertex_buckets[args.jobIndex] = bucket;
+				bucket_counters[bucket].fetch_add(1, std::memory_order_relaxed);
+			});
+			wi::jobsystem::Wait(ctx);
+			wi::vector<uint32_t> bucket_offsets(bucket_count + 1);
+			bucket_offsets[0] = 0;
+			for (uint32_t i = 0; i < bucket_count; ++i)
+			{
+				bucket_offsets[i + 1] = bucket_offsets[i] + bucket_counters[i].load(std::memory_order_relaxed);
+				bucket_counters[i].store(bucket_offsets[i], std::memory_order_relaxed);
+			}
+			wi::vector<uint32_t> bucket_vertices(vertex_count);
+			wi::vector<XMFLOAT3> bucket_positions(vertex_count);
+			wi::jobsystem::Dispatch(ctx, vertex_count, group_size, [&](wi::jobsystem::JobArgs args) {
+				const uint32_t slot = bucket_counters[vertex_buckets[args.jobIndex]].fetch_add(1, std::memory_order_relaxed);
+				bucket_vertices[slot] = args.jobIndex;
+				bucket_positions[slot] = vertex_positions[args.jobIndex];
+			});
+			wi::jobsystem::Wait(ctx);
+			bucket_counters.clear();
+			vertex_buckets.clear();
+
+			// Calls the callback with the vertex of every matching POSITION, some vertices can be repeated:
+			auto query = [&](const XMFLOAT3& p, auto&& callback) {
+				const double tolerance = double(FLT_EPSILON) * 2;
+				const int64_t x0 = get_cell(p.x - tolerance), x1 = get_cell(p.x + tolerance);
+				const int64_t y0 = get_cell(p.y - tolerance), y1 = get_cell(p.y + tolerance);
+				const int64_t z0 = get_cell(p.z - tolerance), z1 = get_cell(p.z + tolerance);
+				for (int64_t z = z0; z <= z1; ++z)
 				{
-					uint32_t i0 = indices[ind * 3 + 0];
-					uint32_t i1 = indices[ind * 3 + 1];
-					uint32_t i2 = indices[ind * 3 + 2];
-
-					XMFLOAT3& v0 = vertex_positions[i0];
-					XMFLOAT3& v1 = vertex_positions[i1];
-					XMFLOAT3& v2 = vertex_positions[i2];
-
-					bool match_pos0 =
-						fabs(v_search_pos.x - v0.x) < FLT_EPSILON &&
-						fabs(v_search_pos.y - v0.y) < FLT_EPSILON &&
-						fabs(v_search_pos.z - v0.z) < FLT_EPSILON;
-
-					bool match_pos1 =
-						fabs(v_search_pos.x - v1.x) < FLT_EPSILON &&
-						fabs(v_search_pos.y - v1.y) < FLT_EPSILON &&
-						fabs(v_search_pos.z - v1.z) < FLT_EPSILON;
-
-					bool match_pos2 =
-						fabs(v_search_pos.x - v2.x) < FLT_EPSILON &&
-						fabs(v_search_pos.y - v2.y) < FLT_EPSILON &&
-						fabs(v_search_pos.z - v2.z) < FLT_EPSILON;
-
-					if (match_pos0 || match_pos1 || match_pos2)
+					for (int64_t y = y0; y <= y1; ++y)
 					{
-						XMVECTOR U = XMLoadFloat3(&v2) - XMLoadFloat3(&v0);
-						XMVECTOR V = XMLoadFloat3(&v1) - XMLoadFloat3(&v0);
-
-						XMVECTOR N = XMVector3Cross(U, V);
-						N = XMVector3Normalize(N);
-
-						XMFLOAT3 normal;
-						XMStoreFloat3(&normal, N);
-
-						vertex_normals[i].x += normal.x;
-						vertex_normals[i].y += normal.y;
-						vertex_normals[i].z += normal.z;
+						for (int64_t x = x0; x <= x1; ++x)
+						{
+							const uint32_t bucket = get_bucket(x, y, z);
+							for (uint32_t slot = bucket_offsets[bucket]; slot < bucket_offsets[bucket + 1]; ++slot)
+							{
+								if (match_position(p, bucket_positions[slot]))
+								{
+									callback(bucket_vertices[slot]);
+								}
+							}
+						}
 					}
-
 				}
+			};
+			// 2.) Sum the normals of the faces that have a vertex at the same POSITION:
+			//	Every face is summed only once, in ascending order
+			wi::vector<XMFLOAT3> face_normals(face_count);
+			for (uint32_t i = 0; i < face_count; ++i)
+			{
+				face_normals[i] = vertex_normals[i * 3];
 			}
+			wi::jobsystem::Dispatch(ctx, wi::jobsystem::DispatchGroupCount(vertex_count, group_size), 1, [&](wi::jobsystem::JobArgs args) {
+				wi::vector<uint32_t> faces; // reused by all vertices of the job
+				const uint32_t first = args.jobIndex * group_size;
+				const uint32_t last = std::min(first + group_size, vertex_count);
+				XMFLOAT3 normal = XMFLOAT3(0, 0, 0);
+				for (uint32_t slot = first; slot < last; ++slot)
+				{
+					// The result only depends on the position, and identical positions are usually next to each other in the bucket:
+					const XMFLOAT3& p = bucket_positions[slot];
+					if (slot == first || std::memcmp(&p, &bucket_positions[slot - 1], sizeof(p)) != 0)
+					{
+						faces.clear();
+						query(p, [&](uint32_t j) {
+							faces.push_back(j / 3);
+						});
+						std::sort(faces.begin(), faces.end());
+						faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+
+						normal = XMFLOAT3(0, 0, 0);
+						for (uint32_t face : faces)
+						{
+							normal.x += face_normals[face].x;
+							normal.y += face_normals[face].y;
+							normal.z += face_normals[face].z;
+						}
+					}
+					vertex_normals[bucket_vertices[slot]] = normal;
+				}
+			});
+			wi::jobsystem::Wait(ctx);
 
 			// 3.) Find duplicated vertices by POSITION and UV0 and UV1 and ATLAS and SUBSET and remove them:
-			for (auto& subset : subsets)
+			//	A duplicate is replaced by the first vertex of the subset that matches it and is not a duplicate itself
+			auto match_vertex = [&](uint32_t a, uint32_t b) {
+				auto match_uv = [](const wi::vector<XMFLOAT2>& uvs, uint32_t a, uint32_t b) {
+					return uvs.empty() || (std::abs(uvs[a].x - uvs[b].x) < FLT_EPSILON && std::abs(uvs[a].y - uvs[b].y) < FLT_EPSILON);
+				};
+				return
+					match_uv(vertex_uvset_0, a, b) &&
+					match_uv(vertex_uvset_1, a, b) &&
+					match_uv(vertex_atlas, a, b);
+			};
+			wi::vector<uint32_t> subset_begin(vertex_count, ~0u); // first vertex of the subset that contains the vertex
+			for (size_t i = subsets.size(); i > 0; --i)
 			{
-				for (uint32_t i = 0; i < subset.indexCount - 1; i++)
+				const MeshSubset& subset = subsets[i - 1];
+				if (subset.indexOffset + subset.indexCount > vertex_count)
+					continue;
+				for (uint32_t j = subset.indexOffset; j < subset.indexOffset + subset.indexCount; ++j)
 				{
-					uint32_t ind0 = indices[subset.indexOffset + (uint32_t)i];
-					const XMFLOAT3& p0 = vertex_positions[ind0];
-					const XMFLOAT2& u00 = vertex_uvset_0.empty() ? XMFLOAT2(0, 0) : vertex_uvset_0[ind0];
-					const XMFLOAT2& u10 = vertex_uvset_1.empty() ? XMFLOAT2(0, 0) : vertex_uvset_1[ind0];
-					const XMFLOAT2& at0 = vertex_atlas.empty() ? XMFLOAT2(0, 0) : vertex_atlas[ind0];
-
-					for (uint32_t j = i + 1; j < subset.indexCount; j++)
-					{
-						uint32_t ind1 = indices[subset.indexOffset + (uint32_t)j];
+					subset_begin[j] = subset.indexOffset;
+				}
+			}
 
-						if (ind1 == ind0)
+			// The first earlier match of every vertex is searched in parallel:
+			wi::vector<uint32_t> first_match(vertex_count);
+			wi::jobsystem::Dispatch(ctx, vertex_count, group_size, [&](wi::jobsystem::JobArgs args) {
+				const uint32_t j = bucket_vertices[args.jobIndex];
+				const uint32_t begin = subset_begin[j];
+				uint32_t k = ~0u;
+				if (begin != ~0u)
+				{
+					query(bucket_positions[args.jobIndex], [&](uint32_t candidate) {
+						if (candidate >= begin && candidate < j && candidate < k && match_vertex(candidate, j))
 						{
-							continue;
+							k = candidate;
 						}
+					});
+				}
+				first_match[j] = k;
+			});
+			wi::jobsystem::Wait(ctx);
 
-						const XMFLOAT3& p1 = vertex_positions[ind1];
-						const XMFLOAT2& u01 = vertex_uvset_0.empty() ? XMFLOAT2(0, 0) : vertex_uvset_0[ind1];
-						const XMFLOAT2& u11 = vertex_uvset_1.empty() ? XMFLOAT2(0, 0) : vertex_uvset_1[ind1];
-						const XMFLOAT2& at1 = vertex_atlas.empty() ? XMFLOAT2(0, 0) : vertex_atlas[ind1];
-
-						const bool duplicated_pos =
-							fabs(p0.x - p1.x) < FLT_EPSILON &&
-							fabs(p0.y - p1.y) < FLT_EPSILON &&
-							fabs(p0.z - p1.z) < FLT_EPSILON;
-
-						const bool duplicated_uv0 =
-							fabs(u00.x - u01.x) < FLT_EPSILON &&
-							fabs(u00.y - u01.y) < FLT_EPSILON;
-
-						const bool duplicated_uv1 =
-							fabs(u10.x - u11.x) < FLT_EPSILON &&
-							fabs(u10.y - u11.y) < FLT_EPSILON;
-
-						const bool duplicated_atl =
-							fabs(at0.x - at1.x) < FLT_EPSILON &&
-							fabs(at0.y - at1.y) < FLT_EPSILON;
-
-						if (duplicated_pos && duplicated_uv0 && duplicated_uv1 && duplicated_atl)
+			// The first match is usually kept, otherwise the first match that is kept is searched:
+			wi::vector<uint32_t> remap(vertex_count);
+			for (uint32_t j = 0; j < vertex_count; ++j)
+			{
+				remap[j] = j;
+				uint32_t k = first_match[j];
+				if (k == ~0u)
+					continue;
+				if (remap[k] != k)
+				{
+					const uint32_t begin = subset_begin[j];
+					k = ~0u;
+					query(vertex_positions[j], [&](uint32_t candidate) {
+						if (candidate >= begin && candidate < j && candidate < k && remap[candidate] == candidate && match_vertex(candidate, j))
 						{
-							// Erase vertices[ind1] because it is a duplicate:
-							if (ind1 < vertex_positions.size())
-							{
-								vertex_positions.erase(vertex_positions.begin() + ind1);
-							}
-							if (ind1 < vertex_normals.size())
-							{
-								vertex_normals.erase(vertex_normals.begin() + ind1);
-							}
-							if (ind1 < vertex_uvset_0.size())
-							{
-								vertex_uvset_0.erase(vertex_uvset_0.begin() + ind1);
-							}
-							if (ind1 < vertex_uvset_1.size())
-							{
-								vertex_uvset_1.erase(vertex_uvset_1.begin() + ind1);
-							}
-							if (ind1 < vertex_atlas.size())
-							{
-								vertex_atlas.erase(vertex_atlas.begin() + ind1);
-							}
-							if (ind1 < vertex_boneindices.size())
-							{
-								vertex_boneindices.erase(vertex_boneindices.begin() + ind1);
-							}
-							if (ind1 < vertex_boneweights.size())
-							{
-								vertex_boneweights.erase(vertex_boneweights.begin() + ind1);
-							}
-
-							// The vertices[ind1] was removed, so each index after that needs to be updated:
-							for (auto& index : indices)
-							{
-								if (index > ind1 && index > 0)
-								{
-									index--;
-								}
-								else if (index == ind1)
-								{
-									index = ind0;
-								}
-							}
-
+							k = candidate;
 						}
+					});
+					if (k == ~0u)
+						continue;
+				}
+				remap[j] = k;
+			}
 
+			// The remaining vertices keep their order:
+			wi::vector<uint32_t> new_indices(vertex_count);
+			uint32_t new_vertex_count = 0;
+			for (uint32_t i = 0; i < vertex_count; ++i)
+			{
+				new_indices[i] = remap[i] == i ? new_vertex_count++ : new_indices[remap[i]];
+			}
+			auto compact = [&](auto& vertices) {
+				if (vertices.size() != vertex_count)
+					return;
+				for (uint32_t i = 0; i < vertex_count; ++i)
+				{
+					if (remap[i] == i)
+					{
+						vertices[new_indices[i]] = vertices[i];
 					}
 				}
-
+				vertices.resize(new_vertex_count);
+			};
+			compact(vertex_positions);
+			compact(vertex_normals);
+			compact(vertex_uvset_0);
+			compact(vertex_uvset_1);
+			compact(vertex_atlas);
+			compact(vertex_boneindices);
+			compact(vertex_boneweights);
+			compact(vertex_colors);
+			compact(vertex_windweights);
+			for (auto& index : indices)
+			{
+				index = new_indices[index];
 			}
 
 		}
@@ -1065,34 +1221,52 @@ namespace wi::scene
 
 		case MeshComponent::COMPUTE_NORMALS_SMOOTH_FAST:
 		{
-			for (size_t i = 0; i < vertex_normals.size(); i++)
-			{
-				vertex_normals[i] = XMFLOAT3(0, 0, 0);
-			}
-			for (size_t i = 0; i < indices.size() / 3; ++i)
-			{
-				uint32_t index1 = indices[i * 3];
-				uint32_t index2 = indices[i * 3 + 1];
-				uint32_t index3 = indices[i * 3 + 2];
+			// The face normals are gathered per vertex in ascending face order in parallel, which gives the same sums as accumulating them face by face:
+			const uint32_t vertex_count = (uint32_t)vertex_positions.size();
+			const uint32_t face_count = uint32_t(indices.size() / 3);
+			wi::vector<XMFLOAT3> face_normals(face_count);
+			wi::jobsystem::Dispatch(ctx, face_count, group_size, [&](wi::jobsystem::JobArgs args) {
+				uint32_t index1 = indices[args.jobIndex * 3];
+				uint32_t index2 = indices[args.jobIndex * 3 + 1];
+				uint32_t index3 = indices[args.jobIndex * 3 + 2];
 
 				XMVECTOR side1 = XMLoadFloat3(&vertex_positions[index1]) - XMLoadFloat3(&vertex_positions[index3]);
 				XMVECTOR side2 = XMLoadFloat3(&vertex_positions[index1]) - XMLoadFloat3(&vertex_positions[index2]);
 				XMVECTOR N = XMVector3Normalize(XMVector3Cross(side1, side2));
-				XMFLOAT3 normal;
-				XMStoreFloat3(&normal, N);
-
-				vertex_normals[index1].x += normal.x;
-				vertex_normals[index1].y += normal.y;
-				vertex_normals[index1].z += normal.z;
-
-				vertex_normals[index2].x += normal.x;
-				vertex_normals[index2].y += normal.y;
-				vertex_normals[index2].z += normal.z;
+				XMStoreFloat3(&face_normals[args.jobIndex], N);
+			});
 
-				vertex_normals[index3].x += normal.x;
-				vertex_normals[index3].y += normal.y;
-				vertex_normals[index3].z += normal.z;
+			// Faces of every vertex, in ascending order:
+			wi::vector<uint32_t> face_offsets(vertex_count + 1, 0);
+			for (uint32_t i = 0; i < face_count * 3; ++i)
+			{
+				face_offsets[indices[i] + 1]++;
+			}
+			for (uint32_t i = 0; i < vertex_count; ++i)
+			{
+				face_offsets[i + 1] += face_offsets[i];
 			}
+			wi::vector<uint32_t> vertex_faces(face_count * 3);
+			wi::vector<uint32_t> face_counters(face_offsets.begin(), face_offsets.end() - 1);
+			for (uint32_t i = 0; i < face_count * 3; ++i)
+			{
+				vertex_faces[face_counters[indices[i]]++] = i / 3;
+			}
+			wi::jobsystem::Wait(ctx);
+
+			vertex_normals.resize(vertex_count);
+			wi::jobsystem::Dispatch(ctx, vertex_count, group_size, [&](wi::jobsystem::JobArgs args) {
+				XMFLOAT3 normal = XMFLOAT3(0, 0, 0);
+				for (uint32_t i = face_offsets[args.jobIndex]; i < face_offsets[args.jobIndex + 1]; ++i)
+				{
+					const XMFLOAT3& face_normal = face_normals[vertex_faces[i]];
+					normal.x += face_normal.x;
+					normal.y += face_normal.y;
+					normal.z += face_normal.z;
+				}
+				vertex_normals[args.jobIndex] = normal;
+			});
+			wi::jobsystem::Wait(ctx);
 		}
 		break;
 
@@ -1100,8 +1274,11 @@ namespace wi::scene
 
 		vertex_tangents.clear(); // <- will be recomputed
 
+		RefreshMeshlets(); // <- hard and smooth normals can change the vertices and indices
+
 		CreateRenderData(); // <- normals will be normalized here!
 	}
+
 	void MeshComponent::FlipCulling()
 	{
 		for (size_t face = 0; face < indices.size() / 3; face++)
@@ -1115,6 +1292,8 @@ namespace wi::scene
 			indices[face * 3 + 2] = i1;
 		}
 
+		RefreshMeshlets(); // the normal cones depend on the winding
+
 		CreateRenderData();
 	}
 	void MeshComponent::FlipNormals()
@@ -1139,6 +1318,8 @@ namespace wi::scene
 			pos.z -= center.z;
 		}
 
+		RefreshMeshlets();
+
 		CreateRenderData();
 	}
 	void MeshComponent::RecenterToBottom()
@@ -1153,6 +1334,8 @@ namespace wi::scene
 			pos.z -= center.z;
 		}
 
+		RefreshMeshlets();
+
 		CreateRenderData();
 	}
 	Sphere MeshComponent::GetBoundingSphere() const
@@ -1162,6 +1345,810 @@ namespace wi::scene
 		sphere.radius = aabb.getRadius();
 		return sphere;
 	}
+	void MeshComponent::GenerateLODs(const LODGenerationParams& params)
+	{
+		if (indices.empty() || vertex_positions.empty() || params.lod_count < 2)
+			return;
+
+		// The meshlets are rebuilt once at the end, instead of by every modification:
+		const bool rebuild_meshlets = !meshlets.empty();
+		ClearMeshlets();
+
+		if (subsets_per_lod == 0)
+		{
+			// if there were no lods before, record the subset count without lods:
+			subsets_per_lod = (uint32_t)subsets.size();
+		}
+
+		// https://github.com/zeux/meshoptimizer/blob/bedaaaf6e710d3b42d49260ca738c15d171b1a8f/demo/main.cpp
+		const size_t lod_count = (size_t)params.lod_count;
+		const size_t vertex_count = vertex_positions.size();
+		wi::vector<wi::vector<uint32_t>> lods(lod_count * subsets_per_lod); // lod-major order, like the subsets
+
+		// Subsets are simplified in parallel, the levels of a subset are simplified from the previous level:
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, subsets_per_lod, 1, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t subsetIndex = args.jobIndex;
+			const MeshSubset& subset = subsets[subsetIndex];
+			lods[subsetIndex].assign(indices.begin() + subset.indexOffset, indices.begin() + subset.indexOffset + subset.indexCount);
+
+			float threshold = wi::math::Lerp(0, 0.9f, wi::math::saturate(params.quality));
+			for (size_t i = 1; i < lod_count; ++i)
+			{
+				const wi::vector<uint32_t>& source = lods[(i - 1) * subsets_per_lod + subsetIndex];
+				wi::vector<uint32_t>& lod = lods[i * subsets_per_lod + subsetIndex];
+
+				const size_t target_index_count = std::min(source.size(), size_t(subset.indexCount * threshold) / 3 * 3);
+				const float target_error = i - 1 < params.target_errors.size() ? params.target_errors[i - 1] : params.target_error;
+
+				lod.resize(source.size());
+				if (!source.empty())
+				{
+					if (params.sloppy)
+					{
+						lod.resize(meshopt_simplifySloppy(lod.data(), source.data(), source.size(), &vertex_positions[0].x, vertex_count, sizeof(XMFLOAT3), target_index_count, target_error));
+					}
+					else
+					{
+						lod.resize(meshopt_simplify(lod.data(), source.data(), source.size(), &vertex_positions[0].x, vertex_count, sizeof(XMFLOAT3), target_index_count, target_error));
+					}
+				}
+
+				threshold *= threshold;
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		indices.clear();
+		wi::vector<MeshSubset> lod_subsets;
+		for (size_t i = 0; i < lod_count; ++i)
+		{
+			for (uint32_t subsetIndex = 0; subsetIndex < subsets_per_lod; ++subsetIndex)
+			{
+				const wi::vector<uint32_t>& lod = lods[i * subsets_per_lod + subsetIndex];
+				MeshSubset& subset = lod_subsets.emplace_back();
+				subset = subsets[subsetIndex];
+				subset.indexOffset = (uint32_t)indices.size();
+				subset.indexCount = (uint32_t)lod.size();
+				indices.insert(indices.end(), lod.begin(), lod.end());
+			}
+		}
+		subsets = lod_subsets;
+
+		// The vertices are not reordered, so vertex indexed data outside of the mesh (eg. soft body mappings) stays valid:
+		OptimizeSubsets();
+
+		if (rebuild_meshlets)
+		{
+			BuildMeshlets();
+		}
+	}
+	void MeshComponent::OptimizationStatistics::Accumulate(const OptimizationStatistics& statistics, size_t mesh_index_count)
+	{
+		const float weight = (float)mesh_index_count;
+		acmr_before += statistics.acmr_before * weight;
+		acmr_after += statistics.acmr_after * weight;
+		atvr_before += statistics.atvr_before * weight;
+		atvr_after += statistics.atvr_after * weight;
+		overfetch_before += statistics.overfetch_before * weight;
+		overfetch_after += statistics.overfetch_after * weight;
+		index_count += mesh_index_count;
+	}
+	MeshComponent::OptimizationStatistics MeshComponent::OptimizationStatistics::GetAverage() const
+	{
+		OptimizationStatistics average;
+		if (index_count == 0)
+			return average;
+		const float weight = 1.0f / index_count;
+		average.acmr_before = acmr_before * weight;
+		average.acmr_after = acmr_after * weight;
+		average.atvr_before = atvr_before * weight;
+		average.atvr_after = atvr_after * weight;
+		average.overfetch_before = overfetch_before * weight;
+		average.overfetch_after = overfetch_after * weight;
+		average.index_count = index_count;
+		return average;
+	}
+	void MeshComponent::OptimizationStatistics::Log(const std::string& title) const
+	{
+		if (index_count == 0)
+			return;
+		const OptimizationStatistics average = GetAverage();
+		std::string str = title;
+		str += "\n\tACMR: " + std::to_string(average.acmr_before) + " -> " + std::to_string(average.acmr_after);
+		str += "\n\tATVR: " + std::to_string(average.atvr_before) + " -> " + std::to_string(average.atvr_after);
+		str += "\n\tvertex overfetch: " + std::to_string(average.overfetch_before) + " -> " + std::to_string(average.overfetch_after);
+		wi::backlog::post(str);
+	}
+	void MeshComponent::Optimize(OptimizationStatistics* statistics, wi::vector<uint32_t>* vertex_remap)
+	{
+		if (indices.empty() || vertex_positions.empty())
+			return;
+
+		// The meshlets are rebuilt once at the end, instead of by every modification:
+		const bool rebuild_meshlets = !meshlets.empty();
+		ClearMeshlets();
+
+		// https://github.com/zeux/meshoptimizer#vertex-cache-optimization
+		const size_t vertex_count = vertex_positions.size();
+		const uint32_t cache_size = 16;
+		if (statistics != nullptr)
+		{
+			const meshopt_VertexCacheStatistics vcache = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertex_count, cache_size, 0, 0);
+			const meshopt_VertexFetchStatistics vfetch = meshopt_analyzeVertexFetch(indices.data(), indices.size(), vertex_count, sizeof(Vertex_POS));
+			statistics->acmr_before = vcache.acmr;
+			statistics->atvr_before = vcache.atvr;
+			statistics->overfetch_before = vfetch.overfetch;
+		}
+
+		OptimizeSubsets();
+
+		// Reorder vertices in the order of their first use, the first LOD is first in the index buffer, so it will be the most coherent:
+		wi::vector<uint32_t> remap(vertex_count);
+		size_t used_vertex_count = meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), vertex_count);
+		for (auto& x : remap)
+		{
+			if (x == ~0u)
+			{
+				x = (uint32_t)used_vertex_count++; // unused vertices are kept at the end
+			}
+		}
+		meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+		auto remap_vertices = [&](auto& vertices) {
+			if (vertices.size() != vertex_count)
+				return;
+			auto source = vertices;
+			for (size_t i = 0; i < vertex_count; ++i)
+			{
+				vertices[remap[i]] = source[i];
+			}
+		};
+		remap_vertices(vertex_positions);
+		remap_vertices(vertex_normals);
+		remap_vertices(vertex_tangents);
+		remap_vertices(vertex_uvset_0);
+		remap_vertices(vertex_uvset_1);
+		remap_vertices(vertex_boneindices);
+		remap_vertices(vertex_boneweights);
+		remap_vertices(vertex_atlas);
+		remap_vertices(vertex_colors);
+		remap_vertices(vertex_windweights);
+		for (MorphTarget& morph : morph_targets)
+		{
+			if (morph.sparse_indices.empty())
+			{
+				remap_vertices(morph.vertex_positions);
+				remap_vertices(morph.vertex_normals);
+			}
+			else
+			{
+				for (auto& x : morph.sparse_indices)
+				{
+					x = remap[x];
+				}
+			}
+		}
+
+		if (statistics != nullptr)
+		{
+			const meshopt_VertexCacheStatistics vcache = meshopt_analyzeVertexCache(indices.data(), indices.size(), vertex_count, cache_size, 0, 0);
+			const meshopt_VertexFetchStatistics vfetch = meshopt_analyzeVertexFetch(indices.data(), indices.size(), vertex_count, sizeof(Vertex_POS));
+			statistics->acmr_after = vcache.acmr;
+			statistics->atvr_after = vcache.atvr;
+			statistics->overfetch_after = vfetch.overfetch;
+		}
+
+		if (vertex_remap != nullptr)
+		{
+			*vertex_remap = std::move(remap);
+		}
+
+		if (rebuild_meshlets)
+		{
+			BuildMeshlets();
+		}
+	}
+	void MeshComponent::OptimizeSubsets()
+	{
+		if (indices.empty() || vertex_positions.empty())
+			return;
+
+		// The triangle order can only be changed if the subsets don't share indices:
+		wi::vector<std::pair<uint32_t, uint32_t>> ranges;
+		for (const MeshSubset& subset : subsets)
+		{
+			ranges.emplace_back(subset.indexOffset, subset.indexOffset + subset.indexCount);
+		}
+		std::sort(ranges.begin(), ranges.end());
+		bool disjoint = true;
+		for (size_t i = 1; i < ranges.size(); ++i)
+		{
+			disjoint &= ranges[i - 1].second <= ranges[i].first;
+		}
+		if (!disjoint)
+			return;
+
+		// Optimize each subset for vertex cache & overdraw in parallel:
+		const size_t vertex_count = vertex_positions.size();
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)subsets.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			const MeshSubset& subset = subsets[args.jobIndex];
+			if (subset.indexCount == 0 || subset.indexOffset + subset.indexCount > indices.size())
+				return;
+			uint32_t* subset_indices = indices.data() + subset.indexOffset;
+			meshopt_optimizeVertexCache(subset_indices, subset_indices, subset.indexCount, vertex_count);
+			meshopt_optimizeOverdraw(subset_indices, subset_indices, subset.indexCount, &vertex_positions[0].x, vertex_count, sizeof(XMFLOAT3), 1.05f);
+		});
+		wi::jobsystem::Wait(ctx);
+
+		RefreshMeshlets();
+	}
+	void MeshComponent::BuildMeshlets(MeshletBuildStatistics* statistics)
+	{
+		ClearMeshlets();
+		if (indices.empty() || vertex_positions.empty())
+			return;
+
+		// https://github.com/zeux/meshoptimizer#mesh-shading
+		const size_t max_vertices = 64;
+		const size_t max_triangles = 124;
+		const float cone_weight = 0.25f;
+		const size_t vertex_count = vertex_positions.size();
+
+		struct SubsetMeshlets
+		{
+			wi::vector<Meshlet> meshlets;
+			wi::vector<uint32_t> vertices;
+			wi::vector<uint8_t> triangles;
+			wi::vector<MeshletNode> nodes;
+		};
+		wi::vector<SubsetMeshlets> results(subsets.size());
+
+		wi::jobsystem::context ctx;
+		wi::jobsystem::Dispatch(ctx, (uint32_t)subsets.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			const MeshSubset& subset = subsets[args.jobIndex];
+			if (subset.indexCount < 3 || subset.indexOffset + subset.indexCount > indices.size())
+				return;
+			SubsetMeshlets& result = results[args.jobIndex];
+			const uint32_t* subset_indices = indices.data() + subset.indexOffset;
+			const size_t index_count = subset.indexCount - subset.indexCount % 3;
+
+			const size_t max_meshlets = meshopt_buildMeshletsBound(index_count, max_vertices, max_triangles);
+			wi::vector<meshopt_Meshlet> clusters(max_meshlets);
+			result.vertices.resize(max_meshlets * max_vertices);
+			result.triangles.resize(max_meshlets * max_triangles * 3);
+			const size_t cluster_count = meshopt_buildMeshlets(clusters.data(), result.vertices.data(), result.triangles.data(), subset_indices, index_count, &vertex_positions[0].x, vertex_count, sizeof(XMFLOAT3), max_vertices, max_triangles, cone_weight);
+			if (cluster_count == 0)
+			{
+				result.vertices.clear();
+				result.triangles.clear();
+				return;
+			}
+			const meshopt_Meshlet& last = clusters[cluster_count - 1];
+			result.vertices.resize(last.vertex_offset + last.vertex_count);
+			result.triangles.resize(last.triangle_offset + ((last.triangle_count * 3 + 3) & ~3));
+
+			wi::vector<Meshlet> unordered(cluster_count);
+			wi::vector<wi::primitive::AABB> aabbs(cluster_count);
+			for (size_t i = 0; i < cluster_count; ++i)
+			{
+				const meshopt_Meshlet& cluster = clusters[i];
+
+				// The front faces are wound in the opposite direction than what meshoptimizer expects for the normal cones:
+				uint8_t flipped[max_triangles * 3];
+				for (uint32_t j = 0; j < cluster.triangle_count; ++j)
+				{
+					flipped[j * 3 + 0] = result.triangles[cluster.triangle_offset + j * 3 + 0];
+					flipped[j * 3 + 1] = result.triangles[cluster.triangle_offset + j * 3 + 2];
+					flipped[j * 3 + 2] = result.triangles[cluster.triangle_offset + j * 3 + 1];
+				}
+				const meshopt_Bounds bounds = meshopt_computeMeshletBounds(&result.vertices[cluster.vertex_offset], flipped, cluster.triangle_count, &vertex_positions[0].x, vertex_count, sizeof(XMFLOAT3));
+
+				Meshlet& meshlet = unordered[i];
+				meshlet.vertexOffset = cluster.vertex_offset;
+				meshlet.triangleOffset = cluster.triangle_offset;
+				meshlet.vertexCount = cluster.vertex_count;
+				meshlet.triangleCount = cluster.triangle_count;
+				meshlet.sphere = wi::primitive::Sphere(XMFLOAT3(bounds.center[0], bounds.center[1], bounds.center[2]), bounds.radius);
+				meshlet.cone_apex = XMFLOAT3(bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2]);
+				meshlet.cone_axis = XMFLOAT3(bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2]);
+				meshlet.cone_cutoff = bounds.cone_cutoff;
+				aabbs[i].createFromHalfWidth(meshlet.sphere.center, XMFLOAT3(bounds.radius, bounds.radius, bounds.radius));
+			}
+
+			// The meshlets are reordered, so that the leaf nodes reference contiguous ranges of them:
+			wi::BVH bvh;
+			bvh.Build(aabbs.data(), (uint32_t)cluster_count);
+			result.meshlets.resize(cluster_count);
+			for (size_t i = 0; i < cluster_count; ++i)
+			{
+				result.meshlets[i] = unordered[bvh.leaf_indices[i]];
+			}
+			result.nodes.resize(bvh.nodes.size());
+			for (size_t i = 0; i < bvh.nodes.size(); ++i)
+			{
+				const wi::BVH::Node& src = bvh.nodes[i];
+				MeshletNode& node = result.nodes[i];
+				node.aabb = src.aabb;
+				node.left = src.left;
+				node.offset = src.offset;
+				node.count = src.count;
+			}
+			// Child nodes are always after their parent, so the triangle counts can be summed in reverse order:
+			for (size_t i = result.nodes.size(); i > 0; --i)
+			{
+				MeshletNode& node = result.nodes[i - 1];
+				node.triangleCount = 0;
+				if (node.IsLeaf())
+				{
+					for (uint32_t j = node.offset; j < node.offset + node.count; ++j)
+					{
+						node.triangleCount += result.meshlets[j].triangleCount;
+					}
+				}
+				else
+				{
+					node.triangleCount = result.nodes[node.left].triangleCount + result.nodes[node.left + 1].triangleCount;
+				}
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		// Merge the subsets in order:
+		meshlet_subset_roots.resize(subsets.size(), ~0u);
+		uint64_t vertices_total = 0;
+		uint64_t triangles_total = 0;
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			SubsetMeshlets& result = results[i];
+			if (result.meshlets.empty())
+				continue;
+			const uint32_t meshlet_offset = (uint32_t)meshlets.size();
+			const uint32_t vertex_offset = (uint32_t)meshlet_vertices.size();
+			const uint32_t triangle_offset = (uint32_t)meshlet_triangles.size();
+			const uint32_t node_offset = (uint32_t)meshlet_nodes.size();
+			for (Meshlet& meshlet : result.meshlets)
+			{
+				meshlet.vertexOffset += vertex_offset;
+				meshlet.triangleOffset += triangle_offset;
+				vertices_total += meshlet.vertexCount;
+				triangles_total += meshlet.triangleCount;
+				meshlets.push_back(meshlet);
+			}
+			for (MeshletNode& node : result.nodes)
+			{
+				if (node.IsLeaf())
+				{
+					node.offset += meshlet_offset;
+				}
+				else
+				{
+					node.left += node_offset;
+				}
+				meshlet_nodes.push_back(node);
+			}
+			meshlet_vertices.insert(meshlet_vertices.end(), result.vertices.begin(), result.vertices.end());
+			meshlet_triangles.insert(meshlet_triangles.end(), result.triangles.begin(), result.triangles.end());
+			meshlet_subset_roots[i] = node_offset;
+		}
+		meshlet_source_vertex_count = (uint32_t)vertex_count;
+		meshlet_source_index_count = (uint32_t)indices.size();
+
+		if (statistics != nullptr)
+		{
+			statistics->meshlet_count = (uint32_t)meshlets.size();
+			statistics->node_count = (uint32_t)meshlet_nodes.size();
+			statistics->vertices_per_meshlet = meshlets.empty() ? 0 : float(vertices_total) / float(meshlets.size());
+			statistics->triangles_per_meshlet = meshlets.empty() ? 0 : float(triangles_total) / float(meshlets.size());
+		}
+	}
+	void MeshComponent::CullMeshlets(
+		uint32_t subsetIndex,
+		const Frustum& frustum,
+		const XMFLOAT3& camera_position,
+		bool backface_culling,
+		wi::vector<uint32_t>& visible_meshlets,
+		MeshletCullStatistics* statistics
+	) const
+	{
+		if (!HasMeshlets() || subsetIndex >= meshlet_subset_roots.size() || meshlet_subset_roots[subsetIndex] >= meshlet_nodes.size())
+			return;
+
+		const uint32_t root = meshlet_subset_roots[subsetIndex];
+		if (statistics != nullptr)
+		{
+			statistics->triangles_total += meshlet_nodes[root].triangleCount;
+		}
+
+		const XMVECTOR C = XMLoadFloat3(&camera_position);
+		uint32_t stack[64];
+		uint32_t stack_count = 0;
+		stack[stack_count++] = root;
+		while (stack_count > 0)
+		{
+			const MeshletNode& node = meshlet_nodes[stack[--stack_count]];
+			if (statistics != nullptr)
+			{
+				statistics->nodes_tested++;
+			}
+			if (!frustum.CheckBoxFast(node.aabb))
+			{
+				if (statistics != nullptr)
+				{
+					statistics->triangles_frustum_culled += node.triangleCount;
+				}
+				continue;
+			}
+			if (!node.IsLeaf())
+			{
+				stack[stack_count++] = node.left;
+				stack[stack_count++] = node.left + 1;
+				continue;
+			}
+
+			for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+			{
+				const Meshlet& meshlet = meshlets[i];
+				if (statistics != nullptr)
+				{
+					statistics->meshlets_tested++;
+				}
+				if (!frustum.CheckSphere(meshlet.sphere.center, meshlet.sphere.radius))
+				{
+					if (statistics != nullptr)
+					{
+						statistics->triangles_frustum_culled += meshlet.triangleCount;
+					}
+					continue;
+				}
+				if (backface_culling)
+				{
+					// All triangles are back facing if the view direction to the cone apex is inside the normal cone:
+					const XMVECTOR V = XMVector3Normalize(XMLoadFloat3(&meshlet.cone_apex) - C);
+					if (XMVectorGetX(XMVector3Dot(V, XMLoadFloat3(&meshlet.cone_axis))) >= meshlet.cone_cutoff)
+					{
+						if (statistics != nullptr)
+						{
+							statistics->triangles_backface_culled += meshlet.triangleCount;
+						}
+						continue;
+					}
+				}
+				visible_meshlets.push_back(i);
+			}
+		}
+	}
+
+	// Hashes the mesh data that the atlas depends on, the current atlas is included so modified atlases are not skipped
+	static uint64_t HashAtlasInput(const MeshComponent& mesh, uint32_t resolution)
+	{
+		uint64_t hash = wi::helper::hash_fnv1a(&resolution, sizeof(resolution));
+		auto hash_data = [&](const void* data, size_t size) {
+			const uint64_t size64 = size;
+			hash = wi::helper::hash_fnv1a(&size64, sizeof(size64), hash);
+			hash = wi::helper::hash_fnv1a(data, size, hash);
+		};
+		hash_data(mesh.vertex_positions.data(), mesh.vertex_positions.size() * sizeof(XMFLOAT3));
+		hash_data(mesh.vertex_normals.data(), mesh.vertex_normals.size() * sizeof(XMFLOAT3));
+		hash_data(mesh.vertex_uvset_0.data(), mesh.vertex_uvset_0.size() * sizeof(XMFLOAT2));
+		hash_data(mesh.vertex_atlas.data(), mesh.vertex_atlas.size() * sizeof(XMFLOAT2));
+		hash_data(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+		return hash;
+	}
+	static bool GenerateAtlasEntry(const MeshComponent& mesh, uint32_t resolution, MeshComponent::AtlasCache::Entry& entry)
+	{
+		entry.vertex_count = (uint32_t)mesh.vertex_positions.size();
+		entry.index_count = (uint32_t)mesh.indices.size();
+		if (mesh.vertex_positions.empty() || mesh.indices.empty())
+			return false;
+
+		xatlas::Atlas* atlas = xatlas::Create();
+
+		xatlas::MeshDecl decl;
+		decl.vertexCount = (uint32_t)mesh.vertex_positions.size();
+		decl.vertexPositionData = mesh.vertex_positions.data();
+		decl.vertexPositionStride = sizeof(XMFLOAT3);
+		if (mesh.vertex_normals.size() == mesh.vertex_positions.size())
+		{
+			decl.vertexNormalData = mesh.vertex_normals.data();
+			decl.vertexNormalStride = sizeof(XMFLOAT3);
+		}
+		if (mesh.vertex_uvset_0.size() == mesh.vertex_positions.size())
+		{
+			decl.vertexUvData = mesh.vertex_uvset_0.data();
+			decl.vertexUvStride = sizeof(XMFLOAT2);
+		}
+		decl.indexCount = (uint32_t)mesh.indices.size();
+		decl.indexData = mesh.indices.data();
+		decl.indexFormat = xatlas::IndexFormat::UInt32;
+		xatlas::AddMeshError::Enum error = xatlas::AddMesh(atlas, decl);
+		if (error != xatlas::AddMeshError::Success)
+		{
+			wi::backlog::post(std::string("Adding mesh to xatlas failed: ") + xatlas::StringForEnum(error), wi::backlog::LogLevel::Warning);
+			xatlas::Destroy(atlas);
+			return false;
+		}
+
+		xatlas::ChartOptions chartoptions;
+		xatlas::ParameterizeOptions parametrizeoptions;
+		xatlas::PackOptions packoptions;
+		packoptions.resolution = resolution;
+		packoptions.blockAlign = true;
+		xatlas::Generate(atlas, chartoptions, parametrizeoptions, packoptions);
+
+		const xatlas::Mesh& output = atlas->meshes[0];
+		entry.width = atlas->width;
+		entry.height = atlas->height;
+		entry.indices.assign(output.indexArray, output.indexArray + output.indexCount);
+		entry.xrefs.resize(output.vertexCount);
+		entry.atlas.resize(output.vertexCount);
+		for (uint32_t i = 0; i < output.vertexCount; ++i)
+		{
+			const xatlas::Vertex& v = output.vertexArray[i];
+			entry.xrefs[i] = v.xref;
+			entry.atlas[i] = XMFLOAT2(v.uv[0] / float(entry.width), v.uv[1] / float(entry.height));
+		}
+
+		xatlas::Destroy(atlas);
+		return entry.width > 0 && entry.height > 0;
+	}
+	static void ApplyAtlasEntry(MeshComponent& mesh, const MeshComponent::AtlasCache::Entry& entry)
+	{
+		// Note: the atlas can split vertices along the chart seams, so all vertex streams are recreated from their source vertices
+		const size_t vertex_count = mesh.vertex_positions.size();
+		auto remap_vertices = [&](auto& vertices) {
+			if (vertices.size() != vertex_count)
+				return;
+			auto source = std::move(vertices);
+			vertices.resize(entry.xrefs.size());
+			for (size_t i = 0; i < entry.xrefs.size(); ++i)
+			{
+				vertices[i] = source[entry.xrefs[i]];
+			}
+		};
+		remap_vertices(mesh.vertex_positions);
+		remap_vertices(mesh.vertex_normals);
+		remap_vertices(mesh.vertex_tangents);
+		remap_vertices(mesh.vertex_uvset_0);
+		remap_vertices(mesh.vertex_uvset_1);
+		remap_vertices(mesh.vertex_boneindices);
+		remap_vertices(mesh.vertex_boneweights);
+		remap_vertices(mesh.vertex_colors);
+		remap_vertices(mesh.vertex_windweights);
+		for (MeshComponent::MorphTarget& morph : mesh.morph_targets)
+		{
+			if (morph.sparse_indices.empty())
+			{
+				remap_vertices(morph.vertex_positions);
+				remap_vertices(morph.vertex_normals);
+			}
+			else
+			{
+				// Every split copy of a targeted vertex is targeted too:
+				wi::vector<uint32_t> sparse_lookup(vertex_count, ~0u);
+				for (size_t i = 0; i < morph.sparse_indices.size(); ++i)
+				{
+					sparse_lookup[morph.sparse_indices[i]] = (uint32_t)i;
+				}
+				wi::vector<uint32_t> sparse_indices;
+				wi::vector<XMFLOAT3> positions;
+				wi::vector<XMFLOAT3> normals;
+				for (size_t i = 0; i < entry.xrefs.size(); ++i)
+				{
+					const uint32_t index = sparse_lookup[entry.xrefs[i]];
+					if (index == ~0u)
+						continue;
+					sparse_indices.push_back((uint32_t)i);
+					if (index < morph.vertex_positions.size())
+					{
+						positions.push_back(morph.vertex_positions[index]);
+					}
+					if (index < morph.vertex_normals.size())
+					{
+						normals.push_back(morph.vertex_normals[index]);
+					}
+				}
+				morph.sparse_indices = std::move(sparse_indices);
+				morph.vertex_positions = std::move(positions);
+				morph.vertex_normals = std::move(normals);
+			}
+		}
+		mesh.vertex_atlas = entry.atlas;
+		mesh.indices = entry.indices;
+	}
+	void MeshComponent::GenerateAtlases(
+		MeshComponent* const* meshes,
+		size_t count,
+		uint32_t resolution,
+		XMUINT2* dimensions,
+		AtlasCache* cache,
+		AtlasGenerationStatistics* statistics
+	)
+	{
+		wi::jobsystem::context ctx;
+		const uint64_t use = cache == nullptr ? 0 : ++cache->use_count;
+
+		wi::vector<uint64_t> hashes(count);
+		wi::jobsystem::Dispatch(ctx, (uint32_t)count, 1, [&](wi::jobsystem::JobArgs args) {
+			hashes[args.jobIndex] = HashAtlasInput(*meshes[args.jobIndex], resolution);
+		});
+		wi::jobsystem::Wait(ctx);
+
+		// Find the results in the cache, equal meshes that are not in the cache will be generated only once:
+		enum RESULT
+		{
+			RESULT_NONE, // the mesh was already processed in this call
+			RESULT_CACHED,
+			RESULT_GENERATED,
+		};
+		wi::vector<RESULT> result_types(count, RESULT_NONE);
+		wi::vector<const AtlasCache::Entry*> cached_entries(count);
+		wi::vector<uint32_t> generated_indices(count);
+		wi::vector<AtlasCache::Entry> generated_entries;
+		wi::vector<uint32_t> generated_sources; // the mesh that each generated entry is generated from
+		wi::unordered_map<uint64_t, uint32_t> generated_lookup;
+		wi::unordered_set<const MeshComponent*> visited;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const MeshComponent& mesh = *meshes[i];
+			if (!visited.insert(&mesh).second)
+				continue;
+			if (cache != nullptr)
+			{
+				auto it = cache->entries.find(hashes[i]);
+				if (it != cache->entries.end() && it->second.vertex_count == mesh.vertex_positions.size() && it->second.index_count == mesh.indices.size())
+				{
+					it->second.last_used = use;
+					result_types[i] = RESULT_CACHED;
+					cached_entries[i] = &it->second;
+					continue;
+				}
+			}
+			auto it = generated_lookup.find(hashes[i]);
+			if (it == generated_lookup.end())
+			{
+				it = generated_lookup.insert({ hashes[i], (uint32_t)generated_entries.size() }).first;
+				generated_entries.emplace_back();
+				generated_sources.push_back((uint32_t)i);
+			}
+			result_types[i] = RESULT_GENERATED;
+			generated_indices[i] = it->second;
+		}
+
+		wi::vector<uint8_t> generated_success(generated_entries.size());
+		wi::jobsystem::Dispatch(ctx, (uint32_t)generated_entries.size(), 1, [&](wi::jobsystem::JobArgs args) {
+			generated_success[args.jobIndex] = GenerateAtlasEntry(*meshes[generated_sources[args.jobIndex]], resolution, generated_entries[args.jobIndex]) ? 1 : 0;
+		});
+		wi::jobsystem::Wait(ctx);
+
+		// Remap the meshes, the new hashes will identify them as up to date in the cache:
+		wi::vector<uint64_t> output_hashes(count);
+		wi::jobsystem::Dispatch(ctx, (uint32_t)count, 1, [&](wi::jobsystem::JobArgs args) {
+			const uint32_t i = args.jobIndex;
+			const AtlasCache::Entry* entry = nullptr;
+			if (result_types[i] == RESULT_CACHED)
+			{
+				entry = cached_entries[i];
+			}
+			else if (result_types[i] == RESULT_GENERATED && generated_success[generated_indices[i]])
+			{
+				entry = &generated_entries[generated_indices[i]];
+			}
+			if (entry == nullptr || entry->xrefs.empty())
+				return;
+			ApplyAtlasEntry(*meshes[i], *entry);
+			if (cache != nullptr)
+			{
+				output_hashes[i] = HashAtlasInput(*meshes[i], resolution);
+			}
+		});
+		wi::jobsystem::Wait(ctx);
+
+		AtlasGenerationStatistics stats;
+		wi::vector<std::pair<uint64_t, AtlasCache::Entry>> uptodate_entries;
+		stats.mesh_count = (uint32_t)count;
+		stats.generated_count = (uint32_t)std::count(generated_success.begin(), generated_success.end(), uint8_t(1));
+		for (size_t i = 0; i < count; ++i)
+		{
+			const AtlasCache::Entry* entry = nullptr;
+			if (result_types[i] == RESULT_CACHED)
+			{
+				entry = cached_entries[i];
+				if (entry->xrefs.empty())
+				{
+					stats.skipped_count++;
+				}
+				else
+				{
+					stats.reused_count++;
+				}
+			}
+			else if (result_types[i] == RESULT_GENERATED)
+			{
+				if (generated_success[generated_indices[i]])
+				{
+					entry = &generated_entries[generated_indices[i]];
+					if (generated_sources[generated_indices[i]] != i)
+					{
+						stats.reused_count++;
+					}
+				}
+				else
+				{
+					stats.failed_count++;
+				}
+			}
+			else
+			{
+				// The same mesh was given multiple times, the first occurence was processed:
+				auto it = std::find(meshes, meshes + i, meshes[i]);
+				if (dimensions != nullptr)
+				{
+					dimensions[i] = dimensions[it - meshes];
+				}
+				continue;
+			}
+
+			if (dimensions != nullptr)
+			{
+				dimensions[i] = entry == nullptr ? XMUINT2(0, 0) : XMUINT2(entry->width, entry->height);
+			}
+			if (entry != nullptr && !entry->xrefs.empty())
+			{
+				MeshComponent& mesh = *meshes[i];
+				mesh.RefreshMeshlets();
+				if (cache != nullptr)
+				{
+					auto& [hash, uptodate] = uptodate_entries.emplace_back();
+					hash = output_hashes[i];
+					uptodate.width = entry->width;
+					uptodate.height = entry->height;
+					uptodate.vertex_count = (uint32_t)mesh.vertex_positions.size();
+					uptodate.index_count = (uint32_t)mesh.indices.size();
+				}
+			}
+		}
+
+		// The cached entries are not referenced anymore, so the cache can be modified
+		//	The generated charts are not inserted, they were applied to every mesh that had the same data, so that data doesn't exist anymore:
+		if (cache != nullptr)
+		{
+			for (auto& [hash, uptodate] : uptodate_entries)
+			{
+				uptodate.last_used = use;
+				cache->entries[hash] = std::move(uptodate);
+			}
+
+			// Entries of meshes that were modified or removed since are never used again, the least recently used ones are removed above the limit:
+			if (cache->max_entries > 0 && cache->entries.size() > cache->max_entries)
+			{
+				wi::vector<std::pair<uint64_t, uint64_t>> ages; // last use, hash
+				ages.reserve(cache->entries.size());
+				for (auto& [hash, entry] : cache->entries)
+				{
+					ages.push_back(std::make_pair(entry.last_used, hash));
+				}
+				const size_t remove_count = cache->entries.size() - cache->max_entries;
+				std::nth_element(ages.begin(), ages.begin() + remove_count, ages.end());
+				for (size_t i = 0; i < remove_count; ++i)
+				{
+					cache->entries.erase(ages[i].second);
+				}
+			}
+		}
+
+		if (statistics != nullptr)
+		{
+			*statistics = stats;
+		}
+	}
+	XMUINT2 MeshComponent::GenerateAtlas(uint32_t resolution, AtlasCache* cache)
+	{
+		MeshComponent* mesh = this;
+		XMUINT2 dimensions = XMUINT2(0, 0);
+		GenerateAtlases(&mesh, 1, resolution, &dimensions, cache);
+		return dimensions;
+	}
 
 	void ObjectComponent::ClearLightmap()
 	{
@@ -1437,6 +2424,33 @@ namespace wi::scene
 			std::fill(weights.begin(), weights.end(), 1.0f);
 		}
 	}
+	void SoftBodyPhysicsComponent::RemapGraphicsVertices(const wi::vector<uint32_t>& vertex_remap)
+	{
+		// The physics vertices and their weights keep their order, only the graphics vertex indices change:
+		for (auto& x : physicsToGraphicsVertexMapping)
+		{
+			if (x < vertex_remap.size())
+			{
+				x = vertex_remap[x];
+			}
+		}
+		auto remap_vertices = [&](auto& vertices) {
+			if (vertices.size() != vertex_remap.size())
+				return;
+			auto source = vertices;
+			for (size_t i = 0; i < vertex_remap.size(); ++i)
+			{
+				vertices[vertex_remap[i]] = source[i];
+			}
+		};
+		remap_vertices(graphicsToPhysicsVertexMapping);
+		remap_vertices(vertex_positions_simulation);
+		remap_vertices(vertex_tangents_tmp);
+		remap_vertices(vertex_tangents_simulation);
+
+		// The physics mesh was created with the old graphics indices:
+		physicsobject = nullptr;
+	}
 
 	void CameraComponent::CreatePerspective(float newWidth, float newHeight, float newNear, float newFar, float newFOV)
 	{
@@ -12,6 +12,7 @@
 #include "wiArchive.h"
 #include "wiRectPacker.h"
 #include "wiUnorderedSet.h"
+#include "wiUnorderedMap.h"
 
 namespace wi::scene
 {
@@ -326,6 +327,7 @@ namespace wi::scene
 			_DEPRECATED_DIRTY_MORPH = 1 << 4,
 			_DEPRECATED_DIRTY_BINDLESS = 1 << 5,
 			TLAS_FORCE_DOUBLE_SIDED = 1 << 6,
+			QUANTIZED_POSITIONS = 1 << 7,
 		};
 		uint32_t _flags = RENDERABLE;
 
@@ -361,11 +363,43 @@ namespace wi::scene
 			wi::vector<XMFLOAT3> vertex_normals;
 			wi::vector<uint32_t> sparse_indices; // optional, these can be used to target vertices indirectly
 			float weight = 0;
+
+			// Non-serialized attributes:
+			wi::primitive::AABB aabb; // bounds of the position offsets, including zero offset
 		};
 		wi::vector<MorphTarget> morph_targets;
 
 		uint32_t subsets_per_lod = 0; // this needs to be specified if there are multiple LOD levels
 
+		// Meshlet cluster hierarchy, created by BuildMeshlets():
+		struct Meshlet
+		{
+			uint32_t vertexOffset = 0; // offset into meshlet_vertices
+			uint32_t triangleOffset = 0; // offset into meshlet_triangles
+			uint32_t vertexCount = 0;
+			uint32_t triangleCount = 0;
+			wi::primitive::Sphere sphere; // bounding sphere
+			XMFLOAT3 cone_apex = XMFLOAT3(0, 0, 0);
+			XMFLOAT3 cone_axis = XMFLOAT3(0, 0, 0);
+			float cone_cutoff = 1; // cosine of the normal cone half angle
+		};
+		struct MeshletNode
+		{
+			wi::primitive::AABB aabb; // bounds of all meshlets below this node
+			uint32_t left = 0; // index of the left child node, the right child node is left + 1
+			uint32_t offset = 0; // offset into meshlets for leaf nodes
+			uint32_t count = 0; // number of meshlets for leaf nodes, interior nodes have zero
+			uint32_t triangleCount = 0; // number of triangles below this node
+			constexpr bool IsLeaf() const { return count > 0; }
+		};
+		wi::vector<Meshlet> meshlets; // the meshlets of a subset are in a contiguous range
+		wi::vector<uint32_t> meshlet_vertices; // indices into the vertex arrays
+		wi::vector<uint8_t> meshlet_triangles; // three indices into the meshlet's vertices per triangle
+		wi::vector<MeshletNode> meshlet_nodes;
+		wi::vector<uint32_t> meshlet_subset_roots; // root node index for every subset, ~0u if the subset has no meshlets
+		uint32_t meshlet_source_vertex_count = 0; // vertex count of the mesh when the meshlets were built
+		uint32_t meshlet_source_index_count = 0; // index count of the mesh when the meshlets were built
+
 		// Non-serialized attributes:
 		wi::primitive::AABB aabb;
 		wi::graphics::GPUBuffer generalBuffer; // index buffer + all static vertex buffers
@@ -394,6 +428,7 @@ namespace wi::scene
 		BufferView so_pos_nor_wind;
 		BufferView so_tan;
 		BufferView so_pre;
+		BufferView blas_transform; // dequantization transform of Vertex_POS16 for the BLAS
 		wi::vector<uint8_t> vertex_subsets;
 		uint32_t geometryOffset = 0;
 		uint32_t meshletCount = 0;
@@ -409,13 +444,21 @@ namespace wi::scene
 
 		mutable bool dirty_morph = false;
 
+		float quantization_threshold = 0.001f; // the largest position error in object space that is accepted for quantized positions
+		bool positions_quantized = false; // whether vb_pos_nor_wind contains Vertex_POS16 instead of Vertex_POS
+		bool full_precision_required = false; // set by the scene while particles, soft bodies or lightmap rendering read the vertices, quantization is skipped while it's set
+
 		inline void SetRenderable(bool value) { if (value) { _flags |= RENDERABLE; } else { _flags &= ~RENDERABLE; } }
 		inline void SetDoubleSided(bool value) { if (value) { _flags |= DOUBLE_SIDED; } else { _flags &= ~DOUBLE_SIDED; } }
 		inline void SetDynamic(bool value) { if (value) { _flags |= DYNAMIC; } else { _flags &= ~DYNAMIC; } }
+		// Allows CreateRenderData() to store quantized positions and normals (Vertex_POS16) when the position error is below quantization_threshold
+		//	Meshes with morph targets, skinning or wind weights are always stored in full precision
+		inline void SetQuantizedPositions(bool value) { if (value) { _flags |= QUANTIZED_POSITIONS; } else { _flags &= ~QUANTIZED_POSITIONS; } }
 
 		inline bool IsRenderable() const { return _flags & RENDERABLE; }
 		inline bool IsDoubleSided() const { return _flags & DOUBLE_SIDED; }
 		inline bool IsDynamic() const { return _flags & DYNAMIC; }
+		inline bool IsQuantizedPositions() const { return _flags & QUANTIZED_POSITIONS; }
 
 		inline float GetTessellationFactor() const { return tessellationFactor; }
 		inline wi::graphics::IndexBufferFormat GetIndexFormat() const { return vertex_positions.size() > 65536 ? wi::graphics::IndexBufferFormat::UINT32 : wi::graphics::IndexBufferFormat::UINT16; }
@@ -436,6 +479,8 @@ namespace wi::scene
 
 		// Recreates GPU resources for index/vertex buffers
 		void CreateRenderData();
+		// Returns whether the positions and normals can be stored as Vertex_POS16 within quantization_threshold, and the largest position error if requested
+		bool CanQuantizePositions(float* max_error = nullptr) const;
 		void CreateStreamoutRenderData();
 
 		enum COMPUTE_NORMALS
@@ -451,6 +496,153 @@ namespace wi::scene
 		void RecenterToBottom();
 		wi::primitive::Sphere GetBoundingSphere() const;
 
+		struct LODGenerationParams
+		{
+			uint32_t lod_count = 6; // number of levels of detail, including the original
+			float quality = 0.5f; // lower values will make the levels more aggressively simplified
+			float target_error = 0.03f; // error limit relative to the mesh extents, lower values will make more precise levels
+			wi::vector<float> target_errors; // optional error limit for each level after the original, target_error is used for levels that are not specified
+			bool sloppy = false; // faster simplification, but it doesn't preserve the topology
+		};
+		// Generates levels of detail from the first level by simplifying its subsets in parallel
+		//	The levels are optimized with OptimizeSubsets(), the vertices are not modified
+		//	Render data is not recreated by this, call CreateRenderData() after
+		void GenerateLODs(const LODGenerationParams& params);
+
+		struct OptimizationStatistics
+		{
+			float acmr_before = 0; // average cache miss ratio: transformed vertices / triangle count
+			float acmr_after = 0;
+			float atvr_before = 0; // average transformed vertex ratio: transformed vertices / vertex count
+			float atvr_after = 0;
+			float overfetch_before = 0; // fetched bytes / vertex buffer size
+			float overfetch_after = 0;
+			size_t index_count = 0; // total index count of the accumulated statistics
+
+			// Adds the statistics of a mesh, weighted by its index count
+			void Accumulate(const OptimizationStatistics& statistics, size_t mesh_index_count);
+			// Returns the accumulated statistics averaged by index count
+			OptimizationStatistics GetAverage() const;
+			// Posts the averaged statistics to the backlog, if anything was accumulated
+			void Log(const std::string& title) const;
+		};
+		// Optimizes the triangle order of subsets in parallel for vertex cache and overdraw, then reorders the vertices for vertex fetch
+		//	All vertex streams and morph targets are reordered together, the rendered geometry doesn't change
+		//	vertex_remap: optional output that receives the new index of every old vertex, data indexed by vertex (eg. SoftBodyPhysicsComponent) must be remapped with it
+		//	Render data is not recreated by this, call CreateRenderData() after
+		void Optimize(OptimizationStatistics* statistics = nullptr, wi::vector<uint32_t>* vertex_remap = nullptr);
+		// Optimizes only the triangle order of subsets in parallel for vertex cache and overdraw, the vertices are not modified
+		void OptimizeSubsets();
+
+		struct MeshletBuildStatistics
+		{
+			uint32_t meshlet_count = 0;
+			uint32_t node_count = 0;
+			float vertices_per_meshlet = 0;
+			float triangles_per_meshlet = 0;
+		};
+		// Clusters the subsets into meshlets with bounding spheres and normal cones in parallel, then builds a bounding volume hierarchy over the meshlets of each subset
+		//	The meshlets reference the indices and vertices, so they need to be rebuilt when those are modified
+		//	The MeshComponent functions that modify the indices or vertex positions rebuild them with RefreshMeshlets()
+		void BuildMeshlets(MeshletBuildStatistics* statistics = nullptr);
+		inline bool HasMeshlets() const
+		{
+			return
+				!meshlets.empty() &&
+				meshlet_subset_roots.size() == subsets.size() &&
+				meshlet_source_vertex_count == (uint32_t)vertex_positions.size() &&
+				meshlet_source_index_count == (uint32_t)indices.size();
+		}
+		inline void ClearMeshlets()
+		{
+			meshlets.clear();
+			meshlet_vertices.clear();
+			meshlet_triangles.clear();
+			meshlet_nodes.clear();
+			meshlet_subset_roots.clear();
+			meshlet_source_vertex_count = 0;
+			meshlet_source_index_count = 0;
+		}
+		// Rebuilds the meshlets if there were any, call it after the indices or vertex positions were modified
+		inline void RefreshMeshlets()
+		{
+			if (!meshlets.empty())
+			{
+				BuildMeshlets();
+			}
+		}
+
+		struct MeshletCullStatistics
+		{
+			uint32_t nodes_tested = 0;
+			uint32_t meshlets_tested = 0;
+			uint32_t triangles_total = 0;
+			uint32_t triangles_frustum_culled = 0;
+			uint32_t triangles_backface_culled = 0;
+		};
+		// Appends the indices of the meshlets of a subset that are not culled to visible_meshlets
+		//	frustum: in the local space of the mesh, it can be created from the world * view * projection matrix
+		//	camera_position: in the local space of the mesh
+		//	backface_culling: cull meshlets that only have back facing triangles by their normal cones, it must be disabled for double sided materials
+		//	statistics: if not nullptr, the results are accumulated into it
+		void CullMeshlets(
+			uint32_t subsetIndex,
+			const wi::primitive::Frustum& frustum,
+			const XMFLOAT3& camera_position,
+			bool backface_culling,
+			wi::vector<uint32_t>& visible_meshlets,
+			MeshletCullStatistics* statistics = nullptr
+		) const;
+
+		// Results of GenerateAtlases() that can be reused, keyed by the hash of the mesh data that the atlas depends on
+		//	Meshes that were not modified since their atlas was generated are skipped
+		//	The charts of a mesh are not kept after they were applied, because the mesh data they were generated from doesn't exist anymore
+		//	It must not be used by multiple GenerateAtlases() calls at the same time
+		struct AtlasCache
+		{
+			struct Entry
+			{
+				uint32_t width = 0; // atlas width in texels
+				uint32_t height = 0; // atlas height in texels
+				uint32_t vertex_count = 0; // vertex count of the mesh before remapping
+				uint32_t index_count = 0;
+				uint64_t last_used = 0; // the GenerateAtlases() call that last used this entry
+				wi::vector<uint32_t> xrefs; // source vertex of each output vertex, empty if the mesh already contains this atlas
+				wi::vector<uint32_t> indices; // output indices
+				wi::vector<XMFLOAT2> atlas; // output atlas coordinates
+			};
+			wi::unordered_map<uint64_t, Entry> entries;
+			size_t max_entries = 4096; // the least recently used entries are removed above this count, 0 means no limit
+			uint64_t use_count = 0; // number of GenerateAtlases() calls that used the cache
+
+			inline void Clear() { entries.clear(); }
+		};
+		struct AtlasGenerationStatistics
+		{
+			uint32_t mesh_count = 0;
+			uint32_t generated_count = 0; // number of atlases that were generated by xatlas
+			uint32_t reused_count = 0; // meshes that reused the charts of an equal mesh
+			uint32_t skipped_count = 0; // meshes that already contained their cached atlas
+			uint32_t failed_count = 0;
+		};
+		// Generates lightmap atlases into vertex_atlas for many meshes in parallel with xatlas
+		//	Vertices are split along chart seams, so the vertex streams and indices are remapped, the triangle order and subsets are unchanged
+		//	resolution: the approximate atlas resolution in texels
+		//	dimensions: if not nullptr, it receives the atlas size of each mesh in texels, which is zero if the generation failed
+		//	cache: if not nullptr, results are reused from it and new results are stored in it
+		//	Render data is not recreated by this, call CreateRenderData() after
+		static void GenerateAtlases(
+			MeshComponent* const* meshes,
+			size_t count,
+			uint32_t resolution,
+			XMUINT2* dimensions = nullptr,
+			AtlasCache* cache = nullptr,
+			AtlasGenerationStatistics* statistics = nullptr
+		);
+		// Generates the lightmap atlas of this mesh, see GenerateAtlases()
+		//	Returns the atlas size in texels, which is zero if the generation failed
+		XMUINT2 GenerateAtlas(uint32_t resolution, AtlasCache* cache = nullptr);
+
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 
 
@@ -509,6 +701,73 @@ namespace wi::scene
 
 			static const wi::graphics::Format FORMAT = wi::graphics::Format::R32G32B32A32_FLOAT;
 		};
+		// Quantized position and normal, without wind weight
+		//	The position is 16-bit normalized within the mesh AABB, the normal is octahedral encoded into 8+8 bits
+		struct Vertex_POS16
+		{
+			int16_t x = 0;
+			int16_t y = 0;
+			int16_t z = 0;
+			uint16_t normal = 0;
+
+			void FromFULL(const wi::primitive::AABB& aabb, const XMFLOAT3& _pos, const XMFLOAT3& _nor)
+			{
+				const XMFLOAT3 center = aabb.getCenter();
+				const XMFLOAT3 extent = aabb.getHalfWidth();
+				x = Quantize(_pos.x, center.x, extent.x);
+				y = Quantize(_pos.y, center.y, extent.y);
+				z = Quantize(_pos.z, center.z, extent.z);
+
+				// octahedral projection, the lower hemisphere is folded over the diagonals:
+				const float len = std::abs(_nor.x) + std::abs(_nor.y) + std::abs(_nor.z);
+				float u = len > 0 ? _nor.x / len : 0;
+				float v = len > 0 ? _nor.y / len : 0;
+				if (_nor.z < 0)
+				{
+					const float fu = (1 - std::abs(v)) * (u >= 0 ? 1 : -1);
+					const float fv = (1 - std::abs(u)) * (v >= 0 ? 1 : -1);
+					u = fu;
+					v = fv;
+				}
+				normal = 0;
+				normal |= (uint16_t)std::round(wi::math::saturate(u * 0.5f + 0.5f) * 255.0f) << 0;
+				normal |= (uint16_t)std::round(wi::math::saturate(v * 0.5f + 0.5f) * 255.0f) << 8;
+			}
+			inline XMFLOAT3 GetPos_FULL(const wi::primitive::AABB& aabb) const
+			{
+				const XMFLOAT3 center = aabb.getCenter();
+				const XMFLOAT3 extent = aabb.getHalfWidth();
+				return XMFLOAT3(
+					center.x + std::max(-1.0f, x / 32767.0f) * extent.x,
+					center.y + std::max(-1.0f, y / 32767.0f) * extent.y,
+					center.z + std::max(-1.0f, z / 32767.0f) * extent.z
+				);
+			}
+			inline XMFLOAT3 GetNor_FULL() const
+			{
+				XMFLOAT3 nor_FULL;
+				nor_FULL.x = (float)((normal >> 0) & 0xFF) / 255.0f * 2.0f - 1.0f;
+				nor_FULL.y = (float)((normal >> 8) & 0xFF) / 255.0f * 2.0f - 1.0f;
+				nor_FULL.z = 1 - std::abs(nor_FULL.x) - std::abs(nor_FULL.y);
+				if (nor_FULL.z < 0)
+				{
+					const float fx = (1 - std::abs(nor_FULL.y)) * (nor_FULL.x >= 0 ? 1 : -1);
+					const float fy = (1 - std::abs(nor_FULL.x)) * (nor_FULL.y >= 0 ? 1 : -1);
+					nor_FULL.x = fx;
+					nor_FULL.y = fy;
+				}
+				XMStoreFloat3(&nor_FULL, XMVector3Normalize(XMLoadFloat3(&nor_FULL)));
+				return nor_FULL;
+			}
+			static inline int16_t Quantize(float value, float center, float extent)
+			{
+				if (extent <= 0)
+					return 0;
+				return (int16_t)std::round(wi::math::Clamp((value - center) / extent, -1.0f, 1.0f) * 32767.0f);
+			}
+
+			static const wi::graphics::Format FORMAT = wi::graphics::Format::R16G16B16A16_SNORM;
+		};
 		struct Vertex_TEX
 		{
 			XMHALF2 tex = XMHALF2(0.0f, 0.0f);
@@ -598,6 +857,9 @@ namespace wi::scene
 		wi::vector<Vertex_POS> vertex_positions_morphed;
 		wi::vector<XMFLOAT3> morph_temp_pos;
 		wi::vector<XMFLOAT3> morph_temp_nor;
+		wi::vector<float> morph_weights_applied; // the morph target weights that are accumulated in morph_temp_pos and morph_temp_nor
+		uint32_t morph_update_count = 0; // incremental morph updates since morph_temp_pos and morph_temp_nor were rebuilt
+		wi::primitive::AABB morph_aabb_rest; // bounds of the mesh without morph targets
 
 	};
 
@@ -611,10 +873,11 @@ namespace wi::scene
 		uint32_t _flags = DIRTY;
 
 		float swapInDistance = 100.0f;
+		uint32_t resolution = 128; // texture resolution of one capture angle in the impostor atlas
 
 		// Non-serialized attributes:
 		mutable bool render_dirty = false;
-		int textureIndex = -1;
+		wi::rectpacker::Rect atlas_rect = {}; // region of all capture angles in the impostor atlas, in IMPOSTOR_ATLAS_GRANULARITY units
 
 		inline void SetDirty(bool value = true) { if (value) { _flags |= DIRTY; } else { _flags &= ~DIRTY; } }
 		inline bool IsDirty() const { return _flags & DIRTY; }
@@ -801,6 +1064,10 @@ namespace wi::scene
 		// Create physics represenation of graphics mesh
 		void CreateFromMesh(const MeshComponent& mesh);
 
+		// Applies a reordering of the graphics vertices (eg. from MeshComponent::Optimize()) and recreates the physics object
+		//	vertex_remap: the new index of every old graphics vertex
+		void RemapGraphicsVertices(const wi::vector<uint32_t>& vertex_remap);
+
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
 
@@ -6,6 +6,7 @@
 #include "wiBacklog.h"
 #include "wiTimer.h"
 #include "wiVector.h"
+#include "wiPhysics.h"
 #include "shaders/ShaderInterop_DDGI.h"
 
 using namespace wi::ecs;
@@ -427,6 +428,55 @@ namespace wi::scene
 				archive >> subsets_per_lod;
 			}
 
+			if (archive.GetVersion() >= 88)
+			{
+				size_t meshletCount;
+				archive >> meshletCount;
+				meshlets.resize(meshletCount);
+				for (size_t i = 0; i < meshletCount; ++i)
+				{
+					Meshlet& meshlet = meshlets[i];
+					archive >> meshlet.vertexOffset;
+					archive >> meshlet.triangleOffset;
+					archive >> meshlet.vertexCount;
+					archive >> meshlet.triangleCount;
+					archive >> meshlet.sphere.center;
+					archive >> meshlet.sphere.radius;
+					archive >> meshlet.cone_apex;
+					archive >> meshlet.cone_axis;
+					archive >> meshlet.cone_cutoff;
+				}
+				archive >> meshlet_vertices;
+				archive >> meshlet_triangles;
+
+				size_t nodeCount;
+				archive >> nodeCount;
+				meshlet_nodes.resize(nodeCount);
+				for (size_t i = 0; i < nodeCount; ++i)
+				{
+					MeshletNode& node = meshlet_nodes[i];
+					archive >> node.aabb._min;
+					archive >> node.aabb._max;
+					archive >> node.left;
+					archive >> node.offset;
+					archive >> node.count;
+					archive >> node.triangleCount;
+				}
+				archive >> meshlet_subset_roots;
+
+				if (archive.GetVersion() >= 90)
+				{
+					archive >> meshlet_source_vertex_count;
+					archive >> meshlet_source_index_count;
+				}
+				else if (!meshlets.empty())
+				{
+					// older archives saved the meshlets together with the mesh they were built for:
+					meshlet_source_vertex_count = (uint32_t)vertex_positions.size();
+					meshlet_source_index_count = (uint32_t)indices.size();
+				}
+			}
+
 			wi::jobsystem::Execute(seri.ctx, [&](wi::jobsystem::JobArgs args) {
 				CreateRenderData();
 			});
@@ -500,6 +550,45 @@ namespace wi::scene
 				archive << subsets_per_lod;
 			}
 
+			if (archive.GetVersion() >= 88)
+			{
+				archive << meshlets.size();
+				for (size_t i = 0; i < meshlets.size(); ++i)
+				{
+					const Meshlet& meshlet = meshlets[i];
+					archive << meshlet.vertexOffset;
+					archive << meshlet.triangleOffset;
+					archive << meshlet.vertexCount;
+					archive << meshlet.triangleCount;
+					archive << meshlet.sphere.center;
+					archive << meshlet.sphere.radius;
+					archive << meshlet.cone_apex;
+					archive << meshlet.cone_axis;
+					archive << meshlet.cone_cutoff;
+				}
+				archive << meshlet_vertices;
+				archive << meshlet_triangles;
+
+				archive << meshlet_nodes.size();
+				for (size_t i = 0; i < meshlet_nodes.size(); ++i)
+				{
+					const MeshletNode& node = meshlet_nodes[i];
+					archive << node.aabb._min;
+					archive << node.aabb._max;
+					archive << node.left;
+					archive << node.offset;
+					archive << node.count;
+					archive << node.triangleCount;
+				}
+				archive << meshlet_subset_roots;
+
+				if (archive.GetVersion() >= 90)
+				{
+					archive << meshlet_source_vertex_count;
+					archive << meshlet_source_index_count;
+				}
+			}
+
 		}
 	}
 	void ImpostorComponent::Serialize(wi::Archive& archive, EntitySerializer& seri)
@@ -509,12 +598,22 @@ namespace wi::scene
 			archive >> _flags;
 			archive >> swapInDistance;
 
+			if (archive.GetVersion() >= 89)
+			{
+				archive >> resolution;
+			}
+
 			SetDirty();
 		}
 		else
 		{
 			archive << _flags;
 			archive << swapInDistance;
+
+			if (archive.GetVersion() >= 89)
+			{
+				archive << resolution;
+			}
 		}
 	}
 	void ObjectComponent::Serialize(wi::Archive& archive, EntitySerializer& seri)
@@ -1733,6 +1832,10 @@ namespace wi::scene
 		{
 			ddgi.Serialize(archive);
 		}
+		if (archive.GetVersion() >= 91)
+		{
+			wi::physics::SerializeCollisionShapes(*this, archive, seri);
+		}
 
 		wi::backlog::post("Scene serialize took " + std::to_string(timer.elapsed_seconds()) + " sec");
 	}
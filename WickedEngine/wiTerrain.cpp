@@ -5,6 +5,14 @@
 #include "wiHelper.h"
 #include "wiScene.h"
 #include "wiPhysics.h"
+#include "wiSpinLock.h"
+
+#include "Utility/basis_universal/zstd/zstd.h"
+
+#include <list>
+#include <deque>
+#include <cstring>
+#include <string_view>
 
 using namespace wi::ecs;
 using namespace wi::scene;
@@ -165,13 +173,305 @@ namespace wi::terrain
 	};
 	static ChunkIndices chunk_indices;
 
+	// The height grid of a chunk has one more row and column than the chunk vertices, so normals can be computed with finite differences for every vertex
+	static constexpr int height_grid_width = chunk_width + 1;
+	static constexpr uint32_t height_grid_count = height_grid_width * height_grid_width;
+
+	// A unit of work for the generation thread, the main thread hands it over and receives it back when it's completed
+	struct GenerationTask
+	{
+		enum class Type
+		{
+			Chunk, // generates the chunk mesh, material and region weights
+			Props, // places props on an already generated chunk
+		} type = Type::Chunk;
+		Chunk chunk = {};
+		float priority = 0; // lower value is generated sooner
+		uint64_t requested_frame = 0; // the last frame when the main thread requested this task
+		bool started = false; // set by the generation thread when it takes the task, while pending_locker is locked
+
+		// Props task inputs, copied from the chunk when the task is created:
+		wi::ecs::Entity chunk_entity = wi::ecs::INVALID_ENTITY;
+		XMFLOAT3 chunk_position = XMFLOAT3(0, 0, 0);
+		float prop_density = 1;
+		wi::vector<XMFLOAT3> vertex_positions;
+		wi::vector<wi::Color> region_weights;
+
+		// Outputs:
+		std::unique_ptr<wi::scene::Scene> scene; // the generated entities, they will be merged into the main scene by the main thread
+		ChunkData chunk_data; // Chunk task output
+		wi::ecs::Entity props_entity = wi::ecs::INVALID_ENTITY; // Props task output
+	};
+
 	struct Generator
 	{
-		wi::scene::Scene scene; // The background generation thread can safely add things to this, it will be merged into the main scene when it is safe to do so
 		wi::jobsystem::context workload;
 		std::atomic_bool cancelled{ false };
+
+		// Pending tasks are sorted by priority, the main thread replaces them every frame and the generation thread takes them from the front
+		wi::SpinLock pending_locker;
+		std::deque<std::shared_ptr<GenerationTask>> pending_tasks;
+		// Completed tasks are pushed by the generation thread and taken by the main thread
+		wi::SpinLock completed_locker;
+		std::deque<std::shared_ptr<GenerationTask>> completed_tasks;
+		// Every task that was handed over to the generation thread but not yet received back, only used by the main thread:
+		wi::unordered_map<Chunk, std::shared_ptr<GenerationTask>> chunk_tasks;
+		wi::unordered_map<Chunk, std::shared_ptr<GenerationTask>> props_tasks;
+		uint64_t frame = 0;
+
+		// Removes all tasks, the generation thread must not be running
+		void ClearTasks()
+		{
+			pending_tasks.clear();
+			completed_tasks.clear();
+			chunk_tasks.clear();
+			props_tasks.clear();
+		}
+
+		// Height grids of recently generated chunks, so chunks that are generated again don't need to evaluate the modifiers again
+		//	The heights are stored before remapping them to [bottomLevel, topLevel] range
+		struct HeightCacheEntry
+		{
+			Chunk chunk;
+			wi::vector<float> heights;
+		};
+		std::list<HeightCacheEntry> height_cache_lru; // front is the most recently used
+		wi::unordered_map<Chunk, std::list<HeightCacheEntry>::iterator> height_cache_lookup;
+
+		const wi::vector<float>* FindChunkHeights(const Chunk& chunk)
+		{
+			auto it = height_cache_lookup.find(chunk);
+			if (it == height_cache_lookup.end())
+				return nullptr;
+			height_cache_lru.splice(height_cache_lru.begin(), height_cache_lru, it->second);
+			return &it->second->heights;
+		}
+		void AddChunkHeights(const Chunk& chunk, wi::vector<float>&& heights, size_t capacity)
+		{
+			if (capacity == 0 || height_cache_lookup.count(chunk) > 0)
+				return;
+			HeightCacheEntry& entry = height_cache_lru.emplace_front();
+			entry.chunk = chunk;
+			entry.heights = std::move(heights);
+			height_cache_lookup[chunk] = height_cache_lru.begin();
+			while (height_cache_lru.size() > capacity)
+			{
+				height_cache_lookup.erase(height_cache_lru.back().chunk);
+				height_cache_lru.pop_back();
+			}
+		}
+		void ClearChunkHeights()
+		{
+			height_cache_lru.clear();
+			height_cache_lookup.clear();
+		}
+	};
+
+	// Disk cache files:
+	//	Chunk file: DiskCacheHeader, then ChunkCacheVertex for every chunk vertex
+	//	Props file: DiskCacheHeader, then PropPlacement for every placed prop
+	//	The data after the header is optionally zstd compressed
+	static constexpr char CHUNK_CACHE_MAGIC[4] = { 'W','I','T','C' };
+	static constexpr char PROP_CACHE_MAGIC[4] = { 'W','I','T','P' };
+	static constexpr uint32_t DISK_CACHE_VERSION = 1;
+	struct DiskCacheHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t hash; // hash of the parameters that were used to generate the data
+		int32_t chunk_x;
+		int32_t chunk_z;
+		uint32_t compressed;
+		uint32_t count; // chunk file: valid grass vertex count, props file: placement count
+		uint64_t size; // data size after decompression
+		uint64_t stored_size; // data size in the file
+	};
+	struct ChunkCacheVertex
+	{
+		float height;
+		XMFLOAT3 normal;
+		uint32_t region_weights;
+		float grass_length;
+	};
+	struct PropPlacement
+	{
+		uint32_t prop_index;
+		uint32_t instance_index;
+		XMFLOAT3 translation;
+		float scaling;
+		float rotation;
+	};
+	static_assert(sizeof(DiskCacheHeader) % 8 == 0);
+
+	static std::string GetDiskCacheFileName(const std::string& directory, uint64_t hash, const Chunk& chunk, const char* extension)
+	{
+		char hash_string[17] = {};
+		snprintf(hash_string, sizeof(hash_string), "%016llx", (unsigned long long)hash);
+		return directory + "/" + hash_string + "/" + std::to_string(chunk.x) + "_" + std::to_string(chunk.z) + extension;
+	}
+	static bool WriteDiskCache(const std::string& filename, const char magic[4], uint64_t hash, const Chunk& chunk, uint32_t count, const void* data, size_t size, bool compress)
+	{
+		wi::vector<uint8_t> filedata(sizeof(DiskCacheHeader));
+		DiskCacheHeader header = {};
+		std::memcpy(header.magic, magic, sizeof(header.magic));
+		header.version = DISK_CACHE_VERSION;
+		header.hash = hash;
+		header.chunk_x = chunk.x;
+		header.chunk_z = chunk.z;
+		header.count = count;
+		header.size = size;
+		header.stored_size = size;
+		if (compress && size > 0)
+		{
+			filedata.resize(sizeof(DiskCacheHeader) + ZSTD_compressBound(size));
+			size_t result = ZSTD_compress(filedata.data() + sizeof(DiskCacheHeader), filedata.size() - sizeof(DiskCacheHeader), data, size, 1);
+			if (!ZSTD_isError(result) && result < size)
+			{
+				header.compressed = 1;
+				header.stored_size = result;
+			}
+		}
+		if (header.compressed == 0)
+		{
+			filedata.resize(sizeof(DiskCacheHeader) + size);
+			if (size > 0)
+			{
+				std::memcpy(filedata.data() + sizeof(DiskCacheHeader), data, size);
+			}
+		}
+		filedata.resize(sizeof(DiskCacheHeader) + (size_t)header.stored_size);
+		std::memcpy(filedata.data(), &header, sizeof(header));
+		wi::helper::DirectoryCreate(wi::helper::GetDirectoryFromPath(filename));
+		return wi::helper::FileWrite(filename, filedata.data(), filedata.size());
+	}
+	// Returns the pointer to the cached data, or nullptr if the file is not found or invalid
+	//	Uncompressed data is returned directly from the memory mapped file, compressed data is decompressed into the decompressed vector
+	static const uint8_t* ReadDiskCache(const std::string& filename, const char magic[4], uint64_t hash, const Chunk& chunk, wi::helper::MappedFile& mapped, wi::vector<uint8_t>& decompressed, uint32_t& count, size_t& size)
+	{
+		if (!wi::helper::FileExists(filename) || !wi::helper::FileMap(filename, mapped))
+			return nullptr;
+		if (mapped.GetSize() < sizeof(DiskCacheHeader))
+			return nullptr;
+		DiskCacheHeader header;
+		std::memcpy(&header, mapped.GetData(), sizeof(header));
+		if (std::memcmp(header.magic, magic, sizeof(header.magic)) != 0 ||
+			header.version != DISK_CACHE_VERSION ||
+			header.hash != hash ||
+			header.chunk_x != chunk.x ||
+			header.chunk_z != chunk.z ||
+			header.stored_size != mapped.GetSize() - sizeof(DiskCacheHeader))
+			return nullptr;
+		count = header.count;
+		size = (size_t)header.size;
+		const uint8_t* data = mapped.GetData() + sizeof(DiskCacheHeader);
+		if (header.compressed == 0)
+			return data;
+		decompressed.resize(size);
+		size_t result = ZSTD_decompress(decompressed.data(), decompressed.size(), data, (size_t)header.stored_size);
+		if (ZSTD_isError(result) || result != size)
+			return nullptr;
+		return decompressed.data();
+	}
+
+	// 64-bit FNV-1a hash of the disk cache parameters
+	//	std::hash is not used, because its results differ between standard library implementations, and the cache files must be found with every build
+	struct DiskCacheHasher
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		void add_data(const void* data, size_t size)
+		{
+			hash = wi::helper::hash_fnv1a(data, size, hash);
+		}
+		template<typename T>
+		void add(const T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value);
+			add_data(&value, sizeof(value));
+		}
+		void add(const wi::vector<uint8_t>& data)
+		{
+			add(uint64_t(data.size()));
+			add_data(data.data(), data.size());
+		}
 	};
 
+	// Hash of every parameter that affects the generated chunk data, the disk cache is keyed by this
+	static uint64_t ComputeGenerationHash(const Terrain& terrain)
+	{
+		DiskCacheHasher hasher;
+		hasher.add(DISK_CACHE_VERSION);
+		hasher.add(terrain.seed);
+		hasher.add(terrain.chunk_scale);
+		hasher.add(terrain.bottomLevel);
+		hasher.add(terrain.topLevel);
+		hasher.add(terrain.region1);
+		hasher.add(terrain.region2);
+		hasher.add(terrain.region3);
+		for (auto& modifier : terrain.modifiers)
+		{
+			hasher.add((int)modifier->type);
+			hasher.add((int)modifier->blend);
+			hasher.add(modifier->weight);
+			hasher.add(modifier->frequency);
+			switch (modifier->type)
+			{
+			case Modifier::Type::Perlin:
+			{
+				const PerlinModifier* perlin = (const PerlinModifier*)modifier.get();
+				hasher.add(perlin->octaves);
+				hasher.add(perlin->seed);
+			}
+			break;
+			case Modifier::Type::Voronoi:
+			{
+				const VoronoiModifier* voronoi = (const VoronoiModifier*)modifier.get();
+				hasher.add(voronoi->fade);
+				hasher.add(voronoi->shape);
+				hasher.add(voronoi->falloff);
+				hasher.add(voronoi->perturbation);
+				hasher.add(voronoi->seed);
+			}
+			break;
+			case Modifier::Type::Heightmap:
+			{
+				const HeightmapModifier* heightmap = (const HeightmapModifier*)modifier.get();
+				hasher.add(heightmap->scale);
+				hasher.add(heightmap->width);
+				hasher.add(heightmap->height);
+				hasher.add(heightmap->data);
+			}
+			break;
+			default:
+				break;
+			}
+		}
+		return hasher.hash;
+	}
+	// Hash of every parameter that affects the prop placements, the disk cache is keyed by this
+	static uint64_t ComputePropsHash(const Terrain& terrain, uint64_t generation_hash)
+	{
+		DiskCacheHasher hasher;
+		hasher.add(generation_hash);
+		hasher.add(terrain.prop_density);
+		for (auto& prop : terrain.props)
+		{
+			hasher.add(prop.data);
+			hasher.add(prop.min_count_per_chunk);
+			hasher.add(prop.max_count_per_chunk);
+			hasher.add(prop.region);
+			hasher.add(prop.region_power);
+			hasher.add(prop.noise_frequency);
+			hasher.add(prop.noise_power);
+			hasher.add(prop.threshold);
+			hasher.add(prop.min_size);
+			hasher.add(prop.max_size);
+			hasher.add(prop.min_y_offset);
+			hasher.add(prop.max_y_offset);
+		}
+		return hasher.hash;
+	}
+
 	Terrain::Terrain()
 	{
 		weather.ambient = XMFLOAT3(0.2f, 0.2f, 0.2f);
@@ -201,7 +501,8 @@ namespace wi::terrain
 	{
 		SetGenerationStarted(true);
 		Generation_Cancel();
-		generator->scene.Clear();
+		generator->ClearTasks();
+		generator->ClearChunkHeights(); // modifiers or their parameters could have changed, so cached heights are invalid
 
 		chunks.clear();
 
@@ -251,9 +552,7 @@ namespace wi::terrain
 
 	void Terrain::Generation_Update(const wi::scene::CameraComponent& camera)
 	{
-		// The generation task is always cancelled every frame so we are sure that generation is not running at this point
-		Generation_Cancel();
-
+		// The generation thread is not cancelled here, it can keep running in the background while this function schedules more tasks for it
 		if (!IsGenerationStarted())
 		{
 			Generation_Restart();
@@ -262,6 +561,7 @@ namespace wi::terrain
 		// Check whether any modifiers need to be removed, and we will really remove them here if so:
 		if (!modifiers_to_remove.empty())
 		{
+			Generation_Cancel(); // the generation thread could be using the modifiers
 			for (auto& modifier : modifiers_to_remove)
 			{
 				for (auto it = modifiers.begin(); it != modifiers.end(); ++it)
@@ -279,6 +579,8 @@ namespace wi::terrain
 
 		if (terrainEntity == INVALID_ENTITY)
 		{
+			Generation_Cancel();
+			generator->ClearTasks();
 			chunks.clear();
 			return;
 		}
@@ -289,8 +591,49 @@ namespace wi::terrain
 			weather = *weather_component; // feedback default weather
 		}
 
-		// What was generated, will be merged in to the main scene
-		scene->Merge(generator->scene);
+		// The completed tasks are received from the generation thread and what was generated will be merged in to the main scene:
+		{
+			auto range = wi::profiler::BeginRangeCPU("Terrain Generation Handover");
+			wi::Timer handover_timer;
+			std::deque<std::shared_ptr<GenerationTask>> completed_tasks;
+			generator->completed_locker.lock();
+			std::swap(completed_tasks, generator->completed_tasks);
+			generator->completed_locker.unlock();
+
+			generation_statistics.handover_chunk_count = 0;
+			generation_statistics.handover_props_count = 0;
+			for (auto& task : completed_tasks)
+			{
+				switch (task->type)
+				{
+				case GenerationTask::Type::Chunk:
+					generator->chunk_tasks.erase(task->chunk);
+					scene->Merge(*task->scene);
+					chunks[task->chunk] = std::move(task->chunk_data);
+					generation_statistics.handover_chunk_count++;
+					break;
+				case GenerationTask::Type::Props:
+				{
+					generator->props_tasks.erase(task->chunk);
+					auto it = chunks.find(task->chunk);
+					if (it != chunks.end() && it->second.entity == task->chunk_entity && it->second.props_entity == INVALID_ENTITY)
+					{
+						// The chunk still exists and it doesn't have props yet:
+						scene->Merge(*task->scene);
+						scene->Component_Attach(task->props_entity, task->chunk_entity, true);
+						it->second.props_entity = task->props_entity;
+						it->second.prop_density_current = task->prop_density;
+						generation_statistics.handover_props_count++;
+					}
+				}
+				break;
+				default:
+					break;
+				}
+			}
+			generation_statistics.handover_milliseconds = (float)handover_timer.elapsed_milliseconds();
+			wi::profiler::EndRange(range);
+		}
 
 		const float chunk_scale_rcp = 1.0f / chunk_scale;
 
@@ -384,6 +727,21 @@ namespace wi::terrain
 				}
 			}
 
+			// Grass patch placement:
+			if (dist <= 1 && IsGrassEnabled() && chunk_data.grass_entity == INVALID_ENTITY && chunk_data.grass.meshID != INVALID_ENTITY)
+			{
+				// add patch for this chunk
+				chunk_data.grass_entity = CreateEntity();
+				wi::HairParticleSystem& grass = scene->hairs.Create(chunk_data.grass_entity);
+				grass = chunk_data.grass;
+				chunk_data.grass_density_current = grass_density;
+				grass.strandCount = uint32_t(grass.strandCount * chunk_data.grass_density_current);
+				scene->materials.Create(chunk_data.grass_entity) = material_GrassParticle;
+				scene->transforms.Create(chunk_data.grass_entity);
+				scene->names.Create(chunk_data.grass_entity) = "grass";
+				scene->Component_Attach(chunk_data.grass_entity, chunk_data.entity, true);
+			}
+
 			// Grass density modification:
 			if (chunk_data.grass_entity != INVALID_ENTITY && std::abs(chunk_data.grass_density_current - grass_density) > std::numeric_limits<float>::epsilon())
 			{
@@ -562,341 +920,546 @@ namespace wi::terrain
 			device->EventEnd(cmd);
 		}
 
-		// Start the generation on a background thread and keep it running until the next frame
-		wi::jobsystem::Execute(generator->workload, [=](wi::jobsystem::JobArgs args) {
+		// Tasks are scheduled in priority order: chunks that are closer to the camera and inside the camera frustum are generated first
+		//	Tasks that were not yet started by the generation thread are taken back, so they can be reprioritized
+		std::deque<std::shared_ptr<GenerationTask>> unstarted_tasks;
+		generator->pending_locker.lock();
+		std::swap(unstarted_tasks, generator->pending_tasks);
+		generator->pending_locker.unlock();
+
+		generator->frame++;
+		std::deque<std::shared_ptr<GenerationTask>> pending_tasks;
+		auto request_task = [&](wi::unordered_map<Chunk, std::shared_ptr<GenerationTask>>& tasks, GenerationTask::Type type, const Chunk& chunk, float priority) -> GenerationTask* {
+			std::shared_ptr<GenerationTask>& task = tasks[chunk];
+			const bool created = task == nullptr;
+			if (created)
+			{
+				task = std::make_shared<GenerationTask>();
+				task->type = type;
+				task->chunk = chunk;
+			}
+			else if (task->started)
+			{
+				return nullptr; // the generation thread is already working on it
+			}
+			task->priority = priority;
+			task->requested_frame = generator->frame;
+			pending_tasks.push_back(task);
+			return created ? task.get() : nullptr;
+		};
+		const float chunk_size = (chunk_width - 1) * chunk_scale;
+		auto request_chunk = [&](int offset_x, int offset_z)
+		{
+			Chunk chunk = center_chunk;
+			chunk.x += offset_x;
+			chunk.z += offset_z;
+			const int dist = std::max(std::abs(offset_x), std::abs(offset_z));
+
+			const XMFLOAT3 chunk_center = XMFLOAT3(float(chunk.x) * chunk_size, 0, float(chunk.z) * chunk_size);
+			wi::primitive::AABB aabb;
+			aabb._min = XMFLOAT3(chunk_center.x - chunk_size * 0.5f, std::min(bottomLevel, topLevel), chunk_center.z - chunk_size * 0.5f);
+			aabb._max = XMFLOAT3(chunk_center.x + chunk_size * 0.5f, std::max(bottomLevel, topLevel), chunk_center.z + chunk_size * 0.5f);
+			const bool visible = dist <= 1 || camera.frustum.CheckBoxFast(aabb);
+			const float priority = float(dist) + (visible ? 0 : float(generation) * 0.5f);
+
+			auto it = chunks.find(chunk);
+			if (it == chunks.end() || it->second.entity == INVALID_ENTITY)
+			{
+				request_task(generator->chunk_tasks, GenerationTask::Type::Chunk, chunk, priority);
+				return;
+			}
 
-			wi::Timer timer;
-			bool generated_something = false;
+			const ChunkData& chunk_data = it->second;
+			if (dist <= prop_generation && !props.empty() && chunk_data.props_entity == INVALID_ENTITY && chunk_data.mesh_vertex_positions != nullptr)
+			{
+				GenerationTask* task = request_task(generator->props_tasks, GenerationTask::Type::Props, chunk, priority);
+				if (task != nullptr)
+				{
+					task->chunk_entity = chunk_data.entity;
+					task->chunk_position = chunk_data.position;
+					task->prop_density = prop_density;
+					task->vertex_positions.assign(chunk_data.mesh_vertex_positions, chunk_data.mesh_vertex_positions + vertexCount);
+					task->region_weights = chunk_data.region_weights;
+				}
+			}
+		};
 
-			auto request_chunk = [&](int offset_x, int offset_z)
+		// request center chunk first:
+		request_chunk(0, 0);
+
+		// then request neighbor chunks in outward spiral:
+		for (int growth = 0; growth < generation; ++growth)
+		{
+			const int side = 2 * (growth + 1);
+			int x = -growth - 1;
+			int z = -growth - 1;
+			for (int i = 0; i < side; ++i)
 			{
-				Chunk chunk = center_chunk;
-				chunk.x += offset_x;
-				chunk.z += offset_z;
-				auto it = chunks.find(chunk);
-				if (it == chunks.end() || it->second.entity == INVALID_ENTITY)
+				request_chunk(x, z);
+				x++;
+			}
+			for (int i = 0; i < side; ++i)
+			{
+				request_chunk(x, z);
+				z++;
+			}
+			for (int i = 0; i < side; ++i)
+			{
+				request_chunk(x, z);
+				x--;
+			}
+			for (int i = 0; i < side; ++i)
+			{
+				request_chunk(x, z);
+				z--;
+			}
+		}
+
+		// Tasks that were not requested again are not needed any more:
+		for (auto& task : unstarted_tasks)
+		{
+			if (task->requested_frame != generator->frame)
+			{
+				auto& tasks = task->type == GenerationTask::Type::Chunk ? generator->chunk_tasks : generator->props_tasks;
+				auto it = tasks.find(task->chunk);
+				if (it != tasks.end() && it->second == task)
+				{
+					tasks.erase(it);
+				}
+			}
+		}
+
+		std::stable_sort(pending_tasks.begin(), pending_tasks.end(), [](const std::shared_ptr<GenerationTask>& a, const std::shared_ptr<GenerationTask>& b) {
+			return a->priority < b->priority;
+		});
+		generation_statistics.pending_task_count = (uint32_t)pending_tasks.size();
+		generation_statistics.running_task_count = uint32_t(generator->chunk_tasks.size() + generator->props_tasks.size() - pending_tasks.size());
+		const bool has_pending_tasks = !pending_tasks.empty();
+		generator->pending_locker.lock();
+		std::swap(generator->pending_tasks, pending_tasks);
+		generator->pending_locker.unlock();
+
+		if (!has_pending_tasks || wi::jobsystem::IsBusy(generator->workload))
+			return;
+
+		// Disk cache entries are keyed by the generation parameters, so they are invalidated automatically when those change:
+		const bool disk_cache_enabled = !disk_cache_directory.empty();
+		const uint64_t generation_hash = disk_cache_enabled ? ComputeGenerationHash(*this) : 0;
+		const uint64_t props_hash = disk_cache_enabled ? ComputePropsHash(*this, generation_hash) : 0;
+
+		// Start the generation thread, it will take tasks until there are no more of them or until it runs out of time budget
+		//	Completed tasks are handed back to the main thread, and unfinished tasks will be continued next time
+		wi::jobsystem::Execute(generator->workload, [=](wi::jobsystem::JobArgs args) {
+
+			auto generate_chunk = [&](GenerationTask& task)
+			{
+				const Chunk& chunk = task.chunk;
+				ChunkData& chunk_data = task.chunk_data;
+				Scene& generated_scene = *task.scene;
+
+				chunk_data.entity = generated_scene.Entity_CreateObject("chunk_" + std::to_string(chunk.x) + "_" + std::to_string(chunk.z));
+				ObjectComponent& object = *generated_scene.objects.GetComponent(chunk_data.entity);
+				object.lod_distance_multiplier = lod_multiplier;
+				generated_scene.Component_Attach(chunk_data.entity, terrainEntity);
+
+				TransformComponent& transform = *generated_scene.transforms.GetComponent(chunk_data.entity);
+				transform.ClearTransform();
+				chunk_data.position = XMFLOAT3(float(chunk.x * (chunk_width - 1)) * chunk_scale, 0, float(chunk.z * (chunk_width - 1)) * chunk_scale);
+				transform.Translate(chunk_data.position);
+				transform.UpdateTransform();
+
+				MaterialComponent& material = generated_scene.materials.Create(chunk_data.entity);
+				// material params will be 1 because they will be created from only texture maps
+				//	because region materials are blended together into one texture
+				material.SetRoughness(1);
+				material.SetMetalness(1);
+				material.SetReflectance(1);
+
+				MeshComponent& mesh = generated_scene.meshes.Create(chunk_data.entity);
+				object.meshID = chunk_data.entity;
+				mesh.indices = chunk_indices.indices;
+				for (auto& lod : chunk_indices.lods)
 				{
-					// Generate a new chunk:
-					ChunkData& chunk_data = chunks[chunk];
-
-					chunk_data.entity = generator->scene.Entity_CreateObject("chunk_" + std::to_string(chunk.x) + "_" + std::to_string(chunk.z));
-					ObjectComponent& object = *generator->scene.objects.GetComponent(chunk_data.entity);
-					object.lod_distance_multiplier = lod_multiplier;
-					generator->scene.Component_Attach(chunk_data.entity, terrainEntity);
-
-					TransformComponent& transform = *generator->scene.transforms.GetComponent(chunk_data.entity);
-					transform.ClearTransform();
-					chunk_data.position = XMFLOAT3(float(chunk.x * (chunk_width - 1)) * chunk_scale, 0, float(chunk.z * (chunk_width - 1)) * chunk_scale);
-					transform.Translate(chunk_data.position);
-					transform.UpdateTransform();
-
-					MaterialComponent& material = generator->scene.materials.Create(chunk_data.entity);
-					// material params will be 1 because they will be created from only texture maps
-					//	because region materials are blended together into one texture
-					material.SetRoughness(1);
-					material.SetMetalness(1);
-					material.SetReflectance(1);
-
-					MeshComponent& mesh = generator->scene.meshes.Create(chunk_data.entity);
-					object.meshID = chunk_data.entity;
-					mesh.indices = chunk_indices.indices;
-					for (auto& lod : chunk_indices.lods)
+					mesh.subsets.emplace_back();
+					mesh.subsets.back().materialID = chunk_data.entity;
+					mesh.subsets.back().indexCount = lod.indexCount;
+					mesh.subsets.back().indexOffset = lod.indexOffset;
+				}
+				mesh.subsets_per_lod = 1;
+				mesh.vertex_positions.resize(vertexCount);
+				mesh.vertex_normals.resize(vertexCount);
+				mesh.vertex_uvset_0.resize(vertexCount);
+				chunk_data.region_weights.resize(vertexCount);
+
+				chunk_data.mesh_vertex_positions = mesh.vertex_positions.data();
+
+				wi::HairParticleSystem grass = grass_properties;
+				grass.vertex_lengths.resize(vertexCount);
+				std::atomic<uint32_t> grass_valid_vertex_count{ 0 };
+
+				wi::jobsystem::context ctx;
+
+				// Try to load the chunk from the disk cache:
+				const std::string chunk_cache_filename = disk_cache_enabled ? GetDiskCacheFileName(disk_cache_directory, generation_hash, chunk, ".chunk") : "";
+				wi::helper::MappedFile chunk_cache_file;
+				wi::vector<uint8_t> chunk_cache_data;
+				uint32_t chunk_cache_count = 0;
+				size_t chunk_cache_size = 0;
+				const ChunkCacheVertex* cached_vertices = nullptr;
+				if (disk_cache_enabled)
+				{
+					cached_vertices = (const ChunkCacheVertex*)ReadDiskCache(chunk_cache_filename, CHUNK_CACHE_MAGIC, generation_hash, chunk, chunk_cache_file, chunk_cache_data, chunk_cache_count, chunk_cache_size);
+					if (chunk_cache_size != vertexCount * sizeof(ChunkCacheVertex))
 					{
-						mesh.subsets.emplace_back();
-						mesh.subsets.back().materialID = chunk_data.entity;
-						mesh.subsets.back().indexCount = lod.indexCount;
-						mesh.subsets.back().indexOffset = lod.indexOffset;
+						cached_vertices = nullptr;
 					}
-					mesh.subsets_per_lod = 1;
-					mesh.vertex_positions.resize(vertexCount);
-					mesh.vertex_normals.resize(vertexCount);
-					mesh.vertex_uvset_0.resize(vertexCount);
-					chunk_data.region_weights.resize(vertexCount);
-
-					chunk_data.mesh_vertex_positions = mesh.vertex_positions.data();
-
-					wi::HairParticleSystem grass = grass_properties;
-					grass.vertex_lengths.resize(vertexCount);
-					std::atomic<uint32_t> grass_valid_vertex_count{ 0 };
-
-					// Do a parallel for loop over all the chunk's vertices and compute their properties:
-					wi::jobsystem::context ctx;
-					wi::jobsystem::Dispatch(ctx, vertexCount, chunk_width, [&](wi::jobsystem::JobArgs args) {
-						uint32_t index = args.jobIndex;
+				}
+
+				if (cached_vertices != nullptr)
+				{
+					for (uint32_t index = 0; index < vertexCount; ++index)
+					{
+						const ChunkCacheVertex& vertex = cached_vertices[index];
 						const float x = (float(index % chunk_width) - chunk_half_width) * chunk_scale;
 						const float z = (float(index / chunk_width) - chunk_half_width) * chunk_scale;
-						XMVECTOR corners[3];
-						XMFLOAT2 corner_offsets[3] = {
-							XMFLOAT2(0, 0),
-							XMFLOAT2(1, 0),
-							XMFLOAT2(0, 1),
-						};
-						for (int i = 0; i < arraysize(corners); ++i)
-						{
-							float height = 0;
-							const XMFLOAT2 world_pos = XMFLOAT2(chunk_data.position.x + x + corner_offsets[i].x, chunk_data.position.z + z + corner_offsets[i].y);
+						mesh.vertex_positions[index] = XMFLOAT3(x, vertex.height, z);
+						mesh.vertex_normals[index] = vertex.normal;
+						mesh.vertex_uvset_0[index] = XMFLOAT2(x * chunk_scale_rcp * chunk_width_rcp + 0.5f, z * chunk_scale_rcp * chunk_width_rcp + 0.5f);
+						chunk_data.region_weights[index] = wi::Color(vertex.region_weights);
+						grass.vertex_lengths[index] = vertex.grass_length;
+					}
+					grass_valid_vertex_count.store(chunk_cache_count);
+				}
+				else
+				{
+					// The height grid is computed once per chunk, or reused from the cache if this chunk was generated before:
+					//	The modifiers are evaluated for a whole row at once, so they can use vectorized noise
+					wi::vector<float> generated_heights;
+					const wi::vector<float>* heights = generator->FindChunkHeights(chunk);
+					if (heights == nullptr)
+					{
+						generated_heights.resize(height_grid_count);
+						wi::jobsystem::Dispatch(ctx, height_grid_width, 1, [&](wi::jobsystem::JobArgs args) {
+							const uint32_t row = args.jobIndex;
+							float world_pos_x[height_grid_width];
+							float world_pos_y[height_grid_width];
+							float* row_heights = generated_heights.data() + row * height_grid_width;
+							const float z = (float(row) - chunk_half_width) * chunk_scale;
+							for (uint32_t column = 0; column < height_grid_width; ++column)
+							{
+								const float x = (float(column) - chunk_half_width) * chunk_scale;
+								world_pos_x[column] = chunk_data.position.x + x;
+								world_pos_y[column] = chunk_data.position.z + z;
+								row_heights[column] = 0;
+							}
 							for (auto& modifier : modifiers)
 							{
-								modifier->Apply(world_pos, height);
+								modifier->ApplyBatch(world_pos_x, world_pos_y, row_heights, height_grid_width);
 							}
-							height = wi::math::Lerp(bottomLevel, topLevel, height);
-							corners[i] = XMVectorSet(world_pos.x, height, world_pos.y, 0);
-						}
-						const float height = XMVectorGetY(corners[0]);
-						const XMVECTOR T = XMVectorSubtract(corners[2], corners[1]);
-						const XMVECTOR B = XMVectorSubtract(corners[1], corners[0]);
-						const XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
-						XMFLOAT3 normal;
-						XMStoreFloat3(&normal, N);
-
-						const float region_base = 1;
-						const float region_slope = std::pow(1.0f - wi::math::saturate(normal.y), region1);
-						const float region_low_altitude = bottomLevel == 0 ? 0 : std::pow(wi::math::saturate(wi::math::InverseLerp(0, bottomLevel, height)), region2);
-						const float region_high_altitude = topLevel == 0 ? 0 : std::pow(wi::math::saturate(wi::math::InverseLerp(0, topLevel, height)), region3);
-
-						XMFLOAT4 materialBlendWeights(region_base, 0, 0, 0);
-						materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 1, 0, 0), region_slope);
-						materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 0, 1, 0), region_low_altitude);
-						materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 0, 0, 1), region_high_altitude);
-						const float weight_norm = 1.0f / (materialBlendWeights.x + materialBlendWeights.y + materialBlendWeights.z + materialBlendWeights.w);
-						materialBlendWeights.x *= weight_norm;
-						materialBlendWeights.y *= weight_norm;
-						materialBlendWeights.z *= weight_norm;
-						materialBlendWeights.w *= weight_norm;
-
-						chunk_data.region_weights[index] = wi::Color::fromFloat4(materialBlendWeights);
-
-						mesh.vertex_positions[index] = XMFLOAT3(x, height, z);
-						mesh.vertex_normals[index] = normal;
-						const XMFLOAT2 uv = XMFLOAT2(x * chunk_scale_rcp * chunk_width_rcp + 0.5f, z * chunk_scale_rcp * chunk_width_rcp + 0.5f);
-						mesh.vertex_uvset_0[index] = uv;
-
-						XMFLOAT3 vertex_pos(chunk_data.position.x + x, height, chunk_data.position.z + z);
-
-						const float grass_noise_frequency = 0.1f;
-						const float grass_noise = perlin_noise.compute(vertex_pos.x * grass_noise_frequency, vertex_pos.y * grass_noise_frequency, vertex_pos.z * grass_noise_frequency) * 0.5f + 0.5f;
-						const float region_grass = std::pow(materialBlendWeights.x * (1 - materialBlendWeights.w), 8.0f) * grass_noise;
-						if (region_grass > 0.1f)
-						{
-							grass_valid_vertex_count.fetch_add(1);
-							grass.vertex_lengths[index] = region_grass;
-						}
-						else
+							});
+						wi::jobsystem::Wait(ctx); // wait until the height grid is fully generated
+						heights = &generated_heights;
+					}
+
+					// Do a parallel for loop over all the chunk's vertex rows and compute their properties:
+					wi::jobsystem::Dispatch(ctx, chunk_width, 1, [&](wi::jobsystem::JobArgs args) {
+						const uint32_t row = args.jobIndex;
+						const float z = (float(row) - chunk_half_width) * chunk_scale;
+						for (uint32_t column = 0; column < chunk_width; ++column)
 						{
-							grass.vertex_lengths[index] = 0;
+							const uint32_t index = column + row * chunk_width;
+							const float x = (float(column) - chunk_half_width) * chunk_scale;
+							const uint32_t grid_offsets[3] = {
+								column + row * height_grid_width,
+								column + 1 + row * height_grid_width,
+								column + (row + 1) * height_grid_width,
+							};
+							const XMFLOAT2 corner_offsets[3] = {
+								XMFLOAT2(0, 0),
+								XMFLOAT2(chunk_scale, 0),
+								XMFLOAT2(0, chunk_scale),
+							};
+							XMVECTOR corners[3];
+							for (int i = 0; i < arraysize(corners); ++i)
+							{
+								const float height = wi::math::Lerp(bottomLevel, topLevel, (*heights)[grid_offsets[i]]);
+								corners[i] = XMVectorSet(x + corner_offsets[i].x, height, z + corner_offsets[i].y, 0);
+							}
+							const float height = XMVectorGetY(corners[0]);
+							const XMVECTOR T = XMVectorSubtract(corners[2], corners[1]);
+							const XMVECTOR B = XMVectorSubtract(corners[1], corners[0]);
+							const XMVECTOR N = XMVector3Normalize(XMVector3Cross(T, B));
+							XMFLOAT3 normal;
+							XMStoreFloat3(&normal, N);
+
+							const float region_base = 1;
+							const float region_slope = std::pow(1.0f - wi::math::saturate(normal.y), region1);
+							const float region_low_altitude = bottomLevel == 0 ? 0 : std::pow(wi::math::saturate(wi::math::InverseLerp(0, bottomLevel, height)), region2);
+							const float region_high_altitude = topLevel == 0 ? 0 : std::pow(wi::math::saturate(wi::math::InverseLerp(0, topLevel, height)), region3);
+
+							XMFLOAT4 materialBlendWeights(region_base, 0, 0, 0);
+							materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 1, 0, 0), region_slope);
+							materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 0, 1, 0), region_low_altitude);
+							materialBlendWeights = wi::math::Lerp(materialBlendWeights, XMFLOAT4(0, 0, 0, 1), region_high_altitude);
+							const float weight_norm = 1.0f / (materialBlendWeights.x + materialBlendWeights.y + materialBlendWeights.z + materialBlendWeights.w);
+							materialBlendWeights.x *= weight_norm;
+							materialBlendWeights.y *= weight_norm;
+							materialBlendWeights.z *= weight_norm;
+							materialBlendWeights.w *= weight_norm;
+
+							chunk_data.region_weights[index] = wi::Color::fromFloat4(materialBlendWeights);
+
+							mesh.vertex_positions[index] = XMFLOAT3(x, height, z);
+							mesh.vertex_normals[index] = normal;
+							const XMFLOAT2 uv = XMFLOAT2(x * chunk_scale_rcp * chunk_width_rcp + 0.5f, z * chunk_scale_rcp * chunk_width_rcp + 0.5f);
+							mesh.vertex_uvset_0[index] = uv;
+
+							XMFLOAT3 vertex_pos(chunk_data.position.x + x, height, chunk_data.position.z + z);
+
+							const float grass_noise_frequency = 0.1f;
+							const float grass_noise = perlin_noise.compute(vertex_pos.x * grass_noise_frequency, vertex_pos.y * grass_noise_frequency, vertex_pos.z * grass_noise_frequency) * 0.5f + 0.5f;
+							const float region_grass = std::pow(materialBlendWeights.x * (1 - materialBlendWeights.w), 8.0f) * grass_noise;
+							if (region_grass > 0.1f)
+							{
+								grass_valid_vertex_count.fetch_add(1);
+								grass.vertex_lengths[index] = region_grass;
+							}
+							else
+							{
+								grass.vertex_lengths[index] = 0;
+							}
 						}
 						});
 					wi::jobsystem::Wait(ctx); // wait until chunk's vertex buffer is fully generated
 
-					wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
-						mesh.CreateRenderData();
-						chunk_data.sphere.center = mesh.aabb.getCenter();
-						chunk_data.sphere.center.x += chunk_data.position.x;
-						chunk_data.sphere.center.y += chunk_data.position.y;
-						chunk_data.sphere.center.z += chunk_data.position.z;
-						chunk_data.sphere.radius = mesh.aabb.getRadius();
-						});
-
-					// If there were any vertices in this chunk that could be valid for grass, store the grass particle system:
-					if (grass_valid_vertex_count.load() > 0)
+					if (!generated_heights.empty())
 					{
-						chunk_data.grass = std::move(grass); // the grass will be added to the scene later, only when the chunk is close to the camera (center chunk's neighbors)
-						chunk_data.grass.meshID = chunk_data.entity;
-						chunk_data.grass.strandCount = uint32_t(grass_valid_vertex_count.load() * 3 * chunk_scale * chunk_scale); // chunk_scale * chunk_scale : grass density increases with squared amount with chunk scale (x*z)
-						chunk_data.grass.viewDistance = chunk_width * chunk_scale;
+						generator->AddChunkHeights(chunk, std::move(generated_heights), height_cache_capacity);
 					}
 
-					// Create the blend weights texture for virtual texture update:
-					CreateChunkRegionTexture(chunk_data);
+					if (disk_cache_enabled)
+					{
+						wi::vector<ChunkCacheVertex> vertices(vertexCount);
+						for (uint32_t index = 0; index < vertexCount; ++index)
+						{
+							ChunkCacheVertex& vertex = vertices[index];
+							vertex.height = mesh.vertex_positions[index].y;
+							vertex.normal = mesh.vertex_normals[index];
+							vertex.region_weights = chunk_data.region_weights[index].rgba;
+							vertex.grass_length = grass.vertex_lengths[index];
+						}
+						WriteDiskCache(chunk_cache_filename, CHUNK_CACHE_MAGIC, generation_hash, chunk, grass_valid_vertex_count.load(), vertices.data(), vertices.size() * sizeof(ChunkCacheVertex), disk_cache_compression);
+					}
+				}
 
-					wi::jobsystem::Wait(ctx); // wait until mesh.CreateRenderData() async task finishes
-					generated_something = true;
+				wi::jobsystem::Execute(ctx, [&](wi::jobsystem::JobArgs args) {
+					mesh.CreateRenderData();
+					chunk_data.sphere.center = mesh.aabb.getCenter();
+					chunk_data.sphere.center.x += chunk_data.position.x;
+					chunk_data.sphere.center.y += chunk_data.position.y;
+					chunk_data.sphere.center.z += chunk_data.position.z;
+					chunk_data.sphere.radius = mesh.aabb.getRadius();
+					});
+
+				// If there were any vertices in this chunk that could be valid for grass, store the grass particle system:
+				if (grass_valid_vertex_count.load() > 0)
+				{
+					chunk_data.grass = std::move(grass); // the grass will be added to the scene later, only when the chunk is close to the camera (center chunk's neighbors)
+					chunk_data.grass.meshID = chunk_data.entity;
+					chunk_data.grass.strandCount = uint32_t(grass_valid_vertex_count.load() * 3 * chunk_scale * chunk_scale); // chunk_scale * chunk_scale : grass density increases with squared amount with chunk scale (x*z)
+					chunk_data.grass.viewDistance = chunk_width * chunk_scale;
 				}
 
-				const int dist = std::max(std::abs(center_chunk.x - chunk.x), std::abs(center_chunk.z - chunk.z));
+				// Create the blend weights texture for virtual texture update:
+				CreateChunkRegionTexture(chunk_data);
 
-				// Grass patch placement:
-				if (dist <= 1 && IsGrassEnabled())
+				wi::jobsystem::Wait(ctx); // wait until mesh.CreateRenderData() async task finishes
+			};
+
+			auto generate_props = [&](GenerationTask& task)
+			{
+				const Chunk& chunk = task.chunk;
+				Scene& generated_scene = *task.scene;
+
+				task.props_entity = CreateEntity();
+				generated_scene.transforms.Create(task.props_entity);
+				generated_scene.names.Create(task.props_entity) = "props";
+
+				// Try to load the prop placements from the disk cache, otherwise compute them:
+				const std::string props_cache_filename = disk_cache_enabled ? GetDiskCacheFileName(disk_cache_directory, props_hash, chunk, ".props") : "";
+				wi::vector<PropPlacement> placements;
+				bool placements_cached = false;
+				if (disk_cache_enabled)
 				{
-					it = chunks.find(chunk);
-					if (it != chunks.end() && it->second.entity != INVALID_ENTITY)
+					wi::helper::MappedFile props_cache_file;
+					wi::vector<uint8_t> props_cache_data;
+					uint32_t props_cache_count = 0;
+					size_t props_cache_size = 0;
+					const PropPlacement* cached_placements = (const PropPlacement*)ReadDiskCache(props_cache_filename, PROP_CACHE_MAGIC, props_hash, chunk, props_cache_file, props_cache_data, props_cache_count, props_cache_size);
+					if (cached_placements != nullptr && props_cache_size == props_cache_count * sizeof(PropPlacement))
 					{
-						ChunkData& chunk_data = it->second;
-						if (chunk_data.grass_entity == INVALID_ENTITY && chunk_data.grass.meshID != INVALID_ENTITY)
+						placements.resize(props_cache_count);
+						if (props_cache_size > 0)
 						{
-							// add patch for this chunk
-							chunk_data.grass_entity = CreateEntity();
-							wi::HairParticleSystem& grass = generator->scene.hairs.Create(chunk_data.grass_entity);
-							grass = chunk_data.grass;
-							chunk_data.grass_density_current = grass_density;
-							grass.strandCount = uint32_t(grass.strandCount * chunk_data.grass_density_current);
-							generator->scene.materials.Create(chunk_data.grass_entity) = material_GrassParticle;
-							generator->scene.transforms.Create(chunk_data.grass_entity);
-							generator->scene.names.Create(chunk_data.grass_entity) = "grass";
-							generator->scene.Component_Attach(chunk_data.grass_entity, chunk_data.entity, true);
-							generated_something = true;
+							std::memcpy(placements.data(), cached_placements, props_cache_size);
 						}
+						placements_cached = true;
 					}
 				}
 
-				// Prop placement:
-				if (dist <= prop_generation)
+				if (!placements_cached)
 				{
-					it = chunks.find(chunk);
-					if (it != chunks.end() && it->second.entity != INVALID_ENTITY)
-					{
-						ChunkData& chunk_data = it->second;
+					std::mt19937 prop_rand;
+					prop_rand.seed((uint32_t)chunk.compute_hash() ^ seed);
 
-						if (chunk_data.props_entity == INVALID_ENTITY && chunk_data.mesh_vertex_positions != nullptr)
+					for (uint32_t prop_index = 0; prop_index < (uint32_t)props.size(); ++prop_index)
+					{
+						const Prop& prop = props[prop_index];
+						if (prop.data.empty())
+							continue;
+						std::uniform_int_distribution<uint32_t> gen_distr(
+							uint32_t(prop.min_count_per_chunk * task.prop_density),
+							uint32_t(prop.max_count_per_chunk * task.prop_density)
+						);
+						int gen_count = gen_distr(prop_rand);
+						for (int i = 0; i < gen_count; ++i)
 						{
-							chunk_data.props_entity = CreateEntity();
-							generator->scene.transforms.Create(chunk_data.props_entity);
-							generator->scene.names.Create(chunk_data.props_entity) = "props";
-							generator->scene.Component_Attach(chunk_data.props_entity, chunk_data.entity, true);
-							chunk_data.prop_density_current = prop_density;
-
-							std::mt19937 prop_rand;
-							prop_rand.seed((uint32_t)chunk.compute_hash() ^ seed);
-
-							for (const auto& prop : props)
+							std::uniform_real_distribution<float> float_distr(0.0f, 1.0f);
+							std::uniform_int_distribution<uint32_t> ind_distr(0, chunk_indices.lods[0].indexCount / 3 - 1);
+							uint32_t tri = ind_distr(prop_rand); // random triangle on the chunk mesh
+							uint32_t ind0 = chunk_indices.indices[tri * 3 + 0];
+							uint32_t ind1 = chunk_indices.indices[tri * 3 + 1];
+							uint32_t ind2 = chunk_indices.indices[tri * 3 + 2];
+							const XMFLOAT3& pos0 = task.vertex_positions[ind0];
+							const XMFLOAT3& pos1 = task.vertex_positions[ind1];
+							const XMFLOAT3& pos2 = task.vertex_positions[ind2];
+							const XMFLOAT4 region0 = task.region_weights[ind0];
+							const XMFLOAT4 region1 = task.region_weights[ind1];
+							const XMFLOAT4 region2 = task.region_weights[ind2];
+							// random barycentric coords on the triangle:
+							float f = float_distr(prop_rand);
+							float g = float_distr(prop_rand);
+							if (f + g > 1)
 							{
-								if (prop.data.empty())
-									continue;
-								std::uniform_int_distribution<uint32_t> gen_distr(
-									uint32_t(prop.min_count_per_chunk * chunk_data.prop_density_current),
-									uint32_t(prop.max_count_per_chunk * chunk_data.prop_density_current)
-								);
-								int gen_count = gen_distr(prop_rand);
-								for (int i = 0; i < gen_count; ++i)
-								{
-									std::uniform_real_distribution<float> float_distr(0.0f, 1.0f);
-									std::uniform_int_distribution<uint32_t> ind_distr(0, chunk_indices.lods[0].indexCount / 3 - 1);
-									uint32_t tri = ind_distr(prop_rand); // random triangle on the chunk mesh
-									uint32_t ind0 = chunk_indices.indices[tri * 3 + 0];
-									uint32_t ind1 = chunk_indices.indices[tri * 3 + 1];
-									uint32_t ind2 = chunk_indices.indices[tri * 3 + 2];
-									const XMFLOAT3& pos0 = chunk_data.mesh_vertex_positions[ind0];
-									const XMFLOAT3& pos1 = chunk_data.mesh_vertex_positions[ind1];
-									const XMFLOAT3& pos2 = chunk_data.mesh_vertex_positions[ind2];
-									const XMFLOAT4 region0 = chunk_data.region_weights[ind0];
-									const XMFLOAT4 region1 = chunk_data.region_weights[ind1];
-									const XMFLOAT4 region2 = chunk_data.region_weights[ind2];
-									// random barycentric coords on the triangle:
-									float f = float_distr(prop_rand);
-									float g = float_distr(prop_rand);
-									if (f + g > 1)
-									{
-										f = 1 - f;
-										g = 1 - g;
-									}
-									XMFLOAT3 vertex_pos;
-									vertex_pos.x = pos0.x + f * (pos1.x - pos0.x) + g * (pos2.x - pos0.x);
-									vertex_pos.y = pos0.y + f * (pos1.y - pos0.y) + g * (pos2.y - pos0.y);
-									vertex_pos.z = pos0.z + f * (pos1.z - pos0.z) + g * (pos2.z - pos0.z);
-									XMFLOAT4 region;
-									region.x = region0.x + f * (region1.x - region0.x) + g * (region2.x - region0.x);
-									region.y = region0.y + f * (region1.y - region0.y) + g * (region2.y - region0.y);
-									region.z = region0.z + f * (region1.z - region0.z) + g * (region2.z - region0.z);
-									region.w = region0.w + f * (region1.w - region0.w) + g * (region2.w - region0.w);
-
-									const float noise = std::pow(perlin_noise.compute((vertex_pos.x + chunk_data.position.x) * prop.noise_frequency, vertex_pos.y * prop.noise_frequency, (vertex_pos.z + chunk_data.position.z) * prop.noise_frequency) * 0.5f + 0.5f, prop.noise_power);
-									const float chance = std::pow(((float*)&region)[prop.region], prop.region_power) * noise;
-									if (chance > prop.threshold)
-									{
-										wi::Archive archive = wi::Archive(prop.data.data());
-										EntitySerializer seri;
-										wi::scene::Scene::EntitySerializeFlags flags = wi::scene::Scene::EntitySerializeFlags::RECURSIVE;
-										if (serializer_state.empty())
-										{
-											// This means the terrain was not serialized, but prop assets provided in this session, so we can keep references to them:
-											flags |= wi::scene::Scene::EntitySerializeFlags::KEEP_INTERNAL_ENTITY_REFERENCES;
-										}
-										else
-										{
-											// This means that terrain was serialized, so we have to resolve prop source asset dependencies:
-											seri.remap = serializer_state;
-										}
-										Entity entity = generator->scene.Entity_Serialize(
-											archive,
-											seri,
-											INVALID_ENTITY,
-											flags
-										);
-										NameComponent* name = generator->scene.names.GetComponent(entity);
-										if (name != nullptr)
-										{
-											name->name += std::to_string(i);
-										}
-										TransformComponent* transform = generator->scene.transforms.GetComponent(entity);
-										if (transform == nullptr)
-										{
-											transform = &generator->scene.transforms.Create(entity);
-										}
-										transform->translation_local = vertex_pos;
-										transform->translation_local.y += wi::math::Lerp(prop.min_y_offset, prop.max_y_offset, float_distr(prop_rand));
-										const float scaling = wi::math::Lerp(prop.min_size, prop.max_size, float_distr(prop_rand));
-										transform->Scale(XMFLOAT3(scaling, scaling, scaling));
-										transform->RotateRollPitchYaw(XMFLOAT3(0, XM_2PI * float_distr(prop_rand), 0));
-										transform->SetDirty();
-										transform->UpdateTransform();
-										generator->scene.Component_Attach(entity, chunk_data.props_entity, true);
-										generated_something = true;
-									}
-								}
+								f = 1 - f;
+								g = 1 - g;
 							}
-							if (!IsPhysicsEnabled())
+							XMFLOAT3 vertex_pos;
+							vertex_pos.x = pos0.x + f * (pos1.x - pos0.x) + g * (pos2.x - pos0.x);
+							vertex_pos.y = pos0.y + f * (pos1.y - pos0.y) + g * (pos2.y - pos0.y);
+							vertex_pos.z = pos0.z + f * (pos1.z - pos0.z) + g * (pos2.z - pos0.z);
+							XMFLOAT4 region;
+							region.x = region0.x + f * (region1.x - region0.x) + g * (region2.x - region0.x);
+							region.y = region0.y + f * (region1.y - region0.y) + g * (region2.y - region0.y);
+							region.z = region0.z + f * (region1.z - region0.z) + g * (region2.z - region0.z);
+							region.w = region0.w + f * (region1.w - region0.w) + g * (region2.w - region0.w);
+
+							const float noise = std::pow(perlin_noise.compute((vertex_pos.x + task.chunk_position.x) * prop.noise_frequency, vertex_pos.y * prop.noise_frequency, (vertex_pos.z + task.chunk_position.z) * prop.noise_frequency) * 0.5f + 0.5f, prop.noise_power);
+							const float chance = std::pow(((float*)&region)[prop.region], prop.region_power) * noise;
+							if (chance > prop.threshold)
 							{
-								generator->scene.rigidbodies.Clear();
+								PropPlacement& placement = placements.emplace_back();
+								placement.prop_index = prop_index;
+								placement.instance_index = uint32_t(i);
+								placement.translation = vertex_pos;
+								placement.translation.y += wi::math::Lerp(prop.min_y_offset, prop.max_y_offset, float_distr(prop_rand));
+								placement.scaling = wi::math::Lerp(prop.min_size, prop.max_size, float_distr(prop_rand));
+								placement.rotation = XM_2PI * float_distr(prop_rand);
 							}
 						}
 					}
-				}
 
-				if (generated_something && timer.elapsed_milliseconds() > generation_time_budget_milliseconds)
-				{
-					generator->cancelled.store(true);
+					if (disk_cache_enabled)
+					{
+						WriteDiskCache(props_cache_filename, PROP_CACHE_MAGIC, props_hash, chunk, (uint32_t)placements.size(), placements.data(), placements.size() * sizeof(PropPlacement), disk_cache_compression);
+					}
 				}
 
-			};
-
-			// generate center chunk first:
-			request_chunk(0, 0);
-			if (generator->cancelled.load()) return;
-
-			// then generate neighbor chunks in outward spiral:
-			for (int growth = 0; growth < generation; ++growth)
-			{
-				const int side = 2 * (growth + 1);
-				int x = -growth - 1;
-				int z = -growth - 1;
-				for (int i = 0; i < side; ++i)
+				for (const PropPlacement& placement : placements)
 				{
-					request_chunk(x, z);
-					if (generator->cancelled.load()) return;
-					x++;
+					if (placement.prop_index >= props.size())
+						continue;
+					const Prop& prop = props[placement.prop_index];
+					wi::Archive archive = wi::Archive(prop.data.data());
+					EntitySerializer seri;
+					wi::scene::Scene::EntitySerializeFlags flags = wi::scene::Scene::EntitySerializeFlags::RECURSIVE;
+					if (serializer_state.empty())
+					{
+						// This means the terrain was not serialized, but prop assets provided in this session, so we can keep references to them:
+						flags |= wi::scene::Scene::EntitySerializeFlags::KEEP_INTERNAL_ENTITY_REFERENCES;
+					}
+					else
+					{
+						// This means that terrain was serialized, so we have to resolve prop source asset dependencies:
+						seri.remap = serializer_state;
+					}
+					Entity entity = generated_scene.Entity_Serialize(
+						archive,
+						seri,
+						INVALID_ENTITY,
+						flags
+					);
+					NameComponent* name = generated_scene.names.GetComponent(entity);
+					if (name != nullptr)
+					{
+						name->name += std::to_string(placement.instance_index);
+					}
+					TransformComponent* transform = generated_scene.transforms.GetComponent(entity);
+					if (transform == nullptr)
+					{
+						transform = &generated_scene.transforms.Create(entity);
+					}
+					transform->translation_local = placement.translation;
+					transform->Scale(XMFLOAT3(placement.scaling, placement.scaling, placement.scaling));
+					transform->RotateRollPitchYaw(XMFLOAT3(0, placement.rotation, 0));
+					transform->SetDirty();
+					transform->UpdateTransform();
+					generated_scene.Component_Attach(entity, task.props_entity, true);
 				}
-				for (int i = 0; i < side; ++i)
+				if (!IsPhysicsEnabled())
 				{
-					request_chunk(x, z);
-					if (generator->cancelled.load()) return;
-					z++;
+					generated_scene.rigidbodies.Clear();
 				}
-				for (int i = 0; i < side; ++i)
+			};
+
+			wi::Timer timer;
+			while (!generator->cancelled.load())
+			{
+				std::shared_ptr<GenerationTask> task;
+				generator->pending_locker.lock();
+				if (!generator->pending_tasks.empty())
 				{
-					request_chunk(x, z);
-					if (generator->cancelled.load()) return;
-					x--;
+					task = std::move(generator->pending_tasks.front());
+					generator->pending_tasks.pop_front();
+					task->started = true;
 				}
-				for (int i = 0; i < side; ++i)
+				generator->pending_locker.unlock();
+
+				if (task == nullptr)
+					break;
+
+				task->scene = std::make_unique<wi::scene::Scene>();
+				switch (task->type)
 				{
-					request_chunk(x, z);
-					if (generator->cancelled.load()) return;
-					z--;
+				case GenerationTask::Type::Chunk:
+					generate_chunk(*task);
+					break;
+				case GenerationTask::Type::Props:
+					generate_props(*task);
+					break;
+				default:
+					break;
 				}
+
+				generator->completed_locker.lock();
+				generator->completed_tasks.push_back(std::move(task));
+				generator->completed_locker.unlock();
+
+				if (timer.elapsed_milliseconds() > generation_time_budget_milliseconds)
+					break;
 			}
 
 			});
-
 	}
 
 	void Terrain::Generation_Cancel()
@@ -907,6 +1470,197 @@ namespace wi::terrain
 		wi::jobsystem::Wait(generator->workload); // waits until generation thread exits
 		generator->cancelled.store(false); // the next generation can run
 	}
+	void Terrain::Generation_Wait()
+	{
+		if (generator == nullptr)
+			return;
+		wi::jobsystem::Wait(generator->workload);
+	}
+
+	// Computes the chunk that contains a world position, and the position on the chunk's vertex grid
+	//	cell_x, cell_z : the grid cell that contains the position, the vertices of the cell are [cell, cell + 1]
+	//	fraction_x, fraction_z : position inside the grid cell in [0, 1] range
+	static inline void ComputeChunkCell(float world_x, float world_z, float chunk_scale_rcp, Chunk& chunk, int& cell_x, int& cell_z, float& fraction_x, float& fraction_z)
+	{
+		const float x = world_x * chunk_scale_rcp + chunk_half_width;
+		const float z = world_z * chunk_scale_rcp + chunk_half_width;
+		chunk.x = (int)std::floor(x * chunk_width_rcp);
+		chunk.z = (int)std::floor(z * chunk_width_rcp);
+		const float grid_x = x - float(chunk.x * (chunk_width - 1));
+		const float grid_z = z - float(chunk.z * (chunk_width - 1));
+		cell_x = std::min(std::max(0, (int)grid_x), chunk_width - 2);
+		cell_z = std::min(std::max(0, (int)grid_z), chunk_width - 2);
+		fraction_x = grid_x - float(cell_x);
+		fraction_z = grid_z - float(cell_z);
+	}
+	// Evaluates the modifiers, this gives the same height as the chunk vertices when they are generated
+	static inline float ComputeModifierHeight(const Terrain& terrain, float world_x, float world_z)
+	{
+		float height = 0;
+		const XMFLOAT2 world_pos = XMFLOAT2(world_x, world_z);
+		for (auto& modifier : terrain.modifiers)
+		{
+			modifier->Apply(world_pos, height);
+		}
+		return wi::math::Lerp(terrain.bottomLevel, terrain.topLevel, height);
+	}
+
+	float Terrain::GetHeight(const XMFLOAT3& position) const
+	{
+		Chunk chunk;
+		int cell_x, cell_z;
+		float fraction_x, fraction_z;
+		ComputeChunkCell(position.x, position.z, 1.0f / chunk_scale, chunk, cell_x, cell_z, fraction_x, fraction_z);
+
+		auto it = chunks.find(chunk);
+		if (it == chunks.end() || it->second.mesh_vertex_positions == nullptr)
+		{
+			return ComputeModifierHeight(*this, position.x, position.z);
+		}
+
+		const XMFLOAT3* vertices = it->second.mesh_vertex_positions;
+		const int index = cell_x + cell_z * chunk_width;
+		const float h00 = vertices[index].y;
+		const float h10 = vertices[index + 1].y;
+		const float h01 = vertices[index + chunk_width].y;
+		const float h11 = vertices[index + chunk_width + 1].y;
+		return wi::math::Lerp(wi::math::Lerp(h00, h10, fraction_x), wi::math::Lerp(h01, h11, fraction_x), fraction_z);
+	}
+	XMFLOAT3 Terrain::GetNormal(const XMFLOAT3& position) const
+	{
+		Chunk chunk;
+		int cell_x, cell_z;
+		float fraction_x, fraction_z;
+		ComputeChunkCell(position.x, position.z, 1.0f / chunk_scale, chunk, cell_x, cell_z, fraction_x, fraction_z);
+
+		// Height differences along one vertex spacing in X and Z directions:
+		float dx = 0;
+		float dz = 0;
+		auto it = chunks.find(chunk);
+		if (it == chunks.end() || it->second.mesh_vertex_positions == nullptr)
+		{
+			const float h = ComputeModifierHeight(*this, position.x, position.z);
+			dx = ComputeModifierHeight(*this, position.x + chunk_scale, position.z) - h;
+			dz = ComputeModifierHeight(*this, position.x, position.z + chunk_scale) - h;
+		}
+		else
+		{
+			const XMFLOAT3* vertices = it->second.mesh_vertex_positions;
+			const int index = cell_x + cell_z * chunk_width;
+			const float h00 = vertices[index].y;
+			const float h10 = vertices[index + 1].y;
+			const float h01 = vertices[index + chunk_width].y;
+			const float h11 = vertices[index + chunk_width + 1].y;
+			dx = wi::math::Lerp(h10 - h00, h11 - h01, fraction_z);
+			dz = wi::math::Lerp(h01 - h00, h11 - h10, fraction_x);
+		}
+
+		XMFLOAT3 normal;
+		XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(-dx, chunk_scale, -dz, 0)));
+		return normal;
+	}
+	void Terrain::GetHeights(const float* x, const float* z, float* heights, size_t count) const
+	{
+		const float chunk_scale_rcp = 1.0f / chunk_scale;
+		const XMVECTOR scale_rcp = XMVectorReplicate(chunk_scale_rcp);
+		const XMVECTOR half_width = XMVectorReplicate(chunk_half_width);
+		const XMVECTOR width_rcp = XMVectorReplicate(chunk_width_rcp);
+		const XMVECTOR width = XMVectorReplicate(float(chunk_width - 1));
+		const XMVECTOR max_cell = XMVectorReplicate(float(chunk_width - 2));
+
+		// Consecutive positions are usually in the same chunk, so the last chunk lookup is remembered:
+		Chunk last_chunk = {};
+		const XMFLOAT3* last_vertices = nullptr;
+		bool last_valid = false;
+
+		wi::vector<uint32_t> fallback; // positions that are not on generated chunks
+
+		for (size_t i = 0; i < count; i += 4)
+		{
+			const size_t lane_count = std::min(count - i, size_t(4));
+			XMFLOAT4A X = {}, Z = {};
+			for (size_t lane = 0; lane < lane_count; ++lane)
+			{
+				(&X.x)[lane] = x[i + lane];
+				(&Z.x)[lane] = z[i + lane];
+			}
+
+			const XMVECTOR grid_x = XMLoadFloat4A(&X) * scale_rcp + half_width;
+			const XMVECTOR grid_z = XMLoadFloat4A(&Z) * scale_rcp + half_width;
+			const XMVECTOR chunk_x = XMVectorFloor(grid_x * width_rcp);
+			const XMVECTOR chunk_z = XMVectorFloor(grid_z * width_rcp);
+			const XMVECTOR local_x = grid_x - chunk_x * width;
+			const XMVECTOR local_z = grid_z - chunk_z * width;
+			const XMVECTOR cell_x = XMVectorClamp(XMVectorFloor(local_x), XMVectorZero(), max_cell);
+			const XMVECTOR cell_z = XMVectorClamp(XMVectorFloor(local_z), XMVectorZero(), max_cell);
+			const XMVECTOR fraction_x = local_x - cell_x;
+			const XMVECTOR fraction_z = local_z - cell_z;
+
+			XMFLOAT4A chunks_x, chunks_z, cells_x, cells_z;
+			XMStoreFloat4A(&chunks_x, chunk_x);
+			XMStoreFloat4A(&chunks_z, chunk_z);
+			XMStoreFloat4A(&cells_x, cell_x);
+			XMStoreFloat4A(&cells_z, cell_z);
+
+			// The vertex heights of the grid cells are gathered per lane:
+			XMFLOAT4A h00 = {}, h10 = {}, h01 = {}, h11 = {};
+			for (size_t lane = 0; lane < lane_count; ++lane)
+			{
+				const Chunk chunk = { (int)(&chunks_x.x)[lane], (int)(&chunks_z.x)[lane] };
+				if (!last_valid || !(chunk == last_chunk))
+				{
+					auto it = chunks.find(chunk);
+					last_chunk = chunk;
+					last_vertices = it == chunks.end() ? nullptr : it->second.mesh_vertex_positions;
+					last_valid = true;
+				}
+				if (last_vertices == nullptr)
+				{
+					fallback.push_back(uint32_t(i + lane));
+					continue;
+				}
+				const int index = (int)(&cells_x.x)[lane] + (int)(&cells_z.x)[lane] * chunk_width;
+				(&h00.x)[lane] = last_vertices[index].y;
+				(&h10.x)[lane] = last_vertices[index + 1].y;
+				(&h01.x)[lane] = last_vertices[index + chunk_width].y;
+				(&h11.x)[lane] = last_vertices[index + chunk_width + 1].y;
+			}
+
+			const XMVECTOR h0 = XMVectorLerpV(XMLoadFloat4A(&h00), XMLoadFloat4A(&h10), fraction_x);
+			const XMVECTOR h1 = XMVectorLerpV(XMLoadFloat4A(&h01), XMLoadFloat4A(&h11), fraction_x);
+			XMFLOAT4A result;
+			XMStoreFloat4A(&result, XMVectorLerpV(h0, h1, fraction_z));
+			for (size_t lane = 0; lane < lane_count; ++lane)
+			{
+				heights[i + lane] = (&result.x)[lane];
+			}
+		}
+
+		// Positions outside of generated chunks are computed by the modifiers in batches:
+		constexpr size_t block_size = 64;
+		float block_x[block_size];
+		float block_z[block_size];
+		float block_heights[block_size];
+		for (size_t offset = 0; offset < fallback.size(); offset += block_size)
+		{
+			const size_t block_count = std::min(fallback.size() - offset, block_size);
+			for (size_t j = 0; j < block_count; ++j)
+			{
+				const uint32_t index = fallback[offset + j];
+				block_x[j] = x[index];
+				block_z[j] = z[index];
+				block_heights[j] = 0;
+			}
+			for (auto& modifier : modifiers)
+			{
+				modifier->ApplyBatch(block_x, block_z, block_heights, block_count);
+			}
+			for (size_t j = 0; j < block_count; ++j)
+			{
+				heights[fallback[offset + j]] = wi::math::Lerp(bottomLevel, topLevel, block_heights[j]);
+			}
+		}
+	}
 
 	void Terrain::BakeVirtualTexturesToFiles()
 	{
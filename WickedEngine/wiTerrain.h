@@ -111,7 +111,25 @@ namespace wi::terrain
 
 		// For generating scene on a background thread:
 		std::shared_ptr<Generator> generator;
-		float generation_time_budget_milliseconds = 12; // after this much time, the generation thread will exit. This can help avoid a very long running, resource consuming and slow cancellation generation
+		float generation_time_budget_milliseconds = 12; // after this much time, the generation thread will exit and continue with the remaining work later. This can help avoid a very long running, resource consuming generation
+
+		// Generation is performed by the generation thread in tasks, the main thread never waits for it in Generation_Update()
+		//	Tasks are ordered by distance to the camera and visibility, and completed tasks are handed over to the main thread every frame
+		struct GenerationStatistics
+		{
+			float handover_milliseconds = 0; // main thread time spent in last frame with merging completed tasks into the scene
+			uint32_t handover_chunk_count = 0; // number of chunks handed over in the last frame
+			uint32_t handover_props_count = 0; // number of prop placements handed over in the last frame
+			uint32_t pending_task_count = 0; // number of tasks waiting for the generation thread
+			uint32_t running_task_count = 0; // number of tasks taken by the generation thread, but not yet handed over
+		} generation_statistics;
+		size_t height_cache_capacity = 256; // the height grids of this many recently generated chunks will be kept in memory, so they don't need to be computed again when the chunks are regenerated
+
+		// Generated chunks and prop placements can be stored in a disk cache, so they don't need to be generated again later
+		//	The cache entries are keyed by the generation parameters, so they are invalidated automatically when modifiers or props change
+		//	The disk cache is disabled when this is empty
+		std::string disk_cache_directory;
+		bool disk_cache_compression = true; // disk cache entries will be compressed
 
 		// Virtual texture updates will be batched like:
 		//	1) Execute all barriers (dst: UNORDERED_ACCESS)
@@ -157,15 +175,31 @@ namespace wi::terrain
 		// Restarts the terrain generation from scratch
 		//	This will remove previously existing terrain
 		void Generation_Restart();
-		// This will run the actual generation tasks, call it once per frame
+		// This will schedule the generation tasks and receive the completed ones, call it once per frame
 		void Generation_Update(const wi::scene::CameraComponent& camera);
 		// Tells the generation thread that it should be cancelled and blocks until that is confirmed
+		//	The tasks that were not completed will be continued by the next Generation_Update()
 		void Generation_Cancel();
+		// Blocks until the generation thread finishes its current work without cancelling it
+		void Generation_Wait();
 		// The virtual textures will be compressed and saved into resources. They can be serialized from there
 		void BakeVirtualTexturesToFiles();
 		// Creates the blend weight texture for a chunk data
 		void CreateChunkRegionTexture(ChunkData& chunk_data);
 
+		// Height queries: positions are in world space, the terrain entity is expected to be at the world origin
+		//	The generated chunks are sampled with bilinear interpolation of their vertices, so querying is O(1)
+		//	Where chunks are not generated, the height is computed by evaluating the modifiers
+		//	These must not be used concurrently with Generation_Update(), because that can modify chunks
+
+		// Returns the terrain height at the world position (only x and z of the position are used)
+		float GetHeight(const XMFLOAT3& position) const;
+		// Returns the terrain surface normal at the world position (only x and z of the position are used)
+		XMFLOAT3 GetNormal(const XMFLOAT3& position) const;
+		// Returns terrain heights for many world positions at once, the positions are given as separate x and z arrays
+		//	This is vectorized and it is faster than calling GetHeight() for every position
+		void GetHeights(const float* x, const float* z, float* heights, size_t count) const;
+
 		void Serialize(wi::Archive& archive, wi::ecs::EntitySerializer& seri);
 	};
 
@@ -190,6 +224,15 @@ namespace wi::terrain
 
 		virtual void Seed(uint32_t seed) {}
 		virtual void Apply(const XMFLOAT2& world_pos, float& height) = 0;
+		// Applies the modifier to many heights at once, the world positions are given as separate x and y arrays
+		//	The default implementation calls Apply() for every element, modifiers can override this with a vectorized version
+		virtual void ApplyBatch(const float* world_pos_x, const float* world_pos_y, float* heights, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				Apply(XMFLOAT2(world_pos_x[i], world_pos_y[i]), heights[i]);
+			}
+		}
 		constexpr void Blend(float& height, float value)
 		{
 			switch (blend)
@@ -226,6 +269,27 @@ namespace wi::terrain
 			p.y *= frequency;
 			Blend(height, perlin_noise.compute(p.x, p.y, 0, octaves) * 0.5f + 0.5f);
 		}
+		void ApplyBatch(const float* world_pos_x, const float* world_pos_y, float* heights, size_t count) override
+		{
+			constexpr size_t block_size = 64;
+			float x[block_size];
+			float y[block_size];
+			float noise[block_size];
+			for (size_t offset = 0; offset < count; offset += block_size)
+			{
+				const size_t block_count = std::min(count - offset, block_size);
+				for (size_t i = 0; i < block_count; ++i)
+				{
+					x[i] = world_pos_x[offset + i] * frequency;
+					y[i] = world_pos_y[offset + i] * frequency;
+				}
+				perlin_noise.compute(x, y, nullptr, noise, block_count, octaves);
+				for (size_t i = 0; i < block_count; ++i)
+				{
+					Blend(heights[offset + i], noise[i] * 0.5f + 0.5f);
+				}
+			}
+		}
 	};
 	struct VoronoiModifier : public Modifier
 	{
@@ -257,6 +321,40 @@ namespace wi::terrain
 			float weight = std::pow(1 - wi::math::saturate((res.distance - shape) * fade), std::max(0.0001f, falloff));
 			Blend(height, weight);
 		}
+		void ApplyBatch(const float* world_pos_x, const float* world_pos_y, float* heights, size_t count) override
+		{
+			constexpr size_t block_size = 64;
+			float x[block_size];
+			float y[block_size];
+			float angle[block_size];
+			float distance[block_size];
+			float cell_id[block_size];
+			for (size_t offset = 0; offset < count; offset += block_size)
+			{
+				const size_t block_count = std::min(count - offset, block_size);
+				for (size_t i = 0; i < block_count; ++i)
+				{
+					x[i] = world_pos_x[offset + i] * frequency;
+					y[i] = world_pos_y[offset + i] * frequency;
+				}
+				if (perturbation > 0)
+				{
+					perlin_noise.compute(x, y, nullptr, angle, block_count, 6);
+					for (size_t i = 0; i < block_count; ++i)
+					{
+						const float a = angle[i] * XM_2PI;
+						x[i] += std::sin(a) * perturbation;
+						y[i] += std::cos(a) * perturbation;
+					}
+				}
+				wi::noise::voronoi::compute(x, y, (float)seed, distance, cell_id, block_count);
+				for (size_t i = 0; i < block_count; ++i)
+				{
+					float weight = std::pow(1 - wi::math::saturate((distance[i] - shape) * fade), std::max(0.0001f, falloff));
+					Blend(heights[offset + i], weight);
+				}
+			}
+		}
 	};
 	struct HeightmapModifier : public Modifier
 	{